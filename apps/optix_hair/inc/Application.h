@@ -53,10 +53,20 @@
 #endif
 
 #include "inc/Camera.h"
+#include "inc/ConvergenceController.h"
+#include "inc/Denoiser.h"
+#include "inc/ExrWriter.h"
+#include "inc/GeometryRegistry.h"
+#include "inc/HairColorMatch.h"
+#include "inc/HairSwatch.h"
+#include "inc/ImportedModel.h"
+#include "inc/NodeArena.h"
 #include "inc/Options.h"
+#include "inc/PictureLoader.h"
 #include "inc/Rasterizer.h"
 #include "inc/Raytracer.h"
 #include "inc/SceneGraph.h"
+#include "inc/ScreenshotWriter.h"
 #include "inc/Texture.h"
 #include "inc/Timer.h"
 
@@ -75,6 +85,8 @@
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/LogStream.hpp>
 
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
 
@@ -182,8 +194,15 @@ public:
 
 private:
   bool loadSystemDescription(std::string const& filename);
+  template <typename TParser> bool parseSystemDescription(TParser& parser);
   bool saveSystemDescription();
   bool loadSceneDescription(std::string const& filename);
+  template <typename TParser> bool parseSceneDescription(TParser& parser);
+
+  uint64_t getSceneSnapshotKey(std::string const& filenameSystem, std::string const& filenameScene);
+  template <typename TParser> uint64_t hashSceneReferences(TParser& parser, uint64_t key);
+  bool     loadSceneSnapshot(std::string const& filename, const uint64_t key);
+  bool     saveSceneSnapshot(std::string const& filename, const uint64_t key) const;
 
   void restartRendering();
 
@@ -191,17 +210,23 @@ private:
   void updateDYEconcentration(MaterialGUI &materialGUI); //PSAN
   void updateHT(MaterialGUI& materialGUI); //PSAN TEST update HT
   void updateDYEinterface(MaterialGUI& materialGUI);
+  void evaluateSwatchPalette(MaterialGUI const& material, std::vector<float3>& palette); // Estimated hair colors of all HT levels with the current dye settings. Only reevaluated when these changed.
+  void matchHairColor(MaterialGUI const& material, float3 const& target, const bool refineMelanin); // Starts the search on the ThreadPool.
+  void dispatchColorMatch(); // Moves the finished search results into m_colorMatches.
 
   bool screenshot(const bool tonemap);
   bool screenshot(const bool tonemap, std::string name);
   bool screenshot360();
+  bool captureScreenshot(std::string const& filename, const float4* bufferHost, const bool tonemap, const bool announce);
   bool loading_bar(const float progress, const int bar_width = 70);
 
   float captureVariance();
+  const float4* getOutputImage(Denoiser& denoiser); // The accumulated output buffer, denoised when m_denoise is enabled.
 
   void createCameras();
   void createLights();
   void createPictures();
+  void initTextures();
 
   void appendInstance(std::shared_ptr<sg::Group>& group,
                       std::shared_ptr<sg::Node> geometry, 
@@ -209,10 +234,17 @@ private:
                       std::string const& reference, 
                       unsigned int& idInstance);
 
-  std::shared_ptr<sg::Group> createASSIMP(std::string const& filename);
-  std::shared_ptr<sg::Group> traverseScene(const struct aiScene *scene, const unsigned int indexSceneBase, const struct aiNode* node);
+  static std::shared_ptr<ImportedModel> importASSIMP(std::string const& filename, std::string const& meshCache);
+  static void convertMeshASSIMP(const aiScene* scene, const unsigned int iMesh, ImportedMesh& imported);
+  std::shared_ptr<sg::Group> createASSIMP(std::string const& filename, const ImportedModel* model);
+  std::shared_ptr<sg::Group> traverseScene(ImportedModel const& model, const unsigned int indexSceneBase, const unsigned int indexNode);
+
+  void submitModelTask(std::function<void()>&& task);
+  void submitASSIMP(std::string const& filename, std::shared_ptr<sg::Instance> const& instance);
+  void resolveModelTasks();
+  void shareGeometries();
 
-  void calculateTangents(std::vector<VertexAttributes>& attributes, std::vector<unsigned int> const& indices);
+  static void calculateTangents(std::vector<VertexAttributes>& attributes, std::vector<unsigned int> const& indices);
 
   void guiRenderingIndicator(const bool isRendering);
 
@@ -247,6 +279,8 @@ private:
   int         m_interop;     // "interop"// 0 = none all through host, 1 = register texture image, 2 = register pixel buffer
   bool        m_present;     // "present"
   bool        m_catchVariance;     // 0 = no variance calculation, 1 = variance calculation
+  float       m_targetError;       // "targetError" // Relative error at which the accumulation stops early, 0.0f = off. Requires catchVariance.
+  bool        m_denoise;           // "denoise" // CPU denoising of the output before tonemapping for display, screenshots and streaming.
   
   bool        m_presentNext;      // (derived)
   double      m_presentAtSecond;  // (derived)
@@ -254,6 +288,13 @@ private:
 
   // GUI Data representing raytracer settings.
   LensShader m_lensShader;          // "lensShader"
+  SamplerType m_sampler;            // "sampler"
+  bool       m_envAliasSampling;    // "envAliasSampling"
+  int        m_textureCacheSize;    // "textureCacheSize" // Memory budget of the decoded picture cache in MB.
+  int        m_textureCompression;  // "textureCompression" // 0 = off, 1 = BC1 (BC6H environment), 2 = BC7 (BC6H environment)
+  bool       m_textureHalfFloat;    // "textureHalfFloat"   // Store float textures (the environment) as half floats.
+  bool       m_exrHalf;             // "exrHalf"        // Linear screenshots with half (default) or float channels.
+  ExrCompression m_exrCompression;  // "exrCompression" // 0 = none, 1 = RLE, 2 = ZIPS, 3 = ZIP (default)
   int2       m_pathLengths;         // "pathLengths"   // min, max
   int2       m_resolution;          // "resolution"    // The actual size of the rendering, independent of the window's client size. (Preparation for final frame rendering.)
   int2       m_tileSize;            // "tileSize"      // Multi-GPU distribution tile size. Must be power-of-two values.
@@ -269,6 +310,13 @@ private:
 
   std::string m_prefixSettings;
 
+  std::string m_sceneSnapshot;      // "sceneSnapshot", binary snapshot of the resolved host scene, written on the first start and loaded afterwards. Empty disables it.
+  std::string m_meshCache;          // "meshCache", directory for the optimized meshes of imported model files, keyed by the file contents. Empty disables it.
+
+  bool       m_useNodeArena;        // "nodeArena"           // 1 = allocate the scene graph nodes from m_nodeArena, 0 = individually with make_shared (default)
+  int        m_sceneGraphBenchmark; // "sceneGraphBenchmark" // Number of top level instances of the scene graph benchmark run at startup. 0 = off (default)
+  int        m_mipmapBenchmark;     // "mipmapBenchmark"     // Edge length of the square images used by the mipmap generation benchmark run at startup. 0 = off (default)
+
   TonemapperGUI m_tonemapperGUI;    // "gamma", "whitePoint", "burnHighlights", "crushBlacks", "saturation", "brightness"
   
   Camera m_camera;                  // "center", "camera"
@@ -347,6 +395,8 @@ private:
   const char* current_settings_value;
   bool hasChanged;
 
+  sg::NodeArena m_nodeArena; // All scene graph nodes are created with m_nodeArena.create().
+
   std::shared_ptr<sg::Group> m_scene; // Root group node of the scene.
   
   std::vector< std::shared_ptr<sg::Node> > m_geometries; // All geometries in the scene.
@@ -357,6 +407,25 @@ private:
   // For all model file format loaders. Allows instancing of full models in the host side scene graph.
   std::map< std::string, std::shared_ptr<sg::Group> > m_mapGroups;
 
+  // Model loading started by the scene description parser on the ThreadPool.
+  // The geometry nodes are created in file order while parsing, the tasks only fill their data.
+  std::vector< std::future<void> > m_modelTasks;
+
+  // ASSIMP imports in flight. Their groups are built in file order by resolveModelTasks(),
+  // which then sets them as child of all instances which referenced the file.
+  struct PendingASSIMP
+  {
+    std::string                                   filename;
+    std::future< std::shared_ptr<ImportedModel> > model;
+    std::vector< std::shared_ptr<sg::Instance> >  instances;
+    unsigned int                                  idGeometry; // m_idGeometry at the submission, the first geometry ID of the model in file order.
+  };
+  std::vector<PendingASSIMP> m_pendingASSIMP;
+
+  // Identical Triangles geometries of all loaders and the area lights. Duplicates keep their slot in m_geometries
+  // but point to the registered node, so their geometry ID is not referenced by any instance anymore.
+  GeometryRegistry m_geometryRegistry;
+
   std::vector<CameraDefinition> m_cameras;
   std::vector<LightDefinition>  m_lights;
   std::vector<MaterialGUI>      m_materialsGUI;
@@ -370,7 +439,12 @@ private:
   // Map of local material names to indices in the m_materialsGUI vector.
   std::map<std::string, int> m_mapMaterialReferences; 
 
-  std::map<std::string, Picture*> m_mapPictures;
+  // Decodes the pictures in the background and caches them. Declared before m_mapPictures which shares its Pictures.
+  PictureLoader m_pictureLoader;
+
+  ScreenshotWriter m_screenshotWriter; // Tonemaps, encodes and writes screenshots while rendering continues.
+
+  std::map<std::string, std::shared_ptr<Picture>> m_mapPictures;
 
   std::vector<unsigned int> m_remappedMeshIndices; 
 
@@ -385,6 +459,23 @@ private:
   int m_lighting_emission[5] = { 12,12,12,12,12};
   ImagemConverter* imageConverter;
   Socket* socket_server;
+
+  HairSwatch               m_hairSwatch;          // CPU color estimation for instant previews.
+  std::vector<float3>      m_swatchPalette;       // HT 1 to 10 of the material shown in the GUI.
+  std::vector<MaterialGUI> m_swatchPaletteLevels; // The HT level materials m_swatchPalette has been evaluated for.
+
+  HairColorMatch                  m_hairColorMatch;
+  float3                          m_colorMatchTarget;       // sRGB target color of the inverse color matching.
+  bool                            m_colorMatchRefine;       // Refine the melanin parameters of the best matches.
+  std::vector<HairColorCandidate> m_colorMatches;           // Best matches, best first.
+  std::future< std::vector<HairColorCandidate> > m_colorMatchTask; // Running search, invalid when idle.
+  size_t                          m_colorMatchCandidates;   // Number of candidates of the running search.
+  Timer                           m_colorMatchTimer;        // Duration of the running search.
+
+  ConvergenceController m_convergence; // Per tile variance statistics and adaptive termination of the accumulation.
+
+  Denoiser m_denoiser;       // Display and screenshots.
+  Denoiser m_denoiserStream; // sendImage() runs on the streaming thread and needs its own result buffers.
 };
 
 #endif // APPLICATION_H
@@ -0,0 +1,72 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <string>
+#include <vector>
+
+// Block compressed texture formats. Each 4x4 pixel block is stored in 8 (BC1) or 16 bytes (all others).
+enum BlockFormat
+{
+  BLOCK_FORMAT_NONE = 0,
+  BLOCK_FORMAT_BC1  = 1, // RGB, 4 bpp. Alpha is ignored.
+  BLOCK_FORMAT_BC3  = 2, // RGBA, 8 bpp. BC1 color with separately interpolated alpha.
+  BLOCK_FORMAT_BC5  = 3, // RG, 8 bpp. Two independent channels, e.g. for tangent space normal maps.
+  BLOCK_FORMAT_BC6H = 4, // RGB unsigned half float, 8 bpp. HDR.
+  BLOCK_FORMAT_BC7  = 5  // RGBA, 8 bpp. Highest quality LDR.
+};
+
+// One mipmap level of the uncompressed input. RGBA8 for all formats except BC6H which reads RGBA32F.
+struct BlockLevel
+{
+  const void*  pixels;
+  unsigned int width;  // Must be a multiple of 4.
+  unsigned int height; // Must be a multiple of 4.
+};
+
+const char*  getBlockFormatName(const BlockFormat format);
+unsigned int getBlockSize(const BlockFormat format); // Bytes per 4x4 block.
+size_t       getCompressedSize(const BlockFormat format, const unsigned int width, const unsigned int height);
+
+// Encode one image. The block rows are distributed over the ThreadPool.
+void compressBlocks(const BlockFormat format, const void* pixels, const unsigned int width, const unsigned int height, unsigned char* blocks);
+
+// Decode one image to RGBA8, or RGBA32F for BC6H. Only the BC6H and BC7 block modes the encoder produces are decoded,
+// other modes result in magenta blocks. Used to verify the encoder.
+void decompressBlocks(const BlockFormat format, const unsigned char* blocks, const unsigned int width, const unsigned int height, void* pixels);
+
+// Encode a mipmap chain. When cacheFilename is not empty, the blocks are read from or written to that file.
+// The cache is keyed by the hash of the input pixels, so edited images are encoded again.
+void compressLevels(const BlockFormat format, std::vector<BlockLevel> const& levels,
+                    std::vector< std::vector<unsigned char> >& blocks, std::string const& cacheFilename = std::string());
+
+#endif // BLOCK_COMPRESSION_H
@@ -0,0 +1,157 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef COMPILED_SCENE_H
+#define COMPILED_SCENE_H
+
+#include "inc/SceneGraph.h"
+#include "inc/Hair.h"
+
+#include <memory>
+#include <vector>
+
+struct InstanceData
+{
+  InstanceData(unsigned int geometry, int material, int light)
+  : idGeometry(geometry)
+  , idMaterial(material)
+  , idLight(light)
+  {
+  }
+
+  unsigned int idGeometry;
+  int          idMaterial; // Negative is an error.
+  int          idLight;    // Negative means no light.
+};
+
+// One entry per flattened geometry instance in the order the devices build the TLAS.
+struct CompiledInstance
+{
+  CompiledInstance(float const* trafo, InstanceData const& instanceData);
+
+  float        matrix[12]; // Concatenated object to world transformation, row-major 3x4.
+  InstanceData data;       // idGeometry, idMaterial, idLight
+};
+
+// Host side staging data of one geometry. The node is empty when no active instance references the geometry ID.
+struct CompiledGeometry
+{
+  CompiledGeometry()
+  : type(sg::NodeType::NT_GROUP)
+  , attributes(nullptr)
+  , indices(nullptr)
+  , thickness(nullptr)
+  {
+  }
+
+  sg::NodeType              type;
+  std::shared_ptr<sg::Node> node;
+
+  // Triangles and Curves data which is uploaded as is.
+  std::vector<VertexAttributes> const* attributes;
+  std::vector<unsigned int>     const* indices;   // Triangles only.
+  std::vector<float>            const* thickness; // Curves only.
+
+  // Curves data derived from the strands.
+  std::vector<unsigned int> segments;
+  std::vector<int>          strandIndices;
+  std::vector<uint2>        strandInfo;
+  std::vector<float3>       strandRand;
+};
+
+// The device side work needed to get from the previous to the current compilation of a scene.
+struct SceneDiff
+{
+  SceneDiff();
+
+  bool isEmpty() const;
+
+  std::vector<unsigned int> geometriesRemoved; // Geometry IDs whose GAS is not needed anymore.
+  std::vector<unsigned int> geometriesBuilt;   // Geometry IDs which need a new GAS.
+  bool                      instancesChanged;  // The instance table changed, the TLAS needs to be rebuilt.
+  bool                      recordsResized;    // The number of instances changed, all hit group records need to be rebuilt.
+  std::vector<unsigned int> recordsChanged;    // Instance indices with new hit group record data. Empty when recordsResized.
+};
+
+// The scene graph flattened into an instance table plus the per geometry staging data.
+// Compiled once on the host and consumed by all devices in Device::initScene(), so the host cost of a scene rebuild doesn't scale with the device count.
+// This also means all devices see the same random per strand values.
+class CompiledScene
+{
+public:
+  CompiledScene();
+
+  // Full compilation, drops all previous results.
+  void compile(std::shared_ptr<sg::Group> root, const unsigned int numGeometries);
+
+  // Incremental compilation. Consumes the change flags of the nodes and returns the difference to the previous compilation for Device::updateScene().
+  // Staging data of unchanged geometries is kept, also for geometries which are only temporarily not referenced,
+  // so that switching them back on doesn't need a new GAS.
+  SceneDiff update(std::shared_ptr<sg::Group> root, const unsigned int numGeometries);
+
+  std::vector<CompiledInstance> const& getInstances() const;
+  std::vector<CompiledGeometry> const& getGeometries() const;
+
+private:
+  void traverseNode(std::shared_ptr<sg::Node> const& node, float const* matrix, InstanceData data);
+
+private:
+  std::vector<CompiledInstance> m_instances;
+  std::vector<CompiledGeometry> m_geometries; // Indexed by the geometry ID.
+
+  unsigned int m_changes; // Union of the change flags of the Groups and Instances seen during the traversal.
+};
+
+// The per device data built from a compiled scene: one GAS per geometry ID, the instances with the TLAS, and the hit group records.
+// Device implements it with OptiX, the unit tests with a stub. Both get their work from applyScene() and applySceneDiff().
+class SceneTarget
+{
+public:
+  virtual ~SceneTarget();
+
+  virtual size_t getNumGeometries() const = 0;
+  virtual void   setNumGeometries(const size_t numGeometries) = 0; // New entries have no GAS.
+  virtual bool   isGeometryBuilt(const unsigned int idGeometry) const = 0;
+  virtual void   freeGeometry(const unsigned int idGeometry) = 0; // Nothing happens when there is no GAS.
+  virtual void   buildGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry) = 0;
+  virtual void   buildInstances(CompiledScene const& scene) = 0; // All instances and the TLAS.
+  virtual void   setInstanceData(const unsigned int idInstance, InstanceData const& data) = 0;
+  virtual void   buildRecords() = 0; // All hit group records.
+  virtual void   updateRecord(const unsigned int idInstance) = 0; // Uploads the hit group records of one instance.
+};
+
+// Drops all previous data of the target and builds the GAS of the referenced geometries, the TLAS and the hit group records.
+void applyScene(CompiledScene const& scene, SceneTarget& target);
+
+// Only the work the diff lists: the GAS of new or changed geometries, the TLAS only when the instance table changed,
+// and only the hit group records which changed.
+void applySceneDiff(CompiledScene const& scene, SceneDiff const& diff, SceneTarget& target);
+
+#endif // COMPILED_SCENE_H
@@ -1,44 +1,102 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
 
 #pragma once
 
 #ifndef CONFIG_PARSER_H
 #define CONFIG_PARSER_H
 
-#include "rapidjson/document.h"     // rapidjson's DOM-style API
-#include "rapidjson/prettywriter.h" // for stringify JSON
+#include "inc/MappedFile.h"
+#include "inc/Tokenizer.h" // ParserTokenType
 
-#include <string>
-
-enum ParserTokenType
-{
-  PTT_UNKNOWN, // Unknown, normally indicates an error.
-  PTT_ID,      // Keywords, identifiers (not a number).
-  PTT_VAL,     // Immediate floating point value.
-  PTT_STRING,  // Filenames and any other identifiers in quotation marks.
-  PTT_EOL,     // End of line.
-  PTT_EOF      // End of file.
-};
+#include "rapidjson/reader.h"       // rapidjson's SAX-style API
+#include "rapidjson/memorystream.h"
 
+#include <string>
+#include <string_view>
 
-// System and scene file parsing information.
+// JSON system and scene descriptions.
+// RapidJSON's iterative SAX reader is pulled one event at a time and every event is returned as the same token
+// the Tokenizer would return for the text format, so the keyword loops in the Application interpret both formats:
+//   object key           -> PTT_ID     (keywords and "model" types)
+//   string               -> PTT_STRING (filenames, names)
+//   number               -> PTT_VAL    (unconverted number text)
+//   true, false          -> PTT_VAL    "1", "0"
+//   null, arrays, objects   produce no tokens, they only group the arguments.
+// Keywords are single member objects inside an array, which keeps their order and allows repetitions:
+//   [ { "albedo": [0.8, 0.8, 0.8] }, { "material": ["Floor", "brdf_diffuse"] },
+//     { "push": null }, { "translate": [0, 1, -1] }, { "model": { "plane": [4, 4, 2, "Floor"] } }, { "pop": null } ]
+// System descriptions without repeated options can also be a single object: { "strategy": 0, "resolution": [512, 512] }
+// Comments (// and /* */) are allowed.
 class ConfigParser
 {
 public:
   ConfigParser();
   //~ConfigParser();
-  
+
   bool load(std::string const& filename);
 
+  // Returns PTT_UNKNOWN after a JSON syntax error, which has been reported then.
   ParserTokenType getNextToken(std::string& token);
 
   size_t                 getSize() const;
   std::string::size_type getIndex() const;
-  unsigned int           getLine() const;
-    
+  unsigned int           getLine() const;   // One-based line of the last token.
+  unsigned int           getColumn() const; // One-based column behind the last token.
+  std::string            getLocation() const;
+
+  static bool isJsonFile(std::string const& filename);
+
+private:
+  // Receives the SAX events of one IterativeParseNext() step.
+  struct Handler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler>
+  {
+    bool Null();
+    bool Bool(bool b);
+    bool RawNumber(const char* str, rapidjson::SizeType length, bool copy);
+    bool String(const char* str, rapidjson::SizeType length, bool copy);
+    bool Key(const char* str, rapidjson::SizeType length, bool copy);
+
+    void setToken(ParserTokenType type, const char* str, rapidjson::SizeType length);
+
+    std::string*    m_token;
+    ParserTokenType m_type; // PTT_UNKNOWN while the step produced no token.
+  };
+
+  void locate(size_t offset, unsigned int& line, unsigned int& column) const;
+
 private:
-  std::string            m_source; // System or scene description file contents.
-  std::string::size_type m_index;  // Parser's current character index into m_source.
-  unsigned int           m_line;   // Current source code line, one-based for error messages.
+  MappedFile              m_file;
+  std::string             m_filename;
+  rapidjson::MemoryStream m_stream;
+  rapidjson::Reader       m_reader;
+  Handler                 m_handler;
+  size_t                  m_tokenOffset; // Stream offset behind the last token.
 };
 
 #endif // CONFIG_PARSER_H
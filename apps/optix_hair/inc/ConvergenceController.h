@@ -0,0 +1,104 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef CONVERGENCE_CONTROLLER_H
+#define CONVERGENCE_CONTROLLER_H
+
+// Always include this before any OptiX headers!
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <vector>
+
+// Per tile statistics of the accumulated image, gathered from the host copies of the output and variance buffers.
+struct ConvergenceTile
+{
+  float meanVariance;  // Average of the per pixel variance written by the ray generation program when catchVariance is enabled.
+  float meanLuminance; // Average luminance of the accumulated radiance.
+  float error;         // Relative 95% confidence interval half-width: 1.96 * sqrt(meanVariance / spp) / meanLuminance.
+  bool  converged;
+};
+
+// Host side adaptive sampling controller.
+// Splits the image into tiles, reduces the variance buffer per tile in parallel and decides when the progressive accumulation can stop.
+// A targetError of 0.0f disables the early termination, the statistics are still gathered for the confidence interval printouts.
+class ConvergenceController
+{
+public:
+  ConvergenceController();
+
+  void setResolution(const int2 resolution);
+  void setTileSize(const int2 tileSize);       // Statistics tile size in pixels, independent of the multi-GPU distribution tile size.
+  void setTargetError(const float targetError); // Relative error threshold, e.g. 0.01f for 1%.
+  void setMinIterations(const unsigned int minIterations);
+  void setCheckInterval(const unsigned int interval); // Only evaluate every interval iterations to limit the device to host copies.
+
+  float        getTargetError() const;
+  unsigned int getMinIterations() const;
+  unsigned int getCheckInterval() const;
+
+  // Restart the convergence tracking, e.g. after a camera or material change.
+  void reset();
+
+  // Returns true when the given iteration should be evaluated, which requires downloading the buffers.
+  bool isCheckDue(const unsigned int iterationIndex) const;
+
+  // Gather the per tile statistics. The output buffer is optional, without it the error is absolute instead of relative.
+  // Returns true when every tile is below the target error.
+  bool update(const float4* output, const float* variance, const unsigned int iterationIndex);
+
+  bool         isConverged() const;
+  float        getConfidenceInterval() const; // Full image 2 * 1.96 * sqrt(meanVariance / spp), matching the former captureVariance() result.
+  unsigned int getNumTiles() const;
+  unsigned int getNumConvergedTiles() const;
+  float        getMaxError() const;
+  int4         getActiveRect() const;          // Pixel bounding rectangle (x0, y0, x1, y1) of the not yet converged tiles, empty when converged.
+
+  std::vector<ConvergenceTile> const& getTiles() const;
+
+private:
+  int2         m_resolution;
+  int2         m_tileSize;
+  int2         m_numTiles;
+  float        m_targetError;
+  unsigned int m_minIterations;
+  unsigned int m_checkInterval;
+
+  std::vector<ConvergenceTile> m_tiles;
+
+  // Results of the last update().
+  bool         m_converged;
+  float        m_confidenceInterval;
+  unsigned int m_numConverged;
+  float        m_maxError;
+  int4         m_activeRect;
+};
+
+#endif // CONVERGENCE_CONTROLLER_H
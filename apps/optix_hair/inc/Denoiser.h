@@ -0,0 +1,91 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef DENOISER_H
+#define DENOISER_H
+
+// Always include this before any OptiX headers!
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <vector>
+
+// CPU denoiser for the accumulated linear HDR output buffer, applied before tonemapping.
+// Edge-avoiding a-trous wavelet filter (5x5 B3-spline kernel with increasing step widths) where the luminance edge-stopping
+// function is scaled by the per pixel standard deviation of the mean, taken from the variance buffer when available.
+// Rows are distributed over the ThreadPool, the color accumulation uses SSE when available.
+class Denoiser
+{
+public:
+  Denoiser();
+
+  void setIterations(const int iterations);       // Number of a-trous levels, step width 1, 2, 4, ... Default 4.
+  void setSigmaLuminance(const float sigma);      // Luminance edge-stopping scale in units of standard deviation. Default 4.0f.
+
+  int   getIterations() const;
+  float getSigmaLuminance() const;
+
+  // Filter the RGBA32F image. The variance buffer is optional, without it the edge-stopping falls back to a relative luminance threshold.
+  // spp is the number of accumulated iterations the variance buffer belongs to.
+  // Returns a pointer to the internal result buffer which stays valid until the next call.
+  const float4* denoise(const float4* color, const float* variance, const int2 resolution, const unsigned int spp);
+
+  double getTime() const; // Duration of the last denoise() call in seconds.
+
+private:
+  struct Level
+  {
+    const float4* src;
+    const float*  srcLum;
+    const float*  srcVar;
+    float4*       dst;
+    float*        dstLum;
+    float*        dstVar;
+  };
+
+  void prefilterVariance(const float* variance, const unsigned int spp);
+  void filterLevel(const Level& level, const int step);
+
+private:
+  int   m_iterations;
+  float m_sigmaLuminance;
+
+  int2 m_resolution;
+
+  // Ping-pong buffers.
+  std::vector<float4> m_color[2];
+  std::vector<float>  m_luminance[2];
+  std::vector<float>  m_variance[2];
+  bool                m_hasVariance;
+
+  double m_time;
+};
+
+#endif // DENOISER_H
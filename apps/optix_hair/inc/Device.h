@@ -42,6 +42,7 @@
 // OptiX 7 function table structure.
 #include <optix_function_table.h>
 
+#include "inc/CompiledScene.h"
 #include "inc/MaterialGUI.h"
 #include "inc/Picture.h"
 #include "inc/SceneGraph.h"
@@ -260,6 +261,9 @@ struct GeometryData
   , numAttributes(0)
   , numIndices(0)
   , d_gas(0)
+  , d_strand_rand(0)
+  , d_strand_i(0)
+  , d_strand_info(0)
   {
   }
  
@@ -277,20 +281,6 @@ struct GeometryData
                                 // info.y = strand length (segments)
 };
 
-struct InstanceData
-{
-  InstanceData(unsigned int geometry, int material, int light)
-  : idGeometry(geometry)
-  , idMaterial(material)
-  , idLight(light)
-  {
-  }
-
-  unsigned int idGeometry;
-  int          idMaterial; // Negative is an error.
-  int          idLight;    // Negative means no light.
-};
-
 // GUI controllable settings in the device.
 struct DeviceState
 {
@@ -300,15 +290,20 @@ struct DeviceState
   int          distribution; // This is depending on the strategy.
   int          samplesSqrt;
   LensShader   lensShader;
+  SamplerType  sampler;
+  bool         envAliasSampling;
   float        epsilonFactor;
   float        envRotation;
   float        clockFactor;
   int          screenshotImageNum;
   bool         catchVariance;
+  int          textureCompression; // 0 = off, 1 = BC1 and BC6H, 2 = BC7 and BC6H. Used by the next initTextures().
+  bool         textureHalfFloat;   // Half float storage of float textures. Used by the next initTextures().
 };
 
 
-class Device
+// The scene data is built through the SceneTarget functions by applyScene() and applySceneDiff().
+class Device : private SceneTarget
 {
 public:
   Device(const RendererStrategy strategy,
@@ -328,7 +323,8 @@ public:
   virtual void initCameras(std::vector<CameraDefinition> const& cameras);
   virtual void initLights(std::vector<LightDefinition> const& lights);
   virtual void initMaterials(std::vector<MaterialGUI> const& materialsGUI);
-  virtual void initScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries);
+  virtual void initScene(CompiledScene const& scene);
+  virtual void updateScene(CompiledScene const& scene, SceneDiff const& diff);
   
   virtual void updateCamera(const int idCamera, CameraDefinition const& camera);
   virtual void updateLight(const int idLight, LightDefinition const& light);
@@ -351,11 +347,25 @@ private:
   void initDeviceAttributes();
   void initDeviceProperties();
   void initPipeline();
-  void traverseNode(std::shared_ptr<sg::Node> node, float matrix[12], InstanceData data);
-  unsigned int createGeometry(std::shared_ptr<sg::Triangles> geometry);
-  unsigned int createHairGeometry(std::shared_ptr<sg::Curves> geometry);
-  void createInstance(const OptixTraversableHandle traversable, float matrix[12], InstanceData const& data);
+  void initSampler();
+  void updateLightAliasTable();
+
+  // SceneTarget
+  virtual size_t getNumGeometries() const;
+  virtual void   setNumGeometries(const size_t numGeometries);
+  virtual bool   isGeometryBuilt(const unsigned int idGeometry) const;
+  virtual void   freeGeometry(const unsigned int idGeometry);
+  virtual void   buildGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry);
+  virtual void   buildInstances(CompiledScene const& scene);
+  virtual void   setInstanceData(const unsigned int idInstance, InstanceData const& data);
+  virtual void   buildRecords();
+  virtual void   updateRecord(const unsigned int idInstance);
+
+  void createGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry);
+  void createHairGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry);
+  void createInstance(const OptixTraversableHandle traversable, const float matrix[12], InstanceData const& data);
   void createTLAS();
+  void setHitGroupRecords(const unsigned int idInstance);
   void createHitGroupRecords();
 
 public:
@@ -426,8 +436,13 @@ public:
   Texture* m_textureAlbedo;
   Texture* m_textureCutout;
   Texture* m_textureEnv;
+  int      m_textureCompression;
+  bool     m_textureHalfFloat;
 
   std::vector<MaterialDefinition> m_materials; // Staging data for the device side sysData.materialDefinitions
+
+  std::vector<LightDefinition> m_lights;          // Host copy of the sysData.lightDefinitions to rebuild the light selection alias table.
+  std::vector<AliasEntry>      m_lightAliasTable; // Staging data for the device side sysData.lightAliasTable
 }; 
 
 #endif // DEVICE_H
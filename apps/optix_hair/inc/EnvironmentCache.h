@@ -0,0 +1,79 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef ENVIRONMENT_CACHE_H
+#define ENVIRONMENT_CACHE_H
+
+#include <cuda_runtime.h>
+
+#include "shaders/alias_table.h"
+
+#include "inc/MappedFile.h"
+
+#include <cstdint>
+#include <string>
+
+// Disk cache of the importance sampling data of a spherical environment map (see Texture::calculateSphericalCDF()).
+// Stored next to the image file and keyed by the content hash and extents of the environment's RGBA32F data.
+// The cache is memory mapped on load, the pointers stay valid until unload() or destruction.
+class EnvironmentCache
+{
+public:
+  EnvironmentCache();
+  ~EnvironmentCache();
+
+  // The cache file name for the given environment image file name.
+  static std::string getCacheFilename(std::string const& filename);
+
+  // Returns false when there is no cache file or it doesn't match the key.
+  bool load(std::string const& filename, const unsigned int width, const unsigned int height, const uint64_t hash);
+  void unload();
+
+  // Write the cache file. The array sizes are the ones of Texture::calculateSphericalCDF().
+  static bool save(std::string const& filename, const unsigned int width, const unsigned int height, const uint64_t hash,
+                   const float integral, const float* cdfU, const float* cdfV, const AliasEntry* aliasU, const AliasEntry* aliasV);
+
+  float             getIntegral() const;
+  const float*      getCDF_U() const;   // (width + 1) * height
+  const float*      getCDF_V() const;   // height + 1
+  const AliasEntry* getAlias_U() const; // width * height
+  const AliasEntry* getAlias_V() const; // height
+
+private:
+  MappedFile m_file;
+
+  float             m_integral;
+  const float*      m_cdfU;
+  const float*      m_cdfV;
+  const AliasEntry* m_aliasU;
+  const AliasEntry* m_aliasV;
+};
+
+#endif // ENVIRONMENT_CACHE_H
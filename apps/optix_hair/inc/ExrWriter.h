@@ -0,0 +1,54 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef EXR_WRITER_H
+#define EXR_WRITER_H
+
+#include <string>
+
+// OpenEXR scanline compression methods. The values are the ones stored in the file.
+// PIZ and the lossy DWA methods are not implemented.
+enum ExrCompression
+{
+  EXR_COMPRESSION_NONE = 0,
+  EXR_COMPRESSION_RLE  = 1,
+  EXR_COMPRESSION_ZIPS = 2, // Deflate, one scanline per block.
+  EXR_COMPRESSION_ZIP  = 3  // Deflate, 16 scanlines per block. Best ratio, the default.
+};
+
+// Write a scanline OpenEXR file with the R, G, B, A channels of the float4 rgba buffer and an optional
+// single float channel, e.g. the variance buffer, named extraName. Both buffers have width * height elements
+// with the bottom row first, like the output buffers. The channels are stored as half or float.
+// The scanline blocks are converted and compressed in parallel on the ThreadPool.
+bool writeEXR(std::string const& filename, const unsigned int width, const unsigned int height,
+              const float* rgba, const float* extra, std::string const& extraName,
+              const bool half, const ExrCompression compression);
+
+#endif // EXR_WRITER_H
@@ -0,0 +1,74 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef GEOMETRY_REGISTRY_H
+#define GEOMETRY_REGISTRY_H
+
+#include "inc/SceneGraph.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Content addressed store of Triangles geometries.
+// Geometries with identical attributes and indices are represented by the first one registered,
+// so that instances of the same mesh share one node and the devices build only one GAS for it.
+// Curves are not registered, the GUI edits hair geometries in place.
+class GeometryRegistry
+{
+public:
+  GeometryRegistry();
+
+  // Hash of the attribute and index data. Thread safe, only reads the geometry.
+  static uint64_t hashContent(sg::Triangles const& geometry);
+
+  // Returns the registered geometry with the same content or registers and returns the given one.
+  // The hash must be hashContent(*geometry), candidates with equal hashes are compared byte by byte.
+  std::shared_ptr<sg::Triangles> acquire(std::shared_ptr<sg::Triangles> const& geometry, const uint64_t hash);
+
+  // Acquires all Triangles of the geometries table, indexed by the geometry ID, and replaces the duplicates by the shared geometry.
+  // The entries keep their index, so IDs stored elsewhere resolve to the shared geometry. Entries whose node ID differs from
+  // their index are shared already. The instances below the roots, also in groups not instanced yet, are redirected.
+  // The hashes are calculated in parallel, the registry is filled in ID order to keep the result deterministic.
+  void share(std::vector< std::shared_ptr<sg::Node> >& geometries, std::vector< std::shared_ptr<sg::Group> > const& roots);
+
+  void clear();
+
+  size_t getNumRegistered() const;
+  size_t getNumShared() const; // Number of acquire() calls which returned an already registered geometry.
+
+private:
+  std::unordered_multimap< uint64_t, std::shared_ptr<sg::Triangles> > m_triangles;
+
+  size_t m_numShared;
+};
+
+#endif // GEOMETRY_REGISTRY_H
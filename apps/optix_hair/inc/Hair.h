@@ -68,8 +68,6 @@ namespace sg
         void createHairFromFile(const std::string& fileName);
         void createHairFromFile(const std::string& fileName, const bool side);
 
-        sg::NodeType getType() const;
-
         void setAttributes(std::vector<VertexAttributes> const& attributes);
         std::vector<VertexAttributes> const& getAttributes() const;
 
@@ -79,12 +77,16 @@ namespace sg
         void setThickness(std::vector<float> const&);
         std::vector<float> const& getThickness() const;
 
+        // Binary scene snapshots, see SceneSnapshot.h.
+        void writeSnapshot(SnapshotWriter& writer) const;
+        bool readSnapshot(SnapshotReader& reader);
+
         virtual ~Curves();
 
         // Factory method for loading Hair from file.
         // static Hair Load( const std::string& fileName, const OptixDeviceContext context );
 
-        void       setSplineMode(SplineMode splineMode) { m_splineMode = splineMode; };
+        void       setSplineMode(SplineMode splineMode) { m_splineMode = splineMode; setChanged(CHANGE_GEOMETRY); };
         SplineMode splineMode() const { return m_splineMode; };
 
         //void  setShadeMode( Shade shadeMode ) { m_shadeMode = shadeMode; };
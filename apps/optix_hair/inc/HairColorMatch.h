@@ -0,0 +1,70 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef HAIR_COLOR_MATCH_H
+#define HAIR_COLOR_MATCH_H
+
+#include "inc/HairSwatch.h"
+
+#include <vector>
+
+struct HairColorCandidate
+{
+  MaterialGUI material;
+  float3      color; // Estimated linear RGB swatch color.
+  float       error; // CIELAB delta E against the target.
+};
+
+// Inverse color matching: Finds the hair material parameters whose HairSwatch estimate is closest to a target color.
+// The discrete candidates (HT level and dye slider positions as set in the GUI) are prepared by the caller
+// and evaluated exhaustively in parallel. The best ones can optionally be refined in the continuous melanin parameters.
+class HairColorMatch
+{
+public:
+  HairColorMatch(HairSwatch& hairSwatch);
+  ~HairColorMatch();
+
+  // target is a linear RGB color. Returns up to numResults candidates, best first.
+  std::vector<HairColorCandidate> match(float3 const& target,
+                                        std::vector<MaterialGUI> const& candidates,
+                                        const size_t numResults,
+                                        const bool refineMelanin);
+
+  // CIELAB delta E 1976 between two linear RGB colors with sRGB primaries and D65 white.
+  static float deltaE(float3 const& a, float3 const& b);
+
+private:
+  void refine(float3 const& target, HairColorCandidate& candidate);
+
+private:
+  HairSwatch& m_hairSwatch;
+};
+
+#endif // HAIR_COLOR_MATCH_H
@@ -0,0 +1,113 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef HAIR_SWATCH_H
+#define HAIR_SWATCH_H
+
+#include "shaders/vector_math.h"
+
+#include "inc/MaterialGUI.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Fast analytic color estimate of a hair swatch on the CPU.
+// Integrates the same longitudinal (M) and azimuthal (N) lobes as bcsdf_hair.cu over a fixed preview environment
+// (uniform dome plus a key light next to the viewer) and a distribution of fiber orientations.
+// Everything which does not depend on the absorption is tabulated once per roughness and cuticle tilt,
+// so evaluating a new dye, melanin or HT setting costs a few thousand expf() and takes well below a millisecond.
+class HairSwatch
+{
+public:
+  HairSwatch();
+  ~HairSwatch();
+
+  // Approximate linear RGB color of a hair swatch with the given material parameters.
+  // Normalized so that fibers without any absorption result in 1.0f.
+  float3 evaluate(MaterialGUI const& materialGUI);
+
+  // Evaluate many swatches in parallel on the ThreadPool. colors is resized to materialsGUI.size().
+  // Any number of distinct roughness and tilt settings is fine, the tables are looked up once per swatch before the evaluation.
+  void evaluate(std::vector<MaterialGUI> const& materialsGUI, std::vector<float3>& colors);
+
+  // True when evaluate() returns the same color for both materials, which means all parameters it reads are equal.
+  static bool isEquivalent(MaterialGUI const& a, MaterialGUI const& b);
+
+  // The dye absorption coefficient as set in Device::updateMaterial(). Melanin absorption is added per fiber.
+  static float3 getDyeAbsorption(MaterialGUI const& materialGUI);
+
+private:
+  // Absorption independent lobe weights per fiber orientation and offset h, integrated over all incident directions.
+  struct Table
+  {
+    float betaM;
+    float betaN;
+    float scaleAngleDeg;
+
+    std::vector<float> weightR;
+    std::vector<float> weightTT;
+    std::vector<float> weightTRT;
+    std::vector<float> fresnel;    // Fresnel reflectance at the entry point.
+    std::vector<float> pathLength; // Transmission path length 2 * cos(gammaT) / cos(thetaT) in units of the fiber radius.
+    float              normalization; // Reciprocal of the integral for zero absorption.
+  };
+
+  // Key of the table cache.
+  struct TableKey
+  {
+    bool operator<(TableKey const& rhs) const;
+
+    float betaM;
+    float betaN;
+    float scaleAngleDeg;
+  };
+
+  // Cached table with the value of m_tableUse at its last lookup.
+  struct TableEntry
+  {
+    std::shared_ptr<Table const> table;
+    unsigned long long           lastUse;
+  };
+
+  std::shared_ptr<Table const> getTable(MaterialGUI const& materialGUI);
+  std::shared_ptr<Table> buildTable(const float betaM, const float betaN, const float scaleAngleDeg) const;
+
+  float3 integrate(Table const& table, float3 const& absorption) const;
+  float3 evaluate(MaterialGUI const& materialGUI, Table const& table) const;
+
+private:
+  std::mutex                     m_mutexTables;
+  std::map<TableKey, TableEntry> m_tables;   // The least recently used table is evicted when the cache is full.
+  unsigned long long             m_tableUse; // Incremented with each lookup.
+};
+
+#endif // HAIR_SWATCH_H
@@ -0,0 +1,50 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef HALF_FLOAT_H
+#define HALF_FLOAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// IEEE 754 binary16 conversions. Round to nearest even, denormals, infinities and NaN are preserved.
+uint16_t floatToHalf(const float value);
+float    halfToFloat(const uint16_t value);
+
+// Array conversions. Uses F16C when the CPU supports it, detected at runtime, and the ThreadPool for big arrays.
+// With saturate set, values beyond the half range are clamped to +-65504 and NaN turns into zero,
+// which is what texture and image storage needs. Without it, they turn into infinities like the hardware conversion.
+void floatToHalf(const float* src, uint16_t* dst, const size_t count, const bool saturate = false);
+void halfToFloat(const uint16_t* src, float* dst, const size_t count);
+
+// True when the F16C path is used.
+bool isHalfConversionAccelerated();
+
+#endif // HALF_FLOAT_H
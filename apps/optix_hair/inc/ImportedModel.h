@@ -0,0 +1,82 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef IMPORTED_MODEL_H
+#define IMPORTED_MODEL_H
+
+// For the vector types.
+#include <cuda_runtime.h>
+
+#include "shaders/vertex_attributes.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Plain data result of a model file import after the mesh optimization stage, independent of the ASSIMP data structures.
+// Built on a ThreadPool worker by Application::importASSIMP(), turned into scene graph nodes on the main thread by Application::createASSIMP().
+
+struct ImportedMesh
+{
+  ImportedMesh();
+
+  std::vector<VertexAttributes> attributes; // Empty when the mesh has no triangles, it doesn't get a geometry then.
+  std::vector<unsigned int>     indices;    // Three per triangle.
+
+  std::string material;   // Name of the material, matched against the material references of the scene description.
+  bool        hasDiffuse; // The material defines a diffuse color.
+  float3      diffuse;
+};
+
+struct ImportedNode
+{
+  ImportedNode();
+
+  float                     matrix[12]; // Row-major 3x4 transformation relative to the parent.
+  std::vector<unsigned int> meshes;     // Indices into ImportedModel::meshes.
+  std::vector<unsigned int> children;   // Indices into ImportedModel::nodes.
+};
+
+struct ImportedModel
+{
+  ImportedModel();
+
+  // Binary mesh cache file written with the SnapshotWriter. The key identifies the source file and the import settings.
+  // Meshes with up to 65536 vertices are stored with 16-bit indices.
+  bool save(std::string const& filename, const uint64_t key) const;
+  bool load(std::string const& filename, const uint64_t key);
+
+  std::vector<ImportedMesh> meshes;
+  std::vector<ImportedNode> nodes; // The root node is nodes[0].
+
+  bool isCached; // Loaded from the mesh cache.
+};
+
+#endif // IMPORTED_MODEL_H
@@ -0,0 +1,49 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef LOW_DISCREPANCY_TABLES_H
+#define LOW_DISCREPANCY_TABLES_H
+
+#include <vector>
+
+// Host side generation of the tables used by the low-discrepancy samplers in shaders/low_discrepancy.h.
+
+// Sobol direction matrices, LD_SOBOL_BITS entries per dimension, most significant bit is the first digit.
+// Dimension 0 is the identity (van der Corput), higher dimensions use the Joe-Kuo primitive polynomials. At most 8 dimensions.
+void generateSobolMatrices(const unsigned int numDimensions, std::vector<unsigned int>& matrices);
+
+// Tileable blue-noise values in [0, 1) of size * size texels, generated with the void-and-cluster method. Size must be a power of two.
+void generateBlueNoise(const int size, const unsigned int seed, std::vector<float>& values);
+
+// Process wide tables with the shader sizes LD_SOBOL_DIMENSIONS and LD_BLUE_NOISE_SIZE. Generated on first use, shared by all devices.
+std::vector<unsigned int> const& getSobolMatrices();
+std::vector<float> const&        getBlueNoise();
+
+#endif // LOW_DISCREPANCY_TABLES_H
@@ -34,11 +34,11 @@
 #include "shaders/function_indices.h"
 
 #include <string>
+#include <type_traits>
 
- // Host side GUI material parameters 
-struct MaterialGUI
+ // Host side GUI material parameters. Plain data only, scene snapshots store them as one block.
+struct MaterialParameters
 {
-  std::string   name;             // The name used in the scene description to identify this material instance.
   FunctionIndex indexBSDF;        // BSDF index to use in the closest hit program.
   float3        albedo;           // Tint, throughput change for specular materials.
   float3        absorptionColor;  // absorptionColor and absorptionScale together build the absorption coefficient
@@ -100,4 +100,11 @@ struct MaterialGUI
    bool shouldModify{ false };
 };
 
+static_assert(std::is_trivially_copyable<MaterialParameters>::value, "MaterialParameters must stay plain data, see writeMaterialGUI().");
+
+struct MaterialGUI : MaterialParameters
+{
+  std::string name; // The name used in the scene description to identify this material instance.
+};
+
 #endif // MATERIAL_GUI_H
@@ -0,0 +1,54 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+// For the vector types.
+#include <cuda_runtime.h>
+
+#include "shaders/vertex_attributes.h"
+
+#include <cstddef>
+#include <vector>
+
+// Host side optimizations of indexed triangle meshes, applied to imported models before they become sg::Triangles.
+// The index vectors hold three indices per triangle.
+
+// Merges vertices with bitwise identical attributes and rewrites the indices. Returns the number of removed vertices.
+size_t weldVertices(std::vector<VertexAttributes>& attributes, std::vector<unsigned int>& indices);
+
+// Reorders the triangles for the post-transform vertex cache (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+void optimizeVertexCache(std::vector<unsigned int>& indices, const size_t numVertices);
+
+// Reorders the vertices by their first use in the index stream and drops unreferenced vertices.
+void optimizeVertexFetch(std::vector<VertexAttributes>& attributes, std::vector<unsigned int>& indices);
+
+#endif // MESH_OPTIMIZER_H
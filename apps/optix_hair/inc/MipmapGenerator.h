@@ -0,0 +1,56 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef MIPMAP_GENERATOR_H
+#define MIPMAP_GENERATOR_H
+
+#include <string>
+
+class Picture;
+
+enum MipmapFilter
+{
+  MIPMAP_FILTER_BOX    = 0, // Area weighted average of the source footprint.
+  MIPMAP_FILTER_KAISER = 1  // Kaiser windowed sinc. Sharper, less aliasing, slight ringing.
+};
+
+// Generate the mipmap chain of the image indexImage of the picture from its LOD 0 down to 1x1 via Picture::addLevel().
+// 8-bit color channels are filtered in linear space when sRGB is set. Alpha is always linear.
+// Only non-layered 2D images with unsigned byte, unsigned short, or float components are supported.
+// When cacheFilename is not empty, the generated levels are read from or written to that file.
+// Returns the number of levels including LOD 0, or 0 when the image is not supported.
+unsigned int generateMipmaps(Picture* picture, const unsigned int indexImage, const MipmapFilter filter, const bool sRGB,
+                             std::string const& cacheFilename = std::string());
+
+// Generates the mipmaps of synthetic size x size images for all supported filter and encoding combinations
+// and prints the best time of three runs in milliseconds per megapixel of the LOD 0.
+void benchmarkMipmaps(const unsigned int size);
+
+#endif // MIPMAP_GENERATOR_H
@@ -0,0 +1,142 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace sg
+{
+
+  // Allocates scene graph nodes together with their shared_ptr control blocks from large memory blocks.
+  // That replaces one heap allocation per node with a pointer increment while a scene is built and keeps the nodes of a scene close in memory.
+  // The memory of single nodes is not reused, the blocks are released when the arena and the last node allocated from it are destroyed.
+  // Creating nodes is not thread safe, the nodes are created on the main thread. They can be released on any thread.
+  class NodeArena
+  {
+  public:
+    NodeArena(const size_t sizeBlock = 1 << 20);
+    ~NodeArena();
+
+    NodeArena(NodeArena const&) = delete;
+    NodeArena& operator=(NodeArena const&) = delete;
+
+    // When disabled create() falls back to std::make_shared().
+    void setEnabled(const bool enabled);
+    bool isEnabled() const;
+
+    template <typename T, typename... Args>
+    std::shared_ptr<T> create(Args&&... args)
+    {
+      if (!m_enabled)
+      {
+        return std::make_shared<T>(std::forward<Args>(args)...);
+      }
+      return std::allocate_shared<T>(Allocator<T>(m_blocks), std::forward<Args>(args)...);
+    }
+
+    size_t getNumBytes() const; // Allocated from the blocks so far.
+
+  private:
+    // Reference counted by the arena and every node allocated from it.
+    class Blocks
+    {
+    public:
+      Blocks(const size_t sizeBlock);
+
+      void* allocate(const size_t size, const size_t alignment);
+      void  release();
+
+      size_t m_sizeBlock;   // Default size of new blocks.
+      size_t m_sizeCurrent; // Of the last block.
+      size_t m_offset;      // Into the last block.
+      size_t m_numBytes;
+
+      std::atomic<size_t> m_refCount;
+
+      std::vector< std::unique_ptr<char[]> > m_blocks;
+    };
+
+    // Stored in the control block of each node. Copying it is free, the reference on the Blocks is taken per allocation.
+    template <typename T>
+    class Allocator
+    {
+    public:
+      typedef T value_type;
+
+      Allocator(Blocks* blocks)
+      : m_blocks(blocks)
+      {
+      }
+
+      template <typename U>
+      Allocator(Allocator<U> const& other)
+      : m_blocks(other.m_blocks)
+      {
+      }
+
+      T* allocate(const size_t n)
+      {
+        return static_cast<T*>(m_blocks->allocate(sizeof(T) * n, alignof(T)));
+      }
+
+      void deallocate(T*, const size_t)
+      {
+        m_blocks->release(); // The memory itself is released with the blocks.
+      }
+
+      template <typename U>
+      bool operator==(Allocator<U> const& other) const
+      {
+        return m_blocks == other.m_blocks;
+      }
+
+      template <typename U>
+      bool operator!=(Allocator<U> const& other) const
+      {
+        return m_blocks != other.m_blocks;
+      }
+
+      Blocks* m_blocks;
+    };
+
+  private:
+    bool    m_enabled;
+    Blocks* m_blocks;
+  };
+
+} // namespace sg
+
+#endif // NODE_ARENA_H
@@ -36,6 +36,7 @@
 
 #include <IL/il.h>
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -51,6 +52,13 @@
 #define IMAGE_FLAG_MIPMAP 0x00000020
 // Special case for a 2D spherical environment map.
 #define IMAGE_FLAG_ENV    0x00000040
+// Color channels of 8-bit images are sRGB encoded. Generated mipmaps are filtered in linear space.
+#define IMAGE_FLAG_SRGB   0x00000080
+// Generate missing mipmaps with the Kaiser filter instead of the box filter. Only with IMAGE_FLAG_MIPMAP.
+#define IMAGE_FLAG_KAISER 0x00000100
+
+// DevIL keeps global state, only one thread may use it at a time. The loader and writer threads lock this around their IL calls.
+std::mutex& getMutexDevIL();
 
 struct Image
 {
@@ -99,6 +107,12 @@ public:
                         const unsigned int width, const unsigned int height, const unsigned int depth, 
                         const int format, const int type);
   
+  // Expand all images to IL_RGBA of the same component type, the layout the textures use on the device.
+  void convertToRGBA();
+
+  // Number of bytes of all images and levels.
+  size_t getMemorySize() const;
+
   // This is needed when generating cubemaps without loading them via DevIL.
   void setIsCubemap(const bool isCube);
 
@@ -107,6 +121,9 @@ public:
   const Image* getImageLevel(unsigned int indexImage, unsigned int indexLevel) const;
   bool         isCubemap() const;
 
+  // The file name of the last successful load(). Empty for generated pictures.
+  std::string const& getFilename() const;
+
   // DEBUG Function to generate all 14 texture targets with RGBA8 images.
   void generateRGBA8(unsigned int width, unsigned int height, unsigned int depth, const unsigned int flags);
 
@@ -118,6 +135,7 @@ private:
 
 private:
   bool m_isCube;                              // Track if the picture is a cube map.
+  std::string m_filename;
   std::vector< std::vector<Image*> > m_images;
 };
 
@@ -0,0 +1,133 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef PICTURE_LOADER_H
+#define PICTURE_LOADER_H
+
+#include "inc/Picture.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Background loading service for Pictures.
+// Worker threads decode the files with DevIL (serialized, DevIL is not thread safe), apply the orientation fixes and
+// mipmap generation inside Picture::load(), and expand all images to the RGBA layout the textures use on the device.
+// Finished Pictures are kept in an LRU cache limited by a memory budget, so requesting the same file again costs no decode.
+// Completion callbacks run on the thread which calls dispatchCompleted(), normally the main loop owning the CUDA contexts.
+class PictureLoader
+{
+public:
+  typedef std::function<void(std::shared_ptr<Picture>)> Callback; // Receives nullptr when loading failed.
+
+  explicit PictureLoader(const unsigned int numThreads = 2, const size_t budget = size_t(512) << 20);
+  ~PictureLoader();
+
+  // Queue a load request. Cache hits and requests of files already in flight do not decode again.
+  void loadAsync(std::string const& filename, const unsigned int flags, Callback const& callback);
+
+  // Blocking load through the cache.
+  std::shared_ptr<Picture> load(std::string const& filename, const unsigned int flags);
+
+  // Run the callbacks of all finished requests on the calling thread. Returns the number of callbacks run.
+  unsigned int dispatchCompleted();
+
+  // Block until all queued requests are decoded. Their callbacks still need dispatchCompleted().
+  void wait();
+
+  bool isBusy() const;
+
+  // Memory budget of the cache in bytes. Pictures still referenced by the caller stay alive when evicted.
+  void   setBudget(const size_t budget);
+  size_t getBudget() const;
+  size_t getCacheSize() const;
+
+  // Drop all queued requests, pending callbacks and cached Pictures.
+  void clear();
+
+private:
+  struct Request
+  {
+    std::string           key;
+    std::string           filename;
+    unsigned int          flags;
+    std::vector<Callback> callbacks;
+  };
+
+  struct Completed
+  {
+    std::shared_ptr<Picture> picture;
+    std::vector<Callback>    callbacks;
+  };
+
+  struct CacheEntry
+  {
+    std::shared_ptr<Picture>         picture;
+    size_t                           size;
+    std::list<std::string>::iterator itLRU;
+  };
+
+  static std::string makeKey(std::string const& filename, const unsigned int flags);
+
+  std::shared_ptr<Picture> decode(std::string const& filename, const unsigned int flags);
+
+  std::shared_ptr<Picture> findCached(std::string const& key); // Requires m_mutex.
+  void insertCached(std::string const& key, std::shared_ptr<Picture> const& picture); // Requires m_mutex.
+  void evict(); // Requires m_mutex.
+
+  void worker();
+
+private:
+  std::vector<std::thread> m_threads;
+
+  mutable std::mutex       m_mutex;
+  std::condition_variable  m_conditionWork;
+  std::condition_variable  m_conditionIdle;
+  bool                     m_stop;
+  unsigned int             m_numActive;
+
+  std::deque<Request>                m_queue;
+  std::map<std::string, Request*>    m_inFlight; // Requests being decoded, to attach further callbacks.
+  std::vector<Completed>             m_completed;
+
+  std::map<std::string, CacheEntry>  m_cache;
+  std::list<std::string>             m_lru;       // Most recently used first.
+  size_t                             m_budget;
+  size_t                             m_cacheSize;
+};
+
+#endif // PICTURE_LOADER_H
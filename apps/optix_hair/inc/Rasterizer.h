@@ -68,6 +68,7 @@ public:
 
   void setResolution(const int w, const int h);
   void setTonemapper(TonemapperGUI const& tm);
+  void setDisplayImage(const float* rgba); // Overwrite the HDR display texture with host RGBA32F data of the current resolution, e.g. a denoised image.
 
 private:
   void checkInfoLog(const char *msg, GLuint object);
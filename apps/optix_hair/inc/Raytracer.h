@@ -75,6 +75,7 @@ public:
   virtual void updateCamera(const int idCamera, CameraDefinition const& camera);
   virtual void updateLight(const int idLight, LightDefinition const& light);
   virtual void updateMaterial(const int idMaterial, MaterialGUI const& src);
+  virtual void updateScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries); // Applies the node changes since the last initScene() or updateScene().
   virtual void updateState(DeviceState const& state);
 
   // Abstract functions must be implemented by each derived Raytracer per strategy individually.
@@ -96,6 +97,8 @@ public:
   unsigned int         m_activeDevicesMask; // The bitmask marking the actually enabled devices.
   std::vector<Device*> m_activeDevices;
 
+  CompiledScene m_compiledScene; // The flattened scene graph shared by all devices. Kept for incremental updates.
+
   unsigned int m_iterationIndex;  // Tracks which frame is currently raytraced.
   unsigned int m_samplesPerPixel; // This is samplesSqrt squared. Rendering end-condition is: m_iterationIndex == m_samplesPerPixel.
 
@@ -41,6 +41,9 @@
 #include <memory>
 #include <vector>
 
+class SnapshotWriter;
+class SnapshotReader;
+
 namespace sg
 {
 
@@ -52,24 +55,70 @@ namespace sg
     NT_CURVES
   };
 
+  // Changes recorded on a node since the last scene compilation. CompiledScene::update() consumes and clears them.
+  // Replacing a geometry node is detected by the node identity, CHANGE_GEOMETRY marks in place edits of its data.
+  enum ChangeFlags
+  {
+    CHANGE_NONE       = 0,
+    CHANGE_ACTIVATION = 1 << 0,
+    CHANGE_TRANSFORM  = 1 << 1,
+    CHANGE_CHILD      = 1 << 2, // Instance child replaced or Group children added or removed.
+    CHANGE_MATERIAL   = 1 << 3,
+    CHANGE_LIGHT      = 1 << 4,
+    CHANGE_GEOMETRY   = 1 << 5
+  };
+
+  // The node type is a tag set by the derived class, there are no virtual functions.
+  // Code switching over the node types uses static casts, see SceneVisitor.h.
   class Node
   {
   public:
-    Node(const unsigned int id);
+    Node(const unsigned int id, const sg::NodeType type);
     //~Node();
 
-    virtual sg::NodeType getType() const = 0;
+    sg::NodeType getType() const
+    {
+      return m_type;
+    }
     
     unsigned int getId() const
     {
       return m_id;
     }
-    bool is_activated() { return activated; }
-    void set_activation (bool v) {  activated = v; }
+    void setId(const unsigned int id) // Only while the host scene is built, before any device knows the node.
+    {
+      m_id = id;
+    }
+    bool is_activated() const { return activated; }
+    void set_activation (bool v)
+    {
+      if (activated != v)
+      {
+        activated = v;
+        setChanged(CHANGE_ACTIVATION);
+      }
+    }
+
+    unsigned int getChanges() const
+    {
+      return m_changes;
+    }
+    void clearChanges()
+    {
+      m_changes = CHANGE_NONE;
+    }
+
+  protected:
+    void setChanged(const unsigned int flags)
+    {
+      m_changes |= flags;
+    }
 
   private:
     unsigned int m_id;
+    sg::NodeType m_type;
     bool activated;
+    unsigned int m_changes;
   };
 
 
@@ -79,8 +128,6 @@ namespace sg
     Triangles(const unsigned int id);
     //~Triangles();
 
-    sg::NodeType getType() const;
-
     void createBox();
     void createPlane(const unsigned int tessU, const unsigned int tessV, const unsigned int upAxis);
     void createSphere(const unsigned int tessU, const unsigned int tessV, const float radius, const float maxTheta);
@@ -93,6 +140,10 @@ namespace sg
     void setIndices(std::vector<unsigned int> const&);
     std::vector<unsigned int> const& getIndices() const;
 
+    // Binary scene snapshots, see SceneSnapshot.h.
+    void writeSnapshot(SnapshotWriter& writer) const;
+    bool readSnapshot(SnapshotReader& reader);
+
   private:
     std::vector<VertexAttributes> m_attributes;
     std::vector<unsigned int>       m_indices; // If m_indices.size() == 0, m_attributes are independent primitives.
@@ -105,13 +156,11 @@ namespace sg
     Instance(const unsigned int id);
     //~Instance();
 
-    sg::NodeType getType() const;
-
     void setTransform(const float m[12]);
     const float* getTransform() const;
     
     void setChild(std::shared_ptr<sg::Node> node);
-    std::shared_ptr<sg::Node> getChild();
+    std::shared_ptr<sg::Node> const& getChild() const; // By reference, traversals don't touch the reference counts.
 
     void setMaterial(const int index);
     int  getMaterial() const;
@@ -132,12 +181,10 @@ namespace sg
     Group(const unsigned int id);
     //~Group();
 
-    sg::NodeType getType() const;
-
     void addChild(std::shared_ptr<sg::Instance> instance); // Groups can only hold Instances.
     void removeCurvesChild();
     size_t getNumChildren() const;
-    std::shared_ptr<sg::Instance> getChild(size_t index);
+    std::shared_ptr<sg::Instance> const& getChild(size_t index) const;
 
   private:
     std::vector< std::shared_ptr<sg::Instance> > m_children;
@@ -0,0 +1,160 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef SCENE_SNAPSHOT_H
+#define SCENE_SNAPSHOT_H
+
+#include "inc/MappedFile.h"
+#include "inc/NodeArena.h"
+#include "inc/SceneGraph.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary snapshot of the resolved host scene.
+// The file is a header followed by a sequence of plain values, strings and arrays. Array data is 16 byte aligned inside 
+// the file so that a mapped snapshot is copied into the vectors without any parsing, node references are indices.
+// Snapshots are caches for the machine which wrote them. The key identifies the inputs and the data layout.
+
+class SnapshotWriter
+{
+public:
+  SnapshotWriter(const uint64_t key);
+
+  template <typename T>
+  void write(T const& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Snapshot values must be plain data.");
+    writeBytes(&value, sizeof(T));
+  }
+
+  template <typename T>
+  void writeArray(std::vector<T> const& values)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Snapshot arrays must be plain data.");
+    write<uint64_t>(values.size());
+    align();
+    writeBytes(values.data(), sizeof(T) * values.size());
+  }
+
+  void writeString(std::string const& value);
+  void writeBytes(const void* data, const size_t size);
+
+  // Writes to a temporary file first and renames it, concurrent readers never see a partial snapshot.
+  bool save(std::string const& filename) const;
+
+private:
+  void align();
+
+private:
+  std::vector<unsigned char> m_data;
+};
+
+
+class SnapshotReader
+{
+public:
+  SnapshotReader();
+
+  // Maps the file and checks the header against the expected key.
+  bool open(std::string const& filename, const uint64_t key);
+
+  template <typename T>
+  bool read(T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Snapshot values must be plain data.");
+    return readBytes(&value, sizeof(T));
+  }
+
+  template <typename T>
+  bool readArray(std::vector<T>& values)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Snapshot arrays must be plain data.");
+    uint64_t count = 0;
+    if (!read(count))
+    {
+      return false;
+    }
+    align();
+    if (getRemaining() / sizeof(T) < count) // A corrupted count must not overflow sizeof(T) * count below.
+    {
+      m_isValid = false;
+      return false;
+    }
+    const unsigned char* data = consume(sizeof(T) * count);
+    if (data == nullptr)
+    {
+      return false;
+    }
+    values.resize(count);
+    if (count != 0) // values.data() may be null for an empty vector.
+    {
+      memcpy(values.data(), data, sizeof(T) * count);
+    }
+    return true;
+  }
+
+  bool readString(std::string& value);
+  bool readBytes(void* data, const size_t size);
+
+  // False after any read past the end of the file.
+  bool isValid() const;
+
+private:
+  void align();
+  size_t getRemaining() const; // Bytes after the current offset.
+  const unsigned char* consume(const size_t size);
+
+private:
+  MappedFile m_file;
+  size_t     m_offset;
+  bool       m_isValid;
+};
+
+
+// Groups, instances and geometries of the host scene graph. Instances reference their child by index into the 
+// geometries or the group table, the reader creates all nodes first and resolves these indices to the shared pointers.
+void writeSceneGraph(SnapshotWriter& writer,
+                     std::shared_ptr<sg::Group> const& root,
+                     std::vector< std::shared_ptr<sg::Node> > const& geometries,
+                     std::map< std::string, std::shared_ptr<sg::Group> > const& mapGroups);
+
+bool readSceneGraph(SnapshotReader& reader,
+                    sg::NodeArena& arena,
+                    std::shared_ptr<sg::Group>& root,
+                    std::vector< std::shared_ptr<sg::Node> >& geometries,
+                    std::map< std::string, std::shared_ptr<sg::Group> >& mapGroups);
+
+#endif // SCENE_SNAPSHOT_H
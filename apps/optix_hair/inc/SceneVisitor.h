@@ -0,0 +1,92 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef SCENE_VISITOR_H
+#define SCENE_VISITOR_H
+
+#include "inc/SceneGraph.h"
+#include "inc/Hair.h"
+
+namespace sg
+{
+
+  // Calls visitor.visit() with the node cast to its concrete type. The type tag selects the overload, there is no virtual call.
+  // A visitor provides visit(sg::Group&), visit(sg::Instance&), visit(sg::Triangles&) and visit(sg::Curves&)
+  // and decides itself whether to descend, see visitChildren() and visitChild().
+  template <typename V>
+  void dispatch(sg::Node& node, V& visitor)
+  {
+    switch (node.getType())
+    {
+      case NT_GROUP:
+        visitor.visit(static_cast<sg::Group&>(node));
+        break;
+
+      case NT_INSTANCE:
+        visitor.visit(static_cast<sg::Instance&>(node));
+        break;
+
+      case NT_TRIANGLES:
+        visitor.visit(static_cast<sg::Triangles&>(node));
+        break;
+
+      case NT_CURVES:
+        visitor.visit(static_cast<sg::Curves&>(node));
+        break;
+    }
+  }
+
+  // Dispatches all active children. The children are accessed by reference, the traversal doesn't change any reference count.
+  template <typename V>
+  void visitChildren(sg::Group const& group, V& visitor)
+  {
+    for (size_t i = 0; i < group.getNumChildren(); ++i)
+    {
+      sg::Instance& instance = *group.getChild(i);
+      if (instance.is_activated())
+      {
+        visitor.visit(instance);
+      }
+    }
+  }
+
+  template <typename V>
+  void visitChild(sg::Instance const& instance, V& visitor)
+  {
+    sg::Node* child = instance.getChild().get();
+    if (child)
+    {
+      dispatch(*child, visitor);
+    }
+  }
+
+} // namespace sg
+
+#endif // SCENE_VISITOR_H
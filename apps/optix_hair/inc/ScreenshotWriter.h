@@ -0,0 +1,117 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef SCREENSHOT_WRITER_H
+#define SCREENSHOT_WRITER_H
+
+// Always include this before any OptiX headers!
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "inc/ExrWriter.h"
+#include "inc/TonemapperGUI.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Asynchronous screenshot pipeline.
+// capture() copies the output buffer into a snapshot on the calling thread and returns, worker threads tonemap,
+// encode and write the images, so the renderer continues with the next camera view or sample count meanwhile.
+// At most capacity snapshots are in flight, capture() blocks while the queue is full to bound the memory.
+class ScreenshotWriter
+{
+public:
+  explicit ScreenshotWriter(const unsigned int numThreads = 2, const unsigned int capacity = 4);
+  ~ScreenshotWriter(); // Finishes all queued snapshots.
+
+  // Queue one image. The filename is without extension, *.png is tonemapped RGB8, *.exr the linear image
+  // with the optional variance buffer as extra channel. With announce the filename is printed when the file is written.
+  // Returns false when the snapshot could not be queued. Write errors happen later, see getLastFailure().
+  bool capture(std::string const& filename, const float4* rgba, const float* variance, const int2 resolution,
+               const bool tonemap, TonemapperGUI const& tonemapper, const bool exrHalf, const ExrCompression exrCompression,
+               const bool announce = false);
+
+  // Block until all queued snapshots are written.
+  void wait();
+
+  bool isBusy() const;
+
+  // Filename of the last snapshot which failed to write since the previous call, empty when all succeeded. Resets it.
+  std::string getLastFailure();
+
+  // Per stage timings of the snapshots written since the last call, averaged per image. Resets the statistics.
+  std::string getTimings();
+
+private:
+  struct Snapshot
+  {
+    std::string         filename;
+    std::vector<float4> rgba;
+    std::vector<float>  variance;
+    int2                resolution;
+    bool                tonemap;
+    TonemapperGUI       tonemapper;
+    bool                exrHalf;
+    ExrCompression      exrCompression;
+    bool                announce;
+  };
+
+  bool write(Snapshot const& snapshot, double& secondsTonemap, double& secondsWrite);
+
+  void worker();
+
+private:
+  std::vector<std::thread> m_threads;
+  unsigned int             m_capacity;
+
+  mutable std::mutex       m_mutex;
+  std::condition_variable  m_conditionWork;
+  std::condition_variable  m_conditionSpace; // A queue slot got free.
+  std::condition_variable  m_conditionIdle;
+  bool                     m_stop;
+  unsigned int             m_numActive;
+
+  std::deque<Snapshot>     m_queue;
+  std::string              m_lastFailure;
+
+  // Statistics in seconds.
+  unsigned int m_numWritten;
+  unsigned int m_numFailed;
+  double       m_timeCapture;  // Copying the buffers on the calling thread.
+  double       m_timeStall;    // Calling thread blocked on a full queue.
+  double       m_timeTonemap;
+  double       m_timeWrite;    // Encoding and writing the file.
+};
+
+#endif // SCREENSHOT_WRITER_H
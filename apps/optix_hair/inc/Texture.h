@@ -35,6 +35,7 @@
 #include <cuda.h>
 #include <cuda_runtime.h>
 
+#include "inc/BlockCompression.h"
 #include "inc/Picture.h"
 
 #include <string>
@@ -100,6 +101,8 @@
 #define ENC_TYPE_INT            ( 4u << ENC_TYPE_SHIFT)
 #define ENC_TYPE_UNSIGNED_INT   ( 5u << ENC_TYPE_SHIFT)
 #define ENC_TYPE_FLOAT          ( 6u << ENC_TYPE_SHIFT)
+// Device only. Converted via float, there are no remappers for it.
+#define ENC_TYPE_HALF           ( 7u << ENC_TYPE_SHIFT)
 #define ENC_TYPE_UNDEFINED      (15u << ENC_TYPE_SHIFT)
 
 // Flags to indicate that special handling is required.
@@ -126,6 +129,11 @@ public:
   void setNormalizedCoords(bool normalized);
   void setMaxAnisotropy(unsigned int aniso);
   void setMipmapLevelBiasMinMax(float bias, float minimum, float maximum);
+  // Block compress non-layered 2D textures (BC1, BC3, BC5, BC7) and environment textures (BC6H) during create().
+  // Falls back to the uncompressed format when the image or the CUDA version doesn't support it.
+  void setBlockFormat(BlockFormat format);
+  // Store float images, including the spherical environment, as half floats (CU_AD_FORMAT_HALF) during create().
+  void setHalfFloat(bool half);
  
   bool create(const Picture* picture, const unsigned int flags);
   bool update(const Picture* picture);
@@ -139,10 +147,13 @@ public:
   // Specific to spherical environment map.
   
   // Create cumulative distribution function for importance sampling of spherical environment lights. Call last.
-  void calculateSphericalCDF(const float* rgba);
+  // When the environment's image filename is given, the result is read from or written to a disk cache next to it.
+  void calculateSphericalCDF(const float* rgba, std::string const& filename = std::string());
   
   CUdeviceptr getCDF_U() const;
   CUdeviceptr getCDF_V() const;
+  CUdeviceptr getAlias_U() const; // AliasEntry per texel, one conditional distribution per row.
+  CUdeviceptr getAlias_V() const; // AliasEntry per row, the marginal distribution.
   float       getIntegral() const;
 
 private:
@@ -158,6 +169,10 @@ private:
   bool updateCube(const Picture* picture);
   bool updateEnv(const Picture* picture);
 
+  bool createCompressedArray(const Picture* picture, const void* dataLevel0);
+
+  void uploadBuffer(CUdeviceptr& d_buffer, const void* data, const size_t sizeBytes);
+
 private:
   unsigned int m_width;
   unsigned int m_height;
@@ -179,9 +194,15 @@ private:
   CUarray          m_d_array;
   CUmipmappedArray m_d_mipmappedArray;
 
+  BlockFormat m_blockFormat;  // Requested block compression.
+  bool        m_isCompressed; // The arrays hold block compressed data.
+  bool        m_halfFloat;    // Requested half float storage of float images.
+
   // Specific to spherical environment map.
   CUdeviceptr m_d_envCDF_U;
   CUdeviceptr m_d_envCDF_V;
+  CUdeviceptr m_d_envAlias_U;
+  CUdeviceptr m_d_envAlias_V;
   float       m_integral;
 };
 
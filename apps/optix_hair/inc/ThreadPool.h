@@ -0,0 +1,85 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads for the host side CPU work (image conversions, color estimation, file encoding, etc.)
+// The process wide instance is returned by getInstance() and uses all hardware threads.
+class ThreadPool
+{
+public:
+  explicit ThreadPool(unsigned int numThreads = 0); // 0 means std::thread::hardware_concurrency().
+  ~ThreadPool();
+
+  static ThreadPool& getInstance();
+
+  unsigned int getNumThreads() const;
+
+  // Run a function on a worker thread. The returned future delivers the result or rethrows the exception.
+  template<typename F>
+  auto submit(F&& func) -> std::future<decltype(func())>
+  {
+    using Result = decltype(func());
+
+    auto task = std::make_shared< std::packaged_task<Result()> >(std::forward<F>(func));
+    std::future<Result> future = task->get_future();
+    enqueue([task]() { (*task)(); });
+    return future;
+  }
+
+  // Split the index range [begin, end) into chunks of at most grain indices and call body(first, last) for each chunk in parallel.
+  // The calling thread participates in the work and returns when all chunks are done.
+  // Safe to call from inside a worker thread, nested calls simply run on fewer threads.
+  void parallelFor(const size_t begin, const size_t end, const size_t grain, std::function<void(size_t, size_t)> const& body);
+
+private:
+  void enqueue(std::function<void()>&& job);
+  void worker();
+
+private:
+  std::vector<std::thread>          m_threads;
+  std::queue< std::function<void()> > m_jobs;
+  std::mutex                        m_mutex;
+  std::condition_variable           m_condition;
+  bool                              m_stop;
+};
+
+#endif // THREAD_POOL_H
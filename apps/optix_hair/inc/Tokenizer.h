@@ -0,0 +1,90 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include "inc/MappedFile.h"
+
+#include <string>
+#include <string_view>
+
+enum ParserTokenType
+{
+  PTT_UNKNOWN, // Unknown, normally indicates an error.
+  PTT_ID,      // Keywords, identifiers (not a number).
+  PTT_VAL,     // Immediate floating point value.
+  PTT_STRING,  // Filenames and any other identifiers in quotation marks.
+  PTT_EOL,     // End of line.
+  PTT_EOF      // End of file.
+};
+
+
+// Tokenizer shared by the system, scene and configuration file parsers.
+// The file is memory mapped and tokens are returned as views into it, so scanning doesn't allocate.
+class Tokenizer
+{
+public:
+  Tokenizer();
+  //~Tokenizer();
+
+  bool load(std::string const& filename);
+  void setSource(std::string const& source); // Tokenize a copy of an in-memory description.
+
+  // The view stays valid until the next load() or setSource().
+  ParserTokenType getNextToken(std::string_view& token);
+  // Copies the token, which reuses the capacity of the string in parse loops.
+  ParserTokenType getNextToken(std::string& token);
+
+  size_t                 getSize() const;
+  std::string::size_type getIndex() const;
+  unsigned int           getLine() const;   // One-based line of the last token.
+  unsigned int           getColumn() const; // One-based column of the last token.
+  std::string            getLocation() const; // "filename(line,column)" for error messages.
+
+private:
+  MappedFile             m_file;
+  std::string            m_buffer;     // Owned contents when the source is not mapped (setSource() or empty files).
+  std::string_view       m_source;     // System or scene description file contents.
+  std::string            m_filename;
+  std::string::size_type m_index;      // Current character index into m_source.
+  std::string::size_type m_lineStart;  // Index of the first character in the current line.
+  unsigned int           m_line;       // Current source code line, one-based for error messages.
+  unsigned int           m_tokenLine;
+  unsigned int           m_tokenColumn;
+};
+
+// Locale independent number conversions of tokens with std::from_chars.
+// Like atof() and atoi() these skip leading blanks and a '+' sign, convert the longest valid prefix, and return 0 if there is none.
+// Out of range floats return infinity or zero like strtof(), out of range integers saturate like strtol().
+float parseFloat(std::string_view token);
+int   parseInt(std::string_view token);
+
+#endif // TOKENIZER_H
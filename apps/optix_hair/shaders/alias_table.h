@@ -0,0 +1,95 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include "config.h"
+
+// Walker/Vose alias table entry for O(1) sampling of a discrete distribution.
+// Built on the host, see inc/AliasTable.h.
+struct AliasEntry
+{
+  float threshold; // Probability to keep this bin inside its 1/count slot, otherwise switch to the alias.
+  int   alias;     // Bin index used when the slot's remainder is hit.
+  float pmf;       // Normalized probability of this bin, needed to weight the selected sample.
+};
+
+// Select a bin with probability table[i].pmf using a single uniform sample u in [0, 1).
+__forceinline__ __host__ __device__ int sampleAliasTable(const AliasEntry* table, const int count, const float u, float& pmf)
+{
+  const float scaled = u * float(count);
+
+  int index = int(scaled);
+  if (count <= index) // Guard against u rounding up to 1.0f.
+  {
+    index = count - 1;
+  }
+
+  if (table[index].threshold <= scaled - float(index))
+  {
+    index = table[index].alias;
+  }
+
+  pmf = table[index].pmf;
+  return index;
+}
+
+// Same selection as above, for continuous distributions.
+// The uniform sample is consumed and replaced with the remainder inside the selected slot, rescaled to [0, 1).
+// This can be used as position inside the selected bin.
+__forceinline__ __host__ __device__ int sampleAliasTableContinuous(const AliasEntry* table, const int count, float& u)
+{
+  const float scaled = u * float(count);
+
+  int index = int(scaled);
+  if (count <= index) // Guard against u rounding up to 1.0f.
+  {
+    index = count - 1;
+  }
+
+  const float threshold = table[index].threshold;
+  const float remainder = scaled - float(index);
+
+  if (remainder < threshold)
+  {
+    u = remainder / threshold;
+  }
+  else
+  {
+    u = (remainder - threshold) / (1.0f - threshold);
+    index = table[index].alias;
+  }
+
+  u = (u < 0.99999994f) ? u : 0.99999994f; // Stay inside the bin.
+  return index;
+}
+
+#endif // ALIAS_TABLE_H
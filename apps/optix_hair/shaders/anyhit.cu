@@ -37,40 +37,56 @@
 #include "material_definition.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
+#include "texture_lod.h"
 
 
 extern "C" __constant__ SystemData sysData;
 
 
-// One anyhit program for the radiance ray for all materials with cutout opacity!
-extern "C" __global__ void __anyhit__radiance_cutout()
+// Cutout opacity of the current triangle hit. The texture is filtered with the ray cone footprint at the hit distance.
+__forceinline__ __device__ float cutoutOpacity(MaterialDefinition const& material, GeometryInstanceData const* theData, PerRayData const* thePrd)
 {
-  GeometryInstanceData* theData = reinterpret_cast<GeometryInstanceData*>(optixGetSbtDataPointer());
+  // Cast the CUdeviceptr to the actual format for Triangles geometry.
+  const uint3*            indices    = reinterpret_cast<uint3*>(theData->indices);
+  const VertexAttributes* attributes = reinterpret_cast<VertexAttributes*>(theData->attributes);
 
-  MaterialDefinition const& material = sysData.materialDefinitions[theData->materialIndex];
+  const uint3 tri = indices[optixGetPrimitiveIndex()];
 
-  if (material.textureCutout != 0)
-  {
-    // Cast the CUdeviceptr to the actual format for Triangles geometry.
-    const uint3*              indices    = reinterpret_cast<uint3*>(theData->indices);
-    const VertexAttributes* attributes = reinterpret_cast<VertexAttributes*>(theData->attributes);
+  VertexAttributes const& attr0 = attributes[tri.x];
+  VertexAttributes const& attr1 = attributes[tri.y];
+  VertexAttributes const& attr2 = attributes[tri.z];
 
-    const unsigned int thePrimitiveIndex = optixGetPrimitiveIndex();
+  const float2 theBarycentrics = optixGetTriangleBarycentrics(); // beta and gamma
+  const float  alpha = 1.0f - theBarycentrics.x - theBarycentrics.y;
 
-    const uint3 tri = indices[thePrimitiveIndex];
-    
-    const float2 theBarycentrics = optixGetTriangleBarycentrics(); // beta and gamma
+  const float3 texcoord = attr0.texcoord * alpha +
+                          attr1.texcoord * theBarycentrics.x +
+                          attr2.texcoord * theBarycentrics.y;
 
-    const float  alpha = 1.0f - theBarycentrics.x - theBarycentrics.y;
+  const float lod = rayConeTriangleLod(optixTransformVectorFromObjectToWorldSpace(attr1.vertex - attr0.vertex),
+                                       optixTransformVectorFromObjectToWorldSpace(attr2.vertex - attr0.vertex),
+                                       make_float2(attr1.texcoord - attr0.texcoord),
+                                       make_float2(attr2.texcoord - attr0.texcoord),
+                                       optixGetWorldRayDirection(),
+                                       thePrd->coneWidth + thePrd->coneSpread * optixGetRayTmax());
 
-    const float3 texcoord = attributes[tri.x].texcoord * alpha +
-                            attributes[tri.y].texcoord * theBarycentrics.x +
-                            attributes[tri.z].texcoord * theBarycentrics.y;
+  return intensity(make_float3(tex2DLod<float4>(material.textureCutout, texcoord.x, texcoord.y, lod + material.lodCutout)));
+}
 
-    const float opacity = intensity(make_float3(tex2D<float4>(material.textureCutout, texcoord.x, texcoord.y)));
 
+// One anyhit program for the radiance ray for all materials with cutout opacity!
+extern "C" __global__ void __anyhit__radiance_cutout()
+{
+  GeometryInstanceData* theData = reinterpret_cast<GeometryInstanceData*>(optixGetSbtDataPointer());
+
+  MaterialDefinition const& material = sysData.materialDefinitions[theData->materialIndex];
+
+  if (material.textureCutout != 0)
+  {
     PerRayData* thePrd = mergePointer(optixGetPayload_0(), optixGetPayload_1());
 
+    const float opacity = cutoutOpacity(material, theData, thePrd);
+
     // Stochastic alpha test to get an alpha blend effect.
     if (opacity < 1.0f && opacity <= rng(thePrd->seed)) // No need to calculate an expensive random number if the test is going to fail anyway.
     {
@@ -107,28 +123,15 @@ extern "C" __global__ void __anyhit__shadow_cutout()
 
   MaterialDefinition const& material = sysData.materialDefinitions[theData->materialIndex];
 
+  PerRayData* thePrd = mergePointer(optixGetPayload_0(), optixGetPayload_1());
+
   float opacity = 1.0f;
 
   if (material.textureCutout != 0)
   {
-    const unsigned int thePrimitiveIndex = optixGetPrimitiveIndex();
-    const uint3* indices = reinterpret_cast<uint3*>(theData->indices);
-    const uint3  tri     = indices[thePrimitiveIndex];
-
-    const VertexAttributes* attributes = reinterpret_cast<VertexAttributes*>(theData->attributes);
-
-    const float2 theBarycentrics = optixGetTriangleBarycentrics(); // beta and gamma
-    const float  alpha = 1.0f - theBarycentrics.x - theBarycentrics.y;
-
-    const float3 texcoord = attributes[tri.x].texcoord * alpha +
-                            attributes[tri.y].texcoord * theBarycentrics.x +
-                            attributes[tri.z].texcoord * theBarycentrics.y;
-
-    opacity = intensity(make_float3(tex2D<float4>(material.textureCutout, texcoord.x, texcoord.y)));
+    opacity = cutoutOpacity(material, theData, thePrd);
   }
 
-  PerRayData* thePrd = mergePointer(optixGetPayload_0(), optixGetPayload_1());
-
   // Stochastic alpha test to get an alpha blend effect.
   if (opacity < 1.0f && opacity <= rng(thePrd->seed)) // No need to calculate an expensive random number if the test is going to fail anyway.
   {
@@ -19,10 +19,14 @@
 
 #include "per_ray_data.h"
 #include "material_definition.h"
+#include "bcsdf_hair_constants.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
+#include "sampler.h"
 #include "curve.h"
 
+extern "C" __constant__ SystemData sysData;
+
 /*rtBuffer<float3> id_values_sop;
 rtBuffer<float3> id_values_cop;*/
 
@@ -106,11 +110,11 @@ extern "C" __device__ void __direct_callable__sample_bcsdf_hair(MaterialDefiniti
 	// Conventional wo correspond to wi in the code
 
 	
-	float h = -1.f + 2.f * rng(prd->seed);//dot(state.normal, cross(state.tangent, state.texcoord)); //
+	float h = -1.f + 2.f * sample1D(sysData, prd);//dot(state.normal, cross(state.tangent, state.texcoord)); //
 	float gammaO = asinf(h);
 
-	float2 xi_N = rng2(prd->seed);
-	float2 xi_M = rng2(prd->seed);
+	float2 xi_N = sample2D(sysData, prd); // .x selects the lobe.
+	float2 xi_M = sample2D(sysData, prd);
 
 	float ior = 1.55f;
 
@@ -120,12 +124,11 @@ extern "C" __device__ void __direct_callable__sample_bcsdf_hair(MaterialDefiniti
 	const float bdwo = dot(prd->wo, normalize(cross(state.texcoord,state.tangent)));
 	float phio = atan2f(prd->wo.x, prd->wo.z);
 
-	float sin2kAlpha0 = sinf(material.scale_angle_rad);
-    float cos2kAlpha0 = trigInverse(sin2kAlpha0);
-	float sin2kAlpha1 = 2.f * cos2kAlpha0 * sin2kAlpha0;
-    float cos2kAlpha1 = cos2kAlpha0*cos2kAlpha0-sin2kAlpha0*sin2kAlpha0;
-	float sin2kAlpha2 = 2.f * cos2kAlpha1 * sin2kAlpha1;
-	float cos2kAlpha2 = cos2kAlpha1 * cos2kAlpha1 - sin2kAlpha1 * sin2kAlpha1;
+	// Scale tilt terms, variance and logistic scale are precalculated per material on the host.
+	const float sin2kAlpha0 = material.sin2kAlpha.x;
+	const float cos2kAlpha0 = material.cos2kAlpha.x;
+	const float sin2kAlpha2 = material.sin2kAlpha.z;
+	const float cos2kAlpha2 = material.cos2kAlpha.z;
 
 
 
@@ -139,12 +142,10 @@ extern "C" __device__ void __direct_callable__sample_bcsdf_hair(MaterialDefiniti
 
 
 	float3 absorption = material.absorption;
-	const float3 absorption_eumelanin = make_float3(0.419f, 0.697f, 1.37f);
-	const float3 absorption_pheomelanin = make_float3(0.187f, 0.4f, 1.05f);
-
-	float melanin_ratio = clamp(material.melanin_ratio * (1.f + material.melanin_ratio_disparity * state.rand.y),0.f,1.f);
-	float melanin_concentration = fmaxf(material.melanin_concentration * (1.f + state.rand.y * material.melanin_concentration_disparity),.0f);
-	absorption += (state.rand.x > material.whitepercen) ? melanin_concentration * lerp(absorption_eumelanin, absorption_pheomelanin, melanin_ratio) : make_float3(0.f);
+	if (state.rand.x > material.whitepercen)
+	{
+		absorption += hairFiberMelaninAbsorption(material, state.rand.y);
+	}
 
 	float3 T = expf(-absorption * 2.f * cosGammaT / cosThetaT);
 
@@ -163,18 +164,14 @@ extern "C" __device__ void __direct_callable__sample_bcsdf_hair(MaterialDefiniti
 	//float lum =  luminance(R)  +luminance(TT) + luminance(TRT)+luminance(TRRT) ;
 	//float4 apsample =  make_float4(luminance(R),luminance(TT),luminance(TRT),luminance(TRRT))/lum;
 
-	const float s = 0.626657069f * (0.265f * material.betaN + 1.194f * (material.betaN * material.betaN) + 5.372f * (material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) *
-		(material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) *
-		(material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN));
+	const float s = material.logisticScale;
 
 	float dphi = SampleTrimmedLogistic(xi_N.y, s, -M_PIf, M_PIf);
 
 	float cosPhi = cosf(2.f * M_PIf * xi_M.y);
 
 	//Sample M
-	const float sqrtv = 0.726f * material.betaM + 0.812f * (material.betaM * material.betaM) + 3.7f * (material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) *
-		(material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) *
-		(material.betaM * material.betaM) * (material.betaM * material.betaM);
+	const float v = material.variance;
 
 	dphi += (xi_N.x < apsample.x) ? Phi(0, gammaO, gammaT) : (xi_N.x < apsample.x + apsample.y) ? Phi(1, gammaO, gammaT) : Phi(2, gammaO, gammaT);
 	float phiI = phio + dphi;
@@ -197,7 +194,7 @@ extern "C" __device__ void __direct_callable__sample_bcsdf_hair(MaterialDefiniti
 
 	float coef = (xi_N.x < apsample.x) ? 1.0f : (xi_N.x < apsample.x + apsample.y) ? 0.25f : 4.f;
 
-	float cosTheta = 1.f + coef * sqrtv * sqrtv * logf(xi_M.x + (1.f - xi_M.x) * expf(-2.f / (coef * sqrtv * sqrtv)));
+	float cosTheta = 1.f + coef * v * logf(xi_M.x + (1.f - xi_M.x) * expf(-2.f / (coef * v)));
 
 	float sinTheta = trigInverse(cosTheta);
 
@@ -216,9 +213,9 @@ extern "C" __device__ void __direct_callable__sample_bcsdf_hair(MaterialDefiniti
 	cosThetaOp1 = fabsf(cosThetaOp1);
 	cosThetaOp2 = fabsf(cosThetaOp2);
 
-	const float M_R = M(sqrtv * sqrtv, sinThetaI, sinThetaOp0, cosThetaI, cosThetaOp0);
-	const float M_TT = M(0.25f * sqrtv * sqrtv, sinThetaI, sinThetaOp1, cosThetaI, cosThetaOp1);
-	const float M_TRT = M(sqrtv * sqrtv * 4.f, sinThetaI, sinThetaOp2, cosThetaI, cosThetaOp2);
+	const float M_R = M(v, sinThetaI, sinThetaOp0, cosThetaI, cosThetaOp0);
+	const float M_TT = M(0.25f * v, sinThetaI, sinThetaOp1, cosThetaI, cosThetaOp1);
+	const float M_TRT = M(4.f * v, sinThetaI, sinThetaOp2, cosThetaI, cosThetaOp2);
 	//const float M_TRRT = M(sqrtv*sqrtv*4.f, sinThetaI, fabsf(sin_theta_o),cosThetaI, fabsf(cos_theta_o));
 
 	const float N_R = Np(dphi, 0, s, gammaO, gammaT);//0.25f*abs(cosf(0.5f*(dphi)));//
@@ -279,12 +276,10 @@ extern "C" __device__ float4 __direct_callable__eval_bcsdf_hair(MaterialDefiniti
 	float phi = phii - phio;
 
 	float3 absorption = material.absorption;
-	const float3 absorption_eumelanin = make_float3(0.419f, 0.697f, 1.37f);
-	const float3 absorption_pheomelanin = make_float3(0.187f, 0.4f, 1.05f);
-
-	float melanin_ratio = clamp(material.melanin_ratio * (1.f + material.melanin_ratio_disparity * state.rand.y), 0.f, 1.f);
-	float melanin_concentration = fmaxf(material.melanin_concentration * (1.f + state.rand.y * material.melanin_concentration_disparity), .0f);
-	absorption += (state.rand.x > material.whitepercen) ? melanin_concentration * lerp(absorption_eumelanin, absorption_pheomelanin, melanin_ratio) : make_float3(0.f);
+	if (state.rand.x > material.whitepercen)
+	{
+		absorption += hairFiberMelaninAbsorption(material, state.rand.y);
+	}
 
 
 	float3 T = expf(-absorption * 2.f * cosGammaT / cosThetaT);
@@ -301,12 +296,10 @@ extern "C" __device__ float4 __direct_callable__eval_bcsdf_hair(MaterialDefiniti
 	float lum = luminance(R) + luminance(TT) + luminance(TRT);
 	float3 apsample = make_float3(luminance(R), luminance(TT), luminance(TRT)) / lum;
 
-	float sin2kAlpha0 = sinf(material.scale_angle_rad);
-	float cos2kAlpha0 = trigInverse(sin2kAlpha0);
-	float sin2kAlpha1 = 2.f * cos2kAlpha0 * sin2kAlpha0;
-	float cos2kAlpha1 = cos2kAlpha0 * cos2kAlpha0 - sin2kAlpha0 * sin2kAlpha0;
-	float sin2kAlpha2 = 2.f * cos2kAlpha1 * sin2kAlpha1;
-	float cos2kAlpha2 = cos2kAlpha1 * cos2kAlpha1 - sin2kAlpha1 * sin2kAlpha1;
+	const float sin2kAlpha0 = material.sin2kAlpha.x;
+	const float cos2kAlpha0 = material.cos2kAlpha.x;
+	const float sin2kAlpha2 = material.sin2kAlpha.z;
+	const float cos2kAlpha2 = material.cos2kAlpha.z;
 
 	float theta_0 = sin_theta_o - 2.f * sin2kAlpha0 * (cosf(phio * 0.5f) * cos2kAlpha0 * cos_theta_o + sin_theta_o * sin2kAlpha0);
 	float sinThetaOp0 = sinf(theta_0);// sin_theta_o*cos2kAlpha1-cos_theta_o*sin2kAlpha1;
@@ -322,22 +315,18 @@ extern "C" __device__ float4 __direct_callable__eval_bcsdf_hair(MaterialDefiniti
 	float cosThetaOp2 = cos_theta_o * cos2kAlpha2 - sin_theta_o * sin2kAlpha2;
 
 
-	const float sqrtv = 0.726f * material.betaM + 0.812f * (material.betaM * material.betaM) + 3.7f * (material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) *
-		(material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) * (material.betaM * material.betaM) *
-		(material.betaM * material.betaM) * (material.betaM * material.betaM);
+	const float v = material.variance;
 
-	const float s = 0.626657069f * (0.265f * material.betaN + 1.194f * (material.betaN * material.betaN) + 5.372f * (material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) *
-		(material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN) *
-		(material.betaN * material.betaN) * (material.betaN * material.betaN) * (material.betaN * material.betaN));
+	const float s = material.logisticScale;
 
 	// Evaluate longitudinal scattering functions
 	cosThetaOp0 = fabsf(cosThetaOp0);
 	cosThetaOp1 = fabsf(cosThetaOp1);
 	cosThetaOp2 = fabsf(cosThetaOp2);
 
-	const float M_R = M(sqrtv * sqrtv, sin_theta_i, sinThetaOp0, cos_theta_i, cosThetaOp0);
-	const float M_TT = M(0.25f * sqrtv * sqrtv, sin_theta_i, sinThetaOp1, cos_theta_i, cosThetaOp1);
-	const float M_TRT = M(sqrtv * sqrtv * 4.f, sin_theta_i, sinThetaOp2, cos_theta_i, cosThetaOp2);
+	const float M_R = M(v, sin_theta_i, sinThetaOp0, cos_theta_i, cosThetaOp0);
+	const float M_TT = M(0.25f * v, sin_theta_i, sinThetaOp1, cos_theta_i, cosThetaOp1);
+	const float M_TRT = M(4.f * v, sin_theta_i, sinThetaOp2, cos_theta_i, cosThetaOp2);
 	//const float M_TRRT = M(sqrtv*sqrtv*4.f, sin_theta_i, sin_theta_o,cos_theta_i, cos_theta_o);
 
 	const float N_R = Np(phi, 0.f, s, gammaO, gammaT);
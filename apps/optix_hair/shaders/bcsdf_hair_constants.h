@@ -0,0 +1,106 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef BCSDF_HAIR_CONSTANTS_H
+#define BCSDF_HAIR_CONSTANTS_H
+
+#include "shader_common.h"
+#include "material_definition.h"
+
+// Hair BCSDF terms which only depend on the material parameters.
+// Evaluated once per material change on the host (Device::initMaterials(), Device::updateMaterial())
+// and read from the MaterialDefinition inside bcsdf_hair.cu instead of being recalculated per sample.
+// The same functions are used on the device for the per-fiber melanin variation.
+
+// Longitudinal variance v = sqrtv^2 of the R lobe from the longitudinal roughness betaM. TT uses v/4, TRT uses 4v.
+__forceinline__ __host__ __device__ float hairLongitudinalVariance(const float betaM)
+{
+  const float b2 = betaM * betaM;
+  const float b4 = b2 * b2;
+  const float b8 = b4 * b4;
+  const float b20 = b8 * b8 * b4;
+
+  const float sqrtv = 0.726f * betaM + 0.812f * b2 + 3.7f * b20;
+  return sqrtv * sqrtv;
+}
+
+// Scale of the trimmed logistic azimuthal distribution from the azimuthal roughness betaN.
+__forceinline__ __host__ __device__ float hairLogisticScale(const float betaN)
+{
+  const float b2 = betaN * betaN;
+  const float b4 = b2 * b2;
+  const float b8 = b4 * b4;
+  const float b22 = b8 * b8 * b4 * b2;
+
+  return 0.626657069f * (0.265f * betaN + 1.194f * b2 + 5.372f * b22);
+}
+
+// Cuticle scale tilt terms sin(2^k * alpha), cos(2^k * alpha) for the lobes k = 0 (R), 1 (TT), 2 (TRT).
+__forceinline__ __host__ __device__ void hairScaleTilt(const float scale_angle_rad, float3& sin2kAlpha, float3& cos2kAlpha)
+{
+  sin2kAlpha.x = sinf(scale_angle_rad);
+  cos2kAlpha.x = trigInverse(sin2kAlpha.x);
+  sin2kAlpha.y = 2.0f * cos2kAlpha.x * sin2kAlpha.x;
+  cos2kAlpha.y = cos2kAlpha.x * cos2kAlpha.x - sin2kAlpha.x * sin2kAlpha.x;
+  sin2kAlpha.z = 2.0f * cos2kAlpha.y * sin2kAlpha.y;
+  cos2kAlpha.z = cos2kAlpha.y * cos2kAlpha.y - sin2kAlpha.y * sin2kAlpha.y;
+}
+
+// Absorption coefficient sigma_a of the melanin mix. The ratio blends eumelanin (0.0f) and pheomelanin (1.0f).
+__forceinline__ __host__ __device__ float3 hairMelaninAbsorption(const float concentration, const float ratio)
+{
+  const float3 absorption_eumelanin   = make_float3(0.419f, 0.697f, 1.37f);
+  const float3 absorption_pheomelanin = make_float3(0.187f, 0.4f, 1.05f);
+
+  return fmaxf(concentration, 0.0f) * lerp(absorption_eumelanin, absorption_pheomelanin, clamp(ratio, 0.0f, 1.0f));
+}
+
+// Melanin absorption of an individual fiber. The disparities vary the material values per fiber with the random value state.rand.y.
+// Without disparity this is the precalculated material.absorptionMelanin.
+__forceinline__ __host__ __device__ float3 hairFiberMelaninAbsorption(MaterialDefinition const& material, const float rnd)
+{
+  if (material.melanin_concentration_disparity == 0.0f && material.melanin_ratio_disparity == 0.0f)
+  {
+    return material.absorptionMelanin;
+  }
+  return hairMelaninAbsorption(material.melanin_concentration * (1.0f + rnd * material.melanin_concentration_disparity),
+                               material.melanin_ratio         * (1.0f + rnd * material.melanin_ratio_disparity));
+}
+
+// Fill the precalculated fields of a hair MaterialDefinition. Call after the material parameters have been set.
+__forceinline__ __host__ void precalculateHairMaterial(MaterialDefinition& material)
+{
+  material.variance = hairLongitudinalVariance(material.betaM);
+  material.logisticScale = hairLogisticScale(material.betaN);
+  hairScaleTilt(material.scale_angle_rad, material.sin2kAlpha, material.cos2kAlpha);
+  material.absorptionMelanin = hairMelaninAbsorption(material.melanin_concentration, material.melanin_ratio);
+}
+
+#endif // BCSDF_HAIR_CONSTANTS_H
@@ -41,6 +41,8 @@
 #include "light_definition.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
+#include "sampler.h"
+#include "texture_lod.h"
 #include "curve.h"
 
 
@@ -208,6 +210,11 @@ extern "C" __global__ void __closesthit__radiance()
   //thePrd->pos = optixGetWorldRayOrigin() + optixGetWorldRayDirection() * optixGetRayTmax();
   thePrd->pos += thePrd->wi * thePrd->distance; // DEBUG Check which version is more efficient.
 
+  // The ray cone footprint at the hit point is the origin of the continuation and shadow rays.
+  thePrd->coneWidth += thePrd->coneSpread * thePrd->distance;
+
+  state.lod = TEXTURE_LOD_FINEST;
+
   const unsigned int thePrimitiveIndex = optixGetPrimitiveIndex();
   if (optixGetPrimitiveType() == OPTIX_PRIMITIVE_TYPE_TRIANGLE) {
 
@@ -239,6 +246,12 @@ extern "C" __global__ void __closesthit__radiance()
       state.normalGeo = normalize(transformNormal(worldToObject, ng));
       state.tangent = normalize(transformVector(objectToWorld, tg));
       state.normal = normalize(transformNormal(worldToObject, ns));
+
+      state.lod = rayConeTriangleLod(transformVector(objectToWorld, attr1.vertex - attr0.vertex),
+                                     transformVector(objectToWorld, attr2.vertex - attr0.vertex),
+                                     make_float2(attr1.texcoord - attr0.texcoord),
+                                     make_float2(attr2.texcoord - attr0.texcoord),
+                                     thePrd->wi, thePrd->coneWidth);
   }
   else if (optixGetPrimitiveType() == OPTIX_PRIMITIVE_TYPE_ROUND_QUADRATIC_BSPLINE){
       //const unsigned int* strand_indices = reinterpret_cast<unsigned int*>(theData->strand_i);
@@ -284,7 +297,8 @@ extern "C" __global__ void __closesthit__radiance()
       float3 emission = light.emission;
 
 #if USE_NEXT_EVENT_ESTIMATION
-      const float lightPdf = (thePrd->distance * thePrd->distance) / (light.area * cosTheta); // This assumes the light.area is greater than zero.
+      // Solid angle pdf times the probability to select this light in the direct lighting. This assumes the light.area is greater than zero.
+      const float lightPdf = (thePrd->distance * thePrd->distance) / (light.area * cosTheta) * sysData.lightAliasTable[theData->lightIndex].pmf;
 
       // If it's an implicit light hit from a diffuse scattering event and the light emission was not returning a zero pdf (e.g. backface or edge on).
       if ((thePrd->flags & FLAG_DIFFUSE) && DENOMINATOR_EPSILON < lightPdf)
@@ -317,7 +331,7 @@ extern "C" __global__ void __closesthit__radiance()
 
   if (material.textureAlbedo != 0)
   {
-      const float3 texColor = make_float3(tex2D<float4>(material.textureAlbedo, state.texcoord.x, state.texcoord.y));
+      const float3 texColor = make_float3(tex2DLod<float4>(material.textureAlbedo, state.texcoord.x, state.texcoord.y, state.lod + material.lodAlbedo));
 
       // Modulate the incoming color with the texture.
       state.albedo *= texColor;               // linear color, resp. if the texture has been uint8 and readmode set to use sRGB, then sRGB.
@@ -325,7 +339,7 @@ extern "C" __global__ void __closesthit__radiance()
   }
   if (material.textureEye != 0)
   {
-    const float3 texColor = make_float3(tex2D<float4>(material.textureEye, state.texcoord.x, state.texcoord.y));
+    const float3 texColor = make_float3(tex2DLod<float4>(material.textureEye, state.texcoord.x, state.texcoord.y, state.lod + material.lodEye));
 
     // Modulate the incoming color with the texture.
     //state.albedo *= texColor;               // linear color, resp. if the texture has been uint8 and readmode set to use sRGB, then sRGB.
@@ -333,7 +347,7 @@ extern "C" __global__ void __closesthit__radiance()
   }
   if (material.textureHead != 0)
   {
-      const float3 texColor = make_float3(tex2D<float4>(material.textureHead, state.texcoord.x, state.texcoord.y));
+      const float3 texColor = make_float3(tex2DLod<float4>(material.textureHead, state.texcoord.x, state.texcoord.y, state.lod + material.lodHead));
 
       // Modulate the incoming color with the texture.
       //state.albedo *= texColor;               // linear color, resp. if the texture has been uint8 and readmode set to use sRGB, then sRGB.
@@ -354,10 +368,14 @@ extern "C" __global__ void __closesthit__radiance()
   if ((thePrd->flags & FLAG_DIFFUSE) && 0 < numLights)
   {
     // Sample one of many lights. 
-    const float2 sample = rng2(thePrd->seed); // Use lower dimension samples for the position. (Irrelevant for the LCG).
+    const float2 sample = sample2D(sysData, thePrd); // Use lower dimension samples for the position.
    
-    // The caller picks the light to sample. Make sure the index stays in the bounds of the sysData.lightDefinitions array.
-    const int indexLight = (1 < numLights) ? clamp(static_cast<int>(floorf(rng(thePrd->seed) * numLights)), 0, numLights - 1) : 0;
+    // The caller picks the light to sample, proportional to its power via the alias table.
+    // Always consume the dimension to keep the dimension count independent of the number of lights.
+    const float selection = sample1D(sysData, thePrd);
+
+    float pmfLight;
+    const int indexLight = sampleAliasTable(sysData.lightAliasTable, numLights, selection, pmfLight);
     
     LightDefinition const& light = sysData.lightDefinitions[indexLight];
     
@@ -365,6 +383,9 @@ extern "C" __global__ void __closesthit__radiance()
 
     LightSample lightSample = optixDirectCall<LightSample, LightDefinition const&, const float3, const float2>(indexCallable, light, thePrd->pos, sample);
 
+    // Include the probability to select this light. This also makes the MIS weights match the implicit light hits.
+    lightSample.pdf *= pmfLight;
+
     if (0.0f < lightSample.pdf) // Useful light sample?
     {
       // Evaluate the BSDF in the light sample direction. Normally cheaper than shooting rays.
@@ -48,6 +48,15 @@ enum LensShader
   NUM_LENS_SHADERS    = 3
 };
 
+enum SamplerType
+{
+  SAMPLER_LCG              = 0, // Per pixel TEA seed and LCG. Independent random samples.
+  SAMPLER_SOBOL            = 1, // Owen-scrambled Sobol with per dimension shuffling (padding), see low_discrepancy.h.
+  SAMPLER_SOBOL_BLUE_NOISE = 2, // Same plus a per pixel blue-noise rotation which distributes the error as blue noise at low sample counts.
+
+  NUM_SAMPLER_TYPES        = 3
+};
+
 enum FunctionIndex
 {
   INDEX_BRDF_DIFFUSE   = 0,
@@ -61,9 +61,9 @@ extern "C" __device__ LightSample __direct_callable__light_env_constant(LightDef
   // Environment lights do not set the light sample position!
   lightSample.distance = RT_DEFAULT_MAX; // Environment light.
   
-  // Explicit light sample. White scaled by inverse probabilty to hit this light.
+  // Explicit light sample. White. The caller accounts for the probability to select this light in the pdf.
   // FIXME Could use the sysData.lightDefinitions[0].emission for different colors.
-  lightSample.emission = make_float3(sysData.numLights);
+  lightSample.emission = make_float3(1.0f);
   
   return lightSample;
 }
@@ -74,63 +74,82 @@ extern "C" __device__ LightSample __direct_callable__light_env_sphere(LightDefin
 
   // Importance-sample the spherical environment light direction.
   
-  // Note that the marginal CDF is one bigger than the texture height. As index this is the 1.0f at the end of the CDF.
   const unsigned int sizeV = sysData.envHeight;
+  const unsigned int sizeU = sysData.envWidth;
 
-  unsigned int ilo = 0;     // Use this for full spherical lighting. (This matches the result of indirect environment lighting.)
-  unsigned int ihi = sizeV; // Index on the last entry containing 1.0f. Can never be reached with the sample in the range [0.0f, 1.0f).
+  unsigned int vIdx; // The row.
+  unsigned int uIdx; // The column.
+  float        du;   // Position inside the texel.
+  float        dv;
 
-  const float* cdfV = sysData.envCDF_V;
+  if (sysData.envAliasSampling)
+  {
+    // Constant time selection of the row from the marginal and the column from this row's conditional distribution.
+    // The remaining sample values are uniformly distributed inside the selected texel.
+    float sampleV = sample.y;
+    float sampleU = sample.x;
+
+    vIdx = sampleAliasTableContinuous(sysData.envAlias_V, sizeV, sampleV);
+    uIdx = sampleAliasTableContinuous(&sysData.envAlias_U[vIdx * sizeU], sizeU, sampleU);
 
-  // Binary search the row index to look up.
-  while (ilo != ihi - 1) // When a pair of limits have been found, the lower index indicates the cell to use.
+    du = sampleU;
+    dv = sampleV;
+  }
+  else
   {
-    const unsigned int i = (ilo + ihi) >> 1;
-    if (sample.y < cdfV[i]) // If the cdf is greater than the sample, use that as new higher limit.
-    {
-      ihi = i;
-    }
-    else // If the sample is greater than or equal to the CDF value, use that as new lower limit.
+    // Note that the marginal CDF is one bigger than the texture height. As index this is the 1.0f at the end of the CDF.
+    unsigned int ilo = 0;     // Use this for full spherical lighting. (This matches the result of indirect environment lighting.)
+    unsigned int ihi = sizeV; // Index on the last entry containing 1.0f. Can never be reached with the sample in the range [0.0f, 1.0f).
+
+    const float* cdfV = sysData.envCDF_V;
+
+    // Binary search the row index to look up.
+    while (ilo != ihi - 1) // When a pair of limits have been found, the lower index indicates the cell to use.
     {
-      ilo = i; 
+      const unsigned int i = (ilo + ihi) >> 1;
+      if (sample.y < cdfV[i]) // If the cdf is greater than the sample, use that as new higher limit.
+      {
+        ihi = i;
+      }
+      else // If the sample is greater than or equal to the CDF value, use that as new lower limit.
+      {
+        ilo = i; 
+      }
     }
-  }
 
-  const unsigned int vIdx = ilo; // This is the row we found.
+    vIdx = ilo; // This is the row we found.
     
-  // Note that the horizontal CDF is one bigger than the texture width. As index this is the 1.0f at the end of the CDF.
-  const unsigned int sizeU = sysData.envWidth; // Note that the horizontal CDFs are one bigger than the texture width.
-
-  // Binary search the column index to look up.
-  ilo = 0;
-  ihi = sizeU; // Index on the last entry containing 1.0f. Can never be reached with the sample in the range [0.0f, 1.0f).
+    // Binary search the column index to look up.
+    ilo = 0;
+    ihi = sizeU; // Index on the last entry containing 1.0f. Can never be reached with the sample in the range [0.0f, 1.0f).
 
-  // Pointer to the indexY row!
-  const float* cdfU = &sysData.envCDF_U[vIdx * (sizeU + 1)]; // Horizontal CDF is one bigger then the texture width!
+    // Pointer to the indexY row!
+    const float* cdfU = &sysData.envCDF_U[vIdx * (sizeU + 1)]; // Horizontal CDF is one bigger then the texture width!
 
-  while (ilo != ihi - 1) // When a pair of limits have been found, the lower index indicates the cell to use.
-  {
-    const unsigned int i = (ilo + ihi) >> 1;
-    if (sample.x < cdfU[i]) // If the CDF value is greater than the sample, use that as new higher limit.
+    while (ilo != ihi - 1) // When a pair of limits have been found, the lower index indicates the cell to use.
     {
-      ihi = i;
+      const unsigned int i = (ilo + ihi) >> 1;
+      if (sample.x < cdfU[i]) // If the CDF value is greater than the sample, use that as new higher limit.
+      {
+        ihi = i;
+      }
+      else // If the sample is greater than or equal to the CDF value, use that as new lower limit.
+      {
+        ilo = i;
+      }
     }
-    else // If the sample is greater than or equal to the CDF value, use that as new lower limit.
-    {
-      ilo = i;
-    }
-  }
 
-  const unsigned int uIdx = ilo; // The column result.
+    uIdx = ilo; // The column result.
 
-  // Continuous sampling of the CDF.
-  const float cdfLowerU = cdfU[uIdx];
-  const float cdfUpperU = cdfU[uIdx + 1];
-  const float du = (sample.x - cdfLowerU) / (cdfUpperU - cdfLowerU);
+    // Continuous sampling of the CDF.
+    const float cdfLowerU = cdfU[uIdx];
+    const float cdfUpperU = cdfU[uIdx + 1];
+    du = (sample.x - cdfLowerU) / (cdfUpperU - cdfLowerU);
 
-  const float cdfLowerV = cdfV[vIdx];
-  const float cdfUpperV = cdfV[vIdx + 1];
-  const float dv = (sample.y - cdfLowerV) / (cdfUpperV - cdfLowerV);
+    const float cdfLowerV = cdfV[vIdx];
+    const float cdfUpperV = cdfV[vIdx + 1];
+    dv = (sample.y - cdfLowerV) / (cdfUpperV - cdfLowerV);
+  }
 
   // Texture lookup coordinates.
   const float u = (float(uIdx) + du) / float(sizeU);
@@ -151,8 +170,8 @@ extern "C" __device__ LightSample __direct_callable__light_env_sphere(LightDefin
   lightSample.distance = RT_DEFAULT_MAX; // Environment light.
 
   const float3 emission = make_float3(tex2D<float4>(sysData.envTexture, u, v));
-  // Explicit light sample. The returned emission must be scaled by the inverse probability to select this light.
-  lightSample.emission = emission * sysData.numLights;
+  // Explicit light sample. The caller accounts for the probability to select this light in the pdf.
+  lightSample.emission = emission;
   // For simplicity we pretend that we perfectly importance-sampled the actual texture-filtered environment map
   // and not the Gaussian-smoothed one used to actually generate the CDFs and uniform sampling in the texel.
   lightSample.pdf = intensity(emission) / sysData.envIntegral;
@@ -178,8 +197,8 @@ extern "C" __device__ LightSample __direct_callable__light_parallelogram(LightDe
     const float cosTheta = dot(-lightSample.direction, light.normal);
     if (DENOMINATOR_EPSILON < cosTheta) // Only emit light on the front side.
     {
-      // Explicit light sample, must scale the emission by inverse probabilty to hit this light.
-      lightSample.emission = light.emission * float(sysData.numLights); 
+      // Explicit light sample. The caller accounts for the probability to select this light in the pdf.
+      lightSample.emission = light.emission;
       lightSample.pdf      = (lightSample.distance * lightSample.distance) / (light.area * cosTheta)/2; // Solid angle pdf. Assumes light.area != 0.0f.
     }
   }
@@ -0,0 +1,162 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef LOW_DISCREPANCY_H
+#define LOW_DISCREPANCY_H
+
+// Host and device compatible low-discrepancy sequence functions.
+// Owen-scrambled Sobol points with hash based nested uniform scrambling after
+// Burley, "Practical Hash-based Owen Scrambling", JCGT 2020.
+// Higher dimensions are built by padding independently shuffled and scrambled 2D Sobol points,
+// so only the first LD_SOBOL_DIMENSIONS direction matrices are needed. These are generated on the host.
+
+#include "config.h"
+
+// Number of Sobol dimensions in the direction matrix table, 32 entries per dimension.
+#define LD_SOBOL_DIMENSIONS 2
+#define LD_SOBOL_BITS       32
+
+// Side length of the square, tileable blue-noise table.
+#define LD_BLUE_NOISE_SIZE  64
+
+// Reciprocal of 2^32 in float.
+#define LD_INV_2_POW_32     2.3283064365386963e-10f
+
+
+__forceinline__ __host__ __device__ unsigned int ldReverseBits(unsigned int x)
+{
+#if defined(__CUDA_ARCH__)
+  return __brev(x);
+#else
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+  x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+  return (x >> 16) | (x << 16);
+#endif
+}
+
+// 32-bit integer finalizer with good avalanche behaviour.
+__forceinline__ __host__ __device__ unsigned int ldHash(unsigned int x)
+{
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+__forceinline__ __host__ __device__ unsigned int ldHashCombine(const unsigned int seed, const unsigned int value)
+{
+  return seed ^ (ldHash(value) + 0x9E3779B9u + (seed << 6) + (seed >> 2));
+}
+
+// Laine-Karras style permutation. Only changes bits by lower bits, which is an Owen scramble of the bit-reversed value.
+__forceinline__ __host__ __device__ unsigned int ldLaineKarrasPermutation(unsigned int x, const unsigned int seed)
+{
+  x += seed;
+  x ^= x * 0x6C50B47Cu;
+  x ^= x * 0xB82F1E52u;
+  x ^= x * 0xC7AFE638u;
+  x ^= x * 0x8D22F6E6u;
+  return x;
+}
+
+// Owen scramble of a 32-bit fixed point value where the most significant bit is the first base-2 digit.
+__forceinline__ __host__ __device__ unsigned int ldNestedUniformScramble(const unsigned int x, const unsigned int seed)
+{
+  return ldReverseBits(ldLaineKarrasPermutation(ldReverseBits(x), seed));
+}
+
+// Sobol point of the given index and dimension as 32-bit fixed point.
+// Dimension 0 is the van der Corput sequence which needs no table.
+__forceinline__ __host__ __device__ unsigned int ldSobol(unsigned int index, const unsigned int dimension, const unsigned int* matrices)
+{
+  if (dimension == 0)
+  {
+    return ldReverseBits(index);
+  }
+
+  const unsigned int* v = matrices + dimension * LD_SOBOL_BITS;
+
+  unsigned int result = 0;
+  for (unsigned int bit = 0; index != 0; index >>= 1, ++bit)
+  {
+    if (index & 1u)
+    {
+      result ^= v[bit];
+    }
+  }
+  return result;
+}
+
+// Fixed point to float in [0, 1). Only the upper 24 bits fit into the mantissa.
+__forceinline__ __host__ __device__ float ldToFloat(const unsigned int x)
+{
+  return float(x >> 8) * (1.0f / 16777216.0f);
+}
+
+// Owen-scrambled, shuffled 2D Sobol point of sample index for one padded dimension pair identified by seed.
+__forceinline__ __host__ __device__ float2 ldOwenSobol2D(const unsigned int sampleIndex, const unsigned int seed, const unsigned int* matrices)
+{
+  // Shuffle the sample order per dimension pair to decorrelate the pairs.
+  // Scrambling the index like a radical inverse keeps every power-of-two prefix of the sequence stratified.
+  const unsigned int index = ldNestedUniformScramble(sampleIndex, seed);
+
+  const unsigned int x = ldNestedUniformScramble(ldSobol(index, 0, matrices), ldHashCombine(seed, 0u));
+  const unsigned int y = ldNestedUniformScramble(ldSobol(index, 1, matrices), ldHashCombine(seed, 1u));
+
+  return make_float2(ldToFloat(x), ldToFloat(y));
+}
+
+__forceinline__ __host__ __device__ float ldOwenSobol1D(const unsigned int sampleIndex, const unsigned int seed)
+{
+  const unsigned int index = ldNestedUniformScramble(sampleIndex, seed);
+
+  return ldToFloat(ldNestedUniformScramble(ldReverseBits(index), ldHashCombine(seed, 0u)));
+}
+
+// Toroidal offset into the blue-noise table per dimension, R2 sequence to avoid correlated neighbours in the table.
+__forceinline__ __host__ __device__ unsigned int ldBlueNoiseIndex(const unsigned int pixelX, const unsigned int pixelY, const unsigned int dimension)
+{
+  const unsigned int x = (pixelX + (unsigned int)(float(dimension) * 0.7548776662f * LD_BLUE_NOISE_SIZE)) & (LD_BLUE_NOISE_SIZE - 1);
+  const unsigned int y = (pixelY + (unsigned int)(float(dimension) * 0.5698402910f * LD_BLUE_NOISE_SIZE)) & (LD_BLUE_NOISE_SIZE - 1);
+  return y * LD_BLUE_NOISE_SIZE + x;
+}
+
+// Cranley-Patterson rotation.
+__forceinline__ __host__ __device__ float ldRotate(const float u, const float offset)
+{
+  const float r = u + offset;
+  return (r < 1.0f) ? r : r - 1.0f;
+}
+
+#endif // LOW_DISCREPANCY_H
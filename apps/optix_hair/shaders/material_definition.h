@@ -62,11 +62,27 @@ struct MaterialDefinition
   float			betaN;
   int			bcsdf_resolution;
 
+  // Precalculated from the hair parameters above whenever the material changes. See bcsdf_hair_constants.h.
+  float			variance;          // Longitudinal variance of the R lobe.
+  float			logisticScale;     // Azimuthal logistic scale s.
+  float3		sin2kAlpha;        // Cuticle scale tilt terms for the R, TT and TRT lobes.
+  float3		cos2kAlpha;
+  float3		absorptionMelanin; // Melanin absorption for the nominal concentration and ratio.
+
+  // Texture LOD offsets log2(sqrt(width * height)) of the mipmap level 0 of the textures above. See texture_lod.h.
+  float			lodEye;
+  float			lodHead;
+  float			lodAlbedo;
+  float			lodCutout;
+
   // Manual padding to 16-byte alignment goes here.
-  //int			pad0;
-  //int			pad1;
+  int			pad0;
+  //int pad1;
+  //int pad2;
   //int pad3;
-  //int pad4;
 };
 
+// The materials are uploaded as one array, see Device::initMaterials().
+static_assert((sizeof(MaterialDefinition) & 15) == 0, "MaterialDefinition size must be a multiple of 16 bytes.");
+
 #endif // MATERIAL_DEFINITION_H
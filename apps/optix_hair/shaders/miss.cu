@@ -56,7 +56,8 @@ extern "C" __global__ void __miss__env_constant()
 #if USE_NEXT_EVENT_ESTIMATION
   // If the last surface intersection was a diffuse which was directly lit with multiple importance sampling,
   // then calculate light emission with multiple importance sampling as well.
-  const float weightMIS = (thePrd->flags & FLAG_DIFFUSE) ? powerHeuristic(thePrd->pdf, 0.25f * M_1_PIf) : 1.0f;
+  // The environment light is always sysData.lightDefinitions[0].
+  const float weightMIS = (thePrd->flags & FLAG_DIFFUSE) ? powerHeuristic(thePrd->pdf, 0.25f * M_1_PIf * sysData.lightAliasTable[0].pmf) : 1.0f;
   thePrd->radiance = make_float3(weightMIS); // Constant white emission multiplied by MIS weight.
 #else
   thePrd->radiance = make_float3(1.0f); // Constant white emission.
@@ -88,7 +89,8 @@ extern "C" __global__ void __miss__env_sphere()
   {
     // For simplicity we pretend that we perfectly importance-sampled the actual texture-filtered environment map
     // and not the Gaussian smoothed one used to actually generate the CDFs.
-    const float pdfLight = intensity(emission) / sysData.envIntegral;
+    // Includes the probability to select the environment light, which is always sysData.lightDefinitions[0].
+    const float pdfLight = intensity(emission) / sysData.envIntegral * sysData.lightAliasTable[0].pmf;
     weightMIS = powerHeuristic(thePrd->pdf, pdfLight);
   }
   thePrd->radiance = emission * weightMIS;
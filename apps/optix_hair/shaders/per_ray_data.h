@@ -81,6 +81,7 @@ struct State
   float3 albedo;    // PERF Added albedo to the state to allow modulation with an optional texture once before BSDF sampling and evaluation.
   float3 rand;
   float radius;
+  float lod;        // Texture independent part of the texture LOD of triangle hits, see texture_lod.h.
 };
 
 // Note that the fields are ordered by CUDA alignment restrictions.
@@ -109,7 +110,16 @@ struct PerRayData
   float3 sigma_t;        // The current volume's extinction coefficient. (Only absorption in this implementation.)
   float  opacity;        // Cutout opacity result.
 
+  float coneWidth;       // Ray cone width at the ray origin, in world space. The closesthit program advances it to the hit point.
+  float coneSpread;      // Ray cone spread angle in radians. See texture_lod.h.
+
   unsigned int seed;     // Random number generator input.
+
+  // Low-discrepancy sampler state, see sampler.h.
+  unsigned int sampleIndex; // Index into the sequence, the iteration index.
+  unsigned int dimension;   // Next padded dimension, incremented per sample1D() and sample2D() call along the path.
+  unsigned int pixel;       // Pixel coordinates (y << 16) | x for the blue-noise lookup.
+  unsigned int pixelHash;   // Per pixel scrambling seed.
 };
 
 
@@ -34,6 +34,8 @@
 #include "per_ray_data.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
+#include "sampler.h"
+#include "texture_lod.h"
 
 
 extern "C" __constant__ SystemData sysData;
@@ -191,11 +193,13 @@ extern "C" __global__ void __raygen__path_tracer()
   const unsigned int seedIndex = theLaunchDim.x * theLaunchIndex.y + launchColumn * sysData.deviceCount + sysData.deviceIndex;
   prd.seed = tea<4>(seedIndex, sysData.iterationIndex); // PERF This template really generates a lot of instructions.
 
+  samplerInit(sysData, prd, launchColumn, theLaunchIndex.y);
+
   // Decoupling the pixel coordinates from the screen size will allow for partial rendering algorithms.
   // Resolution is the actual full rendering resolution and for the single GPU strategy, theLaunchDim == resolution.
   const float2 screen = make_float2(sysData.resolution); // == theLaunchDim for rendering strategy RS_SINGLE_GPU.
   const float2 pixel  = make_float2(launchColumn, theLaunchIndex.y);
-  const float2 sample = rng2(prd.seed); // Random per pixel jitter.
+  const float2 sample = sample2D(sysData, &prd); // Per pixel jitter, the first sampling dimension.
 
   // Lens shaders
   const LensRay ray = optixDirectCall<LensRay, const float2, const float2, const float2>(sysData.lensShader, screen, pixel, sample);
@@ -203,6 +207,9 @@ extern "C" __global__ void __raygen__path_tracer()
   prd.pos = ray.org;
   prd.wi  = ray.dir;
 
+  prd.coneWidth  = 0.0f; // All lens shaders have a point as origin.
+  prd.coneSpread = rayConePixelSpread(sysData.cameraDefinitions[0], screen);
+
   float3 radiance = integrator(prd);
 
 #if USE_DEBUG_EXCEPTIONS
@@ -302,11 +309,13 @@ extern "C" __global__ void __raygen__path_tracer_local_copy()
   const unsigned int seedIndex = theLaunchDim.x * theLaunchIndex.y + launchColumn * sysData.deviceCount + sysData.deviceIndex;
   prd.seed = tea<4>(seedIndex, sysData.iterationIndex); // PERF This template really generates a lot of instructions.
 
+  samplerInit(sysData, prd, launchColumn, theLaunchIndex.y);
+
   // Decoupling the pixel coordinates from the screen size will allow for partial rendering algorithms.
   // Resolution is the actual full rendering resolution and for the single GPU strategy, theLaunchDim == resolution.
   const float2 screen = make_float2(sysData.resolution); // == theLaunchDim for rendering strategy RS_SINGLE_GPU.
   const float2 pixel  = make_float2(launchColumn, theLaunchIndex.y);
-  const float2 sample = rng2(prd.seed); // Random per pixel jitter.
+  const float2 sample = sample2D(sysData, &prd); // Per pixel jitter, the first sampling dimension.
 
   // Lens shaders
   const LensRay ray = optixDirectCall<LensRay, const float2, const float2, const float2>(sysData.lensShader, screen, pixel, sample);
@@ -314,6 +323,9 @@ extern "C" __global__ void __raygen__path_tracer_local_copy()
   prd.pos = ray.org;
   prd.wi  = ray.dir;
 
+  prd.coneWidth  = 0.0f; // All lens shaders have a point as origin.
+  prd.coneSpread = rayConePixelSpread(sysData.cameraDefinitions[0], screen);
+
   float3 radiance = integrator(prd);
 
 #if USE_DEBUG_EXCEPTIONS
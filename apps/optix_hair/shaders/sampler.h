@@ -0,0 +1,97 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+// Device side sampling dimensions of the path tracer.
+// Depending on SystemData::sampler these return the original LCG random numbers or consecutive padded dimensions
+// of an Owen-scrambled Sobol sequence, optionally rotated per pixel by a blue-noise table.
+
+#include "config.h"
+
+#include "system_data.h"
+#include "per_ray_data.h"
+#include "function_indices.h"
+#include "random_number_generators.h"
+#include "low_discrepancy.h"
+
+
+// Called once per camera sample in the ray generation program after prd.seed has been initialized.
+__forceinline__ __device__ void samplerInit(SystemData const& sys, PerRayData& prd, const unsigned int pixelX, const unsigned int pixelY)
+{
+  prd.sampleIndex = (unsigned int) sys.iterationIndex;
+  prd.dimension   = 0;
+  prd.pixel       = (pixelY << 16) | (pixelX & 0xFFFF);
+  // The blue-noise variant needs the same sequence in all pixels. The blue-noise rotation is what decorrelates the pixels then.
+  prd.pixelHash   = (sys.sampler == SAMPLER_SOBOL_BLUE_NOISE) ? 0u : ldHash(pixelY * (unsigned int) sys.resolution.x + pixelX);
+}
+
+__forceinline__ __device__ float sample1D(SystemData const& sys, PerRayData* prd)
+{
+  if (sys.sampler == SAMPLER_LCG)
+  {
+    return rng(prd->seed);
+  }
+
+  const unsigned int dimension = prd->dimension++;
+
+  float u = ldOwenSobol1D(prd->sampleIndex, ldHashCombine(prd->pixelHash, dimension));
+
+  if (sys.sampler == SAMPLER_SOBOL_BLUE_NOISE)
+  {
+    u = ldRotate(u, sys.blueNoise[ldBlueNoiseIndex(prd->pixel & 0xFFFF, prd->pixel >> 16, 2 * dimension)]);
+  }
+  return u;
+}
+
+__forceinline__ __device__ float2 sample2D(SystemData const& sys, PerRayData* prd)
+{
+  if (sys.sampler == SAMPLER_LCG)
+  {
+    return rng2(prd->seed);
+  }
+
+  const unsigned int dimension = prd->dimension++;
+
+  float2 u = ldOwenSobol2D(prd->sampleIndex, ldHashCombine(prd->pixelHash, dimension), sys.sobolMatrices);
+
+  if (sys.sampler == SAMPLER_SOBOL_BLUE_NOISE)
+  {
+    const unsigned int x = prd->pixel & 0xFFFF;
+    const unsigned int y = prd->pixel >> 16;
+
+    u.x = ldRotate(u.x, sys.blueNoise[ldBlueNoiseIndex(x, y, 2 * dimension)]);
+    u.y = ldRotate(u.y, sys.blueNoise[ldBlueNoiseIndex(x, y, 2 * dimension + 1)]);
+  }
+  return u;
+}
+
+#endif // SAMPLER_H
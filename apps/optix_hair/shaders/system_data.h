@@ -33,6 +33,7 @@
 
 #include "camera_definition.h"
 #include "light_definition.h"
+#include "alias_table.h"
 #include "material_definition.h"
 #include "vertex_attributes.h"
 
@@ -56,6 +57,7 @@ struct SystemData
 
   CameraDefinition*   cameraDefinitions; // Currently only one camera in the array. (Allows camera motion blur in the future.)
   LightDefinition*    lightDefinitions;
+  AliasEntry*         lightAliasTable; // numLights entries, power proportional light selection.
   MaterialDefinition* materialDefinitions;
 
   cudaTextureObject_t envTexture;
@@ -63,6 +65,12 @@ struct SystemData
   float* envCDF_U;  // 2D, size (envWidth  + 1) * envHeight
   float* envCDF_V;  // 1D, size (envHeight + 1)
 
+  AliasEntry* envAlias_U; // 2D, size envWidth * envHeight, the conditional distribution per row.
+  AliasEntry* envAlias_V; // 1D, size envHeight, the marginal distribution.
+
+  unsigned int* sobolMatrices; // LD_SOBOL_DIMENSIONS * LD_SOBOL_BITS direction numbers, generated on the host.
+  float*        blueNoise;     // LD_BLUE_NOISE_SIZE^2 tileable blue-noise values in [0, 1).
+
   int2 resolution;  // The actual rendering resolution. Independent from the launch dimensions for some rendering strategies.
   int2 tileSize;    // Example: make_int2(8, 4) for 8x4 tiles. Must be a power of two to make the division a right-shift.
   int2 tileShift;   // Example: make_int2(3, 2) for the integer division by tile size. That actually makes the tileSize redundant. 
@@ -80,6 +88,8 @@ struct SystemData
   float clockScale;
 
   int lensShader; // Camera type.
+  int sampler;    // SamplerType.
+  int envAliasSampling; // Sample the environment light with the alias tables instead of the CDFs.
 
   int numCameras;
   int numMaterials;
@@ -0,0 +1,71 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef TEXTURE_LOD_H
+#define TEXTURE_LOD_H
+
+#include "config.h"
+
+#include "camera_definition.h"
+#include "vector_math.h"
+
+// Texture level of detail from ray cones, after Akenine-Moeller et al., "Improved Shader and Texture Level of Detail Using Ray Cones", JCGT 2021.
+// The PerRayData carries the cone width at the ray origin and its spread angle. The closesthit program grows the width by the hit distance.
+// Only the pixel footprint of the primary ray is propagated, surface curvature does not widen the cone.
+
+// Returned when the footprint can't be determined. Smaller than any negative texture LOD offset, so the sampling uses level 0.
+#define TEXTURE_LOD_FINEST -128.0f
+
+// Spread angle of a primary ray through one pixel. Exact at the image center of the pinhole camera, an approximation for the other lens shaders.
+__forceinline__ __device__ float rayConePixelSpread(CameraDefinition const& camera, const float2 screen)
+{
+  return 2.0f * length(camera.V) / (length(camera.W) * screen.y);
+}
+
+// Texture independent part of the LOD of a triangle hit, the log2 of the cone footprint in texture coordinate units.
+// e1, e2 are the world space triangle edges, t1, t2 the matching texture coordinate edges, direction is the normalized ray direction
+// and width the cone width at the hit point. Add the LOD offset of the texture, log2(sqrt(width * height)), to get the mipmap level.
+__forceinline__ __device__ float rayConeTriangleLod(float3 const& e1, float3 const& e2, float2 const& t1, float2 const& t2, float3 const& direction, const float width)
+{
+  const float3 ng        = cross(e1, e2);
+  const float  areaWorld = length(ng);                         // Twice the triangle area, same scale as areaTex.
+  const float  areaTex   = fabsf(t1.x * t2.y - t1.y * t2.x);
+  const float  cosTheta  = fabsf(dot(ng, direction));          // Scaled by areaWorld.
+
+  if (areaWorld <= 0.0f || areaTex <= 0.0f || width <= 0.0f)
+  {
+    return TEXTURE_LOD_FINEST;
+  }
+
+  // 0.5 * log2(areaTex / areaWorld) + log2(width / (cosTheta / areaWorld)), with grazing angles clamped.
+  return 0.5f * log2f(areaTex * areaWorld) + log2f(width / fmaxf(cosTheta, 0.01f * areaWorld));
+}
+
+#endif // TEXTURE_LOD_H
@@ -0,0 +1,117 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/AliasTable.h"
+#include "inc/MyAssert.h"
+
+#include <algorithm>
+
+
+float buildAliasTable(const float* weights, const unsigned int count, AliasEntry* table)
+{
+  MY_ASSERT(0 < count);
+
+  double sum = 0.0;
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    MY_ASSERT(0.0f <= weights[i]);
+    sum += weights[i];
+  }
+
+  if (sum <= 0.0)
+  {
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      table[i].threshold = 1.0f;
+      table[i].alias     = int(i);
+      table[i].pmf       = 1.0f / float(count);
+    }
+    return 0.0f;
+  }
+
+  // Scaled probabilities, average 1.0. Worklists of the bins below and above the average.
+  std::vector<double>       scaled(count);
+  std::vector<unsigned int> small;
+  std::vector<unsigned int> large;
+
+  small.reserve(count);
+  large.reserve(count);
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    table[i].pmf = float(double(weights[i]) / sum);
+    scaled[i]    = double(weights[i]) * double(count) / sum;
+
+    if (scaled[i] < 1.0)
+    {
+      small.push_back(i);
+    }
+    else
+    {
+      large.push_back(i);
+    }
+  }
+
+  // Fill each small bin up to 1.0 with probability mass of a large bin.
+  while (!small.empty() && !large.empty())
+  {
+    const unsigned int s = small.back();
+    small.pop_back();
+    const unsigned int l = large.back();
+
+    table[s].threshold = float(scaled[s]);
+    table[s].alias     = int(l);
+
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0)
+    {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  // Remaining bins are full up to rounding errors.
+  for (unsigned int i : large)
+  {
+    table[i].threshold = 1.0f;
+    table[i].alias     = int(i);
+  }
+  for (unsigned int i : small)
+  {
+    table[i].threshold = 1.0f;
+    table[i].alias     = int(i);
+  }
+
+  return float(sum);
+}
+
+float buildAliasTable(std::vector<float> const& weights, std::vector<AliasEntry>& table)
+{
+  table.resize(weights.size());
+  return buildAliasTable(weights.data(), static_cast<unsigned int>(weights.size()), table.data());
+}
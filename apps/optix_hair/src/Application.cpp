@@ -27,7 +27,13 @@
  */
 
 #include "inc/Application.h"
+#include "inc/ConfigParser.h"
+#include "inc/Hash.h"
+#include "inc/MipmapGenerator.h"
 #include "inc/Parser.h"
+#include "inc/SceneGraphBenchmark.h"
+#include "inc/SceneSnapshot.h"
+#include "inc/ThreadPool.h"
 
 #include "inc/RaytracerSingleGPU.h"
 #include "inc/RaytracerMultiGPUZeroCopy.h"
@@ -36,6 +42,7 @@
 
 #include <filesystem>
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -67,11 +74,20 @@ Application::Application(GLFWwindow* window, Options const& options)
     , m_miss(1)
     , m_interop(0)
     , m_catchVariance(0)
+    , m_targetError(0.0f)
+    , m_denoise(false)
     , m_present(false)
     , m_presentNext(true)
     , m_presentAtSecond(1.0)
     , m_previousComplete(false)
     , m_lensShader(LENS_SHADER_PINHOLE)
+    , m_sampler(SAMPLER_LCG)
+    , m_envAliasSampling(true)
+    , m_textureCacheSize(512)
+    , m_textureCompression(0)
+    , m_textureHalfFloat(false)
+    , m_exrHalf(true)
+    , m_exrCompression(EXR_COMPRESSION_ZIP)
     , m_samplesSqrt(1)
     , m_epsilonFactor(500.0f)
     , m_environmentRotation(0.0f)
@@ -81,10 +97,17 @@ Application::Application(GLFWwindow* window, Options const& options)
     , m_idInstance(0)
     , m_idGeometry(0)
     , m_screenshotImageNum(6)
+    , m_useNodeArena(false)
+    , m_sceneGraphBenchmark(0)
+    , m_mipmapBenchmark(0)
     , m_current_camera(0)
     , m_lock_camera(0)
     , nbQuickSaveValue(0)
     , looping(true)
+    , m_hairColorMatch(m_hairSwatch)
+    , m_colorMatchTarget(make_float3(0.35f, 0.2f, 0.1f))
+    , m_colorMatchRefine(false)
+    , m_colorMatchCandidates(0)
 {
   try
   {
@@ -158,6 +181,19 @@ Application::Application(GLFWwindow* window, Options const& options)
       MY_ASSERT(!"Failed to load system description");
       return; // m_isValid == false.
     }
+    m_nodeArena.setEnabled(m_useNodeArena);
+    if (0 < m_sceneGraphBenchmark)
+    {
+      benchmarkSceneGraph(static_cast<unsigned int>(m_sceneGraphBenchmark));
+    }
+    if (0 < m_mipmapBenchmark)
+    {
+      benchmarkMipmaps(static_cast<unsigned int>(m_mipmapBenchmark));
+    }
+    if (!m_meshCache.empty() && !fs::exists(m_meshCache))
+    {
+        fs::create_directories(m_meshCache);
+    }
     if (!fs::exists(m_prefixColorSwitch))
     {
         fs::create_directory(m_prefixColorSwitch);
@@ -324,35 +360,56 @@ Application::Application(GLFWwindow* window, Options const& options)
     m_state.pathLengths   = m_pathLengths;
     m_state.samplesSqrt   = m_samplesSqrt;
     m_state.lensShader    = m_lensShader;
+    m_state.sampler       = m_sampler;
+    m_state.envAliasSampling = m_envAliasSampling;
     m_state.epsilonFactor = m_epsilonFactor;
     m_state.envRotation   = m_environmentRotation;
     m_state.clockFactor   = m_clockFactor;
     m_state.catchVariance = m_catchVariance;
     m_state.screenshotImageNum = m_screenshotImageNum;
+    m_state.textureCompression = m_textureCompression;
+    m_state.textureHalfFloat   = m_textureHalfFloat;
 
     // Sync the state with the default GUI data.
     m_raytracer->initState(m_state);
     //m_raytracer->initVarianceCatching(m_catchVariance);
 
-    const double timeRaytracer = m_timer.getTime();
+    m_convergence.setResolution(m_resolution);
+    m_convergence.setTargetError(m_targetError);
 
-    // Host side scene graph information.
-    m_scene = std::make_shared<sg::Group>(m_idGroup++); // Create the scene's root group first.
+    const double timeRaytracer = m_timer.getTime();
 
     createPictures();
-    createCameras();
-    createLights();
-    
+
     // Load the scene description file and generate the host side scene.
     std::string filenameScene = options.getScene();
     if (filenameScene.empty()) {
         filenameScene = "scene_optix_hair_half_head.txt";
     }
-    if (!loadSceneDescription(filenameScene))
+
+    // A snapshot written by an earlier start with the same system and scene description replaces the camera, light and scene setup.
+    // That skips the description parsing, the model imports and the hair densification.
+    const uint64_t keySnapshot = (m_sceneSnapshot.empty()) ? 0 : getSceneSnapshotKey(filenameSystem, filenameScene);
+
+    if (m_sceneSnapshot.empty() || !loadSceneSnapshot(m_sceneSnapshot, keySnapshot))
     {
-      std::cerr << "ERROR: Application() failed to load scene description file " << filenameScene << '\n';
-      MY_ASSERT(!"Failed to load scene description");
-      return;
+      // Host side scene graph information.
+      m_scene = m_nodeArena.create<sg::Group>(m_idGroup++); // Create the scene's root group first.
+
+      createCameras();
+      createLights();
+
+      if (!loadSceneDescription(filenameScene))
+      {
+        std::cerr << "ERROR: Application() failed to load scene description file " << filenameScene << '\n';
+        MY_ASSERT(!"Failed to load scene description");
+        return;
+      }
+
+      if (!m_sceneSnapshot.empty())
+      {
+        saveSceneSnapshot(m_sceneSnapshot, keySnapshot);
+      }
     }
     if (m_models.size() != 0)
     {
@@ -370,7 +427,10 @@ Application::Application(GLFWwindow* window, Options const& options)
     const double timeScene = m_timer.getTime();
 
     // Device side scene information.
-    m_raytracer->initTextures(m_mapPictures); // HACK Hardcoded textures. // FIXME Implement a full material system.
+    // The pictures requested in createPictures() decoded in the background while the scene was loaded.
+    m_pictureLoader.wait();
+    m_pictureLoader.dispatchCompleted();
+    initTextures(); // HACK Hardcoded textures. // FIXME Implement a full material system.
     m_raytracer->initCameras(m_cameras);
     m_raytracer->initLights(m_lights);
     m_raytracer->initMaterials(m_materialsGUI);
@@ -403,11 +463,12 @@ Application::Application(GLFWwindow* window, Options const& options)
 
 Application::~Application()
 {
-  for (std::map<std::string, Picture*>::const_iterator it =  m_mapPictures.begin(); it != m_mapPictures.end(); ++it)
+  // The color matching task references this Application.
+  if (m_colorMatchTask.valid())
   {
-    delete it->second;
+    m_colorMatchTask.wait();
   }
-  
+
   ImGui_ImplGlfwGL3_Shutdown();
   ImGui::DestroyContext();
 }
@@ -448,6 +509,9 @@ bool Application::render()
 
   try
   {
+    m_pictureLoader.dispatchCompleted(); // Apply the pictures which finished loading in the background.
+    dispatchColorMatch();                // Same for the inverse color matching results.
+
     CameraDefinition camera;
 
     const bool cameraChanged = m_camera.getFrustum(camera.P, camera.U, camera.V, camera.W);
@@ -459,10 +523,27 @@ bool Application::render()
       restartRendering();
     }
 
-    const unsigned int iterationIndex = m_raytracer->render();
+    // Any state change restarts the accumulation inside the raytracer, which also restarts the convergence tracking.
+    m_convergence.setResolution(m_resolution);
+    if (m_raytracer->m_iterationIndex == 0)
+    {
+      m_convergence.reset();
+    }
+
+    // Stop launching more iterations when all tiles reached the target error.
+    unsigned int iterationIndex = m_raytracer->m_iterationIndex;
+    if (!m_convergence.isConverged())
+    {
+      iterationIndex = m_raytracer->render();
+    }
+
+    if (m_catchVariance && m_interop != INTEROP_MODE_PBO && m_convergence.isCheckDue(iterationIndex))
+    {
+      captureVariance();
+    }
     
     // When the renderer has completed all iterations, change the GUI title bar to green.
-    const bool complete = ((unsigned int)(m_samplesSqrt * m_samplesSqrt) <= iterationIndex);
+    const bool complete = ((unsigned int)(m_samplesSqrt * m_samplesSqrt) <= iterationIndex) || m_convergence.isConverged();
 
     if (complete)
     {
@@ -482,6 +563,11 @@ bool Application::render()
     {
       m_raytracer->updateDisplayTexture(); // This directly updates the display HDR texture for all rendering strategies.
 
+      if (m_denoise && m_interop != INTEROP_MODE_PBO) // The PBO is uploaded by the device, there is no host copy to replace it with.
+      {
+        m_rasterizer->setDisplayImage(reinterpret_cast<const float*>(getOutputImage(m_denoiser)));
+      }
+
       m_presentNext = m_present;
     }
 
@@ -509,7 +595,17 @@ bool Application::render()
         
         stream << std::fixed << "Samples number : " << iterationIndex << " / Time elapsed : " << seconds << " s / fps : " << fps;
         if (m_catchVariance)
+        {
             stream << " / Confidence Interval : " << captureVariance() * 100.f << " %";
+            if (0.0f < m_targetError)
+            {
+                stream << " / Converged tiles : " << m_convergence.getNumConvergedTiles() << " / " << m_convergence.getNumTiles();
+            }
+        }
+        if (m_denoise)
+        {
+            stream << " / Denoise : " << m_denoiser.getTime() * 1000.0 << " ms";
+        }
         std::cout << stream.str() << '\n';
 
 #if 0   // Automated benchmark in interactive mode. Change m_isVisibleGUI default to false!
@@ -552,12 +648,23 @@ void Application::benchmark()
     std::ostringstream stream;
     stream.precision(3); // Precision is # digits in fraction part.
     const unsigned int samples_sqrt[6] = { 1,4,16,64,256,1024 };
+    m_convergence.setResolution(m_resolution);
+    m_convergence.reset();
+
+    m_screenshotWriter.wait();
+    m_screenshotWriter.getTimings(); // Reset the statistics.
+
     m_timer.restart();
     for (auto i : samples_sqrt) {
         
-        while (iterationIndex < i)
+        while (iterationIndex < i && !m_convergence.isConverged())
         {
             iterationIndex = m_raytracer->render();
+
+            if (m_catchVariance && m_convergence.isCheckDue(iterationIndex)) // Without variance catching the buffer stays zero.
+            {
+                captureVariance();
+            }
             
             if (i % 32 == 0) {
                 float progress = iterationIndex / 1024.f;
@@ -574,9 +681,25 @@ void Application::benchmark()
         stream << " / Confidence Interval : " << captureVariance() * 100.f << " %\n";
 
         m_prefixScreenshot = std::to_string(i);
-        screenshot(true, standard_prefix + std::to_string(i));
+
+        std::string filename = standard_prefix + std::to_string(i);
+        convertPath(filename);
+
+        // Both files show the same image, run the denoiser only once.
+        const float4* bufferHost = getOutputImage(m_denoiser);
+        captureScreenshot(filename, bufferHost, true, false);
+        captureScreenshot(filename, bufferHost, false, false); // The full precision result as *.exr.
+
+        if (m_convergence.isConverged())
+        {
+            stream << "converged : " << iterationIndex << " spp, max tile error " << m_convergence.getMaxError() * 100.f << " %\n";
+            break; // Further stages would only render the same image.
+        }
     }
     stream << "strategy : "<< m_strategy << ";\n" << "interoperability : " << m_interop << ";\n" << "tilesize : [" << m_tileSize.x << "," << m_tileSize.y << "]";
+
+    m_screenshotWriter.wait(); // All images must be on disk before the results are.
+    stream << '\n' << m_screenshotWriter.getTimings();
     
 
 #if 1 // Automated benchmark in batch mode.
@@ -623,33 +746,51 @@ void Application::createPictures()
   // DAR HACK Load some hardcoded Pictures referenced by the materials.   
   unsigned int flags = IMAGE_FLAG_2D; // Load only the LOD into memory.
 
-  Picture* picture = new Picture();
-  auto ok = picture->load(std::string("./eye.tga"), flags);
-  MY_ASSERT(ok);
-  m_mapPictures[std::string("eye")] = picture;
+  // The textures get a generated mipmap chain for the ray cone LOD selection in the shaders. The 8-bit data of the color textures is sRGB encoded.
+  const unsigned int flagsColor  = IMAGE_FLAG_2D | IMAGE_FLAG_MIPMAP | IMAGE_FLAG_SRGB;
+  const unsigned int flagsCutout = IMAGE_FLAG_2D | IMAGE_FLAG_MIPMAP;
 
-  picture = new Picture();
-  ok = picture->load(std::string("./head.tga"), flags);
-  MY_ASSERT(ok);
-  m_mapPictures[std::string("head")] = picture; // The map owns the pointers. //std::string("albedo")
+  m_pictureLoader.setBudget(size_t(std::max(0, m_textureCacheSize)) << 20);
 
-  picture = new Picture();
-  ok = picture->load(std::string("./NVIDIA_Logo.jpg"), flags);
-  MY_ASSERT(ok);
-  m_mapPictures[std::string("Albedo")] = picture; // The map owns the pointers. //std::string("albedo")
+  // All pictures decode in the background. The constructor waits for them right before initTextures().
+  auto request = [this](std::string const& filename, std::string const& name, const unsigned int flagsPicture)
+  {
+    m_pictureLoader.loadAsync(filename, flagsPicture, [this, name](std::shared_ptr<Picture> picture)
+    {
+      MY_ASSERT(picture);
+      m_mapPictures[name] = picture;
+    });
+  };
 
-  picture = new Picture();
-  ok = picture->load(std::string("./slots_alpha.png"), flags);
-  MY_ASSERT(ok);
-  m_mapPictures[std::string("Cutout")] = picture;
+  request(std::string("./eye.tga"),         std::string("eye"),    flagsColor);
+  request(std::string("./head.tga"),        std::string("head"),   flagsColor);
+  request(std::string("./NVIDIA_Logo.jpg"), std::string("Albedo"), flagsColor);
+  request(std::string("./slots_alpha.png"), std::string("Cutout"), flagsCutout);
 
   if (m_miss == 2 && !m_environment.empty())
   {
     flags |= IMAGE_FLAG_ENV; // Special case for the spherical environment.
-    picture = new Picture();
-    picture->load(m_environment, flags);
-    m_mapPictures[std::string("environment")] = picture;
+    m_pictureLoader.loadAsync(m_environment, flags, [this](std::shared_ptr<Picture> picture)
+    {
+      if (picture)
+      {
+        m_mapPictures[std::string("environment")] = picture;
+      }
+    });
+  }
+}
+
+void Application::initTextures()
+{
+  // The devices only reference the Pictures during the upload. The shared pointers stay owned by m_mapPictures.
+  std::map<std::string, Picture*> mapOfPictures;
+
+  for (std::map<std::string, std::shared_ptr<Picture>>::const_iterator it = m_mapPictures.begin(); it != m_mapPictures.end(); ++it)
+  {
+    mapOfPictures[it->first] = it->second.get();
   }
+
+  m_raytracer->initTextures(mapOfPictures);
 }
 
 void Application::createCameras()
@@ -796,12 +937,12 @@ void Application::createLights()
           // Create the Triangles for this parallelogram light.
           m_mapGeometries[reference] = m_idGeometry;
 
-          std::shared_ptr<sg::Triangles> geometry(new sg::Triangles(m_idGeometry++));
+          std::shared_ptr<sg::Triangles> geometry = m_nodeArena.create<sg::Triangles>(m_idGeometry++);
           geometry->createParallelogram(light.position, light.vecU, light.vecV, light.normal);
           
           m_geometries.push_back(geometry);
 
-          std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+          std::shared_ptr<sg::Instance> instance = m_nodeArena.create<sg::Instance>(m_idInstance++);
           // instance->setTransform(trafo); // Instance default matrix is identity.
           instance->setChild(geometry);
           instance->setMaterial(indexMaterial);
@@ -828,7 +969,7 @@ void Application::guiEventHandler()
   {
     MY_VERIFY( screenshot(true) );
   }
-  if (ImGui::IsKeyPressed('H', false)) // Key H: Save the current linear output buffer into a *.hdr file.
+  if (ImGui::IsKeyPressed('H', false)) // Key H: Save the current linear output buffer into a *.exr file.
   {
     MY_VERIFY( screenshot(false) );
   }
@@ -946,6 +1087,18 @@ void Application::ShowOptionLayout(bool* p_open)
                 m_raytracer->updateState(m_state);
                 refresh = true;
             }
+            if (ImGui::Combo("Sampler", (int*)&m_sampler, "Random\0Sobol\0Sobol Blue Noise\0\0"))
+            {
+                m_state.sampler = m_sampler;
+                m_raytracer->updateState(m_state);
+                refresh = true;
+            }
+            if (ImGui::Checkbox("Env Alias Sampling", &m_envAliasSampling))
+            {
+                m_state.envAliasSampling = m_envAliasSampling;
+                m_raytracer->updateState(m_state);
+                refresh = true;
+            }
             if (ImGui::Checkbox("Lock the camera", &m_lock_camera)){}
             ImGui::Text("Camera POV");
             ImGui::SameLine();
@@ -1037,6 +1190,40 @@ void Application::ShowOptionLayout(bool* p_open)
                     float confidenceInterval = captureVariance();
                     std::cout << "Confidence interval :" << 100.f * confidenceInterval << " %" << std::endl;
                 }
+                float targetError = m_targetError * 100.0f; // Shown in percent.
+                if (ImGui::DragFloat("Target Error %", &targetError, 0.05f, 0.0f, 100.0f, "%.2f"))
+                {
+                    m_targetError = targetError * 0.01f;
+                    m_convergence.setTargetError(m_targetError);
+                    restartRendering();
+                    refresh = true;
+                }
+                if (0.0f < m_targetError)
+                {
+                    ImGui::Text("Converged tiles %u / %u", m_convergence.getNumConvergedTiles(), m_convergence.getNumTiles());
+                }
+            }
+            if (ImGui::Checkbox("Denoise", &m_denoise))
+            {
+                m_presentNext = true; // Show the change without restarting the accumulation.
+            }
+            if (m_denoise)
+            {
+                int iterations = m_denoiser.getIterations();
+                if (ImGui::SliderInt("Denoise Levels", &iterations, 1, 8))
+                {
+                    m_denoiser.setIterations(iterations);
+                    m_denoiserStream.setIterations(iterations);
+                    m_presentNext = true;
+                }
+                float sigma = m_denoiser.getSigmaLuminance();
+                if (ImGui::DragFloat("Denoise Sigma", &sigma, 0.05f, 0.0f, 64.0f, "%.2f"))
+                {
+                    m_denoiser.setSigmaLuminance(sigma);
+                    m_denoiserStream.setSigmaLuminance(sigma);
+                    m_presentNext = true;
+                }
+                ImGui::Text("Denoise %.2f ms", m_denoiser.getTime() * 1000.0);
             }
 
 #if USE_TIME_VIEW
@@ -1274,7 +1461,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 10; i++)
             {
                 parser.getNextToken(token);
-                m_melanineConcentration[i] = std::stof(token);
+                m_melanineConcentration[i] = parseFloat(token);
             }
         }
         if (token == "Melanine_Ratio")
@@ -1282,7 +1469,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 10; i++)
             {
                 parser.getNextToken(token);
-                m_melanineRatio[i] = std::stof(token);
+                m_melanineRatio[i] = parseFloat(token);
             }
         }
         if (token == "Factor_Colorant_HT")
@@ -1290,7 +1477,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 10; i++)
             {
                 parser.getNextToken(token);
-                m_factorColorantHT[i] = std::stof(token);
+                m_factorColorantHT[i] = parseFloat(token);
             }
         }
         if (token == "Dye_Neutral_HT_Concentration")
@@ -1298,7 +1485,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 10; i++)
             {
                 parser.getNextToken(token);
-                m_dyeNeutralHT_Concentration[i] = std::stof(token);
+                m_dyeNeutralHT_Concentration[i] = parseFloat(token);
             }
         }
         if (token == "Dye_Neutral_HT")
@@ -1311,14 +1498,14 @@ void Application::chargeSettingsFromFile(std::string filename)
                 dotposition = token.find_first_of(";", 0);
                 if (dotposition != std::string::npos)
                 {
-                    x = std::stof(token.substr(0, dotposition));
+                    x = parseFloat(std::string_view(token).substr(0, dotposition));
                     previousdotposition = dotposition + 1;
                     dotposition = token.find_first_of(";", previousdotposition);
                     if (dotposition != std::string::npos)
                     {
-                        y = std::stof(token.substr(previousdotposition, dotposition));
+                        y = parseFloat(std::string_view(token).substr(previousdotposition, dotposition));
                         previousdotposition = dotposition + 1;
-                        z = std::stof(token.substr(previousdotposition, std::string::npos));
+                        z = parseFloat(std::string_view(token).substr(previousdotposition, std::string::npos));
                     }
                 }
                 m_dyeNeutralHT[i] = make_float3(x, y, z);
@@ -1329,7 +1516,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 10; i++)
             {
                 parser.getNextToken(token);
-                m_lightened_x10[i] = std::stof(token);
+                m_lightened_x10[i] = parseFloat(token);
             }
         }
         if (token == "Lightened_x2")
@@ -1337,7 +1524,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 10; i++)
             {
                 parser.getNextToken(token);
-                m_lightened_x2[i] = std::stof(token);
+                m_lightened_x2[i] = parseFloat(token);
             }
         }
         if (token == "Lightened_x1")
@@ -1345,20 +1532,20 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 10; i++)
             {
                 parser.getNextToken(token);
-                m_lightened_x1[i] = std::stof(token);
+                m_lightened_x1[i] = parseFloat(token);
             }
         }
         if (token == "Lightened")
         {
             parser.getNextToken(token);
-            lightened = std::stof(token);
+            lightened = parseFloat(token);
         }
         if (token == "Concentration_cendre")
         {
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_concentrationCendre[i] = std::stof(token);
+                m_concentrationCendre[i] = parseFloat(token);
             }
         }
         if (token == "Concentration_irise")
@@ -1366,7 +1553,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_concentrationIrise[i] = std::stof(token);
+                m_concentrationIrise[i] = parseFloat(token);
             }
         }
         if (token == "Concentration_dore")
@@ -1374,7 +1561,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_concentrationDore[i] = std::stof(token);
+                m_concentrationDore[i] = parseFloat(token);
             }
         }
         if (token == "Concentration_cuivre")
@@ -1382,7 +1569,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_concentrationCuivre[i] = std::stof(token);
+                m_concentrationCuivre[i] = parseFloat(token);
             }
         }
         if (token == "Concentration_rouge")
@@ -1390,7 +1577,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_concentrationRouge[i] = std::stof(token);
+                m_concentrationRouge[i] = parseFloat(token);
             }
         }
         if (token == "Concentration_vert")
@@ -1398,7 +1585,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_concentrationVert[i] = std::stof(token);
+                m_concentrationVert[i] = parseFloat(token);
             }
         }
         if (token == "dye_concentration_vert")
@@ -1406,7 +1593,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_dye_ConcentrationVert[i] = std::stof(token);
+                m_dye_ConcentrationVert[i] = parseFloat(token);
             }
         }
         if (token == "dye_concentration_rouge")
@@ -1414,7 +1601,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_dye_ConcentrationRouge[i] = std::stof(token);
+                m_dye_ConcentrationRouge[i] = parseFloat(token);
             }
         }
         if (token == "dye_concentration_cender")
@@ -1422,7 +1609,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_dye_ConcentrationCender[i] = std::stof(token);
+                m_dye_ConcentrationCender[i] = parseFloat(token);
             }
         }
         if (token == "dye_concentration_cover")
@@ -1430,7 +1617,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_dye_ConcentrationCover[i] = std::stof(token);
+                m_dye_ConcentrationCover[i] = parseFloat(token);
             }
         }
         if (token == "dye_concentration_ash")
@@ -1438,7 +1625,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_dye_ConcentrationAsh[i] = std::stof(token);
+                m_dye_ConcentrationAsh[i] = parseFloat(token);
             }
         }
         if (token == "dye_concentration_gold")
@@ -1446,7 +1633,7 @@ void Application::chargeSettingsFromFile(std::string filename)
             for (int i = 0; i < 4; i++)
             {
                 parser.getNextToken(token);
-                m_dye_ConcentrationGold[i] = std::stof(token);
+                m_dye_ConcentrationGold[i] = parseFloat(token);
             }
         }
     }
@@ -2247,6 +2434,7 @@ void Application::guiUserWindow(bool* p_open)
         for (; i < static_cast<int>(m_materialsGUI.size()); ++i)
         {
             bool changed = false;
+            bool matched = false; // Inverse color match result applied.
             
             MaterialGUI& materialGUI = m_materialsGUI[i];
                         
@@ -2368,6 +2556,69 @@ void Application::guiUserWindow(bool* p_open)
                         changed = true;
                     }
                     ImGui::PopID();                                
+
+                    // Estimated color of every HT level with the current dye settings. Clicking one selects that HT.
+                    // Checked every frame, so it also follows material changes done elsewhere, but only evaluated again when the settings changed.
+                    evaluateSwatchPalette(materialGUI, m_swatchPalette);
+
+                    ImGui::Text("Preview");
+                    ImGui::PushID("Palette");
+                    for (int ht = 1; ht <= static_cast<int>(m_swatchPalette.size()); ++ht)
+                    {
+                        const float3 color = m_swatchPalette[ht - 1];
+                        const ImVec4 display(powf(color.x, 1.0f / 2.2f), powf(color.y, 1.0f / 2.2f), powf(color.z, 1.0f / 2.2f), 1.0f);
+                        const std::string label = "HT " + std::to_string(ht);
+                        if (1 < ht)
+                        {
+                            ImGui::SameLine();
+                        }
+                        if (ImGui::ColorButton(label.c_str(), display, (ht == materialGUI.HT) ? 0 : ImGuiColorEditFlags_NoBorder, ImVec2(20, 20)))
+                        {
+                            materialGUI.HT = ht;
+                            materialGUI.melanin_concentration = m_melanineConcentration[materialGUI.HT - 1];
+                            materialGUI.dyeNeutralHT_Concentration = m_dyeNeutralHT_Concentration[materialGUI.HT - 1];
+                            materialGUI.dyeNeutralHT = m_dyeNeutralHT[materialGUI.HT - 1];
+                            materialGUI.melanin_ratio = m_melanineRatio[materialGUI.HT - 1];
+                            changed = true;
+                        }
+                    }
+                    ImGui::PopID();
+
+                    // Inverse color matching: Search the HT and dye settings which come closest to a target color.
+                    ImGui::PushID("Match");
+                    ImGui::ColorEdit3("Target", (float*)&m_colorMatchTarget, ImGuiColorEditFlags_NoInputs);
+                    ImGui::SameLine();
+                    ImGui::Checkbox("Refine Melanin", &m_colorMatchRefine);
+                    ImGui::SameLine();
+                    if (m_colorMatchTask.valid())
+                    {
+                        ImGui::Text("Matching...");
+                    }
+                    else if (ImGui::Button("Match"))
+                    {
+                        const float3 target = make_float3(powf(m_colorMatchTarget.x, 2.2f), powf(m_colorMatchTarget.y, 2.2f), powf(m_colorMatchTarget.z, 2.2f));
+                        matchHairColor(materialGUI, target, m_colorMatchRefine);
+                    }
+                    for (size_t m = 0; m < m_colorMatches.size(); ++m)
+                    {
+                        HairColorCandidate const& match = m_colorMatches[m];
+
+                        const ImVec4 display(powf(match.color.x, 1.0f / 2.2f), powf(match.color.y, 1.0f / 2.2f), powf(match.color.z, 1.0f / 2.2f), 1.0f);
+                        const std::string label = "HT " + std::to_string(match.material.HT) + ", dE " + std::to_string(match.error);
+                        if (0 < m)
+                        {
+                            ImGui::SameLine();
+                        }
+                        if (ImGui::ColorButton(label.c_str(), display, 0, ImVec2(20, 20)))
+                        {
+                            // Keep the name. The refined melanin values must not be recalculated by the updates of the changed case.
+                            const std::string name = materialGUI.name;
+                            materialGUI = match.material;
+                            materialGUI.name = name;
+                            matched = true;
+                        }
+                    }
+                    ImGui::PopID();
                 }
                
                 if (changed)
@@ -2380,6 +2631,11 @@ void Application::guiUserWindow(bool* p_open)
                     m_raytracer->updateMaterial(i, materialGUI);
                     refresh = true;                   
                 }
+                else if (matched)
+                {
+                    m_raytracer->updateMaterial(i, materialGUI);
+                    refresh = true;
+                }
                 ImGui::TreePop();                
             }
         }
@@ -2696,13 +2952,19 @@ void Application::guiUserWindow(bool* p_open)
                         m_environment = m_HDR[n].file_name;
                         convertPath(m_environment);
 
-                        Picture* picture = new Picture();
-                        picture->load(m_environment, IMAGE_FLAG_2D);
-                        delete m_mapPictures[std::string("environment")];
-                        m_mapPictures[std::string("environment")] = picture;
-                        m_raytracer->initTextures(m_mapPictures);
-                        m_raytracer->initLights(m_lights);
-                        m_raytracer->updateCamera(0, m_cameras[0]);
+                        // Decode in the background. Environments used before come straight from the cache.
+                        const std::string environment = m_environment;
+                        m_pictureLoader.loadAsync(environment, IMAGE_FLAG_2D | IMAGE_FLAG_ENV, [this, environment](std::shared_ptr<Picture> picture)
+                        {
+                          if (!picture || environment != m_environment) // Failed, or a newer selection superseded this one.
+                          {
+                            return;
+                          }
+                          m_mapPictures[std::string("environment")] = picture;
+                          initTextures();
+                          m_raytracer->initLights(m_lights);
+                          m_raytracer->updateCamera(0, m_cameras[0]);
+                        });
                     }
                 }
                 if (is_selected)
@@ -2787,7 +3049,7 @@ void Application::guiUserWindow(bool* p_open)
                         if (itg1 == m_mapGeometries.end())
                         {
                             m_mapGeometries[keyGeometry1.str()] = m_idGeometry;
-                            geometry_left = std::make_shared<sg::Curves>(m_idGeometry++);
+                            geometry_left = m_nodeArena.create<sg::Curves>(m_idGeometry++);
                             const char* file = current_item_model->file_name.c_str();
                             if (current_item_model->material1Name != current_item_model->material2Name)
                                 geometry_left->createHairFromFile(file, true);
@@ -2796,7 +3058,7 @@ void Application::guiUserWindow(bool* p_open)
                             m_geometries.push_back(geometry_left);
                         }
                         else
-                            geometry_left = std::dynamic_pointer_cast<sg::Curves>(m_geometries[itg1->second]);
+                            geometry_left = std::static_pointer_cast<sg::Curves>(m_geometries[itg1->second]);
                         appendInstance(m_scene, geometry_left, curMatrix, current_item_model->material1Name, m_idInstance);
 
                         if (current_item_model->material1Name != current_item_model->material2Name)
@@ -2806,17 +3068,17 @@ void Application::guiUserWindow(bool* p_open)
                             if (itg2 == m_mapGeometries.end())
                             {
                                 m_mapGeometries[keyGeometry2.str()] = m_idGeometry;
-                                geometry_right = std::make_shared<sg::Curves>(m_idGeometry++);
+                                geometry_right = m_nodeArena.create<sg::Curves>(m_idGeometry++);
                                 const char* file = current_item_model->file_name.c_str();
                                 geometry_right->createHairFromFile(file, false);
                                 m_geometries.push_back(geometry_right);
                             }
                             else
-                                geometry_right = std::dynamic_pointer_cast<sg::Curves>(m_geometries[itg2->second]);
+                                geometry_right = std::static_pointer_cast<sg::Curves>(m_geometries[itg2->second]);
                             appendInstance(m_scene, geometry_right, curMatrix, current_item_model->material2Name, m_idInstance);
                         }
                         m_raytracer->initMaterials(m_materialsGUI);
-                        m_raytracer->initScene(m_scene, m_idGeometry); // m_idGeometry is the number of geometries in the scene
+                        m_raytracer->updateScene(m_scene, m_idGeometry); // Only builds the new hair GAS, the TLAS and the hit group records.
                         refresh = true;
                         m_isValid = true;
                         m_raytracer->updateCamera(0, m_cameras[0]);
@@ -3003,7 +3265,10 @@ void Application::guiUserWindow(bool* p_open)
         }
         if (geo_changed||emi_changed) {
             //m_raytracer->initMaterials(m_materialsGUI);
-            //m_raytracer->initScene(m_scene, m_idGeometry);
+            if (geo_changed)
+            {
+                m_raytracer->updateScene(m_scene, m_idGeometry); // Only the TLAS changes, the light geometry keeps its GAS.
+            }
             m_raytracer->initLights(m_lights);
             m_raytracer->updateCamera(0, m_cameras[0]);
             geo_changed = false;
@@ -3058,7 +3323,7 @@ void Application::guiUserWindow(bool* p_open)
 
         if (geo_changed)
         {
-            m_raytracer->initScene(m_scene, m_idGeometry);
+            m_raytracer->updateScene(m_scene, m_idGeometry);
             m_raytracer->initLights(m_lights);
             m_raytracer->updateCamera(0, m_cameras[0]);
             geo_changed = false;
@@ -3115,27 +3380,33 @@ void Application::guiUserWindow(bool* p_open)
 void Application::updateHT(MaterialGUI& materialGUI)
 {
     float result = 0;
+
+    // The neighbouring HT levels of HT 1 and 10 don't exist. Clamp to the table to not read outside of it.
+    auto melanin = [this](const int index)
+    {
+        return m_melanineConcentration[std::max(0, std::min(index, 9))];
+    };
     
     // hot color
     materialGUI.melanin_concentration = m_melanineConcentration[materialGUI.HT-1];   
 
     if ( materialGUI.int_IriseDore_Concentration == 7 || materialGUI.int_IriseDore_Concentration == 8)
     {
-        result -= (m_melanineConcentration[materialGUI.HT - 1] - m_melanineConcentration[materialGUI.HT])/2;
+        result -= (melanin(materialGUI.HT - 1) - melanin(materialGUI.HT))/2;
     }
     if (materialGUI.int_CendreCuivre_Concentration == 7 || materialGUI.int_CendreCuivre_Concentration == 8)
     {
-        result -= (m_melanineConcentration[materialGUI.HT - 1] - m_melanineConcentration[materialGUI.HT])/4;
+        result -= (melanin(materialGUI.HT - 1) - melanin(materialGUI.HT))/4;
     }
     if (  materialGUI.int_VertRouge_Concentration == 7 || materialGUI.int_VertRouge_Concentration == 8)
     { 
-         result -= (m_melanineConcentration[materialGUI.HT-1] - m_melanineConcentration[materialGUI.HT])/4 ;
+         result -= (melanin(materialGUI.HT - 1) - melanin(materialGUI.HT))/4 ;
     } 
 
     // ROUGE 
     if (materialGUI.int_VertRouge_Concentration == 0 || materialGUI.int_VertRouge_Concentration == 1 || materialGUI.int_VertRouge_Concentration == 2)
     {
-        result -= (m_melanineConcentration[materialGUI.HT - 1] - m_melanineConcentration[materialGUI.HT]) / 2;
+        result -= (melanin(materialGUI.HT - 1) - melanin(materialGUI.HT)) / 2;
     }
 
    
@@ -3162,14 +3433,14 @@ void Application::updateHT(MaterialGUI& materialGUI)
 // CENDER "01" IRISE "02" 
     else if (materialGUI.int_CendreCuivre_Concentration == 3 || materialGUI.int_IriseDore_Concentration == 3)
     {
-        result -= (m_melanineConcentration[materialGUI.HT - 1] - m_melanineConcentration[materialGUI.HT]) / 2;
+        result -= (melanin(materialGUI.HT - 1) - melanin(materialGUI.HT)) / 2;
     }
 
 
 //VERT "7" 
     if (materialGUI.int_VertRouge_Concentration == 0 || materialGUI.int_VertRouge_Concentration == 1 || materialGUI.int_VertRouge_Concentration == 2)
     {
-        result -= (m_melanineConcentration[materialGUI.HT - 2] - m_melanineConcentration[materialGUI.HT - 1])/2;
+        result -= (melanin(materialGUI.HT - 2) - melanin(materialGUI.HT - 1))/2;
     }
 
 
@@ -3444,6 +3715,110 @@ void Application::updateDYE( MaterialGUI& materialGUI)
        materialGUI.dye = rgb;
 }
 
+void Application::evaluateSwatchPalette(MaterialGUI const& material, std::vector<float3>& palette)
+{
+    // Same steps as the HT slider followed by the dye updates in guiUserWindow().
+    std::vector<MaterialGUI> levels(10, material);
+    for (int ht = 1; ht <= static_cast<int>(levels.size()); ++ht)
+    {
+        MaterialGUI& materialGUI = levels[ht - 1];
+
+        materialGUI.HT = ht;
+        materialGUI.melanin_concentration = m_melanineConcentration[ht - 1];
+        materialGUI.dyeNeutralHT_Concentration = m_dyeNeutralHT_Concentration[ht - 1];
+        materialGUI.dyeNeutralHT = m_dyeNeutralHT[ht - 1];
+        materialGUI.melanin_ratio = m_melanineRatio[ht - 1];
+
+        updateDYEinterface(materialGUI);
+        updateDYE(materialGUI);
+        updateDYEconcentration(materialGUI);
+        updateHT(materialGUI);
+    }
+
+    bool changed = (levels.size() != m_swatchPaletteLevels.size() || levels.size() != palette.size());
+    for (size_t i = 0; i < levels.size() && !changed; ++i)
+    {
+        changed = !HairSwatch::isEquivalent(levels[i], m_swatchPaletteLevels[i]);
+    }
+
+    if (changed)
+    {
+        m_hairSwatch.evaluate(levels, palette);
+        m_swatchPaletteLevels.swap(levels);
+    }
+}
+
+void Application::matchHairColor(MaterialGUI const& material, float3 const& target, const bool refineMelanin)
+{
+    // All HT levels and dye slider positions of the user GUI.
+    std::vector<MaterialGUI> candidates;
+    candidates.reserve(10 * 9 * 9 * 9);
+
+    for (int ht = 1; ht <= 10; ++ht)
+    {
+        for (int vertRouge = 0; vertRouge <= 8; ++vertRouge)
+        {
+            for (int cendreCuivre = 0; cendreCuivre <= 8; ++cendreCuivre)
+            {
+                for (int iriseDore = 0; iriseDore <= 8; ++iriseDore)
+                {
+                    MaterialGUI materialGUI = material;
+
+                    materialGUI.HT = ht;
+                    materialGUI.melanin_concentration = m_melanineConcentration[ht - 1];
+                    materialGUI.dyeNeutralHT_Concentration = m_dyeNeutralHT_Concentration[ht - 1];
+                    materialGUI.dyeNeutralHT = m_dyeNeutralHT[ht - 1];
+                    materialGUI.melanin_ratio = m_melanineRatio[ht - 1];
+                    materialGUI.int_VertRouge_Concentration = vertRouge;
+                    materialGUI.int_CendreCuivre_Concentration = cendreCuivre;
+                    materialGUI.int_IriseDore_Concentration = iriseDore;
+
+                    updateDYEinterface(materialGUI);
+                    updateDYE(materialGUI);
+                    updateDYEconcentration(materialGUI);
+                    updateHT(materialGUI);
+
+                    candidates.push_back(materialGUI);
+                }
+            }
+        }
+    }
+
+    // The search takes too long for the GUI thread. dispatchColorMatch() picks up the result.
+    m_colorMatchCandidates = candidates.size();
+    m_colorMatchTimer.restart();
+
+    m_colorMatchTask = ThreadPool::getInstance().submit([this, target, refineMelanin, candidates = std::move(candidates)]()
+    {
+        return m_hairColorMatch.match(target, candidates, 8, refineMelanin);
+    });
+}
+
+void Application::dispatchColorMatch()
+{
+    if (!m_colorMatchTask.valid() || m_colorMatchTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return;
+    }
+
+    try
+    {
+        m_colorMatches = m_colorMatchTask.get();
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "ERROR: dispatchColorMatch() color matching failed: " << e.what() << '\n';
+        m_colorMatches.clear();
+    }
+
+    std::cout << "matchHairColor(): " << m_colorMatchCandidates << " candidates in " << m_colorMatchTimer.getTime() * 1000.0 << " ms";
+    if (!m_colorMatches.empty())
+    {
+        std::cout << ", best delta E = " << m_colorMatches[0].error;
+    }
+    std::cout << '\n';
+}
+
 void Application::guiRenderingIndicator(const bool isRendering)
 {
   // NVIDIA Green when rendering is complete.
@@ -3469,6 +3844,19 @@ void Application::guiRenderingIndicator(const bool isRendering)
 
 bool Application::loadSystemDescription(std::string const& filename)
 {
+  // JSON descriptions are streamed through the ConfigParser, everything else is the keyword text format.
+  if (ConfigParser::isJsonFile(filename))
+  {
+    ConfigParser parser;
+
+    if (!parser.load(filename))
+    {
+      std::cerr << "ERROR: loadSystemDescription() failed in loadString(" << filename << ")\n";
+      return false;
+    }
+    return parseSystemDescription(parser);
+  }
+
   Parser parser;
 
   if (!parser.load(filename))
@@ -3476,7 +3864,13 @@ bool Application::loadSystemDescription(std::string const& filename)
     std::cerr << "ERROR: loadSystemDescription() failed in loadString(" << filename << ")\n";
     return false;
   }
+  return parseSystemDescription(parser);
+}
 
+// Both description formats return the same tokens, see ConfigParser.h.
+template <typename TParser>
+bool Application::parseSystemDescription(TParser& parser)
+{
   ParserTokenType tokenType;
   std::string token;
 
@@ -3484,7 +3878,7 @@ bool Application::loadSystemDescription(std::string const& filename)
   {
     if (tokenType == PTT_UNKNOWN)
     {
-      std::cerr << "ERROR: loadSystemDescription() " << filename << " (" << parser.getLine() << "): Unknown token type.\n";
+      std::cerr << "ERROR: loadSystemDescription() " << parser.getLocation() << ": Unknown token type.\n";
       MY_ASSERT(!"Unknown token type.");
       return false;
     }
@@ -3495,7 +3889,7 @@ bool Application::loadSystemDescription(std::string const& filename)
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        const int strategy = atoi(token.c_str());
+        const int strategy = parseInt(token);
         if (0 <= strategy && strategy < NUM_RENDERER_STRATEGIES)
         {
           m_strategy = static_cast<RendererStrategy>(strategy);
@@ -3509,13 +3903,13 @@ bool Application::loadSystemDescription(std::string const& filename)
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_devicesMask = atoi(token.c_str());
+        m_devicesMask = parseInt(token);
       }
       else if (token == "interop")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_interop = atoi(token.c_str());
+        m_interop = parseInt(token);
         if (m_interop < 0 || 2 < m_interop)
         {
           std::cerr << "WARNING: loadSystemDescription() Invalid interop value " << m_interop << ", using interop 0 (host).\n";
@@ -3526,25 +3920,25 @@ bool Application::loadSystemDescription(std::string const& filename)
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_present = (atoi(token.c_str()) != 0);
+        m_present = (parseInt(token) != 0);
       }
       else if (token == "resolution")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_resolution.x = std::max(1, atoi(token.c_str()));
+        m_resolution.x = std::max(1, parseInt(token));
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_resolution.y = std::max(1, atoi(token.c_str()));
+        m_resolution.y = std::max(1, parseInt(token));
       }
       else if (token == "tileSize")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tileSize.x = std::max(1, atoi(token.c_str()));
+        m_tileSize.x = std::max(1, parseInt(token));
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tileSize.y = std::max(1, atoi(token.c_str()));
+        m_tileSize.y = std::max(1, parseInt(token));
        
         // Make sure the values are power-of-two.
         if (m_tileSize.x & (m_tileSize.x - 1))
@@ -3562,13 +3956,13 @@ bool Application::loadSystemDescription(std::string const& filename)
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_samplesSqrt = std::max(1, atoi(token.c_str()));  // spp = m_samplesSqrt * m_samplesSqrt
+        m_samplesSqrt = std::max(1, parseInt(token));  // spp = m_samplesSqrt * m_samplesSqrt
       }
       else if (token == "miss")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_miss = atoi(token.c_str());
+        m_miss = parseInt(token);
       }
       else if (token == "envMap")
       {
@@ -3589,19 +3983,19 @@ bool Application::loadSystemDescription(std::string const& filename)
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_environmentRotation = (float) atof(token.c_str());
+        m_environmentRotation = parseFloat(token);
       }
       else  if (token == "clockFactor")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_clockFactor = (float) atof(token.c_str());
+        m_clockFactor = parseFloat(token);
       }
       else if (token == "light")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        int light = atoi(token.c_str());
+        int light = parseInt(token);
         if (light < 0||light>5)
         {
           light = 0;
@@ -3612,38 +4006,84 @@ bool Application::loadSystemDescription(std::string const& filename)
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_pathLengths.x = atoi(token.c_str()); // min path length before Russian Roulette kicks in
+        m_pathLengths.x = parseInt(token); // min path length before Russian Roulette kicks in
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_pathLengths.y = atoi(token.c_str()); // max path length
+        m_pathLengths.y = parseInt(token); // max path length
       }
       else if (token == "epsilonFactor")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_epsilonFactor = (float) atof(token.c_str());
+        m_epsilonFactor = parseFloat(token);
       }
       else if (token == "lensShader")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_lensShader = static_cast<LensShader>(atoi(token.c_str()));
+        m_lensShader = static_cast<LensShader>(parseInt(token));
         if (m_lensShader < LENS_SHADER_PINHOLE || LENS_SHADER_SPHERE < m_lensShader)
         {
           m_lensShader = LENS_SHADER_PINHOLE;
         }
       }
+      else if (token == "sampler")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_sampler = static_cast<SamplerType>(parseInt(token));
+        if (m_sampler < SAMPLER_LCG || SAMPLER_SOBOL_BLUE_NOISE < m_sampler)
+        {
+          m_sampler = SAMPLER_LCG;
+        }
+      }
+      else if (token == "envAliasSampling")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_envAliasSampling = (parseInt(token) != 0);
+      }
+      else if (token == "textureCacheSize")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_textureCacheSize = std::max(0, parseInt(token));
+      }
+      else if (token == "textureCompression")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_textureCompression = std::min(std::max(0, parseInt(token)), 2);
+      }
+      else if (token == "textureHalfFloat")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_textureHalfFloat = (parseInt(token) != 0);
+      }
+      else if (token == "exrHalf")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_exrHalf = (parseInt(token) != 0);
+      }
+      else if (token == "exrCompression")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_exrCompression = ExrCompression(std::min(std::max(0, parseInt(token)), int(EXR_COMPRESSION_ZIP)));
+      }
       else if (token == "center")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        const float x = (float) atof(token.c_str());
+        const float x = parseFloat(token);
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        const float y = (float) atof(token.c_str());
+        const float y = parseFloat(token);
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        const float z = (float) atof(token.c_str());
+        const float z = parseFloat(token);
         m_camera.m_center = make_float3(x, y, z);
         m_camera.markDirty();
       }
@@ -3656,16 +4096,16 @@ bool Application::loadSystemDescription(std::string const& filename)
         Camera camera;
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        camera.m_phi = (float) atof(token.c_str());
+        camera.m_phi = parseFloat(token);
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        camera.m_theta = (float)atof(token.c_str());
+        camera.m_theta = parseFloat(token);
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        camera.m_fov = (float)atof(token.c_str());
+        camera.m_fov = parseFloat(token);
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        camera.m_distance = (float)atof(token.c_str());
+        camera.m_distance = parseFloat(token);
         camera.markDirty();
         if (m_camera_pov.size() == 0)
         {
@@ -3698,65 +4138,109 @@ bool Application::loadSystemDescription(std::string const& filename)
           convertPath(token);
           m_prefixSettings = token;
       }
+      else if (token == "sceneSnapshot")
+      {
+        tokenType = parser.getNextToken(token); // Needs to be a filename in quotation marks.
+        MY_ASSERT(tokenType == PTT_STRING);
+        convertPath(token);
+        m_sceneSnapshot = token;
+      }
+      else if (token == "meshCache")
+      {
+        tokenType = parser.getNextToken(token); // Needs to be a path in quotation marks.
+        MY_ASSERT(tokenType == PTT_STRING);
+        convertPath(token);
+        m_meshCache = token;
+      }
+      else if (token == "nodeArena")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_useNodeArena = (parseInt(token) != 0);
+      }
+      else if (token == "sceneGraphBenchmark")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_sceneGraphBenchmark = std::max(0, parseInt(token));
+      }
+      else if (token == "mipmapBenchmark")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_mipmapBenchmark = std::max(0, parseInt(token));
+      }
       else if (token == "gamma")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.gamma = (float) atof(token.c_str());
+        m_tonemapperGUI.gamma = parseFloat(token);
       }
       else if (token == "colorBalance")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.colorBalance[0] = (float) atof(token.c_str());
+        m_tonemapperGUI.colorBalance[0] = parseFloat(token);
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.colorBalance[1] = (float) atof(token.c_str());
+        m_tonemapperGUI.colorBalance[1] = parseFloat(token);
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.colorBalance[2] = (float) atof(token.c_str());
+        m_tonemapperGUI.colorBalance[2] = parseFloat(token);
       }
       else if (token == "whitePoint")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.whitePoint = (float) atof(token.c_str());
+        m_tonemapperGUI.whitePoint = parseFloat(token);
       }
       else if (token == "burnHighlights")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.burnHighlights = (float) atof(token.c_str());
+        m_tonemapperGUI.burnHighlights = parseFloat(token);
       }
       else if (token == "crushBlacks")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.crushBlacks = (float) atof(token.c_str());
+        m_tonemapperGUI.crushBlacks = parseFloat(token);
       }
       else if (token == "saturation")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.saturation = (float) atof(token.c_str());
+        m_tonemapperGUI.saturation = parseFloat(token);
       }
       else if (token == "brightness")
       {
         tokenType = parser.getNextToken(token);
         MY_ASSERT(tokenType == PTT_VAL);
-        m_tonemapperGUI.brightness = (float) atof(token.c_str());
+        m_tonemapperGUI.brightness = parseFloat(token);
       }
       else if (token == "screenshotImageNum")
       {
       tokenType = parser.getNextToken(token);
       MY_ASSERT(tokenType == PTT_VAL);
-      m_screenshotImageNum = atoi(token.c_str());
+      m_screenshotImageNum = parseInt(token);
       }
       else if (token == "catchVariance")
       {
       tokenType = parser.getNextToken(token);
       MY_ASSERT(tokenType == PTT_VAL);
-      m_catchVariance = (atoi(token.c_str()) != 0);
+      m_catchVariance = (parseInt(token) != 0);
+      }
+      else if (token == "targetError")
+      {
+      tokenType = parser.getNextToken(token);
+      MY_ASSERT(tokenType == PTT_VAL);
+      m_targetError = std::max(0.0f, parseFloat(token));
+      }
+      else if (token == "denoise")
+      {
+      tokenType = parser.getNextToken(token);
+      MY_ASSERT(tokenType == PTT_VAL);
+      m_denoise = (parseInt(token) != 0);
       }
       else
       {
@@ -3777,6 +4261,8 @@ bool Application::saveSystemDescription()
   description << "interop " << m_interop << '\n';
   description << "present " << ((m_catchVariance) ? "1" : "0") << '\n';
   description << "catchVariance " << ((m_catchVariance) ? "1" : "0") << '\n';
+  description << "targetError " << m_targetError << '\n';
+  description << "denoise " << ((m_denoise) ? "1" : "0") << '\n';
   description << "resolution " << m_resolution.x << " " << m_resolution.y << '\n';
   description << "tileSize " << m_tileSize.x << " " << m_tileSize.y << '\n';
   description << "samplesSqrt " << m_samplesSqrt << '\n';
@@ -3794,12 +4280,28 @@ bool Application::saveSystemDescription()
   description << "pathLengths " << m_pathLengths.x << " " << m_pathLengths.y << '\n';
   description << "epsilonFactor " << m_epsilonFactor << '\n';
   description << "lensShader " << m_lensShader << '\n';
+  description << "sampler " << m_sampler << '\n';
+  description << "envAliasSampling " << ((m_envAliasSampling) ? "1" : "0") << '\n';
+  description << "textureCacheSize " << m_textureCacheSize << '\n';
+  description << "textureCompression " << m_textureCompression << '\n';
+  description << "textureHalfFloat " << ((m_textureHalfFloat) ? "1" : "0") << '\n';
+  description << "exrHalf " << ((m_exrHalf) ? "1" : "0") << '\n';
+  description << "exrCompression " << int(m_exrCompression) << '\n';
   description << "center " << m_camera.m_center.x << " " << m_camera.m_center.y << " " << m_camera.m_center.z << '\n';
   description << "camera " << m_camera.m_phi << " " << m_camera.m_theta << " " << m_camera.m_fov << " " << m_camera.m_distance << '\n';
   if (!m_prefixScreenshot.empty())
   {
     description << "prefixScreenshot \"" << m_prefixScreenshot << "\"\n";
   }
+  if (!m_sceneSnapshot.empty())
+  {
+    description << "sceneSnapshot \"" << m_sceneSnapshot << "\"\n";
+  }
+  if (!m_meshCache.empty())
+  {
+    description << "meshCache \"" << m_meshCache << "\"\n";
+  }
+  description << "nodeArena " << ((m_useNodeArena) ? 1 : 0) << '\n';
   description << "gamma " << m_tonemapperGUI.gamma << '\n';
   description << "colorBalance " << m_tonemapperGUI.colorBalance[0] << " " << m_tonemapperGUI.colorBalance[1] << " " << m_tonemapperGUI.colorBalance[2] << '\n';
   description << "whitePoint " << m_tonemapperGUI.whitePoint << '\n';
@@ -3835,7 +4337,7 @@ void Application::appendInstance(std::shared_ptr<sg::Group>& group,
             matrix[2][3] == 0.0f && 
             matrix[3][3] == 1.0f);
 
-  std::shared_ptr<sg::Instance> instance(new sg::Instance(idInstance++));
+  std::shared_ptr<sg::Instance> instance = m_nodeArena.create<sg::Instance>(idInstance++);
   instance->setTransform(trafo);
   instance->setChild(geometry);
 
@@ -3865,18 +4367,219 @@ void Application::appendInstance(std::shared_ptr<sg::Group>& group,
   group->addChild(instance);
 }
 
+void Application::submitModelTask(std::function<void()>&& task)
+{
+  m_modelTasks.push_back(ThreadPool::getInstance().submit(std::move(task)));
+}
 
-bool Application::loadSceneDescription(std::string const& filename)
+void Application::submitASSIMP(std::string const& filename, std::shared_ptr<sg::Instance> const& instance)
 {
-  Parser parser;
+  // Models of a previous scene description are instanced directly.
+  std::map< std::string, std::shared_ptr<sg::Group> >::const_iterator itGroup = m_mapGroups.find(filename);
+  if (itGroup != m_mapGroups.end())
+  {
+    instance->setChild(itGroup->second);
+    return;
+  }
 
-  if (!parser.load(filename))
+  // The same file is only imported once, all its instances share the resulting group.
+  for (PendingASSIMP& pending : m_pendingASSIMP)
   {
-    std::cerr << "ERROR: loadSceneDescription() failed in loadString(" << filename << ")\n";
-    return false;
+    if (pending.filename == filename)
+    {
+      pending.instances.push_back(instance);
+      return;
+    }
   }
 
-  ParserTokenType tokenType;
+  if (m_pendingASSIMP.empty())
+  {
+    // The DefaultLogger is a global shared by all imports in flight, messages of concurrent imports can interleave.
+    Assimp::Logger::LogSeverity severity = Assimp::Logger::NORMAL; // or Assimp::Logger::VERBOSE;
+
+    Assimp::DefaultLogger::create("", severity, aiDefaultLogStream_STDOUT);               // Create a logger instance for Console Output
+    //Assimp::DefaultLogger::create("assimp_log.txt", severity, aiDefaultLogStream_FILE); // Create a logger instance for File Output (found in project folder or near .exe)
+
+    Assimp::DefaultLogger::get()->info("Assimp::DefaultLogger initialized."); // Will add message with "info" tag.
+    // Assimp::DefaultLogger::get()->debug(""); // Will add message with "debug" tag.
+  }
+
+  PendingASSIMP pending;
+
+  pending.filename   = filename;
+  pending.idGeometry = m_idGeometry;
+  const std::string meshCache = m_meshCache;
+
+  pending.model = ThreadPool::getInstance().submit([filename, meshCache]() { return importASSIMP(filename, meshCache); });
+  pending.instances.push_back(instance);
+
+  m_pendingASSIMP.push_back(std::move(pending));
+}
+
+void Application::resolveModelTasks()
+{
+  if (m_modelTasks.empty() && m_pendingASSIMP.empty())
+  {
+    return;
+  }
+
+  Timer timer;
+  timer.start();
+
+  const size_t numTasks = m_modelTasks.size() + m_pendingASSIMP.size();
+
+  for (std::future<void>& task : m_modelTasks)
+  {
+    try
+    {
+      task.get();
+    }
+    catch (std::exception const& e)
+    {
+      // The geometry stays empty, the same as when the loaders report a missing file.
+      std::cerr << "ERROR: resolveModelTasks() model loading failed: " << e.what() << '\n';
+    }
+  }
+  m_modelTasks.clear();
+
+  // The geometry IDs a model gets here, behind all geometries of the scene description.
+  struct GeometryRange
+  {
+    unsigned int position; // PendingASSIMP::idGeometry
+    unsigned int first;
+    unsigned int count;
+  };
+  std::vector<GeometryRange> ranges;
+
+  const unsigned int numParsed = m_idGeometry;
+
+  // Building the groups allocates node IDs, do it in the order the files appeared in the scene description.
+  for (PendingASSIMP& pending : m_pendingASSIMP)
+  {
+    const unsigned int first = m_idGeometry;
+
+    std::shared_ptr<ImportedModel> model;
+    try
+    {
+      model = pending.model.get();
+    }
+    catch (std::exception const& e)
+    {
+      std::cerr << "ERROR: resolveModelTasks() importing " << pending.filename << " failed: " << e.what() << '\n';
+    }
+
+    std::shared_ptr<sg::Group> group = createASSIMP(pending.filename, model.get());
+
+    for (std::shared_ptr<sg::Instance> const& instance : pending.instances)
+    {
+      instance->setChild(group);
+    }
+
+    if (first < m_idGeometry)
+    {
+      ranges.push_back({ pending.idGeometry, first, m_idGeometry - first });
+    }
+  }
+
+  // Move the geometries of each model to the position of its assimp keyword, so the geometry IDs and m_geometries indices
+  // are the same as when the models were imported while parsing. The instances reference the nodes, only the IDs change.
+  if (!ranges.empty() && ranges.front().position < numParsed)
+  {
+    std::vector<unsigned int> remap(m_geometries.size());
+
+    unsigned int next   = 0;
+    unsigned int parsed = 0;
+    for (GeometryRange const& range : ranges)
+    {
+      while (parsed < range.position)
+      {
+        remap[parsed++] = next++;
+      }
+      for (unsigned int i = 0; i < range.count; ++i)
+      {
+        remap[range.first + i] = next++;
+      }
+    }
+    while (parsed < numParsed)
+    {
+      remap[parsed++] = next++;
+    }
+    MY_ASSERT(next == m_geometries.size());
+
+    std::vector< std::shared_ptr<sg::Node> > geometries(m_geometries.size());
+    for (size_t i = 0; i < m_geometries.size(); ++i)
+    {
+      m_geometries[i]->setId(remap[i]);
+      geometries[remap[i]] = std::move(m_geometries[i]);
+    }
+    m_geometries.swap(geometries);
+
+    for (auto& it : m_mapGeometries)
+    {
+      it.second = remap[it.second];
+    }
+  }
+
+  if (!m_pendingASSIMP.empty())
+  {
+    m_pendingASSIMP.clear();
+
+    Assimp::DefaultLogger::kill(); // Kill it after the work is done
+  }
+
+  timer.stop();
+  std::cout << "resolveModelTasks(): " << numTasks << " models loaded in " << timer.getTime() << " seconds\n";
+}
+
+// Replaces the Triangles geometries which have the same content as an earlier one with that one.
+void Application::shareGeometries()
+{
+  Timer timer;
+  timer.start();
+
+  std::vector< std::shared_ptr<sg::Group> > roots;
+
+  roots.push_back(m_scene);
+  for (auto const& it : m_mapGroups)
+  {
+    roots.push_back(it.second);
+  }
+
+  m_geometryRegistry.share(m_geometries, roots);
+
+  timer.stop();
+  std::cout << "shareGeometries(): " << m_geometryRegistry.getNumShared() << " of " << m_geometries.size() << " geometries shared in " << timer.getTime() << " seconds\n";
+}
+
+
+bool Application::loadSceneDescription(std::string const& filename)
+{
+  if (ConfigParser::isJsonFile(filename))
+  {
+    ConfigParser parser;
+
+    if (!parser.load(filename))
+    {
+      std::cerr << "ERROR: loadSceneDescription() failed in loadString(" << filename << ")\n";
+      return false;
+    }
+    return parseSceneDescription(parser);
+  }
+
+  Parser parser;
+
+  if (!parser.load(filename))
+  {
+    std::cerr << "ERROR: loadSceneDescription() failed in loadString(" << filename << ")\n";
+    return false;
+  }
+  return parseSceneDescription(parser);
+}
+
+template <typename TParser>
+bool Application::parseSceneDescription(TParser& parser)
+{
+  ParserTokenType tokenType;
   std::string token;
 
   // Reusing some math routines from the NVIDIA nvpro-pipeline https://github.com/nvpro-pipeline/pipeline
@@ -3950,7 +4653,7 @@ bool Application::loadSceneDescription(std::string const& filename)
   {
     if (tokenType == PTT_UNKNOWN)
     {
-      std::cerr << "ERROR: loadSceneDescription() " << filename << " (" << parser.getLine() << "): Unknown token type.\n";
+      std::cerr << "ERROR: loadSceneDescription() " << parser.getLocation() << ": Unknown token type.\n";
       MY_ASSERT(!"Unknown token type.");
       return false;
     }
@@ -3972,118 +4675,118 @@ bool Application::loadSceneDescription(std::string const& filename)
         case KS_ALBEDO:
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curAlbedo.x = (float) atof(token.c_str());
+          curAlbedo.x = parseFloat(token);
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curAlbedo.y = (float) atof(token.c_str());
+          curAlbedo.y = parseFloat(token);
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curAlbedo.z = (float) atof(token.c_str());
+          curAlbedo.z = parseFloat(token);
           break;
 
         case KS_ROUGHNESS:
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curRoughness.x = (float) atof(token.c_str());
+          curRoughness.x = parseFloat(token);
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curRoughness.y = (float) atof(token.c_str());
+          curRoughness.y = parseFloat(token);
           break;
 
         case KS_ABSORPTION: // For convenience this is an absoption color used to calculate the absorption coefficient.
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionColor.x = (float) atof(token.c_str());
+          curAbsorptionColor.x = parseFloat(token);
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionColor.y = (float) atof(token.c_str());
+          curAbsorptionColor.y = parseFloat(token);
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionColor.z = (float) atof(token.c_str());
+          curAbsorptionColor.z = parseFloat(token);
           break;
 
         case KS_ABSORPTION_SCALE:
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionScale = (float) atof(token.c_str());
+          curAbsorptionScale = parseFloat(token);
           break;
 
         case KS_IOR:
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curIOR = (float) atof(token.c_str());
+          curIOR = parseFloat(token);
           break;
 
         case KS_THINWALLED:
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          curThinwalled = (atoi(token.c_str()) != 0);
+          curThinwalled = (parseInt(token) != 0);
           break;
 
         case KS_WHITEPERCEN:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curWhitePercen = (atoi(token.c_str()) != 0);
+            curWhitePercen = (parseInt(token) != 0);
             break;
 
         case KS_DYE:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curDye.x = (float)atof(token.c_str());
+            curDye.x = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curDye.y = (float)atof(token.c_str());
+            curDye.y = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curDye.z = (float)atof(token.c_str());
+            curDye.z = parseFloat(token);
             break;
 
         case KS_DYE_CONCENTRATION:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curDyeConcentration = (atoi(token.c_str()) != 0);
+            curDyeConcentration = (parseInt(token) != 0);
             break;
 
         case KS_SCALE_ANGLE_DEG:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curScaleAngleDeg = (atoi(token.c_str()) != 0);
+            curScaleAngleDeg = (parseInt(token) != 0);
             break;
 
         case KS_ROUGHNESS_M:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curRoughnessM = (atoi(token.c_str()) != 0);
+            curRoughnessM = (parseInt(token) != 0);
             break;
 
         case KS_ROUGHNESS_N:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curRoughnessN = (atoi(token.c_str()) != 0);
+            curRoughnessN = (parseInt(token) != 0);
             break;
 
         case KS_MELANIN_CONCENTRATION:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curMelaninConcentration = (atoi(token.c_str()) != 0);
+            curMelaninConcentration = (parseInt(token) != 0);
             break;
 
         case KS_MELANIN_RATIO:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curMelaninRatio = (atoi(token.c_str()) != 0);
+            curMelaninRatio = (parseInt(token) != 0);
             break;
 
         case KS_MELANIN_CONCENTRATION_DISPARITY:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curMelaninConcentrationDisparity = (atoi(token.c_str()) != 0);
+            curMelaninConcentrationDisparity = (parseInt(token) != 0);
             break;
 
         case KS_MELANIN_RATIO_DISPARITY:
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            curMelaninRatioDisparity = (atoi(token.c_str()) != 0);
+            curMelaninRatioDisparity = (parseInt(token) != 0);
             break;
 
         case KS_MATERIAL:
@@ -4238,44 +4941,44 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.dye = make_float3(x, y, z);
 
                     std::getline(file, line);
-                    materials.Material1.dye_concentration = std::stof(line);
+                    materials.Material1.dye_concentration = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.whitepercen = std::stof(line);
+                    materials.Material1.whitepercen = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.scale_angle_deg = std::stof(line);
+                    materials.Material1.scale_angle_deg = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.roughnessM = std::stof(line);
+                    materials.Material1.roughnessM = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.roughnessN = std::stof(line);
+                    materials.Material1.roughnessN = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.melanin_concentration = std::stof(line);
+                    materials.Material1.melanin_concentration = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.melanin_ratio = std::stof(line);
+                    materials.Material1.melanin_ratio = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.melanin_concentration_disparity = std::stof(line);
+                    materials.Material1.melanin_concentration_disparity = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.melanin_ratio_disparity = std::stof(line);
+                    materials.Material1.melanin_ratio_disparity = parseFloat(line);
 
                     std::getline(file, line);
 
@@ -4285,32 +4988,32 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.dyeNeutralHT = make_float3(x, y, z);
 
                     std::getline(file, line);
-                    materials.Material1.dyeNeutralHT_Concentration = std::stof(line);
+                    materials.Material1.dyeNeutralHT_Concentration = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.HT = std::stoi(line);
+                    materials.Material1.HT = parseInt(line);
 
                     std::getline(file, line);
-                    materials.Material1.int_VertRouge_Concentration = static_cast<int>(std::stof(line));
+                    materials.Material1.int_VertRouge_Concentration = static_cast<int>(parseFloat(line));
 
                     std::getline(file, line);
-                    materials.Material1.int_CendreCuivre_Concentration = std::stoi(line);
+                    materials.Material1.int_CendreCuivre_Concentration = parseInt(line);
 
                     std::getline(file, line);
-                    materials.Material1.int_IriseDore_Concentration = std::stoi(line);
+                    materials.Material1.int_IriseDore_Concentration = parseInt(line);
 
                     std::getline(file, line);
                     dotposition = 0;
@@ -4318,14 +5021,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.cendre = make_float3(x, y, z);
@@ -4336,14 +5039,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.irise = make_float3(x, y, z);
@@ -4354,14 +5057,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.doree = make_float3(x, y, z);
@@ -4372,14 +5075,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.cuivre = make_float3(x, y, z);
@@ -4390,14 +5093,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.acajou = make_float3(x, y, z);
@@ -4408,14 +5111,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.red = make_float3(x, y, z);
@@ -4426,38 +5129,38 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material1.vert = make_float3(x, y, z);
 
                     std::getline(file, line);
-                    materials.Material1.concentrationCendre = std::stof(line);
+                    materials.Material1.concentrationCendre = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.concentrationIrise = std::stof(line);
+                    materials.Material1.concentrationIrise = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.concentrationDore = std::stof(line);
+                    materials.Material1.concentrationDore = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.concentrationCuivre = std::stof(line);
+                    materials.Material1.concentrationCuivre = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.concentrationAcajou = std::stof(line);
+                    materials.Material1.concentrationAcajou = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.concentrationRouge = std::stof(line);
+                    materials.Material1.concentrationRouge = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material1.concentrationVert = std::stof(line);
+                    materials.Material1.concentrationVert = parseFloat(line);
 
                     std::getline(file, line);
 
@@ -4467,44 +5170,44 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.dye = make_float3(x, y, z);
 
                     std::getline(file, line);
-                    materials.Material2.dye_concentration = std::stof(line);
+                    materials.Material2.dye_concentration = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.whitepercen = std::stof(line);
+                    materials.Material2.whitepercen = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.scale_angle_deg = std::stof(line);
+                    materials.Material2.scale_angle_deg = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.roughnessM = std::stof(line);
+                    materials.Material2.roughnessM = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.roughnessN = std::stof(line);
+                    materials.Material2.roughnessN = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.melanin_concentration = std::stof(line);
+                    materials.Material2.melanin_concentration = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.melanin_ratio = std::stof(line);
+                    materials.Material2.melanin_ratio = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.melanin_concentration_disparity = std::stof(line);
+                    materials.Material2.melanin_concentration_disparity = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.melanin_ratio_disparity = std::stof(line);
+                    materials.Material2.melanin_ratio_disparity = parseFloat(line);
 
                     std::getline(file, line);
 
@@ -4514,45 +5217,45 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f ;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f ;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.dyeNeutralHT = make_float3(x, y, z);
                     std::getline(file, line);
-                    materials.Material2.dyeNeutralHT_Concentration = std::stof(line);
+                    materials.Material2.dyeNeutralHT_Concentration = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.HT = std::stoi(line);
+                    materials.Material2.HT = parseInt(line);
 
                     std::getline(file, line);
-                    materials.Material2.int_VertRouge_Concentration = static_cast<int>(std::stof(line));
+                    materials.Material2.int_VertRouge_Concentration = static_cast<int>(parseFloat(line));
 
                     std::getline(file, line);
-                    materials.Material2.int_CendreCuivre_Concentration = std::stoi(line);
+                    materials.Material2.int_CendreCuivre_Concentration = parseInt(line);
 
                     std::getline(file, line);
-                    materials.Material2.int_IriseDore_Concentration = std::stoi(line);
+                    materials.Material2.int_IriseDore_Concentration = parseInt(line);
                     std::getline(file, line);
                     dotposition = 0;
                     previousdotposition = 0;
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.cendre = make_float3(x, y, z);
@@ -4563,14 +5266,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.irise = make_float3(x, y, z);
@@ -4581,14 +5284,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.doree = make_float3(x, y, z);
@@ -4599,14 +5302,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.cuivre = make_float3(x, y, z);
@@ -4617,14 +5320,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.acajou = make_float3(x, y, z);
@@ -4635,14 +5338,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.red = make_float3(x, y, z);
@@ -4653,38 +5356,38 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                     dotposition = line.find_first_of(";", 0);
                     if (dotposition != std::string::npos)
                     {
-                        x = std::stof(line.substr(0, dotposition)) / 255.0f;
+                        x = parseFloat(std::string_view(line).substr(0, dotposition)) / 255.0f;
                         previousdotposition = dotposition + 1;
                         dotposition = line.find_first_of(";", previousdotposition);
                         if (dotposition != std::string::npos)
                         {
-                            y = std::stof(line.substr(previousdotposition, dotposition)) / 255.0f;
+                            y = parseFloat(std::string_view(line).substr(previousdotposition, dotposition)) / 255.0f;
                             previousdotposition = dotposition + 1;
-                            z = std::stof(line.substr(previousdotposition, std::string::npos)) / 255.0f;
+                            z = parseFloat(std::string_view(line).substr(previousdotposition, std::string::npos)) / 255.0f;
                         }
                     }
                     materials.Material2.vert = make_float3(x, y, z);
 
                     std::getline(file, line);
-                    materials.Material2.concentrationCendre = std::stof(line);
+                    materials.Material2.concentrationCendre = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.concentrationIrise = std::stof(line);
+                    materials.Material2.concentrationIrise = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.concentrationDore = std::stof(line);
+                    materials.Material2.concentrationDore = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.concentrationCuivre = std::stof(line);
+                    materials.Material2.concentrationCuivre = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.concentrationAcajou = std::stof(line);
+                    materials.Material2.concentrationAcajou = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.concentrationRouge = std::stof(line);
+                    materials.Material2.concentrationRouge = parseFloat(line);
 
                     std::getline(file, line);
-                    materials.Material2.concentrationVert = std::stof(line);
+                    materials.Material2.concentrationVert = parseFloat(line);
 
                     std::getline(file, line);
                     materials.SettingFile = line;
@@ -4744,18 +5447,18 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            axis[0] = (float) atof(token.c_str());
+            axis[0] = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            axis[1] = (float) atof(token.c_str());
+            axis[1] = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            axis[2] = (float) atof(token.c_str());
+            axis[2] = parseFloat(token);
             axis.normalize();
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const float angle = dp::math::degToRad((float) atof(token.c_str()));
+            const float angle = dp::math::degToRad(parseFloat(token));
 
             dp::math::Quatf rotation(axis, angle);
             curOrientation *= rotation;
@@ -4776,13 +5479,13 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            scaling[0][0] = (float) atof(token.c_str());
+            scaling[0][0] = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            scaling[1][1] = (float) atof(token.c_str());
+            scaling[1][1] = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            scaling[2][2] = (float) atof(token.c_str());
+            scaling[2][2] = parseFloat(token);
 
             curMatrix *= scaling;
 
@@ -4802,13 +5505,13 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
             // Translation is in the third row in dp::math::Mat44f.
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            translation[3][0] = (float) atof(token.c_str());
+            translation[3][0] = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            translation[3][1] = (float) atof(token.c_str());
+            translation[3][1] = parseFloat(token);
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            translation[3][2] = (float) atof(token.c_str());
+            translation[3][2] = parseFloat(token);
 
             curMatrix *= translation;
 
@@ -4828,15 +5531,15 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
           {
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessU = atoi(token.c_str());
+            const unsigned int tessU = parseInt(token);
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessV = atoi(token.c_str());
+            const unsigned int tessV = parseInt(token);
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int upAxis = atoi(token.c_str());
+            const unsigned int upAxis = parseInt(token);
 
             std::string nameMaterialReference;
             tokenType = parser.getNextToken(nameMaterialReference);
@@ -4851,14 +5554,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
             {
               m_mapGeometries[keyGeometry.str()] = m_idGeometry; // PERF Equal to static_cast<unsigned int>(m_geometries.size());
 
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createPlane(tessU, tessV, upAxis);
+              geometry = m_nodeArena.create<sg::Triangles>(m_idGeometry++);
+              submitModelTask([geometry, tessU, tessV, upAxis]() { geometry->createPlane(tessU, tessV, upAxis); });
 
               m_geometries.push_back(geometry);
             }
             else
             {
-              geometry = std::dynamic_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
+              geometry = std::static_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
             }
 
             appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
@@ -4878,14 +5581,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
             {
               m_mapGeometries[keyGeometry] = m_idGeometry;
 
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createBox();
+              geometry = m_nodeArena.create<sg::Triangles>(m_idGeometry++);
+              submitModelTask([geometry]() { geometry->createBox(); });
 
               m_geometries.push_back(geometry);
             }
             else
             {
-              geometry = std::dynamic_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
+              geometry = std::static_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
             }
 
             appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
@@ -4894,16 +5597,16 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
           {
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessU = atoi(token.c_str());
+            const unsigned int tessU = parseInt(token);
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessV = atoi(token.c_str());
+            const unsigned int tessV = parseInt(token);
 
             // Theta is in the range [0.0f, 1.0f] and 1.0f means closed sphere, smaller values open the noth pole.
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const float theta = float(atof(token.c_str()));
+            const float theta = parseFloat(token);
 
             std::string nameMaterialReference;
             tokenType = parser.getNextToken(nameMaterialReference);
@@ -4918,14 +5621,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
             {
               m_mapGeometries[keyGeometry.str()] = m_idGeometry;
 
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createSphere(tessU, tessV, 1.0f, theta * M_PIf);
+              geometry = m_nodeArena.create<sg::Triangles>(m_idGeometry++);
+              submitModelTask([geometry, tessU, tessV, theta]() { geometry->createSphere(tessU, tessV, 1.0f, theta * M_PIf); });
 
               m_geometries.push_back(geometry);
             }
             else
             {
-              geometry = std::dynamic_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
+              geometry = std::static_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
             }
 
             appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
@@ -4934,19 +5637,19 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
           {
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessU = atoi(token.c_str());
+            const unsigned int tessU = parseInt(token);
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessV = atoi(token.c_str());
+            const unsigned int tessV = parseInt(token);
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const float innerRadius = float(atof(token.c_str()));
+            const float innerRadius = parseFloat(token);
 
             tokenType = parser.getNextToken(token);
             MY_ASSERT(tokenType == PTT_VAL);
-            const float outerRadius = float(atof(token.c_str()));
+            const float outerRadius = parseFloat(token);
 
             std::string nameMaterialReference;
             tokenType = parser.getNextToken(nameMaterialReference);
@@ -4961,14 +5664,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
             {
               m_mapGeometries[keyGeometry.str()] = m_idGeometry;
 
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createTorus(tessU, tessV, innerRadius, outerRadius);
+              geometry = m_nodeArena.create<sg::Triangles>(m_idGeometry++);
+              submitModelTask([geometry, tessU, tessV, innerRadius, outerRadius]() { geometry->createTorus(tessU, tessV, innerRadius, outerRadius); });
 
               m_geometries.push_back(geometry);
             }
             else
             {
-              geometry = std::dynamic_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
+              geometry = std::static_pointer_cast<sg::Triangles>(m_geometries[itg->second]);
             }
 
             appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
@@ -5001,15 +5704,15 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                       {
                           m_mapGeometries[keyGeometry.str()] = m_idGeometry;
 
-                          geometry = std::make_shared<sg::Curves>(m_idGeometry++);
-                          const char* file = model.file_name.c_str();
-                          geometry->createHairFromFile(file);
+                          geometry = m_nodeArena.create<sg::Curves>(m_idGeometry++);
+                          const std::string file = model.file_name;
+                          submitModelTask([geometry, file]() { geometry->createHairFromFile(file); });
 
                           m_geometries.push_back(geometry);
                       }
                       else
                       {
-                          geometry = std::dynamic_pointer_cast<sg::Curves>(m_geometries[itg->second]);
+                          geometry = std::static_pointer_cast<sg::Curves>(m_geometries[itg->second]);
                       }
 
                       appendInstance(m_scene, geometry, curMatrix, model.material1Name, m_idInstance);
@@ -5026,12 +5729,12 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
           float density;
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          density = (float) atof(token.c_str());
+          density = parseFloat(token);
 
           float disparity;
           tokenType = parser.getNextToken(token);
           MY_ASSERT(tokenType == PTT_VAL);
-          disparity = (float) atof(token.c_str());
+          disparity = parseFloat(token);
 
           std::string nameMaterialReference;
           tokenType = parser.getNextToken(nameMaterialReference);
@@ -5046,15 +5749,15 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
           {
               m_mapGeometries[keyGeometry.str()] = m_idGeometry;
 
-              geometry = std::make_shared<sg::Curves>(m_idGeometry++, density, disparity );
-              const char* file = filenameModel.c_str();
-              geometry->createHairFromFile(file);
+              geometry = m_nodeArena.create<sg::Curves>(m_idGeometry++, density, disparity );
+              const std::string file = filenameModel;
+              submitModelTask([geometry, file]() { geometry->createHairFromFile(file); });
 
               m_geometries.push_back(geometry);
           }
           else
           {
-              geometry = std::dynamic_pointer_cast<sg::Curves>(m_geometries[itg->second]);
+              geometry = std::static_pointer_cast<sg::Curves>(m_geometries[itg->second]);
           }
 
           appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
@@ -5091,14 +5794,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                       {
                           m_mapGeometries[keyGeometry1.str()] = m_idGeometry;
 
-                          geometry_left = std::make_shared<sg::Curves>(m_idGeometry++);
-                          const char* file = model.file_name.c_str();
-                          geometry_left->createHairFromFile(file, true);
+                          geometry_left = m_nodeArena.create<sg::Curves>(m_idGeometry++);
+                          const std::string file = model.file_name;
+                          submitModelTask([geometry_left, file]() { geometry_left->createHairFromFile(file, true); });
 
                           m_geometries.push_back(geometry_left);
                       }
                       else
-                          geometry_left = std::dynamic_pointer_cast<sg::Curves>(m_geometries[itg1->second]);
+                          geometry_left = std::static_pointer_cast<sg::Curves>(m_geometries[itg1->second]);
                       appendInstance(m_scene, geometry_left, curMatrix, model.material1Name, m_idInstance);
 
                       std::shared_ptr<sg::Curves> geometry_right;
@@ -5108,14 +5811,14 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                       {
                           m_mapGeometries[keyGeometry2.str()] = m_idGeometry;
 
-                          geometry_right = std::make_shared<sg::Curves>(m_idGeometry++);
-                          const char* file = model.file_name.c_str();
-                          geometry_right->createHairFromFile(file, false);
+                          geometry_right = m_nodeArena.create<sg::Curves>(m_idGeometry++);
+                          const std::string file = model.file_name;
+                          submitModelTask([geometry_right, file]() { geometry_right->createHairFromFile(file, false); });
 
                           m_geometries.push_back(geometry_right);
                       }
                       else
-                          geometry_right = std::dynamic_pointer_cast<sg::Curves>(m_geometries[itg2->second]);
+                          geometry_right = std::static_pointer_cast<sg::Curves>(m_geometries[itg2->second]);
 
                       appendInstance(m_scene, geometry_right, curMatrix, model.material2Name, m_idInstance);
                   }
@@ -5128,8 +5831,6 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
             MY_ASSERT(tokenType == PTT_STRING);
             convertPath(filenameModel);
 
-            std::shared_ptr<sg::Group> model = createASSIMP(filenameModel);
-
             // nvpro-pipeline matrices are row-major multiplied from the right, means the translation is in the last row. Transpose!
             const float trafo[12] =
             {
@@ -5143,10 +5844,10 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
                       curMatrix[2][3] == 0.0f && 
                       curMatrix[3][3] == 1.0f);
 
-            std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+            std::shared_ptr<sg::Instance> instance = m_nodeArena.create<sg::Instance>(m_idInstance++);
             
             instance->setTransform(trafo);
-            instance->setChild(model);
+            submitASSIMP(filenameModel, instance); // The child is set when the import finished.
 
             m_scene->addChild(instance);
           }
@@ -5160,12 +5861,307 @@ materialGUI.dyeNeutralHT = make_float3(84.0f / 255.f, 182.f / 255.f, 157.f / 255
     }
   }
 
+  // All models are loaded concurrently, wait for them before the scene gets used.
+  resolveModelTasks();
+
+  // Only after all geometry data is known.
+  shareGeometries();
+
   std::cout << "loadSceneDescription(): m_idGroup = " << m_idGroup << ", m_idInstance = " << m_idInstance << ", m_idGeometry = " << m_idGeometry << '\n';
 
   return true;
 }
 
 
+// MaterialGUI is the name plus the plain MaterialParameters.
+static void writeMaterialGUI(SnapshotWriter& writer, MaterialGUI const& material)
+{
+  writer.writeString(material.name);
+  writer.write(static_cast<MaterialParameters const&>(material));
+}
+
+static bool readMaterialGUI(SnapshotReader& reader, MaterialGUI& material)
+{
+  return reader.readString(material.name) &&
+         reader.read(static_cast<MaterialParameters&>(material));
+}
+
+// Path, size and modification time of every file the scene description names, which are the model, hair and color files.
+// Hashing their contents would cost about as much as the imports the snapshot saves.
+template <typename TParser>
+uint64_t Application::hashSceneReferences(TParser& parser, uint64_t key)
+{
+  ParserTokenType tokenType;
+  std::string token;
+
+  while ((tokenType = parser.getNextToken(token)) != PTT_EOF && tokenType != PTT_UNKNOWN)
+  {
+    if (tokenType != PTT_ID && tokenType != PTT_STRING)
+    {
+      continue;
+    }
+    convertPath(token);
+
+    std::error_code error;
+    if (!fs::is_regular_file(token, error))
+    {
+      continue;
+    }
+    const uint64_t size = fs::file_size(token, error);
+    const int64_t  time = static_cast<int64_t>(fs::last_write_time(token, error).time_since_epoch().count());
+
+    key = hash64(token.data(), token.size(), key);
+    key = hash64(&size, sizeof(size), key);
+    key = hash64(&time, sizeof(time), key);
+  }
+  return key;
+}
+
+uint64_t Application::getSceneSnapshotKey(std::string const& filenameSystem, std::string const& filenameScene)
+{
+  // The size of the plain data records is part of the key, old snapshots don't match after a layout change.
+  const uint64_t layout[5] =
+  {
+    sizeof(VertexAttributes),
+    sizeof(MaterialParameters),
+    sizeof(CameraDefinition),
+    sizeof(LightDefinition),
+    sizeof(dp::math::Mat44f)
+  };
+
+  uint64_t key = hash64(layout, sizeof(layout));
+
+  // The system description defines the cameras and lights, the scene description everything else.
+  for (std::string const& filename : { filenameSystem, filenameScene })
+  {
+    MappedFile file;
+    if (file.open(filename))
+    {
+      key = hash64(file.getData(), file.getSize(), key);
+    }
+  }
+
+  // Edited or replaced model, hair and color files invalidate the snapshot as well.
+  if (ConfigParser::isJsonFile(filenameScene))
+  {
+    ConfigParser parser;
+    if (parser.load(filenameScene))
+    {
+      key = hashSceneReferences(parser, key);
+    }
+  }
+  else
+  {
+    Parser parser;
+    if (parser.load(filenameScene))
+    {
+      key = hashSceneReferences(parser, key);
+    }
+  }
+  return key;
+}
+
+bool Application::saveSceneSnapshot(std::string const& filename, const uint64_t key) const
+{
+  Timer timer;
+  timer.start();
+
+  SnapshotWriter writer(key);
+
+  writer.write(m_idGroup);
+  writer.write(m_idInstance);
+  writer.write(m_idGeometry);
+  writer.write(curMatrix);
+
+  writer.writeArray(m_cameras);
+  writer.writeArray(m_lights);
+
+  writer.write<uint64_t>(m_materialsGUI.size());
+  for (MaterialGUI const& material : m_materialsGUI)
+  {
+    writeMaterialGUI(writer, material);
+  }
+
+  writer.write<uint64_t>(m_mapMaterialReferences.size());
+  for (auto const& it : m_mapMaterialReferences)
+  {
+    writer.writeString(it.first);
+    writer.write(it.second);
+  }
+
+  writer.write<uint64_t>(m_mapGeometries.size());
+  for (auto const& it : m_mapGeometries)
+  {
+    writer.writeString(it.first);
+    writer.write(it.second);
+  }
+
+  writer.write<uint64_t>(m_models.size());
+  for (ModelSwitch const& model : m_models)
+  {
+    writer.writeString(model.name);
+    writer.writeString(model.file_name);
+    writer.writeString(model.map_identifier);
+    writer.writeString(model.material1Name);
+    writer.writeString(model.material2Name);
+  }
+
+  writer.write<uint64_t>(m_materialsColor.size());
+  for (ColorSwitch const& color : m_materialsColor)
+  {
+    writer.writeString(color.name);
+    writeMaterialGUI(writer, color.Material1);
+    writeMaterialGUI(writer, color.Material2);
+    writer.writeString(color.SettingFile);
+  }
+
+  writer.write<uint64_t>(m_settings.size());
+  for (auto const& setting : m_settings)
+  {
+    writer.writeString(setting.first);
+    writer.writeString(setting.second);
+  }
+
+  writeSceneGraph(writer, m_scene, m_geometries, m_mapGroups);
+
+  const bool success = writer.save(filename);
+
+  timer.stop();
+  if (success)
+  {
+    std::cout << "saveSceneSnapshot(): " << filename << " in " << timer.getTime() << " seconds\n";
+  }
+  return success;
+}
+
+bool Application::loadSceneSnapshot(std::string const& filename, const uint64_t key)
+{
+  Timer timer;
+  timer.start();
+
+  SnapshotReader reader;
+
+  if (!reader.open(filename, key))
+  {
+    std::cout << "loadSceneSnapshot(): No matching snapshot " << filename << ", loading the scene description.\n";
+    return false;
+  }
+
+  // Read into locals first, a corrupted snapshot leaves the application state untouched.
+  unsigned int     idGroup    = 0;
+  unsigned int     idInstance = 0;
+  unsigned int     idGeometry = 0;
+  dp::math::Mat44f matrix;
+
+  std::vector<CameraDefinition>                       cameras;
+  std::vector<LightDefinition>                        lights;
+  std::vector<MaterialGUI>                            materials;
+  std::map<std::string, int>                          mapMaterialReferences;
+  std::map<std::string, unsigned int>                 mapGeometries;
+  std::vector<ModelSwitch>                            models;
+  std::vector<ColorSwitch>                            colors;
+  std::vector<std::pair<std::string, std::string>>    settings;
+  std::shared_ptr<sg::Group>                          scene;
+  std::vector< std::shared_ptr<sg::Node> >            geometries;
+  std::map< std::string, std::shared_ptr<sg::Group> > mapGroups;
+
+  bool success = reader.read(idGroup) &&
+                 reader.read(idInstance) &&
+                 reader.read(idGeometry) &&
+                 reader.read(matrix) &&
+                 reader.readArray(cameras) &&
+                 reader.readArray(lights);
+
+  uint64_t count = 0;
+
+  success = success && reader.read(count);
+  for (uint64_t i = 0; success && i < count; ++i)
+  {
+    MaterialGUI material;
+    success = readMaterialGUI(reader, material);
+    materials.push_back(material);
+  }
+
+  success = success && reader.read(count);
+  for (uint64_t i = 0; success && i < count; ++i)
+  {
+    std::string name;
+    int         index = 0;
+    success = reader.readString(name) && reader.read(index);
+    mapMaterialReferences[name] = index;
+  }
+
+  success = success && reader.read(count);
+  for (uint64_t i = 0; success && i < count; ++i)
+  {
+    std::string  name;
+    unsigned int index = 0;
+    success = reader.readString(name) && reader.read(index);
+    mapGeometries[name] = index;
+  }
+
+  success = success && reader.read(count);
+  for (uint64_t i = 0; success && i < count; ++i)
+  {
+    ModelSwitch model;
+    success = reader.readString(model.name) &&
+              reader.readString(model.file_name) &&
+              reader.readString(model.map_identifier) &&
+              reader.readString(model.material1Name) &&
+              reader.readString(model.material2Name);
+    models.push_back(model);
+  }
+
+  success = success && reader.read(count);
+  for (uint64_t i = 0; success && i < count; ++i)
+  {
+    ColorSwitch color;
+    success = reader.readString(color.name) &&
+              readMaterialGUI(reader, color.Material1) &&
+              readMaterialGUI(reader, color.Material2) &&
+              reader.readString(color.SettingFile);
+    colors.push_back(color);
+  }
+
+  success = success && reader.read(count);
+  for (uint64_t i = 0; success && i < count; ++i)
+  {
+    std::pair<std::string, std::string> setting;
+    success = reader.readString(setting.first) && reader.readString(setting.second);
+    settings.push_back(setting);
+  }
+
+  success = success && readSceneGraph(reader, m_nodeArena, scene, geometries, mapGroups);
+
+  if (!success || idGeometry != geometries.size())
+  {
+    std::cerr << "WARNING: loadSceneSnapshot() " << filename << " is corrupted, loading the scene description.\n";
+    return false;
+  }
+
+  m_idGroup    = idGroup;
+  m_idInstance = idInstance;
+  m_idGeometry = idGeometry;
+  curMatrix    = matrix;
+
+  m_cameras.swap(cameras);
+  m_lights.swap(lights);
+  m_materialsGUI.swap(materials);
+  m_mapMaterialReferences.swap(mapMaterialReferences);
+  m_mapGeometries.swap(mapGeometries);
+  m_models.swap(models);
+  m_materialsColor.swap(colors);
+  m_settings.swap(settings);
+  m_scene = scene;
+  m_geometries.swap(geometries);
+  m_mapGroups.swap(mapGroups);
+
+  timer.stop();
+  std::cout << "loadSceneSnapshot(): " << filename << " in " << timer.getTime() << " seconds, m_idGroup = " << m_idGroup << ", m_idInstance = " << m_idInstance << ", m_idGeometry = " << m_idGeometry << '\n';
+  return true;
+}
+
+
 bool Application::loadString(std::string const& filename, std::string& text)
 {
   std::ifstream inputStream(filename);
@@ -5518,8 +6514,6 @@ void Application::calculateTangents(std::vector<VertexAttributes>& attributes, s
 
 bool Application::screenshot(const bool tonemap)
 {
-  ILboolean hasImage = false;
-  
   const int spp = m_samplesSqrt * m_samplesSqrt; // Add the samples per pixel to the filename for quality comparisons.
 
   std::ostringstream path;
@@ -5530,107 +6524,17 @@ bool Application::screenshot(const bool tonemap)
   auto path_value = tmpValue.find_last_of("\\");
   tmpValue = tmpValue.substr(0, path_value);
   std::cerr << tmpValue << std::endl;
-  if (!fs::exists(tmpValue)) {
-      fs::create_directory(tmpValue);
-  }
-
-  unsigned int imageID;
-
-  ilGenImages(1, (ILuint *) &imageID);
-
-  ilBindImage(imageID);
-  ilActiveImage(0);
-  ilActiveFace(0);
-
-  ilDisable(IL_ORIGIN_SET);
-
-  const float4* bufferHost = reinterpret_cast<const float4*>(m_raytracer->getOutputBufferHost());
-  
-  if (tonemap)
-  {
-    // Store a tonemapped RGB8 *.png image
-    path << ".png";
-
-    if (ilTexImage(m_resolution.x, m_resolution.y, 1, 3, IL_RGB, IL_UNSIGNED_BYTE, nullptr))
-    {
-      uchar3* dst = reinterpret_cast<uchar3*>(ilGetData());
-
-      const float  invGamma       = 1.0f / m_tonemapperGUI.gamma;
-      const float3 colorBalance   = make_float3(m_tonemapperGUI.colorBalance[0], m_tonemapperGUI.colorBalance[1], m_tonemapperGUI.colorBalance[2]);
-      const float  invWhitePoint  = m_tonemapperGUI.brightness / m_tonemapperGUI.whitePoint;
-      const float  burnHighlights = m_tonemapperGUI.burnHighlights;
-      const float  crushBlacks    = m_tonemapperGUI.crushBlacks + m_tonemapperGUI.crushBlacks + 1.0f;
-      const float  saturation     = m_tonemapperGUI.saturation;
-
-      for (int y = 0; y < m_resolution.y; ++y)
-      {
-        for (int x = 0; x < m_resolution.x; ++x)
-        {
-          const int idx = y * m_resolution.x + x;
-
-          // Tonemapper. // PERF Add a native CUDA kernel doing this.
-          float3 hdrColor = make_float3(bufferHost[idx]);
-          float3 ldrColor = invWhitePoint * colorBalance * hdrColor;
-          ldrColor       *= ((ldrColor * burnHighlights) + 1.0f) / (ldrColor + 1.0f);
-          
-          float luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
-          ldrColor = lerp(make_float3(luminance), ldrColor, saturation); // This can generate negative values for saturation > 1.0f!
-          ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
-
-          luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
-          if (luminance < 1.0f)
-          {
-            const float3 crushed = powf(ldrColor, crushBlacks);
-            ldrColor = lerp(crushed, ldrColor, sqrtf(luminance));
-            ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
-          }
-          ldrColor = clamp(powf(ldrColor, invGamma), 0.0f, 1.0f); // Saturate, clamp to range [0.0f, 1.0f].
-
-          dst[idx] = make_uchar3((unsigned char) (ldrColor.x * 255.0f),
-                                 (unsigned char) (ldrColor.y * 255.0f),
-                                 (unsigned char) (ldrColor.z * 255.0f));
-        }
-      }
-      hasImage = true;
-    }
-  }
-  else
-  {
-    // Store the float4 linear output buffer as *.hdr image.
-    // FIXME Add a half float conversion and store as *.exr. (Pre-built DevIL 1.7.8 supports EXR, DevIL 1.8.0 doesn't!)
-    path << ".hdr";
-
-    hasImage = ilTexImage(m_resolution.x, m_resolution.y, 1, 4, IL_RGBA, IL_FLOAT, (void*) bufferHost);
-  }
-
-  if (hasImage)
-  {
-    ilEnable(IL_FILE_OVERWRITE); // By default, always overwrite
-    
-    std::string filename = path.str();
-    convertPath(filename);
-	
-    if (ilSaveImage((const ILstring) filename.c_str()))
-    {
-      ilDeleteImages(1, &imageID);
-
-      std::cout << filename << '\n'; // Print out filename to indicate that a screenshot has been taken.
-      return true;
-    }
-  }
-
-  // There was an error when reaching this code.
-  ILenum error = ilGetError(); // DEBUG 
-  std::cerr << "ERROR: screenshot() failed with IL error " << error << '\n';
-
-  while (ilGetError() != IL_NO_ERROR) // Clean up errors.
-  {
+  std::error_code error;
+  if (!fs::exists(tmpValue, error) && !fs::create_directory(tmpValue, error)) {
+      std::cerr << "ERROR: screenshot() cannot create the directory " << tmpValue << ": " << error.message() << '\n';
+      return false;
   }
 
-  // Free all resources associated with the DevIL image
-  ilDeleteImages(1, &imageID);
+  std::string filename = path.str();
+  convertPath(filename);
 
-  return false;
+  // Tonemapped *.png or linear *.exr, written asynchronously. The filename is printed when the file has been written.
+  return captureScreenshot(filename, getOutputImage(m_denoiser), tonemap, true);
 }
 
 bool Application::screenshot360()
@@ -5664,123 +6568,47 @@ bool Application::screenshot360()
         }
         display();
 
-        screenshot(true, standard_prefix + std::to_string(i));
+        screenshot(true, standard_prefix + std::to_string(i)); // Returns after the copy, the next view renders while this one is written.
     }
+    m_screenshotWriter.wait();
+    std::cout << '\n' << m_screenshotWriter.getTimings() << '\n';
     return true;
 }
 
 
 bool Application::screenshot(const bool tonemap, std::string name)
 {
-    ILboolean hasImage = false;
-
-    const int spp = m_samplesSqrt * m_samplesSqrt; // Add the samples per pixel to the filename for quality comparisons.
-
-    std::ostringstream path;
-
-    path << name;
-
-    unsigned int imageID;
-
-    ilGenImages(1, (ILuint*)&imageID);
-
-    ilBindImage(imageID);
-    ilActiveImage(0);
-    ilActiveFace(0);
-
-    ilDisable(IL_ORIGIN_SET);
-
-    const float4* bufferHost = reinterpret_cast<const float4*>(m_raytracer->getOutputBufferHost());
-
-    if (tonemap)
-    {
-        // Store a tonemapped RGB8 *.png image
-        path << ".png";
-
-        if (ilTexImage(m_resolution.x, m_resolution.y, 1, 3, IL_RGB, IL_UNSIGNED_BYTE, nullptr))
-        {
-            uchar3* dst = reinterpret_cast<uchar3*>(ilGetData());
-
-            const float  invGamma = 1.0f / m_tonemapperGUI.gamma;
-            const float3 colorBalance = make_float3(m_tonemapperGUI.colorBalance[0], m_tonemapperGUI.colorBalance[1], m_tonemapperGUI.colorBalance[2]);
-            const float  invWhitePoint = m_tonemapperGUI.brightness / m_tonemapperGUI.whitePoint;
-            const float  burnHighlights = m_tonemapperGUI.burnHighlights;
-            const float  crushBlacks = m_tonemapperGUI.crushBlacks + m_tonemapperGUI.crushBlacks + 1.0f;
-            const float  saturation = m_tonemapperGUI.saturation;
-
-            for (int y = 0; y < m_resolution.y; ++y)
-            {
-                for (int x = 0; x < m_resolution.x; ++x)
-                {
-                    const int idx = y * m_resolution.x + x;
-
-                    // Tonemapper. // PERF Add a native CUDA kernel doing this.
-                    float3 hdrColor = make_float3(bufferHost[idx]);
-                    float3 ldrColor = invWhitePoint * colorBalance * hdrColor;
-                    ldrColor *= ((ldrColor * burnHighlights) + 1.0f) / (ldrColor + 1.0f);
-
-                    float luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
-                    ldrColor = lerp(make_float3(luminance), ldrColor, saturation); // This can generate negative values for saturation > 1.0f!
-                    ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
-
-                    luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
-                    if (luminance < 1.0f)
-                    {
-                        const float3 crushed = powf(ldrColor, crushBlacks);
-                        ldrColor = lerp(crushed, ldrColor, sqrtf(luminance));
-                        ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
-                    }
-                    ldrColor = clamp(powf(ldrColor, invGamma), 0.0f, 1.0f); // Saturate, clamp to range [0.0f, 1.0f].
-
-                    dst[idx] = make_uchar3((unsigned char)(ldrColor.x * 255.0f),
-                        (unsigned char)(ldrColor.y * 255.0f),
-                        (unsigned char)(ldrColor.z * 255.0f));
-                }
-            }
-            hasImage = true;
-        }
-    }
-    else
-    {
-        // Store the float4 linear output buffer as *.hdr image.
-        // FIXME Add a half float conversion and store as *.exr. (Pre-built DevIL 1.7.8 supports EXR, DevIL 1.8.0 doesn't!)
-        path << ".hdr";
-
-        hasImage = ilTexImage(m_resolution.x, m_resolution.y, 1, 4, IL_RGBA, IL_FLOAT, (void*)bufferHost);
-    }
-
-    if (hasImage)
-    {
-        ilEnable(IL_FILE_OVERWRITE); // By default, always overwrite
-
-        std::string filename = path.str();
-        convertPath(filename);
-
-        if (ilSaveImage((const ILstring)filename.c_str()))
-        {
-            ilDeleteImages(1, &imageID);
-
-            //std::cout << filename << '\n'; // Print out filename to indicate that a screenshot has been taken.
-            return true;
-        }
-    }
+    std::string filename = name; // Without extension.
+    convertPath(filename);
 
-    // There was an error when reaching this code.
-    ILenum error = ilGetError(); // DEBUG 
-    std::cerr << "ERROR: screenshot() failed with IL error " << error << '\n';
+    return captureScreenshot(filename, getOutputImage(m_denoiser), tonemap, false);
+}
 
-    while (ilGetError() != IL_NO_ERROR) // Clean up errors.
-    {
-    }
+// Snapshot of the output image, plus the variance when it's caught, for the ScreenshotWriter.
+// Only the copy happens here, tonemapping, encoding and writing run on its threads while rendering continues.
+// Returns false when the snapshot could not be queued or when an earlier screenshot failed to write.
+bool Application::captureScreenshot(std::string const& filename, const float4* bufferHost, const bool tonemap, const bool announce)
+{
+  const float* varbufferHost = (m_catchVariance && m_interop != INTEROP_MODE_PBO) ? reinterpret_cast<const float*>(m_raytracer->getOutputVarBufferHost()) : nullptr;
 
-    // Free all resources associated with the DevIL image
-    ilDeleteImages(1, &imageID);
+  if (!m_screenshotWriter.capture(filename, bufferHost, varbufferHost, m_resolution, tonemap, m_tonemapperGUI, m_exrHalf, m_exrCompression, announce))
+  {
+    return false;
+  }
 
+  const std::string failure = m_screenshotWriter.getLastFailure();
+  if (!failure.empty())
+  {
+    std::cerr << "ERROR: captureScreenshot() failed to write " << failure << '\n';
     return false;
+  }
+  return true;
 }
 
 bool Application::sendImage(const bool tonemap)
 {
+    std::lock_guard<std::mutex> lockDevIL(getMutexDevIL()); // The loader and screenshot threads use DevIL as well.
+
     ILboolean hasImage = false;
 
     const int spp = m_samplesSqrt * m_samplesSqrt; // Add the samples per pixel to the filename for quality comparisons.
@@ -5807,7 +6635,7 @@ bool Application::sendImage(const bool tonemap)
 
     ilDisable(IL_ORIGIN_SET);
 
-    const float4* bufferHost = reinterpret_cast<const float4*>(m_raytracer->getOutputBufferHost());
+    const float4* bufferHost = getOutputImage(m_denoiserStream);
 
     if (tonemap)
     {
@@ -5974,25 +6802,34 @@ void Application::convertPath(char* path)
 #endif
 }
 
+const float4* Application::getOutputImage(Denoiser& denoiser)
+{
+  const float4* bufferHost = reinterpret_cast<const float4*>(m_raytracer->getOutputBufferHost());
+
+  if (!m_denoise)
+  {
+    return bufferHost;
+  }
+
+  // The variance buffer is only written when variance catching is enabled. The denoiser falls back to a relative luminance threshold without it.
+  const float* varbufferHost = (m_catchVariance && m_interop != INTEROP_MODE_PBO) ? reinterpret_cast<const float*>(m_raytracer->getOutputVarBufferHost()) : nullptr;
+
+  return denoiser.denoise(bufferHost, varbufferHost, m_resolution, m_raytracer->m_iterationIndex); // Timed inside, see Denoiser::getTime().
+}
+
 float Application::captureVariance()
 {
     if (m_raytracer->m_iterationIndex == 0)
         return 1.f;
 
-    const float* varbufferHost = reinterpret_cast<const float*>(m_raytracer->getOutputVarBufferHost());
-    float variance = 0.f;
-    int idx = 0;
-    for (int y = 0; y < m_resolution.y; ++y)
-    {
-        for (int x = 0; x < m_resolution.x; ++x)
-        {
-            idx = y * m_resolution.x + x;
-            variance += varbufferHost[idx];
-        }
-    }
-    variance /= (m_resolution.x * m_resolution.y);
+    const float*  varbufferHost = reinterpret_cast<const float*>(m_raytracer->getOutputVarBufferHost());
+    const float4* bufferHost    = (0.0f < m_targetError) ? reinterpret_cast<const float4*>(m_raytracer->getOutputBufferHost()) : nullptr; // Only needed for the relative tile errors.
+
+    // Parallel per tile reduction. Also updates the convergence state used for the adaptive termination.
+    m_convergence.setResolution(m_resolution);
+    m_convergence.update(bufferHost, varbufferHost, m_raytracer->m_iterationIndex);
 
-    float confidence_interval = 2.f * 1.96f * sqrtf(variance / m_raytracer->m_iterationIndex);
+    float confidence_interval = m_convergence.getConfidenceInterval();
     //std::cout << "IC :" << confidence_interval << std::endl;
     return confidence_interval;
 }
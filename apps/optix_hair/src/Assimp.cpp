@@ -27,6 +27,10 @@
  */
 
 #include "inc/Application.h"
+#include "inc/Hash.h"
+#include "inc/MappedFile.h"
+#include "inc/MeshOptimizer.h"
+#include "inc/ThreadPool.h"
 
 #include <dp/math/math.h>
 #include <dp/math/Vecnt.h>
@@ -34,6 +38,7 @@
 #include <dp/math/Quatt.h>
 #include <dp/math/Trafo.h>
 
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -44,36 +49,147 @@
 #include "inc/MyAssert.h"
 
 
-std::shared_ptr<sg::Group> Application::createASSIMP(std::string const& filename)
+// Bump when the conversion or the optimization of the meshes changes, older mesh cache files are not used then.
+static const uint64_t c_meshCacheVersion = 1;
+
+// Converts one triangle mesh and runs the mesh optimization stage on it. Runs on the ThreadPool.
+void Application::convertMeshASSIMP(const aiScene* scene, const unsigned int iMesh, ImportedMesh& imported)
 {
-  std::map< std::string, std::shared_ptr<sg::Group> >::const_iterator itGroup = m_mapGroups.find(filename);
-  if (itGroup != m_mapGroups.end())
+  const aiMesh* mesh = scene->mMeshes[iMesh];
+
+  // Allow to specify different materials per assimp model by using the material name.
+  struct aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+
+  aiString materialName;
+  if (material->Get(AI_MATKEY_NAME, materialName) == aiReturn_SUCCESS)
   {
-    return itGroup->second; // Full model instancing under an Instance node.
+    imported.material = std::string(materialName.C_Str());
   }
 
-  std::ifstream fin(filename);
-  if (!fin.fail())
+  aiColor4D diffuse;
+  if (material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse) == aiReturn_SUCCESS)
   {
-    fin.close(); // Ok, file found.
+    imported.hasDiffuse = true;
+    imported.diffuse    = make_float3(diffuse.r, diffuse.g, diffuse.b);
   }
-  else
+
+  // The post-processor took care of meshes per primitive type.
+  if (mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE || mesh->mNumVertices <= 2)
   {
-    std::cerr << "ERROR: createASSIMP() could not open " << filename << '\n';
+    return;
+  }
 
-    // Generate a Group node in any case. It will not have children when the file loading fails. 
-    std::shared_ptr<sg::Group> group(new sg::Group(m_idGroup++));
-    m_mapGroups[filename] = group; // Allow instancing of this whole model (to fail again quicker next time).
-    return group;
+  std::vector<VertexAttributes>& attributes = imported.attributes;
+  std::vector<unsigned int>&     indices    = imported.indices;
+
+  attributes.resize(mesh->mNumVertices);
+      
+  bool needsTangents = false;
+
+  for (unsigned int iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex)
+  {
+    VertexAttributes& attrib = attributes[iVertex];
+
+    aiVector3D const& v = mesh->mVertices[iVertex];
+    attrib.vertex = make_float3(v.x, v.y, v.z);
+
+    if (mesh->HasTangentsAndBitangents())
+    {
+      aiVector3D const& t = mesh->mTangents[iVertex];
+      attrib.tangent = make_float3(t.x, t.y, t.z);
+    }
+    else
+    {
+      needsTangents = true;
+      attrib.tangent = make_float3(1.0f, 0.0f, 0.0f);
+    }
+
+    if (mesh->HasNormals()) // Assimp generates missing normals via the aiProcess_GenSmoothNormals flag.
+    {
+      aiVector3D const& n = mesh->mNormals[iVertex];
+      attrib.normal = make_float3(n.x, n.y, n.z);
+    }
+    else
+    {
+      attrib.normal = make_float3(0.0f, 0.0f, 1.0f);
+    }
+
+    if (mesh->HasTextureCoords(0))
+    {
+      aiVector3D const& t = mesh->mTextureCoords[0][iVertex];
+      attrib.texcoord = make_float3(t.x, t.y, t.z);
+    }
+    else
+    {
+      attrib.texcoord = make_float3(0.0f, 0.0f, 0.0f);
+    }
   }
 
-  Assimp::Logger::LogSeverity severity = Assimp::Logger::NORMAL; // or Assimp::Logger::VERBOSE;
+  indices.reserve(mesh->mNumFaces * 3);
 
-  Assimp::DefaultLogger::create("", severity, aiDefaultLogStream_STDOUT);               // Create a logger instance for Console Output
-  //Assimp::DefaultLogger::create("assimp_log.txt", severity, aiDefaultLogStream_FILE); // Create a logger instance for File Output (found in project folder or near .exe)
+  for (unsigned int iFace = 0; iFace < mesh->mNumFaces; ++iFace)
+  {
+    const struct aiFace* face = &mesh->mFaces[iFace];
+    MY_ASSERT(face->mNumIndices == 3);
 
-  Assimp::DefaultLogger::get()->info("Assimp::DefaultLogger initialized."); // Will add message with "info" tag.
-  // Assimp::DefaultLogger::get()->debug(""); // Will add message with "debug" tag.
+    for (unsigned int iIndex = 0; iIndex < face->mNumIndices; ++iIndex)
+    {
+      indices.push_back(face->mIndices[iIndex]);
+    }
+  }
+
+  // Mesh optimization stage. Many importers emit one vertex per face corner, weld them before the tangents are generated.
+  weldVertices(attributes, indices);
+
+  if (needsTangents)
+  {
+    calculateTangents(attributes, indices); // This calculates geometry tangents though.
+  }
+
+  optimizeVertexCache(indices, attributes.size());
+  optimizeVertexFetch(attributes, indices);
+}
+
+// Flattens the node hierarchy depth first, parents before their children.
+static unsigned int convertNodeASSIMP(const aiNode* node, std::vector<ImportedNode>& nodes)
+{
+  const unsigned int index = static_cast<unsigned int>(nodes.size());
+  nodes.push_back(ImportedNode());
+
+  aiMatrix4x4 const& m = node->mTransformation;
+
+  const float trafo[12] =
+  {
+    float(m.a1), float(m.a2), float(m.a3), float(m.a4),
+    float(m.b1), float(m.b2), float(m.b3), float(m.b4),
+    float(m.c1), float(m.c2), float(m.c3), float(m.c4)
+  };
+  memcpy(nodes[index].matrix, trafo, sizeof(trafo));
+
+  nodes[index].meshes.assign(node->mMeshes, node->mMeshes + node->mNumMeshes);
+
+  for (unsigned int iChild = 0; iChild < node->mNumChildren; ++iChild)
+  {
+    const unsigned int indexChild = convertNodeASSIMP(node->mChildren[iChild], nodes);
+    nodes[index].children.push_back(indexChild); // nodes may have been reallocated.
+  }
+  return index;
+}
+
+// Runs on a ThreadPool worker. Imports the file, or loads the optimized meshes from the mesh cache when a cache directory is given.
+// The Importer and with it the aiScene is released before the result is handed to the main thread.
+std::shared_ptr<ImportedModel> Application::importASSIMP(std::string const& filename, std::string const& meshCache)
+{
+  std::ifstream fin(filename);
+  if (!fin.fail())
+  {
+    fin.close(); // Ok, file found.
+  }
+  else
+  {
+    std::cerr << "ERROR: importASSIMP() could not open " << filename << '\n';
+    return nullptr;
+  }
 
   unsigned int postProcessSteps = 
       //aiProcess_CalcTangentSpace       |
@@ -107,146 +223,136 @@ std::shared_ptr<sg::Group> Application::createASSIMP(std::string const& filename
       //aiProcess_ForceGenNormals        |
       //aiProcess_DropNormals            |
 
-  Assimp::Importer importer;
+  // The mesh cache is keyed by the content of the source file, the import settings and the vertex layout.
+  std::string filenameCache;
+  uint64_t    keyCache = 0;
 
-  const aiScene* scene = importer.ReadFile(filename, postProcessSteps);
+  if (!meshCache.empty())
+  {
+    const uint64_t settings[3] = { c_meshCacheVersion, postProcessSteps, sizeof(VertexAttributes) };
+
+    MappedFile file;
+    if (file.open(filename))
+    {
+      keyCache = hash64Parallel(file.getData(), file.getSize(), hash64(settings, sizeof(settings)));
+
+      char name[32];
+      snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(keyCache));
+      filenameCache = meshCache + std::string("/") + name;
+
+      std::shared_ptr<ImportedModel> model = std::make_shared<ImportedModel>();
+      if (model->load(filenameCache, keyCache))
+      {
+        return model;
+      }
+    }
+  }
+
+  Assimp::Importer importer;
 
   // If the import failed, report it
+  const aiScene* scene = importer.ReadFile(filename, postProcessSteps);
   if (!scene)
   {
     Assimp::DefaultLogger::get()->info(importer.GetErrorString());
-    Assimp::DefaultLogger::kill(); // Kill it after the work is done
-
-    std::shared_ptr<sg::Group> group(new sg::Group(m_idGroup++));
-    m_mapGroups[filename] = group; // Allow instancing of this whole model (to fail again quicker next time).
-    return group;
+    return nullptr;
   }
 
-  // Each scene needs to know where its geometries begin in the m_geometries to calculate the correct mesh index in traverseScene()
-  const unsigned int indexSceneBase = static_cast<unsigned int>(m_geometries.size());
+  std::shared_ptr<ImportedModel> model = std::make_shared<ImportedModel>();
 
-  m_remappedMeshIndices.clear(); // Clear the local remapping vector from iMesh to m_geometries index.
+  // Meshes are independent, convert and optimize them in parallel. Nested inside this worker that uses the idle threads.
+  model->meshes.resize(scene->mNumMeshes);
 
-  // Create all geometries in the assimp scene with triangle data. Ignore the others and remap their geometry indices.
-  for (unsigned int iMesh = 0; iMesh < scene->mNumMeshes; ++iMesh)
+  ThreadPool::getInstance().parallelFor(0, scene->mNumMeshes, 1, [scene, &model](size_t first, size_t last)
   {
-    const aiMesh* mesh = scene->mMeshes[iMesh];
-    
-    unsigned int remapMeshToGeometry = ~0u; // Remap mesh index to geometry index. ~0 means there was no geometry for a mesh.
-
-    // The post-processor took care of meshes per primitive type.
-    if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE && 2 < mesh->mNumVertices)
+    for (size_t iMesh = first; iMesh < last; ++iMesh)
     {
-      std::vector<VertexAttributes> attributes(mesh->mNumVertices);
-      
-      bool needsTangents  = false;
-      bool needsNormals   = false;
-      bool needsTexcoords = false;
+      convertMeshASSIMP(scene, static_cast<unsigned int>(iMesh), model->meshes[iMesh]);
+    }
+  });
 
-      for (unsigned int iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex)
-      {
-        VertexAttributes& attrib = attributes[iVertex];
+  convertNodeASSIMP(scene->mRootNode, model->nodes);
 
-        aiVector3D const& v = mesh->mVertices[iVertex];
-        attrib.vertex = make_float3(v.x, v.y, v.z);
+  if (!filenameCache.empty())
+  {
+    model->save(filenameCache, keyCache); // Failures are reported by the SnapshotWriter, the import result is valid anyway.
+  }
 
-        if (mesh->HasTangentsAndBitangents())
-        {
-          aiVector3D const& t = mesh->mTangents[iVertex];
-          attrib.tangent = make_float3(t.x, t.y, t.z);
-        }
-        else
-        {
-          needsTangents = true;
-          attrib.tangent = make_float3(1.0f, 0.0f, 0.0f);
-        }
+  return model;
+}
 
-        if (mesh->HasNormals())
-        {
-          aiVector3D const& n = mesh->mNormals[iVertex];
-          attrib.normal = make_float3(n.x, n.y, n.z);
-        }
-        else
-        {
-          needsNormals = true;
-          attrib.normal = make_float3(0.0f, 0.0f, 1.0f);
-        }
+// Runs on the main thread in file order, it allocates the node IDs and appends to m_geometries.
+std::shared_ptr<sg::Group> Application::createASSIMP(std::string const& filename, const ImportedModel* model)
+{
+  std::map< std::string, std::shared_ptr<sg::Group> >::const_iterator itGroup = m_mapGroups.find(filename);
+  if (itGroup != m_mapGroups.end())
+  {
+    return itGroup->second; // Full model instancing under an Instance node.
+  }
 
-        if (mesh->HasTextureCoords(0))
-        {
-          aiVector3D const& t = mesh->mTextureCoords[0][iVertex];
-          attrib.texcoord = make_float3(t.x, t.y, t.z);
-        }
-        else
-        {
-          needsTexcoords = true;
-          attrib.texcoord = make_float3(0.0f, 0.0f, 0.0f);
-        }
-      }
+  if (!model)
+  {
+    // Generate a Group node in any case. It will not have children when the file loading fails. 
+    std::shared_ptr<sg::Group> group = m_nodeArena.create<sg::Group>(m_idGroup++);
+    m_mapGroups[filename] = group; // Allow instancing of this whole model (to fail again quicker next time).
+    return group;
+  }
 
-      std::vector<unsigned int> indices;
+  // Each scene needs to know where its geometries begin in the m_geometries to calculate the correct mesh index in traverseScene()
+  const unsigned int indexSceneBase = static_cast<unsigned int>(m_geometries.size());
 
-      for (unsigned int iFace = 0; iFace < mesh->mNumFaces; ++iFace)
-      {
-        const struct aiFace* face = &mesh->mFaces[iFace];
-        MY_ASSERT(face->mNumIndices == 3);
+  m_remappedMeshIndices.clear(); // Clear the local remapping vector from iMesh to m_geometries index.
 
-        for (unsigned int iIndex = 0; iIndex < face->mNumIndices; ++iIndex)
-        {
-          indices.push_back(face->mIndices[iIndex]);
-        }
-      }
+  size_t numVertices  = 0;
+  size_t numTriangles = 0;
 
-      //if (needsNormals) // Assimp handled that via the aiProcess_GenSmoothNormals flag.
-      //{
-      //  calculateNormals(attributes, indices);
-      //}
-      if (needsTangents)
-      {
-        calculateTangents(attributes, indices); // This calculates geometry tangents though.
-      }
+  // Create all geometries in the model with triangle data. Ignore the others and remap their geometry indices.
+  for (ImportedMesh const& mesh : model->meshes)
+  {
+    unsigned int remapMeshToGeometry = ~0u; // Remap mesh index to geometry index. ~0 means there was no geometry for a mesh.
 
+    if (!mesh.attributes.empty())
+    {
       remapMeshToGeometry = static_cast<unsigned int>(m_geometries.size());
 
-      std::shared_ptr<sg::Triangles> geometry(new sg::Triangles(m_idGeometry++));
-      geometry->setAttributes(attributes);
-      geometry->setIndices(indices);
+      std::shared_ptr<sg::Triangles> geometry = m_nodeArena.create<sg::Triangles>(m_idGeometry++);
+      geometry->setAttributes(mesh.attributes);
+      geometry->setIndices(mesh.indices);
       
       m_geometries.push_back(geometry);
+
+      numVertices  += mesh.attributes.size();
+      numTriangles += mesh.indices.size() / 3;
     }
 
     m_remappedMeshIndices.push_back(remapMeshToGeometry); 
   }
 
-  std::shared_ptr<sg::Group> group = traverseScene(scene, indexSceneBase, scene->mRootNode);
+  std::cout << "createASSIMP(): " << filename << ((model->isCached) ? " from the mesh cache, " : ", ")
+            << numVertices << " vertices, " << numTriangles << " triangles\n";
+
+  std::shared_ptr<sg::Group> group = traverseScene(*model, indexSceneBase, 0);
   m_mapGroups[filename] = group; // Allow instancing of this whole model.
-  
-  Assimp::DefaultLogger::kill(); // Kill it after the work is done
 
   return group;
 }
   
-std::shared_ptr<sg::Group> Application::traverseScene(const struct aiScene *scene, const unsigned int indexSceneBase, const struct aiNode* node)
+std::shared_ptr<sg::Group> Application::traverseScene(ImportedModel const& model, const unsigned int indexSceneBase, const unsigned int indexNode)
 {
   // Create a group to hold all children and all meshes of this node.
-  std::shared_ptr<sg::Group> group(new sg::Group(m_idGroup++));
+  std::shared_ptr<sg::Group> group = m_nodeArena.create<sg::Group>(m_idGroup++);
 
-  aiMatrix4x4 const& m = node->mTransformation;
+  ImportedNode const& node = model.nodes[indexNode];
 
-  const float trafo[12] =
-  {
-    float(m.a1), float(m.a2), float(m.a3), float(m.a4),
-    float(m.b1), float(m.b2), float(m.b3), float(m.b4),
-    float(m.c1), float(m.c2), float(m.c3), float(m.c4)
-  };
+  const float* trafo = node.matrix;
 
   // Need to do a depth first traversal here to attach the bottom most nodes to each node's group.
-  for (unsigned int iChild = 0; iChild < node->mNumChildren; ++iChild)
+  for (const unsigned int indexChild : node.children)
   {
-    std::shared_ptr<sg::Group> child = traverseScene(scene, indexSceneBase, node->mChildren[iChild]);
+    std::shared_ptr<sg::Group> child = traverseScene(model, indexSceneBase, indexChild);
 
     // Create an instance which holds the subtree.
-    std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+    std::shared_ptr<sg::Instance> instance = m_nodeArena.create<sg::Instance>(m_idInstance++);
 
     instance->setTransform(trafo);
     instance->setChild(child);
@@ -255,9 +361,8 @@ std::shared_ptr<sg::Group> Application::traverseScene(const struct aiScene *scen
   }
 
   // Now also gather all meshes assigned to this node.
-  for (unsigned int iMesh = 0; iMesh < node->mNumMeshes; ++iMesh)
+  for (const unsigned int indexMesh : node.meshes) // Original mesh index in the assimp scene.
   {
-    const unsigned int indexMesh = node->mMeshes[iMesh];  // Original mesh index in the assimp scene.
     MY_ASSERT(indexMesh < m_remappedMeshIndices.size())
 
     if (m_remappedMeshIndices[indexMesh] != ~0) // If there exists a Triangles geometry for this assimp mesh, then build the Instance.
@@ -265,22 +370,15 @@ std::shared_ptr<sg::Group> Application::traverseScene(const struct aiScene *scen
       const unsigned int indexGeometry = m_remappedMeshIndices[indexMesh];
       
       // Create an instance with the current nodes transformation and append it to the parent group.
-      std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+      std::shared_ptr<sg::Instance> instance = m_nodeArena.create<sg::Instance>(m_idInstance++);
       
       instance->setTransform(trafo);
       instance->setChild(m_geometries[indexGeometry]);
 
-      const struct aiMesh* mesh = scene->mMeshes[indexMesh];
-
-      // Allow to specify different materials per assimp model by using the filename (no path no extension) and the material index.
-      struct aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+      ImportedMesh const& mesh = model.meshes[indexMesh];
 
-      std::string nameMaterialReference;
-      aiString materialName;
-      if (material->Get(AI_MATKEY_NAME, materialName) == aiReturn_SUCCESS)
-      {
-        nameMaterialReference = std::string(materialName.C_Str());
-      }
+      // Allow to specify different materials per assimp model by using the material name.
+      std::string const& nameMaterialReference = mesh.material;
 
       int indexMaterial = -1;
       std::map<std::string, int>::const_iterator itm = m_mapMaterialReferences.find(nameMaterialReference);
@@ -290,10 +388,9 @@ std::shared_ptr<sg::Group> Application::traverseScene(const struct aiScene *scen
         
         // The materials had been created with default albedo colors.
         // Change it to the diffuse color of the assimp material.
-        aiColor4D diffuse;
-        if (material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse) == aiReturn_SUCCESS)
+        if (mesh.hasDiffuse)
         {
-          m_materialsGUI[indexMaterial].albedo = make_float3(diffuse.r, diffuse.g, diffuse.b);
+          m_materialsGUI[indexMaterial].albedo = mesh.diffuse;
           m_materialsGUI[indexMaterial].useHeadTexture = false;
           m_materialsGUI[indexMaterial].useEyeTexture = false;
           m_materialsGUI[indexMaterial].useAlbedoTexture = false;
@@ -0,0 +1,1148 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/BlockCompression.h"
+#include "inc/HalfFloat.h"
+#include "inc/Hash.h"
+#include "inc/MappedFile.h"
+#include "inc/ThreadPool.h"
+#include "inc/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "inc/MyAssert.h"
+
+// Increment whenever the encoder output or the file layout changes.
+#define BLOCK_CACHE_VERSION 2
+
+// BC6H and BC7 interpolation weights for 4-bit indices, out of 64.
+static const int c_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+
+// Little endian bit stream inside one 128-bit block.
+class BitWriter
+{
+public:
+  explicit BitWriter(unsigned char* block)
+  : m_block(block)
+  , m_position(0)
+  {
+    memset(m_block, 0, 16);
+  }
+
+  void write(const unsigned int value, const unsigned int numBits)
+  {
+    for (unsigned int i = 0; i < numBits; ++i, ++m_position)
+    {
+      m_block[m_position >> 3] |= ((value >> i) & 1) << (m_position & 7);
+    }
+  }
+
+private:
+  unsigned char* m_block;
+  unsigned int   m_position;
+};
+
+class BitReader
+{
+public:
+  explicit BitReader(const unsigned char* block)
+  : m_block(block)
+  , m_position(0)
+  {
+  }
+
+  unsigned int read(const unsigned int numBits)
+  {
+    unsigned int value = 0;
+    for (unsigned int i = 0; i < numBits; ++i, ++m_position)
+    {
+      value |= ((m_block[m_position >> 3] >> (m_position & 7)) & 1) << i;
+    }
+    return value;
+  }
+
+private:
+  const unsigned char* m_block;
+  unsigned int         m_position;
+};
+
+
+// Unsigned half float conversion for BC6H. Negative values and NaN are clamped to zero, big values to the largest half.
+static unsigned int floatToHalfUnsigned(const float f)
+{
+  if (!(0.0f < f)) // Also catches NaN.
+  {
+    return 0;
+  }
+  return floatToHalf(std::min(f, 65504.0f));
+}
+
+
+// Principal axis of the block's points via power iteration on the covariance matrix.
+// The endpoints are the extreme projections onto that axis through the mean.
+template<int C>
+static void principalEndpoints(const float (*points)[C], float* e0, float* e1)
+{
+  float mean[C] = {};
+  for (int i = 0; i < 16; ++i)
+  {
+    for (int c = 0; c < C; ++c)
+    {
+      mean[c] += points[i][c];
+    }
+  }
+  for (int c = 0; c < C; ++c)
+  {
+    mean[c] *= 1.0f / 16.0f;
+  }
+
+  float covariance[C][C] = {};
+  for (int i = 0; i < 16; ++i)
+  {
+    for (int r = 0; r < C; ++r)
+    {
+      for (int c = 0; c < C; ++c)
+      {
+        covariance[r][c] += (points[i][r] - mean[r]) * (points[i][c] - mean[c]);
+      }
+    }
+  }
+
+  // Start with the diagonal of the bounding box, which is a good guess and never orthogonal to the principal axis in practice.
+  float axis[C];
+  float minimum[C];
+  float maximum[C];
+  for (int c = 0; c < C; ++c)
+  {
+    minimum[c] = maximum[c] = points[0][c];
+  }
+  for (int i = 1; i < 16; ++i)
+  {
+    for (int c = 0; c < C; ++c)
+    {
+      minimum[c] = std::min(minimum[c], points[i][c]);
+      maximum[c] = std::max(maximum[c], points[i][c]);
+    }
+  }
+  for (int c = 0; c < C; ++c)
+  {
+    axis[c] = maximum[c] - minimum[c];
+  }
+
+  for (int iteration = 0; iteration < 8; ++iteration)
+  {
+    float next[C] = {};
+    float length  = 0.0f;
+    for (int r = 0; r < C; ++r)
+    {
+      for (int c = 0; c < C; ++c)
+      {
+        next[r] += covariance[r][c] * axis[c];
+      }
+      length = std::max(length, std::abs(next[r]));
+    }
+    if (length <= 0.0f)
+    {
+      break; // Keep the previous axis, the block has no variance along it.
+    }
+    for (int c = 0; c < C; ++c)
+    {
+      axis[c] = next[c] / length;
+    }
+  }
+
+  float length = 0.0f;
+  for (int c = 0; c < C; ++c)
+  {
+    length += axis[c] * axis[c];
+  }
+  if (length <= 0.0f) // Constant block.
+  {
+    for (int c = 0; c < C; ++c)
+    {
+      e0[c] = e1[c] = mean[c];
+    }
+    return;
+  }
+  length = 1.0f / sqrtf(length);
+  for (int c = 0; c < C; ++c)
+  {
+    axis[c] *= length;
+  }
+
+  float tMin =  1.0e30f;
+  float tMax = -1.0e30f;
+  for (int i = 0; i < 16; ++i)
+  {
+    float t = 0.0f;
+    for (int c = 0; c < C; ++c)
+    {
+      t += (points[i][c] - mean[c]) * axis[c];
+    }
+    tMin = std::min(tMin, t);
+    tMax = std::max(tMax, t);
+  }
+
+  for (int c = 0; c < C; ++c)
+  {
+    e0[c] = mean[c] + axis[c] * tMin;
+    e1[c] = mean[c] + axis[c] * tMax;
+  }
+}
+
+// Least squares fit of the endpoints to the points given the interpolation weight of e1 per point.
+// Returns false when all points use the same weight and the system is singular.
+template<int C>
+static bool fitEndpoints(const float (*points)[C], const float* weights, float* e0, float* e1)
+{
+  float aa = 0.0f;
+  float ab = 0.0f;
+  float bb = 0.0f;
+  float ax[C] = {};
+  float bx[C] = {};
+
+  for (int i = 0; i < 16; ++i)
+  {
+    const float b = weights[i];
+    const float a = 1.0f - b;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int c = 0; c < C; ++c)
+    {
+      ax[c] += a * points[i][c];
+      bx[c] += b * points[i][c];
+    }
+  }
+
+  const float determinant = aa * bb - ab * ab;
+  if (std::abs(determinant) < 1.0e-6f)
+  {
+    return false;
+  }
+  const float invDeterminant = 1.0f / determinant;
+
+  for (int c = 0; c < C; ++c)
+  {
+    e0[c] = (bb * ax[c] - ab * bx[c]) * invDeterminant;
+    e1[c] = (aa * bx[c] - ab * ax[c]) * invDeterminant;
+  }
+  return true;
+}
+
+template<int C, int N>
+static float selectIndices(const float (*points)[C], const float (*palette)[C], unsigned int* indices)
+{
+  float error = 0.0f;
+  for (int i = 0; i < 16; ++i)
+  {
+    float best = 1.0e30f;
+    for (int p = 0; p < N; ++p)
+    {
+      float d = 0.0f;
+      for (int c = 0; c < C; ++c)
+      {
+        const float diff = points[i][c] - palette[p][c];
+        d += diff * diff;
+      }
+      if (d < best)
+      {
+        best       = d;
+        indices[i] = p;
+      }
+    }
+    error += best;
+  }
+  return error;
+}
+
+
+// BC1 color block.
+
+static unsigned int packRGB565(const float* color)
+{
+  const unsigned int r = (unsigned int) (std::min(std::max(color[0], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+  const unsigned int g = (unsigned int) (std::min(std::max(color[1], 0.0f), 255.0f) * (63.0f / 255.0f) + 0.5f);
+  const unsigned int b = (unsigned int) (std::min(std::max(color[2], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+  return (r << 11) | (g << 5) | b;
+}
+
+static void unpackRGB565(const unsigned int c, float* color)
+{
+  const unsigned int r = (c >> 11) & 0x1F;
+  const unsigned int g = (c >>  5) & 0x3F;
+  const unsigned int b =  c        & 0x1F;
+  color[0] = float((r << 3) | (r >> 2));
+  color[1] = float((g << 2) | (g >> 4));
+  color[2] = float((b << 3) | (b >> 2));
+}
+
+// Four color palette in index order: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1.
+static void paletteBC1(const unsigned int c0, const unsigned int c1, float (*palette)[3])
+{
+  unpackRGB565(c0, palette[0]);
+  unpackRGB565(c1, palette[1]);
+  for (int c = 0; c < 3; ++c)
+  {
+    palette[2][c] = float((2 * int(palette[0][c]) + int(palette[1][c])) / 3);
+    palette[3][c] = float((int(palette[0][c]) + 2 * int(palette[1][c])) / 3);
+  }
+}
+
+static const float c_weightsBC1[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f }; // Weight of c1 per index.
+
+static float evaluateBC1(const float (*points)[3], const float* e0, const float* e1, unsigned int& c0, unsigned int& c1, unsigned int* indices)
+{
+  c0 = packRGB565(e0);
+  c1 = packRGB565(e1);
+
+  float palette[4][3];
+  paletteBC1(c0, c1, palette);
+
+  return selectIndices<3, 4>(points, palette, indices);
+}
+
+static void encodeBlockBC1(const float (*points)[3], unsigned char* block)
+{
+  float e0[3];
+  float e1[3];
+  principalEndpoints<3>(points, e1, e0); // e0 is the bright end, that keeps c0 > c1 more often.
+
+  unsigned int c0;
+  unsigned int c1;
+  unsigned int indices[16];
+  float error = evaluateBC1(points, e0, e1, c0, c1, indices);
+
+  // One least squares refinement of the endpoints for the chosen indices.
+  float weights[16];
+  for (int i = 0; i < 16; ++i)
+  {
+    weights[i] = c_weightsBC1[indices[i]];
+  }
+  if (fitEndpoints<3>(points, weights, e0, e1))
+  {
+    unsigned int c0Fit;
+    unsigned int c1Fit;
+    unsigned int indicesFit[16];
+    const float errorFit = evaluateBC1(points, e0, e1, c0Fit, c1Fit, indicesFit);
+    if (errorFit < error)
+    {
+      c0 = c0Fit;
+      c1 = c1Fit;
+      memcpy(indices, indicesFit, sizeof(indices));
+    }
+  }
+
+  // c0 <= c1 selects the three color mode with transparent black. Keep the four color mode.
+  if (c0 < c1)
+  {
+    std::swap(c0, c1);
+    for (int i = 0; i < 16; ++i)
+    {
+      indices[i] ^= 1; // 0 <-> 1, 2 <-> 3
+    }
+  }
+  else if (c0 == c1)
+  {
+    memset(indices, 0, sizeof(indices));
+  }
+
+  unsigned int bits = 0;
+  for (int i = 0; i < 16; ++i)
+  {
+    bits |= indices[i] << (2 * i);
+  }
+
+  block[0] = (unsigned char) (c0 & 0xFF);
+  block[1] = (unsigned char) (c0 >> 8);
+  block[2] = (unsigned char) (c1 & 0xFF);
+  block[3] = (unsigned char) (c1 >> 8);
+  block[4] = (unsigned char) (bits & 0xFF);
+  block[5] = (unsigned char) ((bits >>  8) & 0xFF);
+  block[6] = (unsigned char) ((bits >> 16) & 0xFF);
+  block[7] = (unsigned char) (bits >> 24);
+}
+
+static void decodeBlockBC1(const unsigned char* block, unsigned char (*rgba)[4], const bool alwaysFourColors)
+{
+  const unsigned int c0   = block[0] | (block[1] << 8);
+  const unsigned int c1   = block[2] | (block[3] << 8);
+  const unsigned int bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int) block[7] << 24);
+
+  float palette[4][3];
+  paletteBC1(c0, c1, palette);
+
+  float alpha[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+  if (!alwaysFourColors && c0 <= c1)
+  {
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+      palette[2][c] = float((int(palette[0][c]) + int(palette[1][c])) / 2);
+      palette[3][c] = 0.0f;
+    }
+    alpha[3] = 0.0f;
+  }
+
+  for (int i = 0; i < 16; ++i)
+  {
+    const unsigned int index = (bits >> (2 * i)) & 3;
+    for (int c = 0; c < 3; ++c)
+    {
+      rgba[i][c] = (unsigned char) palette[index][c];
+    }
+    rgba[i][3] = (unsigned char) alpha[index];
+  }
+}
+
+
+// BC4 single channel block, used for the BC3 alpha and the two BC5 channels.
+
+// Eight value palette for a0 > a1: a0, a1, then six values interpolated from a0 to a1.
+static void paletteBC4(const unsigned int a0, const unsigned int a1, int* palette)
+{
+  palette[0] = a0;
+  palette[1] = a1;
+  if (a0 > a1)
+  {
+    for (int i = 2; i < 8; ++i)
+    {
+      palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+    }
+  }
+  else
+  {
+    for (int i = 2; i < 6; ++i)
+    {
+      palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+static void encodeBlockBC4(const unsigned char* values, unsigned char* block)
+{
+  unsigned int a0 = values[0]; // maximum
+  unsigned int a1 = values[0]; // minimum
+  for (int i = 1; i < 16; ++i)
+  {
+    a0 = std::max(a0, (unsigned int) values[i]);
+    a1 = std::min(a1, (unsigned int) values[i]);
+  }
+
+  uint64_t bits = 0;
+  if (a0 != a1)
+  {
+    int palette[8];
+    paletteBC4(a0, a1, palette);
+
+    for (int i = 0; i < 16; ++i)
+    {
+      unsigned int index = 0;
+      int          best  = 256;
+      for (unsigned int p = 0; p < 8; ++p)
+      {
+        const int d = std::abs(int(values[i]) - palette[p]);
+        if (d < best)
+        {
+          best  = d;
+          index = p;
+        }
+      }
+      bits |= uint64_t(index) << (3 * i);
+    }
+  }
+
+  block[0] = (unsigned char) a0;
+  block[1] = (unsigned char) a1;
+  for (int i = 0; i < 6; ++i)
+  {
+    block[2 + i] = (unsigned char) ((bits >> (8 * i)) & 0xFF);
+  }
+}
+
+static void decodeBlockBC4(const unsigned char* block, unsigned char* values, const unsigned int stride)
+{
+  int palette[8];
+  paletteBC4(block[0], block[1], palette);
+
+  uint64_t bits = 0;
+  for (int i = 0; i < 6; ++i)
+  {
+    bits |= uint64_t(block[2 + i]) << (8 * i);
+  }
+
+  for (int i = 0; i < 16; ++i)
+  {
+    values[i * stride] = (unsigned char) palette[(bits >> (3 * i)) & 7];
+  }
+}
+
+
+// BC7 mode 6: one subset, RGBA endpoints with 7 bits plus a p-bit per endpoint, 4-bit indices.
+
+static float evaluateBC7(const float (*points)[4], const float* e0, const float* e1,
+                         unsigned int (*q)[4], unsigned int* p, unsigned int* indices)
+{
+  float best = 1.0e30f;
+
+  // Try all four p-bit combinations. The p-bit is the shared lowest bit of all channels of an endpoint.
+  for (unsigned int pbits = 0; pbits < 4; ++pbits)
+  {
+    const unsigned int p0 = pbits & 1;
+    const unsigned int p1 = pbits >> 1;
+
+    unsigned int q0[4];
+    unsigned int q1[4];
+    int          v0[4];
+    int          v1[4];
+    for (int c = 0; c < 4; ++c)
+    {
+      q0[c] = (unsigned int) std::min(std::max((e0[c] - float(p0)) * 0.5f + 0.5f, 0.0f), 127.0f);
+      q1[c] = (unsigned int) std::min(std::max((e1[c] - float(p1)) * 0.5f + 0.5f, 0.0f), 127.0f);
+      v0[c] = int((q0[c] << 1) | p0);
+      v1[c] = int((q1[c] << 1) | p1);
+    }
+
+    float palette[16][4];
+    for (int i = 0; i < 16; ++i)
+    {
+      for (int c = 0; c < 4; ++c)
+      {
+        palette[i][c] = float(((64 - c_weights4[i]) * v0[c] + c_weights4[i] * v1[c] + 32) >> 6);
+      }
+    }
+
+    unsigned int candidate[16];
+    const float error = selectIndices<4, 16>(points, palette, candidate);
+    if (error < best)
+    {
+      best = error;
+      memcpy(q[0], q0, sizeof(q0));
+      memcpy(q[1], q1, sizeof(q1));
+      p[0] = p0;
+      p[1] = p1;
+      memcpy(indices, candidate, sizeof(candidate));
+    }
+  }
+  return best;
+}
+
+static void encodeBlockBC7(const float (*points)[4], unsigned char* block)
+{
+  float e0[4];
+  float e1[4];
+  principalEndpoints<4>(points, e0, e1);
+
+  unsigned int q[2][4];
+  unsigned int p[2];
+  unsigned int indices[16];
+  float error = evaluateBC7(points, e0, e1, q, p, indices);
+
+  float weights[16];
+  for (int i = 0; i < 16; ++i)
+  {
+    weights[i] = float(c_weights4[indices[i]]) / 64.0f;
+  }
+  if (fitEndpoints<4>(points, weights, e0, e1))
+  {
+    unsigned int qFit[2][4];
+    unsigned int pFit[2];
+    unsigned int indicesFit[16];
+    const float errorFit = evaluateBC7(points, e0, e1, qFit, pFit, indicesFit);
+    if (errorFit < error)
+    {
+      memcpy(q, qFit, sizeof(q));
+      memcpy(p, pFit, sizeof(p));
+      memcpy(indices, indicesFit, sizeof(indices));
+    }
+  }
+
+  // The most significant index bit of the first pixel is implicitly zero. Swap the endpoints if needed.
+  if (8 <= indices[0])
+  {
+    for (int c = 0; c < 4; ++c)
+    {
+      std::swap(q[0][c], q[1][c]);
+    }
+    std::swap(p[0], p[1]);
+    for (int i = 0; i < 16; ++i)
+    {
+      indices[i] = 15 - indices[i];
+    }
+  }
+
+  BitWriter writer(block);
+  writer.write(1 << 6, 7); // Mode 6.
+  for (int c = 0; c < 4; ++c)
+  {
+    writer.write(q[0][c], 7);
+    writer.write(q[1][c], 7);
+  }
+  writer.write(p[0], 1);
+  writer.write(p[1], 1);
+  writer.write(indices[0], 3);
+  for (int i = 1; i < 16; ++i)
+  {
+    writer.write(indices[i], 4);
+  }
+}
+
+static void decodeBlockBC7(const unsigned char* block, unsigned char (*rgba)[4])
+{
+  if ((block[0] & 0x7F) != (1 << 6)) // Only mode 6 is supported.
+  {
+    for (int i = 0; i < 16; ++i)
+    {
+      rgba[i][0] = 255;
+      rgba[i][1] = 0;
+      rgba[i][2] = 255;
+      rgba[i][3] = 255;
+    }
+    return;
+  }
+
+  BitReader reader(block);
+  reader.read(7);
+
+  unsigned int q[2][4];
+  for (int c = 0; c < 4; ++c)
+  {
+    q[0][c] = reader.read(7);
+    q[1][c] = reader.read(7);
+  }
+  const unsigned int p0 = reader.read(1);
+  const unsigned int p1 = reader.read(1);
+
+  for (int i = 0; i < 16; ++i)
+  {
+    const unsigned int index = reader.read((i == 0) ? 3 : 4);
+    for (int c = 0; c < 4; ++c)
+    {
+      const int v0 = int((q[0][c] << 1) | p0);
+      const int v1 = int((q[1][c] << 1) | p1);
+      rgba[i][c] = (unsigned char) (((64 - c_weights4[index]) * v0 + c_weights4[index] * v1 + 32) >> 6);
+    }
+  }
+}
+
+
+// BC6H mode 11 (unsigned): one region, 10-bit RGB endpoints without delta transform, 4-bit indices.
+// The encoder works on the half float bit patterns as integers, which is roughly logarithmic in the radiance,
+// the same space the hardware interpolates in.
+
+static int unquantizeBC6H(const unsigned int x) // 10-bit endpoint to 16-bit interpolation space.
+{
+  if (x == 0)
+  {
+    return 0;
+  }
+  if (x == 1023)
+  {
+    return 0xFFFF;
+  }
+  return int(((x << 16) + 0x8000) >> 10);
+}
+
+static unsigned int quantizeBC6H(const float half) // Half bit pattern to 10-bit endpoint.
+{
+  const float u = half * (64.0f / 31.0f); // Inverse of the final (u * 31) >> 6 scaling.
+  return (unsigned int) std::min(std::max((u - 32.0f) / 64.0f + 0.5f, 0.0f), 1023.0f);
+}
+
+static int finishBC6H(const int u0, const int u1, const int weight)
+{
+  return ((((64 - weight) * u0 + weight * u1 + 32) >> 6) * 31) >> 6;
+}
+
+static float evaluateBC6H(const float (*points)[3], const float* e0, const float* e1, unsigned int (*q)[3], unsigned int* indices)
+{
+  float palette[16][3];
+  for (int c = 0; c < 3; ++c)
+  {
+    q[0][c] = quantizeBC6H(e0[c]);
+    q[1][c] = quantizeBC6H(e1[c]);
+
+    const int u0 = unquantizeBC6H(q[0][c]);
+    const int u1 = unquantizeBC6H(q[1][c]);
+    for (int i = 0; i < 16; ++i)
+    {
+      palette[i][c] = float(finishBC6H(u0, u1, c_weights4[i]));
+    }
+  }
+  return selectIndices<3, 16>(points, palette, indices);
+}
+
+static void encodeBlockBC6H(const float (*points)[3], unsigned char* block)
+{
+  float e0[3];
+  float e1[3];
+  principalEndpoints<3>(points, e0, e1);
+
+  unsigned int q[2][3];
+  unsigned int indices[16];
+  float error = evaluateBC6H(points, e0, e1, q, indices);
+
+  float weights[16];
+  for (int i = 0; i < 16; ++i)
+  {
+    weights[i] = float(c_weights4[indices[i]]) / 64.0f;
+  }
+  if (fitEndpoints<3>(points, weights, e0, e1))
+  {
+    unsigned int qFit[2][3];
+    unsigned int indicesFit[16];
+    const float errorFit = evaluateBC6H(points, e0, e1, qFit, indicesFit);
+    if (errorFit < error)
+    {
+      memcpy(q, qFit, sizeof(q));
+      memcpy(indices, indicesFit, sizeof(indices));
+    }
+  }
+
+  if (8 <= indices[0]) // Anchor index MSB is implicitly zero.
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      std::swap(q[0][c], q[1][c]);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+      indices[i] = 15 - indices[i];
+    }
+  }
+
+  BitWriter writer(block);
+  writer.write(0x03, 5); // Mode 11.
+  for (int e = 0; e < 2; ++e)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      writer.write(q[e][c], 10);
+    }
+  }
+  writer.write(indices[0], 3);
+  for (int i = 1; i < 16; ++i)
+  {
+    writer.write(indices[i], 4);
+  }
+}
+
+static void decodeBlockBC6H(const unsigned char* block, float (*rgba)[4])
+{
+  if ((block[0] & 0x1F) != 0x03) // Only mode 11 is supported.
+  {
+    for (int i = 0; i < 16; ++i)
+    {
+      rgba[i][0] = 1.0f;
+      rgba[i][1] = 0.0f;
+      rgba[i][2] = 1.0f;
+      rgba[i][3] = 1.0f;
+    }
+    return;
+  }
+
+  BitReader reader(block);
+  reader.read(5);
+
+  int u[2][3];
+  for (int e = 0; e < 2; ++e)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      u[e][c] = unquantizeBC6H(reader.read(10));
+    }
+  }
+
+  for (int i = 0; i < 16; ++i)
+  {
+    const unsigned int index = reader.read((i == 0) ? 3 : 4);
+    for (int c = 0; c < 3; ++c)
+    {
+      rgba[i][c] = halfToFloat((uint16_t) finishBC6H(u[0][c], u[1][c], c_weights4[index]));
+    }
+    rgba[i][3] = 1.0f;
+  }
+}
+
+
+const char* getBlockFormatName(const BlockFormat format)
+{
+  switch (format)
+  {
+    case BLOCK_FORMAT_BC1:
+      return "bc1";
+    case BLOCK_FORMAT_BC3:
+      return "bc3";
+    case BLOCK_FORMAT_BC5:
+      return "bc5";
+    case BLOCK_FORMAT_BC6H:
+      return "bc6h";
+    case BLOCK_FORMAT_BC7:
+      return "bc7";
+    default:
+      return "none";
+  }
+}
+
+unsigned int getBlockSize(const BlockFormat format)
+{
+  switch (format)
+  {
+    case BLOCK_FORMAT_NONE:
+      return 0;
+    case BLOCK_FORMAT_BC1:
+      return 8;
+    default:
+      return 16;
+  }
+}
+
+size_t getCompressedSize(const BlockFormat format, const unsigned int width, const unsigned int height)
+{
+  return size_t((width + 3) / 4) * size_t((height + 3) / 4) * getBlockSize(format);
+}
+
+void compressBlocks(const BlockFormat format, const void* pixels, const unsigned int width, const unsigned int height, unsigned char* blocks)
+{
+  MY_ASSERT(format != BLOCK_FORMAT_NONE);
+  MY_ASSERT((width & 3) == 0 && (height & 3) == 0);
+
+  const unsigned int blocksX   = width  / 4;
+  const unsigned int blocksY   = height / 4;
+  const unsigned int blockSize = getBlockSize(format);
+
+  ThreadPool::getInstance().parallelFor(0, blocksY, 4, [&](size_t first, size_t last)
+  {
+    for (size_t by = first; by < last; ++by)
+    {
+      for (unsigned int bx = 0; bx < blocksX; ++bx)
+      {
+        unsigned char* block = blocks + (by * blocksX + bx) * blockSize;
+
+        if (format == BLOCK_FORMAT_BC6H)
+        {
+          float points[16][3];
+          for (int i = 0; i < 16; ++i)
+          {
+            const float* src = static_cast<const float*>(pixels) + ((by * 4 + (i >> 2)) * width + bx * 4 + (i & 3)) * 4;
+            for (int c = 0; c < 3; ++c)
+            {
+              points[i][c] = float(floatToHalfUnsigned(src[c]));
+            }
+          }
+          encodeBlockBC6H(points, block);
+          continue;
+        }
+
+        unsigned char rgba[16][4];
+        for (int y = 0; y < 4; ++y)
+        {
+          memcpy(rgba[y * 4], static_cast<const unsigned char*>(pixels) + ((by * 4 + y) * width + bx * 4) * 4, 16);
+        }
+
+        switch (format)
+        {
+          case BLOCK_FORMAT_BC1:
+          case BLOCK_FORMAT_BC3:
+          {
+            unsigned char* blockColor = block;
+            if (format == BLOCK_FORMAT_BC3)
+            {
+              unsigned char alpha[16];
+              for (int i = 0; i < 16; ++i)
+              {
+                alpha[i] = rgba[i][3];
+              }
+              encodeBlockBC4(alpha, block);
+              blockColor += 8;
+            }
+
+            float points[16][3];
+            for (int i = 0; i < 16; ++i)
+            {
+              for (int c = 0; c < 3; ++c)
+              {
+                points[i][c] = float(rgba[i][c]);
+              }
+            }
+            encodeBlockBC1(points, blockColor);
+            break;
+          }
+
+          case BLOCK_FORMAT_BC5:
+          {
+            unsigned char channel[16];
+            for (int c = 0; c < 2; ++c)
+            {
+              for (int i = 0; i < 16; ++i)
+              {
+                channel[i] = rgba[i][c];
+              }
+              encodeBlockBC4(channel, block + c * 8);
+            }
+            break;
+          }
+
+          default: // BLOCK_FORMAT_BC7
+          {
+            float points[16][4];
+            for (int i = 0; i < 16; ++i)
+            {
+              for (int c = 0; c < 4; ++c)
+              {
+                points[i][c] = float(rgba[i][c]);
+              }
+            }
+            encodeBlockBC7(points, block);
+            break;
+          }
+        }
+      }
+    }
+  });
+}
+
+void decompressBlocks(const BlockFormat format, const unsigned char* blocks, const unsigned int width, const unsigned int height, void* pixels)
+{
+  MY_ASSERT(format != BLOCK_FORMAT_NONE);
+  MY_ASSERT((width & 3) == 0 && (height & 3) == 0);
+
+  const unsigned int blocksX   = width  / 4;
+  const unsigned int blocksY   = height / 4;
+  const unsigned int blockSize = getBlockSize(format);
+
+  ThreadPool::getInstance().parallelFor(0, blocksY, 4, [&](size_t first, size_t last)
+  {
+    for (size_t by = first; by < last; ++by)
+    {
+      for (unsigned int bx = 0; bx < blocksX; ++bx)
+      {
+        const unsigned char* block = blocks + (by * blocksX + bx) * blockSize;
+
+        if (format == BLOCK_FORMAT_BC6H)
+        {
+          float rgba[16][4];
+          decodeBlockBC6H(block, rgba);
+          for (int y = 0; y < 4; ++y)
+          {
+            memcpy(static_cast<float*>(pixels) + ((by * 4 + y) * width + bx * 4) * 4, rgba[y * 4], 4 * 4 * sizeof(float));
+          }
+          continue;
+        }
+
+        unsigned char rgba[16][4];
+        switch (format)
+        {
+          case BLOCK_FORMAT_BC1:
+            decodeBlockBC1(block, rgba, false);
+            break;
+
+          case BLOCK_FORMAT_BC3:
+            decodeBlockBC1(block + 8, rgba, true);
+            decodeBlockBC4(block, &rgba[0][3], 4);
+            break;
+
+          case BLOCK_FORMAT_BC5:
+            decodeBlockBC4(block,     &rgba[0][0], 4);
+            decodeBlockBC4(block + 8, &rgba[0][1], 4);
+            for (int i = 0; i < 16; ++i)
+            {
+              rgba[i][2] = 0;
+              rgba[i][3] = 255;
+            }
+            break;
+
+          default: // BLOCK_FORMAT_BC7
+            decodeBlockBC7(block, rgba);
+            break;
+        }
+
+        for (int y = 0; y < 4; ++y)
+        {
+          memcpy(static_cast<unsigned char*>(pixels) + ((by * 4 + y) * width + bx * 4) * 4, rgba[y * 4], 16);
+        }
+      }
+    }
+  });
+}
+
+
+// The block cache file starts with this header, followed by the blocks of all levels.
+struct BlockCacheHeader
+{
+  char         magic[8]; // "BLKCACHE"
+  unsigned int version;
+  unsigned int format;
+  unsigned int numLevels;
+  unsigned int width;     // LOD 0
+  unsigned int height;
+  unsigned int reserved;
+  uint64_t     hash;      // Of the uncompressed input pixels of all levels.
+};
+
+static const char c_blockMagic[8] = { 'B', 'L', 'K', 'C', 'A', 'C', 'H', 'E' };
+
+static bool loadBlockCache(std::string const& filename, BlockCacheHeader const& key, std::vector<BlockLevel> const& levels,
+                           std::vector< std::vector<unsigned char> >& blocks)
+{
+  MappedFile file;
+  if (!file.open(filename) || file.getSize() < sizeof(BlockCacheHeader))
+  {
+    return false;
+  }
+
+  const BlockCacheHeader* header = static_cast<const BlockCacheHeader*>(file.getData());
+
+  if (memcmp(header->magic, key.magic, sizeof(c_blockMagic)) != 0 ||
+      header->version   != key.version ||
+      header->format    != key.format ||
+      header->numLevels != key.numLevels ||
+      header->width     != key.width ||
+      header->height    != key.height ||
+      header->hash      != key.hash)
+  {
+    return false;
+  }
+
+  size_t size = sizeof(BlockCacheHeader);
+  for (BlockLevel const& level : levels)
+  {
+    size += getCompressedSize(BlockFormat(key.format), level.width, level.height);
+  }
+  if (size != file.getSize())
+  {
+    return false;
+  }
+
+  const unsigned char* p = static_cast<const unsigned char*>(file.getData()) + sizeof(BlockCacheHeader);
+
+  blocks.resize(levels.size());
+  for (size_t i = 0; i < levels.size(); ++i)
+  {
+    const size_t sizeLevel = getCompressedSize(BlockFormat(key.format), levels[i].width, levels[i].height);
+    blocks[i].assign(p, p + sizeLevel);
+    p += sizeLevel;
+  }
+  return true;
+}
+
+static void saveBlockCache(std::string const& filename, BlockCacheHeader const& header, std::vector< std::vector<unsigned char> > const& blocks)
+{
+  // Write to a temporary file first. Concurrent readers never see a partially written cache.
+  const std::string filenameTemp = filename + std::string(".tmp");
+  {
+    std::ofstream output(filenameTemp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+      std::cerr << "WARNING: compressLevels() cannot write " << filenameTemp << '\n';
+      return;
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(BlockCacheHeader));
+    for (std::vector<unsigned char> const& level : blocks)
+    {
+      output.write(reinterpret_cast<const char*>(level.data()), level.size());
+    }
+
+    if (!output)
+    {
+      std::cerr << "WARNING: compressLevels() failed writing " << filenameTemp << '\n';
+      output.close();
+      std::remove(filenameTemp.c_str());
+      return;
+    }
+  }
+
+  std::remove(filename.c_str()); // rename() does not replace existing files on Windows.
+  if (std::rename(filenameTemp.c_str(), filename.c_str()) != 0)
+  {
+    std::cerr << "WARNING: compressLevels() cannot rename " << filenameTemp << " to " << filename << '\n';
+    std::remove(filenameTemp.c_str());
+  }
+}
+
+void compressLevels(const BlockFormat format, std::vector<BlockLevel> const& levels,
+                    std::vector< std::vector<unsigned char> >& blocks, std::string const& cacheFilename)
+{
+  MY_ASSERT(!levels.empty());
+
+  const size_t bytesPerPixel = (format == BLOCK_FORMAT_BC6H) ? 4 * sizeof(float) : 4;
+
+  BlockCacheHeader header;
+  memset(&header, 0, sizeof(BlockCacheHeader));
+
+  if (!cacheFilename.empty())
+  {
+    memcpy(header.magic, c_blockMagic, sizeof(c_blockMagic));
+    header.version   = BLOCK_CACHE_VERSION;
+    header.format    = static_cast<unsigned int>(format);
+    header.numLevels = static_cast<unsigned int>(levels.size());
+    header.width     = levels[0].width;
+    header.height    = levels[0].height;
+    for (BlockLevel const& level : levels)
+    {
+      header.hash = hash64Parallel(level.pixels, size_t(level.width) * level.height * bytesPerPixel, header.hash);
+    }
+
+    if (loadBlockCache(cacheFilename, header, levels, blocks))
+    {
+      return;
+    }
+  }
+
+  Timer timer;
+  timer.start();
+
+  blocks.resize(levels.size());
+  for (size_t i = 0; i < levels.size(); ++i)
+  {
+    blocks[i].resize(getCompressedSize(format, levels[i].width, levels[i].height));
+    compressBlocks(format, levels[i].pixels, levels[i].width, levels[i].height, blocks[i].data());
+  }
+
+  timer.stop();
+
+  const double megapixels = double(levels[0].width) * double(levels[0].height) * 1.0e-6;
+  std::cout << "compressLevels(): " << getBlockFormatName(format) << ' ' << levels[0].width << " x " << levels[0].height << ", "
+            << levels.size() << " levels in " << timer.getTime() * 1000.0 << " ms (" << timer.getTime() * 1000.0 / megapixels << " ms/MP)\n";
+
+  if (!cacheFilename.empty())
+  {
+    saveBlockCache(cacheFilename, header, blocks);
+  }
+}
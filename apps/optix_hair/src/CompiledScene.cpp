@@ -0,0 +1,391 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/CompiledScene.h"
+
+#include "inc/ThreadPool.h"
+
+#include "inc/MyAssert.h"
+
+#include <cstring>
+
+
+CompiledInstance::CompiledInstance(float const* trafo, InstanceData const& instanceData)
+: data(instanceData)
+{
+  memcpy(matrix, trafo, sizeof(float) * 12);
+}
+
+
+SceneDiff::SceneDiff()
+: instancesChanged(false)
+, recordsResized(false)
+{
+}
+
+bool SceneDiff::isEmpty() const
+{
+  return geometriesRemoved.empty() && geometriesBuilt.empty() && !instancesChanged && !recordsResized && recordsChanged.empty();
+}
+
+
+CompiledScene::CompiledScene()
+: m_changes(sg::CHANGE_NONE)
+{
+}
+
+std::vector<CompiledInstance> const& CompiledScene::getInstances() const
+{
+  return m_instances;
+}
+
+std::vector<CompiledGeometry> const& CompiledScene::getGeometries() const
+{
+  return m_geometries;
+}
+
+void CompiledScene::compile(std::shared_ptr<sg::Group> root, const unsigned int numGeometries)
+{
+  m_instances.clear();
+  m_geometries.clear();
+
+  update(root, numGeometries);
+}
+
+SceneDiff CompiledScene::update(std::shared_ptr<sg::Group> root, const unsigned int numGeometries)
+{
+  std::vector<CompiledInstance> previousInstances;
+  std::vector<CompiledGeometry> previousGeometries;
+
+  previousInstances.swap(m_instances);
+  previousGeometries.swap(m_geometries);
+
+  m_geometries.resize(numGeometries);
+  m_changes = sg::CHANGE_NONE;
+
+  // Set the affine matrix to identity by default.
+  float matrix[12];
+
+  memset(matrix, 0, sizeof(float) * 12);
+  matrix[ 0] = 1.0f;
+  matrix[ 5] = 1.0f;
+  matrix[10] = 1.0f;
+
+  InstanceData data(~0u, -1, -1);
+  traverseNode(root, matrix, data);
+
+  SceneDiff diff;
+
+  std::vector<bool> isBuilt(numGeometries, false);
+
+  for (unsigned int id = 0; id < numGeometries; ++id)
+  {
+    CompiledGeometry& geometry = m_geometries[id];
+    CompiledGeometry* previous = (id < previousGeometries.size() && previousGeometries[id].node) ? &previousGeometries[id] : nullptr;
+
+    if (geometry.node)
+    {
+      const bool isChanged = (!previous || previous->node != geometry.node || (geometry.node->getChanges() & sg::CHANGE_GEOMETRY));
+      
+      geometry.node->clearChanges();
+
+      if (isChanged)
+      {
+        diff.geometriesBuilt.push_back(id);
+        isBuilt[id] = true;
+      }
+      else
+      {
+        geometry.segments.swap(previous->segments);
+        geometry.strandIndices.swap(previous->strandIndices);
+        geometry.strandInfo.swap(previous->strandInfo);
+        geometry.strandRand.swap(previous->strandRand);
+      }
+    }
+    else if (previous)
+    {
+      // Not referenced by an active instance anymore. Keep the data as long as it's unchanged, the devices keep the GAS as well.
+      if (previous->node->getChanges() & sg::CHANGE_GEOMETRY)
+      {
+        diff.geometriesRemoved.push_back(id);
+      }
+      else
+      {
+        geometry = std::move(*previous);
+      }
+    }
+  }
+
+  for (size_t id = numGeometries; id < previousGeometries.size(); ++id)
+  {
+    if (previousGeometries[id].node)
+    {
+      diff.geometriesRemoved.push_back(static_cast<unsigned int>(id));
+    }
+  }
+
+  // The strand arrays of the Curves are derived per strand. Build them once for all devices, in parallel for multiple hair models.
+  ThreadPool::getInstance().parallelFor(0, diff.geometriesBuilt.size(), 1, [this, &diff](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      CompiledGeometry& geometry = m_geometries[diff.geometriesBuilt[i]];
+
+      if (geometry.type == sg::NodeType::NT_CURVES)
+      {
+        sg::Curves const& curves = static_cast<sg::Curves const&>(*geometry.node);
+
+        geometry.segments      = curves.segments();
+        geometry.strandIndices = curves.strandIndices();
+        geometry.strandInfo    = curves.strandInfo();
+        geometry.strandRand    = curves.strandRand();
+      }
+    }
+  });
+
+  if (previousInstances.size() != m_instances.size())
+  {
+    diff.instancesChanged = true;
+    diff.recordsResized   = true;
+  }
+  else if (m_changes != sg::CHANGE_NONE || !diff.geometriesBuilt.empty()) // Otherwise the instance table is unchanged.
+  {
+    for (size_t i = 0; i < m_instances.size(); ++i)
+    {
+      CompiledInstance const& before = previousInstances[i];
+      CompiledInstance const& after  = m_instances[i];
+
+      const bool isNewGeometry = (before.data.idGeometry != after.data.idGeometry || isBuilt[after.data.idGeometry]);
+
+      if (isNewGeometry || memcmp(before.matrix, after.matrix, sizeof(float) * 12) != 0)
+      {
+        diff.instancesChanged = true;
+      }
+      if (isNewGeometry || before.data.idMaterial != after.data.idMaterial || before.data.idLight != after.data.idLight)
+      {
+        diff.recordsChanged.push_back(static_cast<unsigned int>(i));
+      }
+    }
+  }
+
+  return diff;
+}
+
+// m = a * b;
+static void multiplyMatrix(float* m, const float* a, const float* b)
+{
+  m[ 0] = a[0] * b[0] + a[1] * b[4] + a[ 2] * b[ 8]; // + a[3] * 0
+  m[ 1] = a[0] * b[1] + a[1] * b[5] + a[ 2] * b[ 9]; // + a[3] * 0
+  m[ 2] = a[0] * b[2] + a[1] * b[6] + a[ 2] * b[10]; // + a[3] * 0
+  m[ 3] = a[0] * b[3] + a[1] * b[7] + a[ 2] * b[11] + a[3]; // * 1
+  
+  m[ 4] = a[4] * b[0] + a[5] * b[4] + a[ 6] * b[ 8]; // + a[7] * 0
+  m[ 5] = a[4] * b[1] + a[5] * b[5] + a[ 6] * b[ 9]; // + a[7] * 0
+  m[ 6] = a[4] * b[2] + a[5] * b[6] + a[ 6] * b[10]; // + a[7] * 0
+  m[ 7] = a[4] * b[3] + a[5] * b[7] + a[ 6] * b[11] + a[7]; // * 1
+
+  m[ 8] = a[8] * b[0] + a[9] * b[4] + a[10] * b[ 8]; // + a[11] * 0
+  m[ 9] = a[8] * b[1] + a[9] * b[5] + a[10] * b[ 9]; // + a[11] * 0
+  m[10] = a[8] * b[2] + a[9] * b[6] + a[10] * b[10]; // + a[11] * 0
+  m[11] = a[8] * b[3] + a[9] * b[7] + a[10] * b[11] + a[11]; // * 1
+}
+
+void CompiledScene::traverseNode(std::shared_ptr<sg::Node> const& node, float const* matrix, InstanceData data)
+{
+  // The node type is known from getType(), static casts are sufficient.
+  switch (node->getType())
+  {
+    case sg::NodeType::NT_GROUP:
+    {
+      sg::Group& group = static_cast<sg::Group&>(*node);
+
+      m_changes |= group.getChanges();
+      group.clearChanges();
+
+      for (size_t i = 0; i < group.getNumChildren(); ++i)
+      {
+        std::shared_ptr<sg::Instance> const& child = group.getChild(i);
+        if (child->is_activated()) 
+        {
+          traverseNode(child, matrix, data);
+        }
+        else
+        {
+          // Deactivating removes the instances of the child's sub-tree.
+          m_changes |= child->getChanges();
+          child->clearChanges();
+        }
+      }
+    }
+    break;
+
+    case sg::NodeType::NT_INSTANCE:
+    {
+      sg::Instance& instance = static_cast<sg::Instance&>(*node);
+
+      m_changes |= instance.getChanges();
+      instance.clearChanges();
+
+      // Concatenate the transformations along the path.
+      float trafo[12];
+      multiplyMatrix(trafo, matrix, instance.getTransform());
+
+      int idMaterial = instance.getMaterial();
+      if (0 <= idMaterial)
+      {
+        data.idMaterial = idMaterial;  
+      }
+
+      int idLight = instance.getLight();
+      if (0 <= idLight)
+      {
+        data.idLight = idLight;  
+      }
+      traverseNode(instance.getChild(), trafo, data);      
+    }
+    break;
+
+    case sg::NodeType::NT_TRIANGLES:
+    case sg::NodeType::NT_CURVES:
+    {
+      data.idGeometry = node->getId();
+      MY_ASSERT(data.idGeometry < m_geometries.size());
+
+      CompiledGeometry& geometry = m_geometries[data.idGeometry];
+
+      if (!geometry.node) // First instance of this geometry.
+      {
+        geometry.type = node->getType();
+        geometry.node = node;
+
+        if (geometry.type == sg::NodeType::NT_TRIANGLES)
+        {
+          sg::Triangles const& triangles = static_cast<sg::Triangles const&>(*node);
+
+          geometry.attributes = &triangles.getAttributes();
+          geometry.indices    = &triangles.getIndices();
+          geometry.thickness  = nullptr;
+        }
+        else
+        {
+          sg::Curves const& curves = static_cast<sg::Curves const&>(*node);
+
+          geometry.attributes = &curves.getAttributes();
+          geometry.indices    = nullptr;
+          geometry.thickness  = &curves.getThickness();
+        }
+      }
+
+      m_instances.push_back(CompiledInstance(matrix, data));
+    }
+    break;
+  }
+}
+
+
+SceneTarget::~SceneTarget()
+{
+}
+
+void applyScene(CompiledScene const& scene, SceneTarget& target)
+{
+  std::vector<CompiledGeometry> const& geometries = scene.getGeometries();
+
+  for (unsigned int idGeometry = 0; idGeometry < static_cast<unsigned int>(target.getNumGeometries()); ++idGeometry)
+  {
+    target.freeGeometry(idGeometry);
+  }
+  target.setNumGeometries(0);
+  target.setNumGeometries(geometries.size());
+
+  // Only referenced geometries get a GAS, each one once.
+  for (CompiledInstance const& instance : scene.getInstances())
+  {
+    const unsigned int idGeometry = instance.data.idGeometry;
+
+    if (!target.isGeometryBuilt(idGeometry))
+    {
+      target.buildGeometry(idGeometry, geometries[idGeometry]);
+    }
+  }
+
+  target.buildInstances(scene);
+  target.buildRecords();
+}
+
+void applySceneDiff(CompiledScene const& scene, SceneDiff const& diff, SceneTarget& target)
+{
+  if (diff.isEmpty())
+  {
+    return;
+  }
+
+  std::vector<CompiledGeometry> const& geometries = scene.getGeometries();
+
+  if (target.getNumGeometries() < geometries.size())
+  {
+    target.setNumGeometries(geometries.size());
+  }
+
+  for (const unsigned int idGeometry : diff.geometriesRemoved)
+  {
+    target.freeGeometry(idGeometry);
+  }
+
+  for (const unsigned int idGeometry : diff.geometriesBuilt)
+  {
+    target.freeGeometry(idGeometry);
+    target.buildGeometry(idGeometry, geometries[idGeometry]);
+  }
+
+  target.setNumGeometries(geometries.size()); // All geometries beyond the new size have been removed above.
+
+  if (diff.instancesChanged)
+  {
+    target.buildInstances(scene);
+  }
+  else
+  {
+    for (const unsigned int idInstance : diff.recordsChanged)
+    {
+      target.setInstanceData(idInstance, scene.getInstances()[idInstance].data);
+    }
+  }
+
+  if (diff.recordsResized)
+  {
+    target.buildRecords();
+  }
+  else
+  {
+    for (const unsigned int idInstance : diff.recordsChanged)
+    {
+      target.updateRecord(idInstance);
+    }
+  }
+}
@@ -1,13 +1,53 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
 
 #include "inc/ConfigParser.h"
 
+#include "rapidjson/error/en.h"
+
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+
+
+// Comments and trailing commas make hand edited descriptions less brittle.
+// Numbers stay text and are converted by the keyword handlers with parseFloat() and parseInt() like in the text format.
+static const unsigned int parseFlags = rapidjson::kParseCommentsFlag | 
+                                       rapidjson::kParseTrailingCommasFlag | 
+                                       rapidjson::kParseNumbersAsStringsFlag;
 
 
 ConfigParser::ConfigParser()
+: m_stream(nullptr, 0)
+, m_tokenOffset(0)
 {
+  m_handler.m_token = nullptr;
+  m_handler.m_type  = PTT_UNKNOWN;
 }
 
 //ConfigParser::~ConfigParser()
@@ -16,136 +56,158 @@ ConfigParser::ConfigParser()
 
 bool ConfigParser::load(std::string const& filename)
 {
-  m_source.clear();
+  m_filename    = filename;
+  m_tokenOffset = 0;
 
-  std::ifstream inputStream(filename);
-  if (!inputStream)
+  if (!m_file.open(filename))
   {
     std::cerr << "ERROR: ConfigParser::load() failed to open file " << filename << '\n';
+    m_stream = rapidjson::MemoryStream(nullptr, 0);
     return false;
   }
 
-  std::stringstream data;
+  m_stream = rapidjson::MemoryStream(static_cast<const char*>(m_file.getData()), m_file.getSize());
 
-  data << inputStream.rdbuf();
+  m_reader.IterativeParseInit();
+  return true;
+}
+
+ParserTokenType ConfigParser::getNextToken(std::string& token)
+{
+  m_handler.m_token = &token;
 
-  if (inputStream.fail())
+  while (!m_reader.IterativeParseComplete())
   {
-    std::cerr << "ERROR: loadString() Failed to read file " << filename << '\n';
-    return false;
+    m_handler.m_type = PTT_UNKNOWN;
+
+    if (!m_reader.IterativeParseNext<parseFlags>(m_stream, m_handler))
+    {
+      unsigned int line;
+      unsigned int column;
+
+      locate(m_reader.GetErrorOffset(), line, column);
+
+      std::cerr << "ERROR: ConfigParser::getNextToken() " << m_filename << "(" << line << "," << column << "): " 
+                << rapidjson::GetParseError_En(m_reader.GetParseErrorCode()) << '\n';
+      token.clear();
+      return PTT_UNKNOWN;
+    }
+
+    if (m_handler.m_type != PTT_UNKNOWN)
+    {
+      m_tokenOffset = m_stream.Tell();
+      return m_handler.m_type;
+    }
   }
 
-  m_source = data.str();
-  return true;
+  token.clear();
+  return PTT_EOF;
 }
 
-ParserTokenType ConfigParser::getNextToken(std::string& token)
+size_t ConfigParser::getSize() const
 {
-  const static std::string whitespace = " \t"; // space, tab
-  const static std::string value      = "+-0123456789.eE";
-  const static std::string delimiter  = " \t\r\n"; // space, tab, carriage return, linefeed
-  const static std::string newline    = "\n";
-  const static std::string quotation  = "\"";
+  return m_file.getSize();
+}
 
-  token.clear(); // Make sure the returned token starts empty.
+std::string::size_type ConfigParser::getIndex() const
+{
+  return m_stream.Tell();
+}
 
-  ParserTokenType type = PTT_UNKNOWN; // This return value indicates an error.
+unsigned int ConfigParser::getLine() const
+{
+  unsigned int line;
+  unsigned int column;
 
-  std::string::size_type first;
-  std::string::size_type last;
+  locate(m_tokenOffset, line, column);
+  return line;
+}
+
+unsigned int ConfigParser::getColumn() const
+{
+  unsigned int line;
+  unsigned int column;
+
+  locate(m_tokenOffset, line, column);
+  return column;
+}
+
+std::string ConfigParser::getLocation() const
+{
+  unsigned int line;
+  unsigned int column;
+
+  locate(m_tokenOffset, line, column);
+  return m_filename + "(" + std::to_string(line) + "," + std::to_string(column) + ")";
+}
 
-  bool done = false;
-  while (!done)
+bool ConfigParser::isJsonFile(std::string const& filename)
+{
+  const std::string::size_type dot = filename.find_last_of('.');
+  if (dot == std::string::npos)
   {
-    // Find first character which is not a whitespace.
-    first = m_source.find_first_not_of(whitespace, m_index);
-    if (first == std::string::npos)
-    {
-      token = std::string();
-      type = PTT_EOF;
-      done = true;
-      continue;
-    }
+    return false;
+  }
 
-    // The found character indicates how parsing continues.
-    char c = m_source[first];
+  std::string extension = filename.substr(dot + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
 
-    if (c == '#') // comment until the next newline
-    {
-      // m_index = first + 1; // skip '#' // Redundant.
-      first = m_source.find_first_of(newline, m_index); // Skip everything until the next newline.
-      if (first == std::string::npos)
-      {
-        type = PTT_EOF;
-        done = true;
-      }
-      m_index = first + 1; // skip newline
-      m_line++;
-    }
-    else if (c == '\r') // carriage return 13
-    {
-      m_index = first + 1;
-    }
-    else if (c == '\n') // newline (linefeed 10)
-    {
-      m_index = first + 1;
-      m_line++;
-    }
-    else if (c == '\"') // Quotation mark delimits strings (filenames or material names with spaces.)
-    {
-      ++first; // Skip beginning quotation mark.
-      last = m_source.find_first_of(quotation, first); // Find the ending quotation mark. Should be in the same line!
-      if (last == std::string::npos) // Error, no matching end quotation mark found.
-      { 
-        m_index = first; // Keep scanning behind the quotation mark.
-      }
-      else
-      {
-        m_index = last + 1; // Skip the ending quotation mark.
-        token = m_source.substr(first, last - first);
-        type = PTT_STRING;
-        done = true;
-      }
-    }
-    else // anything else
+  return extension == "json";
+}
+
+// Line and column are only needed for messages. Counting them here keeps the token loop free of that work.
+void ConfigParser::locate(size_t offset, unsigned int& line, unsigned int& column) const
+{
+  const char* data = static_cast<const char*>(m_file.getData());
+
+  offset = std::min(offset, m_file.getSize());
+
+  line = 1;
+  size_t lineStart = 0;
+  for (size_t i = 0; i < offset; ++i)
+  {
+    if (data[i] == '\n')
     {
-      last = m_source.find_first_of(delimiter, first);
-      if (last == std::string::npos) 
-      { 
-        last = m_source.size();
-      }
-      m_index = last;
-      token = m_source.substr(first, last - first);
-      type = PTT_ID; // Default to general identifier.
-      // Check if token is only built of characters used for numbers. 
-      // (Not perfectly parsing a floating point number but good enough for most filenames.)
-      if (isdigit(c) || c == '-' || c == '+' || c == '.') // Legal start characters for a floating point number.
-      {
-        last = token.find_first_not_of(value, 0);
-        if (last == std::string::npos) 
-        { 
-          type = PTT_VAL;
-        }
-      }
-      done = true;
+      ++line;
+      lineStart = i + 1;
     }
   }
+  column = static_cast<unsigned int>(offset - lineStart) + 1;
+}
 
-  return type;
+
+bool ConfigParser::Handler::Null()
+{
+  return true;
 }
 
-std::string::size_type ConfigParser::getSize() const
+bool ConfigParser::Handler::Bool(bool b)
 {
-  return m_source.size();
+  setToken(PTT_VAL, (b) ? "1" : "0", 1);
+  return true;
 }
 
-std::string::size_type ConfigParser::getIndex() const
+bool ConfigParser::Handler::RawNumber(const char* str, rapidjson::SizeType length, bool /* copy */)
 {
-  return m_index;
+  setToken(PTT_VAL, str, length);
+  return true;
 }
 
-unsigned int ConfigParser::getLine() const
+bool ConfigParser::Handler::String(const char* str, rapidjson::SizeType length, bool /* copy */)
+{
+  setToken(PTT_STRING, str, length);
+  return true;
+}
+
+bool ConfigParser::Handler::Key(const char* str, rapidjson::SizeType length, bool /* copy */)
 {
-  return m_line;
+  setToken(PTT_ID, str, length);
+  return true;
 }
 
+// The reader's string buffer is only valid during the event, copy into the caller's token which reuses its capacity.
+void ConfigParser::Handler::setToken(ParserTokenType type, const char* str, rapidjson::SizeType length)
+{
+  m_token->assign(str, length);
+  m_type = type;
+}
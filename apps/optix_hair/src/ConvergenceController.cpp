@@ -0,0 +1,270 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/ConvergenceController.h"
+#include "inc/ThreadPool.h"
+#include "inc/MyAssert.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Luminance below this is treated as black for the relative error to not stall on dark tiles forever.
+static const float CONVERGENCE_MIN_LUMINANCE = 1.0e-2f;
+
+
+ConvergenceController::ConvergenceController()
+: m_resolution(make_int2(0, 0))
+, m_tileSize(make_int2(32, 32))
+, m_numTiles(make_int2(0, 0))
+, m_targetError(0.0f)
+, m_minIterations(16)
+, m_checkInterval(16)
+, m_converged(false)
+, m_confidenceInterval(1.0f)
+, m_numConverged(0)
+, m_maxError(0.0f)
+, m_activeRect(make_int4(0, 0, 0, 0))
+{
+}
+
+void ConvergenceController::setResolution(const int2 resolution)
+{
+  if (m_resolution.x != resolution.x || m_resolution.y != resolution.y)
+  {
+    m_resolution = resolution;
+    reset();
+  }
+}
+
+void ConvergenceController::setTileSize(const int2 tileSize)
+{
+  m_tileSize = make_int2(std::max(1, tileSize.x), std::max(1, tileSize.y));
+  reset();
+}
+
+void ConvergenceController::setTargetError(const float targetError)
+{
+  m_targetError = std::max(0.0f, targetError);
+  m_converged   = false;
+}
+
+void ConvergenceController::setMinIterations(const unsigned int minIterations)
+{
+  m_minIterations = std::max(2u, minIterations); // The variance buffer is zero after the first iteration.
+}
+
+void ConvergenceController::setCheckInterval(const unsigned int interval)
+{
+  m_checkInterval = std::max(1u, interval);
+}
+
+float ConvergenceController::getTargetError() const
+{
+  return m_targetError;
+}
+
+unsigned int ConvergenceController::getMinIterations() const
+{
+  return m_minIterations;
+}
+
+unsigned int ConvergenceController::getCheckInterval() const
+{
+  return m_checkInterval;
+}
+
+void ConvergenceController::reset()
+{
+  m_numTiles = make_int2((m_resolution.x + m_tileSize.x - 1) / m_tileSize.x,
+                         (m_resolution.y + m_tileSize.y - 1) / m_tileSize.y);
+
+  ConvergenceTile tile;
+
+  tile.meanVariance  = 0.0f;
+  tile.meanLuminance = 0.0f;
+  tile.error         = 1.0f;
+  tile.converged     = false;
+
+  m_tiles.assign(size_t(m_numTiles.x) * size_t(m_numTiles.y), tile);
+
+  m_converged          = false;
+  m_confidenceInterval = 1.0f;
+  m_numConverged       = 0;
+  m_maxError           = 0.0f;
+  m_activeRect         = make_int4(0, 0, m_resolution.x, m_resolution.y);
+}
+
+bool ConvergenceController::isCheckDue(const unsigned int iterationIndex) const
+{
+  return (0.0f < m_targetError && !m_converged && m_minIterations <= iterationIndex && (iterationIndex % m_checkInterval) == 0);
+}
+
+bool ConvergenceController::update(const float4* output, const float* variance, const unsigned int iterationIndex)
+{
+  MY_ASSERT(variance != nullptr);
+
+  if (m_tiles.empty() || iterationIndex == 0)
+  {
+    return false;
+  }
+
+  const float spp = float(iterationIndex);
+  const float targetError = m_targetError;
+
+  // One tile per job. Each tile only writes its own entry, no synchronization needed.
+  ThreadPool::getInstance().parallelFor(0, m_tiles.size(), 4, [&](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      const int tx = int(i % size_t(m_numTiles.x));
+      const int ty = int(i / size_t(m_numTiles.x));
+
+      const int x0 = tx * m_tileSize.x;
+      const int y0 = ty * m_tileSize.y;
+      const int x1 = std::min(x0 + m_tileSize.x, m_resolution.x);
+      const int y1 = std::min(y0 + m_tileSize.y, m_resolution.y);
+
+      // Accumulate in double, a tile can easily hold thousands of pixels with very different magnitudes.
+      double sumVariance  = 0.0;
+      double sumLuminance = 0.0;
+
+      for (int y = y0; y < y1; ++y)
+      {
+        const size_t row = size_t(y) * size_t(m_resolution.x);
+
+        for (int x = x0; x < x1; ++x)
+        {
+          sumVariance += variance[row + x];
+        }
+        if (output)
+        {
+          for (int x = x0; x < x1; ++x)
+          {
+            const float4 c = output[row + x];
+            sumLuminance += 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+          }
+        }
+      }
+
+      const double count = double((x1 - x0) * (y1 - y0));
+
+      ConvergenceTile& tile = m_tiles[i];
+
+      tile.meanVariance  = float(sumVariance  / count);
+      tile.meanLuminance = float(sumLuminance / count);
+
+      // The variance buffer holds the summed squared RGB deviation, scale it to a per channel value before comparing against luminance.
+      float error = 1.96f * sqrtf(tile.meanVariance / (3.0f * spp));
+      if (output)
+      {
+        error /= std::max(tile.meanLuminance, CONVERGENCE_MIN_LUMINANCE);
+      }
+      tile.error     = error;
+      tile.converged = (0.0f < targetError && error <= targetError);
+    }
+  });
+
+  // The serial part is only over the tiles.
+  double       sumVariance = 0.0;
+  unsigned int converged   = 0;
+  float        maxError    = 0.0f;
+  int4         rect        = make_int4(m_resolution.x, m_resolution.y, 0, 0);
+
+  for (size_t i = 0; i < m_tiles.size(); ++i)
+  {
+    ConvergenceTile const& tile = m_tiles[i];
+
+    const int tx = int(i % size_t(m_numTiles.x));
+    const int ty = int(i / size_t(m_numTiles.x));
+
+    const int x0 = tx * m_tileSize.x;
+    const int y0 = ty * m_tileSize.y;
+    const int x1 = std::min(x0 + m_tileSize.x, m_resolution.x);
+    const int y1 = std::min(y0 + m_tileSize.y, m_resolution.y);
+
+    sumVariance += double(tile.meanVariance) * double((x1 - x0) * (y1 - y0));
+    maxError     = std::max(maxError, tile.error);
+
+    if (tile.converged)
+    {
+      ++converged;
+    }
+    else
+    {
+      rect.x = std::min(rect.x, x0);
+      rect.y = std::min(rect.y, y0);
+      rect.z = std::max(rect.z, x1);
+      rect.w = std::max(rect.w, y1);
+    }
+  }
+
+  const float meanVariance = float(sumVariance / (double(m_resolution.x) * double(m_resolution.y)));
+
+  m_confidenceInterval = 2.0f * 1.96f * sqrtf(meanVariance / spp);
+  m_numConverged       = converged;
+  m_maxError           = maxError;
+  m_converged          = (0.0f < targetError && m_minIterations <= iterationIndex && converged == (unsigned int) m_tiles.size()); // Too few samples give unreliable variance estimates.
+  m_activeRect         = (m_converged) ? make_int4(0, 0, 0, 0) : rect;
+
+  return m_converged;
+}
+
+bool ConvergenceController::isConverged() const
+{
+  return m_converged;
+}
+
+float ConvergenceController::getConfidenceInterval() const
+{
+  return m_confidenceInterval;
+}
+
+unsigned int ConvergenceController::getNumTiles() const
+{
+  return (unsigned int) m_tiles.size();
+}
+
+unsigned int ConvergenceController::getNumConvergedTiles() const
+{
+  return m_numConverged;
+}
+
+float ConvergenceController::getMaxError() const
+{
+  return m_maxError;
+}
+
+int4 ConvergenceController::getActiveRect() const
+{
+  return m_activeRect;
+}
+
+std::vector<ConvergenceTile> const& ConvergenceController::getTiles() const
+{
+  return m_tiles;
+}
@@ -0,0 +1,544 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/Deflate.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <utility>
+
+#define DEFLATE_WINDOW_SIZE     32768
+#define DEFLATE_WINDOW_MASK     (DEFLATE_WINDOW_SIZE - 1)
+#define DEFLATE_HASH_BITS       15
+#define DEFLATE_MIN_MATCH       3
+#define DEFLATE_MAX_MATCH       258
+#define DEFLATE_BLOCK_TOKENS    65536 // Tokens per dynamic Huffman block.
+#define DEFLATE_NUM_LITLEN      286
+#define DEFLATE_NUM_DIST        30
+#define DEFLATE_NUM_CODELEN     19
+
+static const uint16_t c_lengthBase[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t  c_lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+static const uint16_t c_distBase[30]  = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                          1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t  c_distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Transmission order of the code length code lengths.
+static const uint8_t c_codeLengthOrder[DEFLATE_NUM_CODELEN] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+
+namespace
+{
+  // A literal when distance is zero, otherwise a match.
+  struct Token
+  {
+    uint16_t value; // Literal byte or match length.
+    uint16_t distance;
+  };
+
+  // Length and distance symbol lookup tables.
+  struct SymbolTables
+  {
+    SymbolTables()
+    {
+      for (int code = 0; code < 29; ++code)
+      {
+        const int count = (code == 28) ? 1 : (1 << c_lengthExtra[code]);
+        for (int i = 0; i < count; ++i)
+        {
+          lengthCode[c_lengthBase[code] + i] = uint8_t(code);
+        }
+      }
+      for (int code = 0; code < 30; ++code)
+      {
+        for (int i = 0; i < (1 << c_distExtra[code]); ++i)
+        {
+          const int distance = c_distBase[code] + i;
+          if (distance <= 256)
+          {
+            distanceCodeLow[distance - 1] = uint8_t(code);
+          }
+          else
+          {
+            distanceCodeHigh[(distance - 1) >> 7] = uint8_t(code);
+          }
+        }
+      }
+    }
+
+    int getDistanceCode(const int distance) const
+    {
+      return (distance <= 256) ? distanceCodeLow[distance - 1] : distanceCodeHigh[(distance - 1) >> 7];
+    }
+
+    uint8_t lengthCode[DEFLATE_MAX_MATCH + 1];
+    uint8_t distanceCodeLow[256];
+    uint8_t distanceCodeHigh[256];
+  };
+
+  // Deflate streams are filled from the least significant bit.
+  class BitWriter
+  {
+  public:
+    explicit BitWriter(std::vector<unsigned char>& out)
+    : m_out(out)
+    , m_bits(0)
+    , m_count(0)
+    {
+    }
+
+    void write(const uint32_t value, const int count)
+    {
+      m_bits  |= uint64_t(value) << m_count;
+      m_count += count;
+      while (8 <= m_count)
+      {
+        m_out.push_back((unsigned char) (m_bits & 0xFF));
+        m_bits  >>= 8;
+        m_count  -= 8;
+      }
+    }
+
+    void flush()
+    {
+      if (0 < m_count)
+      {
+        m_out.push_back((unsigned char) (m_bits & 0xFF));
+      }
+      m_bits  = 0;
+      m_count = 0;
+    }
+
+  private:
+    std::vector<unsigned char>& m_out;
+    uint64_t m_bits;
+    int      m_count;
+  };
+}
+
+
+// Huffman code lengths for the given symbol frequencies, limited to maxBits.
+// When the tree gets too deep, the frequencies are flattened and the tree rebuilt. That costs a little compression but is simple.
+static void buildCodeLengths(const uint32_t* frequencies, const int numSymbols, const int maxBits, uint8_t* lengths)
+{
+  std::vector<uint32_t> freq(frequencies, frequencies + numSymbols);
+
+  for (;;)
+  {
+    std::fill(lengths, lengths + numSymbols, uint8_t(0));
+
+    typedef std::pair<uint64_t, int> Node; // Weight, index. Leaves are 0 to numSymbols - 1.
+    std::priority_queue< Node, std::vector<Node>, std::greater<Node> > queue;
+    for (int i = 0; i < numSymbols; ++i)
+    {
+      if (freq[i] != 0)
+      {
+        queue.push(Node(freq[i], i));
+      }
+    }
+    if (queue.empty())
+    {
+      return;
+    }
+    if (queue.size() == 1) // A single used symbol still needs a one bit code.
+    {
+      lengths[queue.top().second] = 1;
+      return;
+    }
+
+    std::vector<int> parent(numSymbols * 2, -1);
+    int next = numSymbols;
+    while (1 < queue.size())
+    {
+      const Node a = queue.top();
+      queue.pop();
+      const Node b = queue.top();
+      queue.pop();
+      parent[a.second] = next;
+      parent[b.second] = next;
+      queue.push(Node(a.first + b.first, next++));
+    }
+
+    int maxLength = 0;
+    for (int i = 0; i < numSymbols; ++i)
+    {
+      if (freq[i] != 0)
+      {
+        int length = 0;
+        for (int node = i; parent[node] != -1; node = parent[node])
+        {
+          ++length;
+        }
+        lengths[i] = uint8_t(std::min(length, 255));
+        maxLength  = std::max(maxLength, length);
+      }
+    }
+    if (maxLength <= maxBits)
+    {
+      return;
+    }
+
+    for (int i = 0; i < numSymbols; ++i)
+    {
+      if (freq[i] != 0)
+      {
+        freq[i] = (freq[i] >> 1) | 1;
+      }
+    }
+  }
+}
+
+// Canonical Huffman codes, bit reversed for the least significant bit first stream.
+static void buildCodes(const uint8_t* lengths, const int numSymbols, uint16_t* codes)
+{
+  int count[16] = {};
+  for (int i = 0; i < numSymbols; ++i)
+  {
+    ++count[lengths[i]];
+  }
+  count[0] = 0;
+
+  int nextCode[16];
+  int code = 0;
+  for (int bits = 1; bits < 16; ++bits)
+  {
+    code = (code + count[bits - 1]) << 1;
+    nextCode[bits] = code;
+  }
+
+  for (int i = 0; i < numSymbols; ++i)
+  {
+    const int length = lengths[i];
+    if (length != 0)
+    {
+      int c        = nextCode[length]++;
+      int reversed = 0;
+      for (int b = 0; b < length; ++b)
+      {
+        reversed = (reversed << 1) | (c & 1);
+        c >>= 1;
+      }
+      codes[i] = uint16_t(reversed);
+    }
+  }
+}
+
+// Run length encoding of the concatenated literal/length and distance code lengths with the symbols 16, 17 and 18.
+static void encodeCodeLengths(const uint8_t* lengths, const int count, std::vector< std::pair<uint8_t, uint8_t> >& symbols)
+{
+  int i = 0;
+  while (i < count)
+  {
+    const uint8_t value = lengths[i];
+
+    int run = 1;
+    while (i + run < count && lengths[i + run] == value)
+    {
+      ++run;
+    }
+    i += run;
+
+    if (value == 0)
+    {
+      while (11 <= run)
+      {
+        const int n = std::min(run, 138);
+        symbols.push_back(std::make_pair(uint8_t(18), uint8_t(n - 11)));
+        run -= n;
+      }
+      if (3 <= run)
+      {
+        symbols.push_back(std::make_pair(uint8_t(17), uint8_t(run - 3)));
+        run = 0;
+      }
+    }
+    else
+    {
+      symbols.push_back(std::make_pair(value, uint8_t(0)));
+      --run;
+      while (3 <= run)
+      {
+        const int n = std::min(run, 6);
+        symbols.push_back(std::make_pair(uint8_t(16), uint8_t(n - 3)));
+        run -= n;
+      }
+    }
+    while (0 < run)
+    {
+      symbols.push_back(std::make_pair(value, uint8_t(0)));
+      --run;
+    }
+  }
+}
+
+static void writeBlock(BitWriter& writer, SymbolTables const& tables, std::vector<Token> const& tokens, const bool isFinal)
+{
+  uint32_t freqLitLen[DEFLATE_NUM_LITLEN] = {};
+  uint32_t freqDist[DEFLATE_NUM_DIST]     = {};
+
+  for (Token const& token : tokens)
+  {
+    if (token.distance == 0)
+    {
+      ++freqLitLen[token.value];
+    }
+    else
+    {
+      ++freqLitLen[257 + tables.lengthCode[token.value]];
+      ++freqDist[tables.getDistanceCode(token.distance)];
+    }
+  }
+  freqLitLen[256] = 1; // End of block.
+
+  uint8_t lengthsLitLen[DEFLATE_NUM_LITLEN];
+  uint8_t lengthsDist[DEFLATE_NUM_DIST];
+  buildCodeLengths(freqLitLen, DEFLATE_NUM_LITLEN, 15, lengthsLitLen);
+  buildCodeLengths(freqDist,   DEFLATE_NUM_DIST,   15, lengthsDist);
+  if (std::all_of(lengthsDist, lengthsDist + DEFLATE_NUM_DIST, [](uint8_t l) { return l == 0; }))
+  {
+    lengthsDist[0] = 1; // Decoders expect at least one distance code.
+  }
+
+  int numLitLen = DEFLATE_NUM_LITLEN;
+  while (257 < numLitLen && lengthsLitLen[numLitLen - 1] == 0)
+  {
+    --numLitLen;
+  }
+  int numDist = DEFLATE_NUM_DIST;
+  while (1 < numDist && lengthsDist[numDist - 1] == 0)
+  {
+    --numDist;
+  }
+
+  uint8_t lengths[DEFLATE_NUM_LITLEN + DEFLATE_NUM_DIST];
+  std::copy(lengthsLitLen, lengthsLitLen + numLitLen, lengths);
+  std::copy(lengthsDist, lengthsDist + numDist, lengths + numLitLen);
+
+  std::vector< std::pair<uint8_t, uint8_t> > symbols;
+  encodeCodeLengths(lengths, numLitLen + numDist, symbols);
+
+  uint32_t freqCodeLen[DEFLATE_NUM_CODELEN] = {};
+  for (auto const& symbol : symbols)
+  {
+    ++freqCodeLen[symbol.first];
+  }
+  uint8_t lengthsCodeLen[DEFLATE_NUM_CODELEN];
+  buildCodeLengths(freqCodeLen, DEFLATE_NUM_CODELEN, 7, lengthsCodeLen);
+
+  int numCodeLen = DEFLATE_NUM_CODELEN;
+  while (4 < numCodeLen && lengthsCodeLen[c_codeLengthOrder[numCodeLen - 1]] == 0)
+  {
+    --numCodeLen;
+  }
+
+  uint16_t codesLitLen[DEFLATE_NUM_LITLEN]   = {};
+  uint16_t codesDist[DEFLATE_NUM_DIST]       = {};
+  uint16_t codesCodeLen[DEFLATE_NUM_CODELEN] = {};
+  buildCodes(lengthsLitLen,  DEFLATE_NUM_LITLEN,  codesLitLen);
+  buildCodes(lengthsDist,    DEFLATE_NUM_DIST,    codesDist);
+  buildCodes(lengthsCodeLen, DEFLATE_NUM_CODELEN, codesCodeLen);
+
+  // Block header.
+  writer.write((isFinal) ? 1 : 0, 1);
+  writer.write(2, 2); // Dynamic Huffman codes.
+  writer.write(numLitLen - 257, 5);
+  writer.write(numDist - 1, 5);
+  writer.write(numCodeLen - 4, 4);
+  for (int i = 0; i < numCodeLen; ++i)
+  {
+    writer.write(lengthsCodeLen[c_codeLengthOrder[i]], 3);
+  }
+  for (auto const& symbol : symbols)
+  {
+    writer.write(codesCodeLen[symbol.first], lengthsCodeLen[symbol.first]);
+    if (symbol.first == 16)
+    {
+      writer.write(symbol.second, 2);
+    }
+    else if (symbol.first == 17)
+    {
+      writer.write(symbol.second, 3);
+    }
+    else if (symbol.first == 18)
+    {
+      writer.write(symbol.second, 7);
+    }
+  }
+
+  // Block data.
+  for (Token const& token : tokens)
+  {
+    if (token.distance == 0)
+    {
+      writer.write(codesLitLen[token.value], lengthsLitLen[token.value]);
+    }
+    else
+    {
+      const int lengthCode = tables.lengthCode[token.value];
+      writer.write(codesLitLen[257 + lengthCode], lengthsLitLen[257 + lengthCode]);
+      writer.write(token.value - c_lengthBase[lengthCode], c_lengthExtra[lengthCode]);
+
+      const int distanceCode = tables.getDistanceCode(token.distance);
+      writer.write(codesDist[distanceCode], lengthsDist[distanceCode]);
+      writer.write(token.distance - c_distBase[distanceCode], c_distExtra[distanceCode]);
+    }
+  }
+  writer.write(codesLitLen[256], lengthsLitLen[256]);
+}
+
+
+static uint32_t adler32(const unsigned char* data, const size_t size)
+{
+  uint32_t a = 1;
+  uint32_t b = 0;
+
+  size_t i = 0;
+  while (i < size)
+  {
+    const size_t end = std::min(size, i + 5552); // Largest run without overflowing the 32-bit sums.
+    for (; i < end; ++i)
+    {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+void compressZlib(const unsigned char* src, const size_t size, std::vector<unsigned char>& dst, const int effort)
+{
+  static const SymbolTables tables;
+
+  const int maxChain   = 1 << std::min(std::max(effort, 1), 9);  // 2 to 512 candidates.
+  const int niceLength = std::min(DEFLATE_MAX_MATCH, 8 << std::min(std::max(effort, 1), 5)); // Stop searching at this length.
+
+  dst.clear();
+  dst.reserve(size / 2 + 64);
+  dst.push_back(0x78); // Deflate with 32 KB window.
+  dst.push_back(0x9C); // Default level, check bits.
+
+  BitWriter writer(dst);
+
+  std::vector<int32_t> head(size_t(1) << DEFLATE_HASH_BITS, -1);
+  std::vector<int32_t> prev(DEFLATE_WINDOW_SIZE, -1);
+
+  auto hash = [src](const size_t p) -> size_t
+  {
+    return ((size_t(src[p]) << 10) ^ (size_t(src[p + 1]) << 5) ^ size_t(src[p + 2])) & ((size_t(1) << DEFLATE_HASH_BITS) - 1);
+  };
+  auto insert = [&](const size_t p)
+  {
+    const size_t h = hash(p);
+    prev[p & DEFLATE_WINDOW_MASK] = head[h];
+    head[h] = int32_t(p);
+  };
+
+  std::vector<Token> tokens;
+  tokens.reserve(DEFLATE_BLOCK_TOKENS);
+
+  size_t pos = 0;
+  while (pos < size)
+  {
+    int bestLength   = 0;
+    int bestDistance = 0;
+
+    if (pos + DEFLATE_MIN_MATCH <= size)
+    {
+      const int maxLength = int(std::min(size - pos, size_t(DEFLATE_MAX_MATCH)));
+
+      int32_t candidate = head[hash(pos)];
+      for (int chain = maxChain; 0 <= candidate && 0 < chain && pos - size_t(candidate) <= DEFLATE_WINDOW_SIZE; --chain)
+      {
+        const unsigned char* a = src + candidate;
+        const unsigned char* b = src + pos;
+        if (a[bestLength] == b[bestLength] && a[0] == b[0]) // Quick reject before the full compare.
+        {
+          int length = 0;
+          while (length < maxLength && a[length] == b[length])
+          {
+            ++length;
+          }
+          if (bestLength < length)
+          {
+            bestLength   = length;
+            bestDistance = int(pos - size_t(candidate));
+            // Stop at the end of the input, the quick reject of the next candidate would read behind it.
+            if (niceLength <= length || length == maxLength)
+            {
+              break;
+            }
+          }
+        }
+        const int32_t next = prev[candidate & DEFLATE_WINDOW_MASK];
+        if (candidate <= next) // Overwritten ring entry.
+        {
+          break;
+        }
+        candidate = next;
+      }
+      insert(pos);
+    }
+
+    Token token;
+    if (DEFLATE_MIN_MATCH <= bestLength)
+    {
+      token.value    = uint16_t(bestLength);
+      token.distance = uint16_t(bestDistance);
+      for (size_t p = pos + 1; p < pos + bestLength && p + DEFLATE_MIN_MATCH <= size; ++p)
+      {
+        insert(p);
+      }
+      pos += bestLength;
+    }
+    else
+    {
+      token.value    = src[pos];
+      token.distance = 0;
+      ++pos;
+    }
+    tokens.push_back(token);
+
+    if (tokens.size() == DEFLATE_BLOCK_TOKENS && pos < size)
+    {
+      writeBlock(writer, tables, tokens, false);
+      tokens.clear();
+    }
+  }
+  writeBlock(writer, tables, tokens, true);
+  writer.flush();
+
+  const uint32_t adler = adler32(src, size);
+  dst.push_back((unsigned char) (adler >> 24));
+  dst.push_back((unsigned char) (adler >> 16));
+  dst.push_back((unsigned char) (adler >>  8));
+  dst.push_back((unsigned char) (adler      ));
+}
@@ -0,0 +1,368 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/Denoiser.h"
+#include "inc/ThreadPool.h"
+#include "inc/Timer.h"
+#include "inc/MyAssert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define DENOISER_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define DENOISER_USE_SSE 0
+#endif
+
+// B3-spline a-trous kernel weights.
+static const float c_kernel[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+
+static inline float luminance(const float4& c)
+{
+  return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+}
+
+// exp(-x) for x >= 0 with about 1e-3 relative error. The edge-stopping weights don't need more
+// and std::exp() would dominate the filter cost.
+static inline float expNegative(float x)
+{
+  x = std::min(x, 16.0f); // Clamp instead of branching to give the same results as the SSE version.
+
+  const float t = -x * 1.44269504f; // exp(-x) = 2^t, t in [-23.1, 0]
+
+  int i = int(t); // Truncation, floorf() is a library call without SSE4.1.
+  if (t < float(i))
+  {
+    --i;
+  }
+  const float f = t - float(i); // [0, 1)
+
+  // Polynomial approximation of 2^f on [0, 1).
+  const float p = 1.0f + f * (0.6958038f + f * (0.2251606f + f * 0.0790353f));
+
+  // 2^i by constructing the exponent bits directly.
+  const int bits = (i + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(float));
+  return p * scale;
+}
+
+
+#if DENOISER_USE_SSE
+// Four lanes of expNegative().
+static inline __m128 expNegative4(__m128 x)
+{
+  x = _mm_min_ps(x, _mm_set1_ps(16.0f));
+
+  const __m128 t = _mm_mul_ps(x, _mm_set1_ps(-1.44269504f));
+
+  __m128i i = _mm_cvttps_epi32(t);
+  i = _mm_add_epi32(i, _mm_castps_si128(_mm_cmplt_ps(t, _mm_cvtepi32_ps(i)))); // Comparison mask is -1 where truncation rounded up.
+
+  const __m128 f = _mm_sub_ps(t, _mm_cvtepi32_ps(i));
+
+  __m128 p = _mm_add_ps(_mm_set1_ps(0.2251606f), _mm_mul_ps(f, _mm_set1_ps(0.0790353f)));
+  p = _mm_add_ps(_mm_set1_ps(0.6958038f), _mm_mul_ps(f, p));
+  p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, p));
+
+  const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23));
+  return _mm_mul_ps(p, scale);
+}
+#endif
+
+
+Denoiser::Denoiser()
+: m_iterations(4)
+, m_sigmaLuminance(4.0f)
+, m_resolution(make_int2(0, 0))
+, m_hasVariance(false)
+, m_time(0.0)
+{
+}
+
+void Denoiser::setIterations(const int iterations)
+{
+  m_iterations = std::max(1, std::min(iterations, 8));
+}
+
+void Denoiser::setSigmaLuminance(const float sigma)
+{
+  m_sigmaLuminance = std::max(0.0f, sigma);
+}
+
+int Denoiser::getIterations() const
+{
+  return m_iterations;
+}
+
+float Denoiser::getSigmaLuminance() const
+{
+  return m_sigmaLuminance;
+}
+
+double Denoiser::getTime() const
+{
+  return m_time;
+}
+
+const float4* Denoiser::denoise(const float4* color, const float* variance, const int2 resolution, const unsigned int spp)
+{
+  MY_ASSERT(color != nullptr && 0 < resolution.x && 0 < resolution.y);
+
+  Timer timer;
+  timer.start();
+
+  const size_t count = size_t(resolution.x) * size_t(resolution.y);
+
+  if (m_resolution.x != resolution.x || m_resolution.y != resolution.y)
+  {
+    m_resolution = resolution;
+    for (int i = 0; i < 2; ++i)
+    {
+      m_color[i].resize(count);
+      m_luminance[i].resize(count);
+      m_variance[i].resize(count);
+    }
+  }
+
+  m_hasVariance = (variance != nullptr && 0 < spp);
+  if (m_hasVariance)
+  {
+    prefilterVariance(variance, spp); // Into m_variance[0].
+  }
+
+  if (!m_hasVariance)
+  {
+    memset(m_variance[0].data(), 0, sizeof(float) * count); // Keeps the propagated variance finite, it's not used for the edge-stopping then.
+  }
+
+  // Luminance of the input, the levels write the luminance of their results for the next level.
+  float* lum = m_luminance[1].data();
+  ThreadPool::getInstance().parallelFor(0, count, 4096, [&](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      lum[i] = luminance(color[i]);
+    }
+  });
+
+  // Ping-pong: level n writes into index n & 1 of the color and luminance buffers and reads from the other one.
+  // The variance is one level ahead because the prefiltered input variance is stored in index 0.
+  // The first level reads the caller's color buffer directly.
+  for (int n = 0; n < m_iterations; ++n)
+  {
+    Level level;
+
+    level.src    = (n == 0) ? color : m_color[(n - 1) & 1].data();
+    level.srcLum = m_luminance[(n + 1) & 1].data();
+    level.srcVar = m_variance[n & 1].data();
+    level.dst    = m_color[n & 1].data();
+    level.dstLum = m_luminance[n & 1].data();
+    level.dstVar = m_variance[(n + 1) & 1].data();
+
+    filterLevel(level, 1 << n);
+  }
+
+  timer.stop();
+  m_time = timer.getTime();
+
+  return m_color[(m_iterations - 1) & 1].data();
+}
+
+// Variance of the mean per pixel, slightly blurred with a 3x3 Gaussian to make the edge-stopping more robust at low sample counts.
+void Denoiser::prefilterVariance(const float* variance, const unsigned int spp)
+{
+  const int   w = m_resolution.x;
+  const int   h = m_resolution.y;
+  // The variance buffer holds the summed squared RGB deviation per sample. Convert to a per channel variance of the mean.
+  const float scale = 1.0f / (3.0f * float(spp));
+
+  float* dst = m_variance[0].data();
+
+  ThreadPool::getInstance().parallelFor(0, size_t(h), 8, [&](size_t first, size_t last)
+  {
+    static const float g[3] = { 0.25f, 0.5f, 0.25f };
+
+    for (int y = int(first); y < int(last); ++y)
+    {
+      for (int x = 0; x < w; ++x)
+      {
+        float sum  = 0.0f;
+        float wsum = 0.0f;
+        for (int j = -1; j <= 1; ++j)
+        {
+          const int yy = y + j;
+          if (yy < 0 || h <= yy)
+          {
+            continue;
+          }
+          for (int i = -1; i <= 1; ++i)
+          {
+            const int xx = x + i;
+            if (xx < 0 || w <= xx)
+            {
+              continue;
+            }
+            const float k = g[i + 1] * g[j + 1];
+            sum  += k * variance[size_t(yy) * w + xx];
+            wsum += k;
+          }
+        }
+        dst[size_t(y) * w + x] = sum / wsum * scale;
+      }
+    }
+  });
+}
+
+void Denoiser::filterLevel(const Level& level, const int step)
+{
+  const int  w = m_resolution.x;
+  const int  h = m_resolution.y;
+  const bool hasVariance = m_hasVariance;
+  const float sigma = m_sigmaLuminance;
+
+  const float4* src    = level.src;
+  const float*  srcLum = level.srcLum;
+  const float*  srcVar = level.srcVar;
+
+  ThreadPool::getInstance().parallelFor(0, size_t(h), 4, [&](size_t first, size_t last)
+  {
+    for (int y = int(first); y < int(last); ++y)
+    {
+#if DENOISER_USE_SSE
+      const bool interiorRows = (2 * step <= y && y + 2 * step < h);
+#endif
+
+      for (int x = 0; x < w; ++x)
+      {
+        const size_t idx = size_t(y) * w + x;
+        const float  lumCenter = srcLum[idx];
+
+        // Without variance use a threshold relative to the pixel brightness.
+        const float invSigma = (hasVariance) ? 1.0f / (sigma * sqrtf(std::max(srcVar[idx], 0.0f)) + 1.0e-6f)
+                                             : 1.0f / (0.1f * sigma * (lumCenter + 0.01f));
+        float wsum = 0.0f;
+        float vsum = 0.0f;
+
+#if DENOISER_USE_SSE
+        __m128 acc = _mm_setzero_ps();
+
+        if (interiorRows && 2 * step <= x && x + 2 * step < w)
+        {
+          // All 25 taps are inside the image. The first four taps of each row are weighted with one vector exp.
+          const __m128 lumCenter4 = _mm_set1_ps(lumCenter);
+          const __m128 invSigma4  = _mm_set1_ps(invSigma);
+          const __m128 absMask    = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+          const __m128 kernel4    = _mm_loadu_ps(c_kernel);
+
+          for (int j = -2; j <= 2; ++j)
+          {
+            const size_t row = idx + ptrdiff_t(j * step) * w;
+            const float  kj  = c_kernel[j + 2];
+
+            const __m128 lum4 = _mm_set_ps(srcLum[row + step], srcLum[row], srcLum[row - step], srcLum[row - 2 * step]);
+            const __m128 diff = _mm_and_ps(_mm_sub_ps(lum4, lumCenter4), absMask);
+
+            alignas(16) float k[4];
+            _mm_store_ps(k, _mm_mul_ps(_mm_mul_ps(kernel4, _mm_set1_ps(kj)), expNegative4(_mm_mul_ps(diff, invSigma4))));
+
+            for (int i = 0; i < 4; ++i)
+            {
+              const size_t tap = row + (i - 2) * step;
+              acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k[i]), _mm_loadu_ps(&src[tap].x)));
+              wsum += k[i];
+              vsum += k[i] * k[i] * srcVar[tap];
+            }
+
+            const size_t tap = row + 2 * step;
+            const float  k4  = c_kernel[4] * kj * expNegative(fabsf(srcLum[tap] - lumCenter) * invSigma);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k4), _mm_loadu_ps(&src[tap].x)));
+            wsum += k4;
+            vsum += k4 * k4 * srcVar[tap];
+          }
+        }
+        else
+#else
+        float4 acc = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+#endif
+        {
+          for (int j = -2; j <= 2; ++j)
+          {
+            const int yy = y + j * step;
+            if (yy < 0 || h <= yy)
+            {
+              continue;
+            }
+            const size_t row = size_t(yy) * w;
+
+            for (int i = -2; i <= 2; ++i)
+            {
+              const int xx = x + i * step;
+              if (xx < 0 || w <= xx)
+              {
+                continue;
+              }
+              const size_t tap = row + xx;
+              const float4& c  = src[tap];
+              const float   k  = c_kernel[i + 2] * c_kernel[j + 2] * expNegative(fabsf(srcLum[tap] - lumCenter) * invSigma);
+
+#if DENOISER_USE_SSE
+              acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k), _mm_loadu_ps(&c.x)));
+#else
+              acc.x += k * c.x;
+              acc.y += k * c.y;
+              acc.z += k * c.z;
+#endif
+              wsum += k;
+              vsum += k * k * srcVar[tap];
+            }
+          }
+        }
+
+        // The center tap always has weight c_kernel[2]^2 > 0.
+        const float invWsum = 1.0f / wsum;
+
+#if DENOISER_USE_SSE
+        float4 result;
+        _mm_storeu_ps(&result.x, _mm_mul_ps(acc, _mm_set1_ps(invWsum)));
+#else
+        float4 result = make_float4(acc.x * invWsum, acc.y * invWsum, acc.z * invWsum, 0.0f);
+#endif
+        result.w = src[idx].w;
+
+        level.dst[idx]    = result;
+        level.dstLum[idx] = luminance(result);
+        level.dstVar[idx] = vsum * invWsum * invWsum; // Variance of the weighted mean.
+      }
+    }
+  });
+}
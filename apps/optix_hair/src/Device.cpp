@@ -30,6 +30,12 @@
 #include "inc/Hair.h"
 #include "inc/CheckMacros.h"
 
+#include "shaders/bcsdf_hair_constants.h"
+#include "shaders/low_discrepancy.h"
+#include "shaders/shader_common.h"
+#include "inc/LowDiscrepancy.h"
+#include "inc/AliasTable.h"
+
 #ifdef _WIN32
 #if !defined WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN 1
@@ -232,7 +238,11 @@ Device::Device(const RendererStrategy strategy,
 , m_textureAlbedo(nullptr)
 , m_textureCutout(nullptr)
 , m_textureEnv(nullptr)
+, m_textureCompression(0)
+, m_textureHalfFloat(false)
 , m_catchVariance(0)
+, m_d_ias(0)
+, m_d_sbtRecordGeometryInstanceData(nullptr)
 {
   initDeviceAttributes(); // CUDA
 
@@ -280,10 +290,15 @@ Device::Device(const RendererStrategy strategy,
   m_systemData.texelBuffer         = 0; // For the final frame tiled renderer. Contains the accumulated result of the current tile.
   m_systemData.cameraDefinitions   = nullptr;
   m_systemData.lightDefinitions    = nullptr;
+  m_systemData.lightAliasTable     = nullptr;
   m_systemData.materialDefinitions = nullptr;
   m_systemData.envTexture          = 0;
   m_systemData.envCDF_U            = nullptr;
   m_systemData.envCDF_V            = nullptr;
+  m_systemData.envAlias_U          = nullptr;
+  m_systemData.envAlias_V          = nullptr;
+  m_systemData.sobolMatrices       = nullptr;
+  m_systemData.blueNoise           = nullptr;
   m_systemData.resolution          = make_int2(1, 1); // Deferred allocation after setResolution() when m_isDirtyOutputBuffer == true.
   m_systemData.tileSize            = make_int2(8, 8); // Default value for multi-GPU tiling. Must be power-of-two values. (8x8 covers either 8x4 or 4x8 internal 2D warp shapes.)
   m_systemData.tileShift           = make_int2(3, 3); // The right-shift for the division by tileSize. 
@@ -296,6 +311,8 @@ Device::Device(const RendererStrategy strategy,
   m_systemData.sceneEpsilon        = 500.0f * SCENE_EPSILON_SCALE;
   m_systemData.clockScale          = 1000.0f * CLOCK_FACTOR_SCALE;
   m_systemData.lensShader          = 0;
+  m_systemData.sampler             = SAMPLER_LCG;
+  m_systemData.envAliasSampling    = 1;
   m_systemData.numCameras          = 0;
   m_systemData.numLights           = 0;
   m_systemData.numMaterials        = 0;
@@ -307,6 +324,7 @@ Device::Device(const RendererStrategy strategy,
 
   m_isDirtyOutputBuffer = true; // First render call initializes it. This is done in the derived render() functions.
 
+  initSampler();
   initPipeline();
 }
 
@@ -332,8 +350,12 @@ Device::~Device()
 
   CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.cameraDefinitions)) );
   CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.lightDefinitions)) );
+  CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.lightAliasTable)) );
   CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.materialDefinitions)) );
 
+  CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.sobolMatrices)) );
+  CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.blueNoise)) );
+
   for (size_t i = 0; i < m_geometryData.size(); ++i)
   {
     CU_CHECK_NO_THROW( cuMemFree(m_geometryData[i].d_attributes) ); // DAR FIXME Move these into an arena allocator.
@@ -932,6 +954,27 @@ void Device::initPipeline()
 
 
 // HACK FIXME Hardcocded textures.
+// Create a 2D texture which samples all mipmap levels the picture provides, trilinear when there are any.
+static void createMipmappedTexture(Texture* texture, const Picture* picture, const BlockFormat blockFormat)
+{
+  const unsigned int numLevels = picture->getNumberOfLevels(0);
+
+  texture->setBlockFormat(blockFormat);
+
+  if (1 < numLevels)
+  {
+    texture->setFilterMode(CU_TR_FILTER_MODE_LINEAR, CU_TR_FILTER_MODE_LINEAR);
+    texture->setMipmapLevelBiasMinMax(0.0f, 0.0f, float(numLevels - 1));
+  }
+  texture->create(picture, IMAGE_FLAG_2D | IMAGE_FLAG_MIPMAP);
+}
+
+// The shaders add this to the texture independent ray cone LOD to select the mipmap level. See shaders/texture_lod.h.
+static float getTextureLodOffset(const Texture* texture)
+{
+  return 0.5f * log2f(float(texture->getWidth()) * float(texture->getHeight()));
+}
+
 void Device::initTextures(std::map<std::string, Picture*> const& mapOfPictures)
 {
   activateContext();
@@ -962,26 +1005,35 @@ void Device::initTextures(std::map<std::string, Picture*> const& mapOfPictures)
 
   std::map<std::string, Picture*>::const_iterator itEnv = mapOfPictures.find(std::string("environment"));
 
+  // The color textures are opaque. The cutout opacity stays uncompressed to keep its edges exact.
+  // All of them are sampled with the ray cone LOD, so they need their full mipmap chains.
+  const BlockFormat formatColor = (m_textureCompression == 1) ? BLOCK_FORMAT_BC1 : 
+                                  (m_textureCompression == 2) ? BLOCK_FORMAT_BC7 : BLOCK_FORMAT_NONE;
+
   m_textureEye = new Texture();
-  m_textureEye ->create(itEye->second, IMAGE_FLAG_2D);
+  createMipmappedTexture(m_textureEye, itEye->second, formatColor);
 
   m_textureHead = new Texture();
-  m_textureHead->create(itHead->second, IMAGE_FLAG_2D);
+  createMipmappedTexture(m_textureHead, itHead->second, formatColor);
 
   m_textureAlbedo = new Texture();
-  m_textureAlbedo->create(itAlbedo->second, IMAGE_FLAG_2D);
+  createMipmappedTexture(m_textureAlbedo, itAlbedo->second, formatColor);
 
   m_textureCutout = new Texture();
-  m_textureCutout->create(itCutout->second, IMAGE_FLAG_2D);
+  createMipmappedTexture(m_textureCutout, itCutout->second, BLOCK_FORMAT_NONE);
 
   if (itEnv != mapOfPictures.end())
   {
     m_textureEnv = new Texture();
+    m_textureEnv->setBlockFormat((m_textureCompression != 0) ? BLOCK_FORMAT_BC6H : BLOCK_FORMAT_NONE);
+    m_textureEnv->setHalfFloat(m_textureHalfFloat); // Used when not block compressed.
     m_textureEnv->create(itEnv->second, IMAGE_FLAG_2D | IMAGE_FLAG_ENV);
 
     m_systemData.envTexture  = m_textureEnv->getTextureObject();
     m_systemData.envCDF_U    = reinterpret_cast<float*>(m_textureEnv->getCDF_U());
     m_systemData.envCDF_V    = reinterpret_cast<float*>(m_textureEnv->getCDF_V());
+    m_systemData.envAlias_U  = reinterpret_cast<AliasEntry*>(m_textureEnv->getAlias_U());
+    m_systemData.envAlias_V  = reinterpret_cast<AliasEntry*>(m_textureEnv->getAlias_V());
     m_systemData.envWidth    = m_textureEnv->getWidth();
     m_systemData.envHeight   = m_textureEnv->getHeight();
     m_systemData.envIntegral = m_textureEnv->getIntegral();
@@ -1028,19 +1080,26 @@ void Device::initLights(std::vector<LightDefinition> const& lights)
     if (m_systemData.lightDefinitions != nullptr) // No need to call free on first time initialization.
     {
       CU_CHECK( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.lightDefinitions)) );
+      CU_CHECK( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.lightAliasTable)) );
       m_systemData.lightDefinitions = nullptr; // It's valid to have zero lights.
+      m_systemData.lightAliasTable  = nullptr;
     }
     if (0 < numLights)
     {
       CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_systemData.lightDefinitions), sizeof(LightDefinition) * numLights) );
+      CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_systemData.lightAliasTable), sizeof(AliasEntry) * numLights) );
     }
   }
 
+  m_lights = lights;
+
   if (0 < numLights)
   {
     CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_systemData.lightDefinitions), lights.data(), sizeof(LightDefinition) * numLights, m_cudaStream) );
-    m_systemData.numLights = numLights;
   }
+  m_systemData.numLights = numLights; // Also when dropping to zero lights, or the shaders would access the freed buffers.
+
+  updateLightAliasTable();
 
   m_isDirtySystemData = true;  // Trigger full update of the device system data on the next launch.
 }
@@ -1083,6 +1142,10 @@ void Device::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
         material.textureHead = (materialGUI.useHeadTexture) ? m_textureHead->getTextureObject() : 0;
         material.textureAlbedo = (materialGUI.useAlbedoTexture) ? m_textureAlbedo->getTextureObject() : 0;
         material.textureCutout = (materialGUI.useCutoutTexture) ? m_textureCutout->getTextureObject() : 0;
+        material.lodEye    = getTextureLodOffset(m_textureEye);
+        material.lodHead   = getTextureLodOffset(m_textureHead);
+        material.lodAlbedo = getTextureLodOffset(m_textureAlbedo);
+        material.lodCutout = getTextureLodOffset(m_textureCutout);
         material.roughness = materialGUI.roughness;
         material.indexBSDF = materialGUI.indexBSDF;
         material.albedo = materialGUI.albedo;
@@ -1119,6 +1182,7 @@ void Device::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
         material.betaM = materialGUI.roughnessM;
         material.betaN = materialGUI.roughnessN;
 
+        precalculateHairMaterial(material);
     }
   }
 
@@ -1127,39 +1191,104 @@ void Device::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
   m_isDirtySystemData = true;  // Trigger full update of the device system data on the next launch.
 }
 
-void Device::initScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries)
+size_t Device::getNumGeometries() const
 {
-   m_instances.clear();
-   m_instanceData.clear();
-   for (int i = 0; i < m_geometryData.size(); i++)
-   {
-       cuMemFree(m_geometryData[i].d_attributes);
-       cuMemFree(m_geometryData[i].d_indices);
-       cuMemFree(m_geometryData[i].d_gas);
-       cuMemFree(m_geometryData[i].d_strand_rand);
-       cuMemFree(m_geometryData[i].d_strand_i);
-       cuMemFree(m_geometryData[i].d_strand_info);
-   }
-   m_geometryData.clear();
-   m_geometryData.resize(numGeometries);
-  activateContext();
-  synchronizeStream();
-  
+  return m_geometryData.size();
+}
 
-  float matrix[12];
+void Device::setNumGeometries(const size_t numGeometries)
+{
+  m_geometryData.resize(numGeometries);
+}
 
-  // Set the affine matrix to identity by default.
-  memset(matrix, 0, sizeof(float) * 12);
-  matrix[ 0] = 1.0f;
-  matrix[ 5] = 1.0f;
-  matrix[10] = 1.0f;
+bool Device::isGeometryBuilt(const unsigned int idGeometry) const
+{
+  return m_geometryData[idGeometry].traversable != 0;
+}
 
-  InstanceData data(~0u, -1, -1);
-  traverseNode(root, matrix, data);
+void Device::freeGeometry(const unsigned int idGeometry)
+{
+  GeometryData& geometryData = m_geometryData[idGeometry];
+
+  cuMemFree(geometryData.d_attributes);
+  cuMemFree(geometryData.d_indices);
+  cuMemFree(geometryData.d_gas);
+  cuMemFree(geometryData.d_strand_rand);
+  cuMemFree(geometryData.d_strand_i);
+  cuMemFree(geometryData.d_strand_info);
+
+  geometryData = GeometryData(); // The zero traversable marks the geometry as not created.
+}
+
+void Device::buildGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry)
+{
+  if (geometry.type == sg::NodeType::NT_CURVES)
+  {
+    createHairGeometry(idGeometry, geometry);
+  }
+  else
+  {
+    createGeometry(idGeometry, geometry);
+  }
+}
+
+void Device::buildInstances(CompiledScene const& scene)
+{
+  m_instances.clear();
+  m_instanceData.clear();
+
+  for (CompiledInstance const& instance : scene.getInstances())
+  {
+    createInstance(m_geometryData[instance.data.idGeometry].traversable, instance.matrix, instance.data);
+  }
+
+  CU_CHECK( cuMemFree(m_d_ias) );
   createTLAS();
+}
+
+void Device::setInstanceData(const unsigned int idInstance, InstanceData const& data)
+{
+  m_instanceData[idInstance] = data;
+}
+
+void Device::buildRecords()
+{
+  CU_CHECK( cuMemFree(reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData)) );
   createHitGroupRecords();
 }
 
+void Device::updateRecord(const unsigned int idInstance)
+{
+  setHitGroupRecords(idInstance);
+
+  // Only copy the two SBT entries which changed.
+  const unsigned int idx = idInstance * NUM_RAYTYPES;
+  CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_sbtRecordGeometryInstanceData[idx]), &m_sbtRecordGeometryInstanceData[idx], sizeof(SbtRecordGeometryInstanceData) * NUM_RAYTYPES, m_cudaStream) );
+}
+
+void Device::initScene(CompiledScene const& scene)
+{
+  activateContext();
+  synchronizeStream();
+
+  // The scene graph has been flattened once for all devices, only build the GAS per referenced geometry and the instances.
+  applyScene(scene, *this);
+}
+
+// Apply the changes between two compilations of the scene, see applySceneDiff().
+void Device::updateScene(CompiledScene const& scene, SceneDiff const& diff)
+{
+  if (diff.isEmpty()) // Don't synchronize for nothing.
+  {
+    return;
+  }
+
+  activateContext();
+  synchronizeStream();
+
+  applySceneDiff(scene, diff, *this);
+}
+
 
 
 void Device::updateCamera(const int idCamera, CameraDefinition const& camera)
@@ -1178,6 +1307,88 @@ void Device::updateLight(const int idLight, LightDefinition const& light)
 
   MY_ASSERT(idLight < m_systemData.numLights);
   CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_systemData.lightDefinitions[idLight]), &light, sizeof(LightDefinition), m_cudaStream) );
+
+  // Emission or activation changes alter the light powers and with that the selection probabilities.
+  m_lights[idLight] = light;
+  updateLightAliasTable();
+}
+
+// Build the alias table for power proportional light selection and upload it. 
+// Called whenever the light definitions change. Requires m_lights and m_systemData.envIntegral to be current.
+void Device::updateLightAliasTable()
+{
+  const size_t numLights = m_lights.size();
+  if (numLights == 0)
+  {
+    m_lightAliasTable.clear();
+    return;
+  }
+
+  // The parallelogram lights' extent gives the scale to compare their flux against the environment's.
+  float3 sceneMin = make_float3( RT_DEFAULT_MAX);
+  float3 sceneMax = make_float3(-RT_DEFAULT_MAX);
+  bool   hasArea  = false;
+
+  for (LightDefinition const& light : m_lights)
+  {
+    if (light.type == LIGHT_PARALLELOGRAM)
+    {
+      const float3 corners[4] = { light.position, light.position + light.vecU, light.position + light.vecV, light.position + light.vecU + light.vecV };
+      for (int i = 0; i < 4; ++i)
+      {
+        sceneMin = fminf(sceneMin, corners[i]);
+        sceneMax = fmaxf(sceneMax, corners[i]);
+      }
+      hasArea = true;
+    }
+  }
+  const float sceneRadius = (hasArea) ? std::max(0.5f * length(sceneMax - sceneMin), 1.0f) : 1.0f;
+
+  // Constant environment is white with radiance 1.0 over the whole sphere.
+  const float envIntegral = (m_miss == 2) ? m_systemData.envIntegral : 4.0f * M_PIf;
+
+  std::vector<float> power(numLights, 0.0f);
+
+  float  sumPower  = 0.0f;
+  size_t numActive = 0;
+
+  for (size_t i = 0; i < numLights; ++i)
+  {
+    LightDefinition const& light = m_lights[i];
+
+    if (light.type == LIGHT_ENVIRONMENT)
+    {
+      // Flux of the environment onto a disk of the scene radius.
+      power[i] = M_PIf * sceneRadius * sceneRadius * envIntegral;
+    }
+    else if (light.lighting_activated != 0.0f)
+    {
+      // Flux of a one-sided Lambertian emitter.
+      power[i] = M_PIf * light.area * std::max(0.0f, intensity(light.emission));
+    }
+
+    if (0.0f < power[i])
+    {
+      sumPower += power[i];
+      ++numActive;
+    }
+  }
+
+  // Mix in a fraction of uniform selection among the active lights.
+  // This keeps dim but nearby lights from being starved by one bright distant emitter.
+  const float uniformFraction = 0.1f;
+
+  for (size_t i = 0; i < numLights; ++i)
+  {
+    if (0.0f < power[i])
+    {
+      power[i] = (1.0f - uniformFraction) * power[i] / sumPower + uniformFraction / float(numActive);
+    }
+  }
+
+  buildAliasTable(power, m_lightAliasTable); // Uniform selection if all lights are off.
+
+  CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_systemData.lightAliasTable), m_lightAliasTable.data(), sizeof(AliasEntry) * numLights, m_cudaStream) );
 }
 
 void Device::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI)
@@ -1199,6 +1410,10 @@ void Device::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI
       material.textureHead = (materialGUI.useHeadTexture) ? m_textureHead->getTextureObject() : 0;
       material.textureAlbedo = (materialGUI.useAlbedoTexture) ? m_textureAlbedo->getTextureObject() : 0;
       material.textureCutout = (materialGUI.useCutoutTexture) ? m_textureCutout->getTextureObject() : 0;
+      material.lodEye    = getTextureLodOffset(m_textureEye);
+      material.lodHead   = getTextureLodOffset(m_textureHead);
+      material.lodAlbedo = getTextureLodOffset(m_textureAlbedo);
+      material.lodCutout = getTextureLodOffset(m_textureCutout);
       material.roughness = materialGUI.roughness;
       material.indexBSDF = materialGUI.indexBSDF;
       material.albedo = materialGUI.albedo;
@@ -1234,6 +1449,8 @@ void Device::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI
       material.absorption = ((1.f - materialGUI.dyeNeutralHT) * materialGUI.dyeNeutralHT_Concentration + (1.f - materialGUI.dye) * materialGUI.dye_concentration); //PSAN Add Dye neutral melanine
       material.betaM = materialGUI.roughnessM;
       material.betaN = materialGUI.roughnessN;
+
+      precalculateHairMaterial(material);
   }
 
   // Copy only the one changed material. No need to trigger an update of the system data, because the m_systemData.materialDefinitions pointer itself didn't change.
@@ -1298,6 +1515,22 @@ static int2 calculateTileShift(const int2 tileSize)
 }
 
 
+// The sampler tables are generated once on the host and uploaded to every device. They are small and always present
+// to allow switching the sampler at runtime.
+void Device::initSampler()
+{
+  std::vector<unsigned int> const& matrices  = getSobolMatrices();
+  std::vector<float> const&        blueNoise = getBlueNoise();
+
+  CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_systemData.sobolMatrices), sizeof(unsigned int) * matrices.size()) );
+  CU_CHECK( cuMemcpyHtoD(reinterpret_cast<CUdeviceptr>(m_systemData.sobolMatrices), matrices.data(), sizeof(unsigned int) * matrices.size()) );
+
+  CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_systemData.blueNoise), sizeof(float) * blueNoise.size()) );
+  CU_CHECK( cuMemcpyHtoD(reinterpret_cast<CUdeviceptr>(m_systemData.blueNoise), blueNoise.data(), sizeof(float) * blueNoise.size()) );
+
+  m_isDirtySystemData = true;
+}
+
 void Device::setState(DeviceState const& state)
 {
   activateContext();
@@ -1336,6 +1569,18 @@ void Device::setState(DeviceState const& state)
     m_isDirtySystemData = true;
   }
 
+  if (m_systemData.sampler != state.sampler)
+  {
+    m_systemData.sampler = state.sampler;
+    m_isDirtySystemData = true;
+  }
+
+  if (m_systemData.envAliasSampling != int(state.envAliasSampling))
+  {
+    m_systemData.envAliasSampling = int(state.envAliasSampling);
+    m_isDirtySystemData = true;
+  }
+
   if (m_systemData.pathLengths != state.pathLengths)
   {
     m_systemData.pathLengths = state.pathLengths;
@@ -1373,6 +1618,9 @@ void Device::setState(DeviceState const& state)
       m_isDirtySystemData = true;
   }
 
+  m_textureCompression = state.textureCompression; // Host side only, no launch parameter change.
+  m_textureHalfFloat   = state.textureHalfFloat;
+
 
 #if USE_TIME_VIEW
   if (m_systemData.clockScale != state.clockFactor * CLOCK_FACTOR_SCALE)
@@ -1389,99 +1637,12 @@ void Device::compositor(Device* /* other */)
 }
 
 
-// m = a * b;
-static void multiplyMatrix(float* m, const float* a, const float* b)
+void Device::createGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry)
 {
-  m[ 0] = a[0] * b[0] + a[1] * b[4] + a[ 2] * b[ 8]; // + a[3] * 0
-  m[ 1] = a[0] * b[1] + a[1] * b[5] + a[ 2] * b[ 9]; // + a[3] * 0
-  m[ 2] = a[0] * b[2] + a[1] * b[6] + a[ 2] * b[10]; // + a[3] * 0
-  m[ 3] = a[0] * b[3] + a[1] * b[7] + a[ 2] * b[11] + a[3]; // * 1
-  
-  m[ 4] = a[4] * b[0] + a[5] * b[4] + a[ 6] * b[ 8]; // + a[7] * 0
-  m[ 5] = a[4] * b[1] + a[5] * b[5] + a[ 6] * b[ 9]; // + a[7] * 0
-  m[ 6] = a[4] * b[2] + a[5] * b[6] + a[ 6] * b[10]; // + a[7] * 0
-  m[ 7] = a[4] * b[3] + a[5] * b[7] + a[ 6] * b[11] + a[7]; // * 1
-
-  m[ 8] = a[8] * b[0] + a[9] * b[4] + a[10] * b[ 8]; // + a[11] * 0
-  m[ 9] = a[8] * b[1] + a[9] * b[5] + a[10] * b[ 9]; // + a[11] * 0
-  m[10] = a[8] * b[2] + a[9] * b[6] + a[10] * b[10]; // + a[11] * 0
-  m[11] = a[8] * b[3] + a[9] * b[7] + a[10] * b[11] + a[11]; // * 1
-}
-
-void Device::traverseNode(std::shared_ptr<sg::Node> node, float matrix[12], InstanceData data)
-{
-  switch (node->getType())
-  {
-    case sg::NodeType::NT_GROUP:
-    {
-      std::shared_ptr<sg::Group> group = std::dynamic_pointer_cast<sg::Group>(node);
-
-      for (size_t i = 0; i < group->getNumChildren(); ++i)
-      {
-          if (group->getChild(i)->is_activated()) 
-          {
-              traverseNode(group->getChild(i), matrix, data);
-          }
-      }
-    }
-    break;
-
-    case sg::NodeType::NT_INSTANCE:
-    {
-      std::shared_ptr<sg::Instance> instance = std::dynamic_pointer_cast<sg::Instance>(node);
-
-      // Concatenate the transformations along the path.
-      float trafo[12];
-      multiplyMatrix(trafo, matrix, instance->getTransform());
-
-      int idMaterial = instance->getMaterial();
-      if (0 <= idMaterial)
-      {
-        data.idMaterial = idMaterial;  
-      }
-
-      int idLight = instance->getLight();
-      if (0 <= idLight)
-      {
-        data.idLight = idLight;  
-      }
-      traverseNode(instance->getChild(), trafo, data);      
-    }
-    break;
-
-    case sg::NodeType::NT_TRIANGLES:
-    {
-      std::shared_ptr<sg::Triangles> geometry = std::dynamic_pointer_cast<sg::Triangles>(node);
-      data.idGeometry = createGeometry(geometry);
-
-      createInstance(m_geometryData[data.idGeometry].traversable, matrix, data);
-    }
-    break;
-
-    case sg::NodeType::NT_CURVES:
-    {
-        std::shared_ptr<sg::Curves> geometry = std::dynamic_pointer_cast<sg::Curves>(node);
-        data.idGeometry = createHairGeometry(geometry);
-
-        createInstance(m_geometryData[data.idGeometry].traversable, matrix, data);
-    }
-    break;
-  }
-}
-
-unsigned int Device::createGeometry(std::shared_ptr<sg::Triangles> geometry)
-{
-  const unsigned int idGeometry = geometry->getId();
   MY_ASSERT(idGeometry < m_geometryData.size());
 
-  // Did we create a geometry acceleration structure (GAS) for this Triangles node already?
-  if (m_geometryData[idGeometry].traversable != 0)
-  {
-    return idGeometry; // Yes, reuse the GAS traversable.
-  }
-  
-  std::vector<VertexAttributes> const& attributes = geometry->getAttributes();
-  std::vector<unsigned int>       const& indices    = geometry->getIndices();
+  std::vector<VertexAttributes> const& attributes = *geometry.attributes;
+  std::vector<unsigned int>       const& indices    = *geometry.indices;
 
   const size_t attributesSizeInBytes = sizeof(VertexAttributes) * attributes.size();
 
@@ -1559,28 +1720,19 @@ unsigned int Device::createGeometry(std::shared_ptr<sg::Triangles> geometry)
   geometryData.d_gas         = d_gas;
 
   m_geometryData[idGeometry] = geometryData;
-    
-  return idGeometry;
 }
 
-unsigned int Device::createHairGeometry(std::shared_ptr<sg::Curves> geometry)
+void Device::createHairGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry)
 {
-    const unsigned int idGeometry = geometry->getId();
     MY_ASSERT(idGeometry < m_geometryData.size());
 
-    // Did we create a geometry acceleration structure (GAS) for this Triangles node already?
-    if (m_geometryData[idGeometry].traversable != 0)
-    {
-        return idGeometry; // Yes, reuse the GAS traversable.
-    }
-
-    std::vector<VertexAttributes> const& attributes = geometry->getAttributes();
-    std::vector<unsigned int>      const& indices = geometry->getIndices();
-    std::vector<unsigned int> const& segments = geometry->segments();
-    std::vector<float> const& thickness = geometry->getThickness();
-    std::vector<int> const& strandIs = geometry->strandIndices();
-    std::vector<uint2> const& strandInfo = geometry->strandInfo();
-    std::vector<float3> const& strandRand = geometry->strandRand();
+    // The strand arrays have been derived from the sg::Curves once in CompiledScene::compile().
+    std::vector<VertexAttributes> const& attributes = *geometry.attributes;
+    std::vector<unsigned int> const& segments = geometry.segments;
+    std::vector<float> const& thickness = *geometry.thickness;
+    std::vector<int> const& strandIs = geometry.strandIndices;
+    std::vector<uint2> const& strandInfo = geometry.strandInfo;
+    std::vector<float3> const& strandRand = geometry.strandRand;
 
     const size_t attributesSizeInBytes = sizeof(VertexAttributes) * attributes.size();
 
@@ -1696,11 +1848,9 @@ unsigned int Device::createHairGeometry(std::shared_ptr<sg::Curves> geometry)
     geometryData.d_strand_rand = d_strandRand;
 
     m_geometryData[idGeometry] = geometryData;
-
-    return idGeometry;
 }
 
-void Device::createInstance(const OptixTraversableHandle traversable, float matrix[12], InstanceData const& data)
+void Device::createInstance(const OptixTraversableHandle traversable, const float matrix[12], InstanceData const& data)
 {
   MY_ASSERT(0 <= data.idMaterial);
 
@@ -1761,9 +1911,55 @@ void Device::createTLAS()
   CU_CHECK( cuMemFree(d_tmp) );
 
   CU_CHECK( cuMemFree(d_instances) ); // Don't need the instances anymore.
+
+  m_isDirtySystemData = true; // The m_systemData.topObject changed.
 }
 
 
+// Fill the host side hit group records of one instance.
+void Device::setHitGroupRecords(const unsigned int i)
+{
+  InstanceData const& data = m_instanceData[i];
+  
+  const int idx = i * NUM_RAYTYPES; // idx == radiance ray, idx + 1 == shadow ray
+ 
+  if (m_materials[data.idMaterial].indexBSDF == INDEX_BCSDF_HAIR) {
+      memcpy(m_sbtRecordGeometryInstanceData[idx].header, m_sbtRecordHitRadianceCurve.header, OPTIX_SBT_RECORD_HEADER_SIZE);
+      memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadowCurve.header, OPTIX_SBT_RECORD_HEADER_SIZE);
+  }
+  else if (m_materials[data.idMaterial].textureHead == 0)
+  {
+    // Only update the header to switch the program hit group. The SBT record data field doesn't change. 
+    memcpy(m_sbtRecordGeometryInstanceData[idx    ].header, m_sbtRecordHitRadiance.header, OPTIX_SBT_RECORD_HEADER_SIZE);
+    memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadow.header,   OPTIX_SBT_RECORD_HEADER_SIZE);
+  }
+  else
+  {
+    memcpy(m_sbtRecordGeometryInstanceData[idx    ].header, m_sbtRecordHitRadianceCutout.header, OPTIX_SBT_RECORD_HEADER_SIZE);
+    memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadowCutout.header,   OPTIX_SBT_RECORD_HEADER_SIZE);
+  }
+  
+  m_sbtRecordGeometryInstanceData[idx    ].data.attributes    = m_geometryData[data.idGeometry].d_attributes;
+  m_sbtRecordGeometryInstanceData[idx    ].data.indices       = m_geometryData[data.idGeometry].d_indices;
+  m_sbtRecordGeometryInstanceData[idx    ].data.materialIndex = data.idMaterial;
+  m_sbtRecordGeometryInstanceData[idx    ].data.lightIndex    = data.idLight;
+
+  m_sbtRecordGeometryInstanceData[idx + 1].data.attributes    = m_geometryData[data.idGeometry].d_attributes;
+  m_sbtRecordGeometryInstanceData[idx + 1].data.indices       = m_geometryData[data.idGeometry].d_indices;
+  m_sbtRecordGeometryInstanceData[idx + 1].data.materialIndex = data.idMaterial;
+  m_sbtRecordGeometryInstanceData[idx + 1].data.lightIndex    = data.idLight;
+
+  if (m_materials[data.idMaterial].indexBSDF == INDEX_BCSDF_HAIR) {
+      m_sbtRecordGeometryInstanceData[idx].data.strand_i = m_geometryData[data.idGeometry].d_strand_i;
+      m_sbtRecordGeometryInstanceData[idx].data.strand_info = m_geometryData[data.idGeometry].d_strand_info;
+      m_sbtRecordGeometryInstanceData[idx].data.strand_rand = m_geometryData[data.idGeometry].d_strand_rand;
+
+      m_sbtRecordGeometryInstanceData[idx+1].data.strand_i = m_geometryData[data.idGeometry].d_strand_i;
+      m_sbtRecordGeometryInstanceData[idx+1].data.strand_info = m_geometryData[data.idGeometry].d_strand_info;
+      m_sbtRecordGeometryInstanceData[idx+1].data.strand_rand = m_geometryData[data.idGeometry].d_strand_rand;
+  }
+}
+
 void Device::createHitGroupRecords()
 {
   const unsigned int numInstances = static_cast<unsigned int>(m_instances.size());
@@ -1772,45 +1968,7 @@ void Device::createHitGroupRecords()
 
   for (unsigned int i = 0; i < numInstances; ++i)
   {
-    InstanceData const& data = m_instanceData[i];
-    
-    const int idx = i * NUM_RAYTYPES; // idx == radiance ray, idx + 1 == shadow ray
-   
-    if (m_materials[data.idMaterial].indexBSDF == INDEX_BCSDF_HAIR) {
-        memcpy(m_sbtRecordGeometryInstanceData[idx].header, m_sbtRecordHitRadianceCurve.header, OPTIX_SBT_RECORD_HEADER_SIZE);
-        memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadowCurve.header, OPTIX_SBT_RECORD_HEADER_SIZE);
-    }
-    else if (m_materials[data.idMaterial].textureHead == 0)
-    {
-      // Only update the header to switch the program hit group. The SBT record data field doesn't change. 
-      memcpy(m_sbtRecordGeometryInstanceData[idx    ].header, m_sbtRecordHitRadiance.header, OPTIX_SBT_RECORD_HEADER_SIZE);
-      memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadow.header,   OPTIX_SBT_RECORD_HEADER_SIZE);
-    }
-    else
-    {
-      memcpy(m_sbtRecordGeometryInstanceData[idx    ].header, m_sbtRecordHitRadianceCutout.header, OPTIX_SBT_RECORD_HEADER_SIZE);
-      memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadowCutout.header,   OPTIX_SBT_RECORD_HEADER_SIZE);
-    }
-    
-    m_sbtRecordGeometryInstanceData[idx    ].data.attributes    = m_geometryData[data.idGeometry].d_attributes;
-    m_sbtRecordGeometryInstanceData[idx    ].data.indices       = m_geometryData[data.idGeometry].d_indices;
-    m_sbtRecordGeometryInstanceData[idx    ].data.materialIndex = data.idMaterial;
-    m_sbtRecordGeometryInstanceData[idx    ].data.lightIndex    = data.idLight;
-
-    m_sbtRecordGeometryInstanceData[idx + 1].data.attributes    = m_geometryData[data.idGeometry].d_attributes;
-    m_sbtRecordGeometryInstanceData[idx + 1].data.indices       = m_geometryData[data.idGeometry].d_indices;
-    m_sbtRecordGeometryInstanceData[idx + 1].data.materialIndex = data.idMaterial;
-    m_sbtRecordGeometryInstanceData[idx + 1].data.lightIndex    = data.idLight;
-
-    if (m_materials[data.idMaterial].indexBSDF == INDEX_BCSDF_HAIR) {
-        m_sbtRecordGeometryInstanceData[idx].data.strand_i = m_geometryData[data.idGeometry].d_strand_i;
-        m_sbtRecordGeometryInstanceData[idx].data.strand_info = m_geometryData[data.idGeometry].d_strand_info;
-        m_sbtRecordGeometryInstanceData[idx].data.strand_rand = m_geometryData[data.idGeometry].d_strand_rand;
-
-        m_sbtRecordGeometryInstanceData[idx+1].data.strand_i = m_geometryData[data.idGeometry].d_strand_i;
-        m_sbtRecordGeometryInstanceData[idx+1].data.strand_info = m_geometryData[data.idGeometry].d_strand_info;
-        m_sbtRecordGeometryInstanceData[idx+1].data.strand_rand = m_geometryData[data.idGeometry].d_strand_rand;
-    }
+    setHitGroupRecords(i);
   }
 
   CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_d_sbtRecordGeometryInstanceData), sizeof(SbtRecordGeometryInstanceData) * NUM_RAYTYPES * numInstances) );
@@ -0,0 +1,222 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/EnvironmentCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+
+// Increment whenever the filter, the distributions, or the layout change.
+#define ENVIRONMENT_CACHE_VERSION 1
+
+// The file starts with this header. The arrays follow in the order cdfU, cdfV, aliasU, aliasV.
+struct EnvironmentCacheHeader
+{
+  char         magic[8]; // "ENVCACHE"
+  unsigned int version;
+  unsigned int width;
+  unsigned int height;
+  float        integral;
+  uint64_t     hash;
+  uint64_t     reserved[4];
+};
+
+static_assert(sizeof(EnvironmentCacheHeader) == 64, "EnvironmentCacheHeader must be 64 bytes");
+
+static const char c_magic[8] = { 'E', 'N', 'V', 'C', 'A', 'C', 'H', 'E' };
+
+// Byte sizes of the individual arrays.
+struct EnvironmentCacheLayout
+{
+  EnvironmentCacheLayout(const unsigned int width, const unsigned int height)
+  : sizeCDF_U(size_t(width + 1) * height * sizeof(float))
+  , sizeCDF_V(size_t(height + 1) * sizeof(float))
+  , sizeAlias_U(size_t(width) * height * sizeof(AliasEntry))
+  , sizeAlias_V(size_t(height) * sizeof(AliasEntry))
+  {
+  }
+
+  size_t getTotalSize() const
+  {
+    return sizeof(EnvironmentCacheHeader) + sizeCDF_U + sizeCDF_V + sizeAlias_U + sizeAlias_V;
+  }
+
+  size_t sizeCDF_U;
+  size_t sizeCDF_V;
+  size_t sizeAlias_U;
+  size_t sizeAlias_V;
+};
+
+
+EnvironmentCache::EnvironmentCache()
+: m_integral(1.0f)
+, m_cdfU(nullptr)
+, m_cdfV(nullptr)
+, m_aliasU(nullptr)
+, m_aliasV(nullptr)
+{
+}
+
+EnvironmentCache::~EnvironmentCache()
+{
+  unload();
+}
+
+std::string EnvironmentCache::getCacheFilename(std::string const& filename)
+{
+  return filename + std::string(".envcache");
+}
+
+bool EnvironmentCache::load(std::string const& filename, const unsigned int width, const unsigned int height, const uint64_t hash)
+{
+  unload();
+
+  if (!m_file.open(filename))
+  {
+    return false;
+  }
+
+  const EnvironmentCacheLayout layout(width, height);
+
+  const EnvironmentCacheHeader* header = static_cast<const EnvironmentCacheHeader*>(m_file.getData());
+
+  if (m_file.getSize() != layout.getTotalSize() ||
+      memcmp(header->magic, c_magic, sizeof(c_magic)) != 0 ||
+      header->version != ENVIRONMENT_CACHE_VERSION ||
+      header->width   != width ||
+      header->height  != height ||
+      header->hash    != hash)
+  {
+    m_file.close();
+    return false;
+  }
+
+  const unsigned char* p = static_cast<const unsigned char*>(m_file.getData()) + sizeof(EnvironmentCacheHeader);
+
+  m_integral = header->integral;
+
+  m_cdfU   = reinterpret_cast<const float*>(p);
+  p += layout.sizeCDF_U;
+  m_cdfV   = reinterpret_cast<const float*>(p);
+  p += layout.sizeCDF_V;
+  m_aliasU = reinterpret_cast<const AliasEntry*>(p);
+  p += layout.sizeAlias_U;
+  m_aliasV = reinterpret_cast<const AliasEntry*>(p);
+
+  return true;
+}
+
+void EnvironmentCache::unload()
+{
+  m_file.close();
+
+  m_integral = 1.0f;
+  m_cdfU     = nullptr;
+  m_cdfV     = nullptr;
+  m_aliasU   = nullptr;
+  m_aliasV   = nullptr;
+}
+
+bool EnvironmentCache::save(std::string const& filename, const unsigned int width, const unsigned int height, const uint64_t hash,
+                            const float integral, const float* cdfU, const float* cdfV, const AliasEntry* aliasU, const AliasEntry* aliasV)
+{
+  const EnvironmentCacheLayout layout(width, height);
+
+  EnvironmentCacheHeader header;
+  memset(&header, 0, sizeof(EnvironmentCacheHeader));
+
+  memcpy(header.magic, c_magic, sizeof(c_magic));
+  header.version  = ENVIRONMENT_CACHE_VERSION;
+  header.width    = width;
+  header.height   = height;
+  header.integral = integral;
+  header.hash     = hash;
+
+  // Write to a temporary file first. Concurrent readers never see a partially written cache.
+  const std::string filenameTemp = filename + std::string(".tmp");
+  {
+    std::ofstream output(filenameTemp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+      std::cerr << "WARNING: EnvironmentCache::save() cannot write " << filenameTemp << '\n';
+      return false;
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(EnvironmentCacheHeader));
+    output.write(reinterpret_cast<const char*>(cdfU),   layout.sizeCDF_U);
+    output.write(reinterpret_cast<const char*>(cdfV),   layout.sizeCDF_V);
+    output.write(reinterpret_cast<const char*>(aliasU), layout.sizeAlias_U);
+    output.write(reinterpret_cast<const char*>(aliasV), layout.sizeAlias_V);
+
+    if (!output)
+    {
+      std::cerr << "WARNING: EnvironmentCache::save() failed writing " << filenameTemp << '\n';
+      output.close();
+      std::remove(filenameTemp.c_str());
+      return false;
+    }
+  }
+
+  std::remove(filename.c_str()); // rename() does not replace existing files on Windows.
+  if (std::rename(filenameTemp.c_str(), filename.c_str()) != 0)
+  {
+    std::cerr << "WARNING: EnvironmentCache::save() cannot rename " << filenameTemp << " to " << filename << '\n';
+    std::remove(filenameTemp.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+float EnvironmentCache::getIntegral() const
+{
+  return m_integral;
+}
+
+const float* EnvironmentCache::getCDF_U() const
+{
+  return m_cdfU;
+}
+
+const float* EnvironmentCache::getCDF_V() const
+{
+  return m_cdfV;
+}
+
+const AliasEntry* EnvironmentCache::getAlias_U() const
+{
+  return m_aliasU;
+}
+
+const AliasEntry* EnvironmentCache::getAlias_V() const
+{
+  return m_aliasV;
+}
@@ -0,0 +1,366 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/ExrWriter.h"
+#include "inc/Deflate.h"
+#include "inc/HalfFloat.h"
+#include "inc/ThreadPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#define EXR_MAGIC           20000630
+#define EXR_VERSION         2
+#define EXR_PIXEL_TYPE_HALF  1
+#define EXR_PIXEL_TYPE_FLOAT 2
+
+#define EXR_RLE_MIN_RUN 3
+#define EXR_RLE_MAX_RUN 127
+
+// Deflate effort for the ZIP methods. The hash chains get expensive beyond this for little gain on image data.
+#define EXR_DEFLATE_EFFORT 4
+
+
+namespace
+{
+  struct ExrChannel
+  {
+    std::string  name;
+    const float* data;
+    unsigned int stride; // In floats.
+  };
+
+  // Little endian serialization of the header.
+  class ByteWriter
+  {
+  public:
+    void u8(const unsigned char value)
+    {
+      m_data.push_back(value);
+    }
+
+    void u32(const uint32_t value)
+    {
+      for (int i = 0; i < 4; ++i)
+      {
+        m_data.push_back((unsigned char) (value >> (8 * i)));
+      }
+    }
+
+    void u64(const uint64_t value)
+    {
+      for (int i = 0; i < 8; ++i)
+      {
+        m_data.push_back((unsigned char) (value >> (8 * i)));
+      }
+    }
+
+    void f32(const float value)
+    {
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(float));
+      u32(bits);
+    }
+
+    void str(std::string const& value) // Null terminated.
+    {
+      m_data.insert(m_data.end(), value.begin(), value.end());
+      m_data.push_back(0);
+    }
+
+    void attribute(std::string const& name, std::string const& type, const uint32_t size)
+    {
+      str(name);
+      str(type);
+      u32(size);
+    }
+
+    std::vector<unsigned char>& data()
+    {
+      return m_data;
+    }
+
+  private:
+    std::vector<unsigned char> m_data;
+  };
+}
+
+
+static unsigned int getLinesPerBlock(const ExrCompression compression)
+{
+  return (compression == EXR_COMPRESSION_ZIP) ? 16 : 1;
+}
+
+// The RLE and ZIP methods split the bytes into two halves with the even and odd bytes
+// and store the differences to the previous byte. That groups the similar high bytes of the values together.
+static void reorderPredict(std::vector<unsigned char> const& src, std::vector<unsigned char>& dst)
+{
+  const size_t size = src.size();
+  dst.resize(size);
+
+  unsigned char* t1 = dst.data();
+  unsigned char* t2 = dst.data() + (size + 1) / 2;
+  for (size_t i = 0; i < size; i += 2)
+  {
+    *t1++ = src[i];
+    if (i + 1 < size)
+    {
+      *t2++ = src[i + 1];
+    }
+  }
+
+  int previous = (size != 0) ? dst[0] : 0;
+  for (size_t i = 1; i < size; ++i)
+  {
+    const int value = dst[i];
+    dst[i]   = (unsigned char) (value - previous + (128 + 256));
+    previous = value;
+  }
+}
+
+// OpenEXR run length encoding. A non-negative count byte n is followed by one byte repeated n + 1 times,
+// a negative count -n is followed by n literal bytes.
+static void compressRLE(std::vector<unsigned char> const& src, std::vector<unsigned char>& dst)
+{
+  dst.clear();
+  dst.reserve(src.size() + src.size() / EXR_RLE_MAX_RUN + 1);
+
+  const unsigned char* in    = src.data();
+  const unsigned char* inEnd = src.data() + src.size();
+
+  const unsigned char* runStart = in;
+  const unsigned char* runEnd   = in + 1;
+  while (runStart < inEnd)
+  {
+    while (runEnd < inEnd && *runStart == *runEnd && runEnd - runStart - 1 < EXR_RLE_MAX_RUN)
+    {
+      ++runEnd;
+    }
+    if (EXR_RLE_MIN_RUN <= runEnd - runStart)
+    {
+      dst.push_back((unsigned char) ((runEnd - runStart) - 1));
+      dst.push_back(*runStart);
+      runStart = runEnd;
+    }
+    else
+    {
+      // Extend the literal run until the next run of at least three equal bytes starts.
+      while (runEnd < inEnd &&
+             ((runEnd + 1 >= inEnd || *runEnd != *(runEnd + 1)) ||
+              (runEnd + 2 >= inEnd || *(runEnd + 1) != *(runEnd + 2))) &&
+             runEnd - runStart < EXR_RLE_MAX_RUN)
+      {
+        ++runEnd;
+      }
+      dst.push_back((unsigned char) (runStart - runEnd));
+      dst.insert(dst.end(), runStart, runEnd);
+      runStart = runEnd;
+    }
+    ++runEnd;
+  }
+}
+
+// Gather the scanlines [y0, y1) channel by channel in the pixel type and compress them.
+// Blocks which don't get smaller are stored uncompressed, readers detect that by the size.
+static void encodeBlock(std::vector<ExrChannel> const& channels, const unsigned int width, const unsigned int height,
+                        const unsigned int y0, const unsigned int y1, const bool half, const ExrCompression compression,
+                        std::vector<unsigned char>& block)
+{
+  const size_t bytesPerValue = (half) ? 2 : 4;
+
+  std::vector<unsigned char> raw((y1 - y0) * channels.size() * width * bytesPerValue);
+  std::vector<float>         line(width);
+
+  unsigned char* dst = raw.data();
+  for (unsigned int y = y0; y < y1; ++y)
+  {
+    const size_t row = size_t(height - 1 - y) * width; // EXR files are top to bottom.
+    for (ExrChannel const& channel : channels)
+    {
+      const float* src = channel.data + row * channel.stride;
+      for (unsigned int x = 0; x < width; ++x)
+      {
+        line[x] = src[x * channel.stride];
+      }
+      if (half)
+      {
+        floatToHalf(line.data(), reinterpret_cast<uint16_t*>(dst), width, true); // Assumes a little endian host like the rest of the file.
+      }
+      else
+      {
+        memcpy(dst, line.data(), width * sizeof(float));
+      }
+      dst += width * bytesPerValue;
+    }
+  }
+
+  if (compression == EXR_COMPRESSION_NONE)
+  {
+    block.swap(raw);
+    return;
+  }
+
+  std::vector<unsigned char> predicted;
+  reorderPredict(raw, predicted);
+
+  if (compression == EXR_COMPRESSION_RLE)
+  {
+    compressRLE(predicted, block);
+  }
+  else
+  {
+    compressZlib(predicted.data(), predicted.size(), block, EXR_DEFLATE_EFFORT);
+  }
+
+  if (raw.size() <= block.size())
+  {
+    block.swap(raw);
+  }
+}
+
+
+bool writeEXR(std::string const& filename, const unsigned int width, const unsigned int height,
+              const float* rgba, const float* extra, std::string const& extraName,
+              const bool half, const ExrCompression compression)
+{
+  if (width == 0 || height == 0 || rgba == nullptr)
+  {
+    std::cerr << "ERROR: writeEXR() " << filename << " has no image data.\n";
+    return false;
+  }
+
+  // Channels are stored in alphabetical order.
+  std::vector<ExrChannel> channels;
+  channels.push_back({ "A", rgba + 3, 4 });
+  channels.push_back({ "B", rgba + 2, 4 });
+  channels.push_back({ "G", rgba + 1, 4 });
+  channels.push_back({ "R", rgba + 0, 4 });
+  if (extra != nullptr && !extraName.empty())
+  {
+    channels.push_back({ extraName, extra, 1 });
+  }
+  std::sort(channels.begin(), channels.end(), [](ExrChannel const& a, ExrChannel const& b) { return a.name < b.name; });
+
+  ByteWriter header;
+  header.u32(EXR_MAGIC);
+  header.u32(EXR_VERSION); // Single part scanline file, no flags.
+
+  uint32_t sizeChannels = 1;
+  for (ExrChannel const& channel : channels)
+  {
+    sizeChannels += uint32_t(channel.name.size()) + 1 + 16;
+  }
+  header.attribute("channels", "chlist", sizeChannels);
+  for (ExrChannel const& channel : channels)
+  {
+    header.str(channel.name);
+    header.u32((half) ? EXR_PIXEL_TYPE_HALF : EXR_PIXEL_TYPE_FLOAT);
+    header.u32(0); // pLinear and reserved bytes.
+    header.u32(1); // xSampling
+    header.u32(1); // ySampling
+  }
+  header.u8(0);
+
+  header.attribute("compression", "compression", 1);
+  header.u8((unsigned char) compression);
+
+  for (const char* window : { "dataWindow", "displayWindow" })
+  {
+    header.attribute(window, "box2i", 16);
+    header.u32(0);
+    header.u32(0);
+    header.u32(width - 1);
+    header.u32(height - 1);
+  }
+
+  header.attribute("lineOrder", "lineOrder", 1);
+  header.u8(0); // Increasing y.
+
+  header.attribute("pixelAspectRatio", "float", 4);
+  header.f32(1.0f);
+
+  header.attribute("screenWindowCenter", "v2f", 8);
+  header.f32(0.0f);
+  header.f32(0.0f);
+
+  header.attribute("screenWindowWidth", "float", 4);
+  header.f32(1.0f);
+
+  header.u8(0); // End of header.
+
+  const unsigned int linesPerBlock = getLinesPerBlock(compression);
+  const unsigned int numBlocks     = (height + linesPerBlock - 1) / linesPerBlock;
+
+  std::vector< std::vector<unsigned char> > blocks(numBlocks);
+
+  ThreadPool::getInstance().parallelFor(0, numBlocks, 1, [&](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      const unsigned int y0 = (unsigned int) i * linesPerBlock;
+      const unsigned int y1 = std::min(y0 + linesPerBlock, height);
+      encodeBlock(channels, width, height, y0, y1, half, compression, blocks[i]);
+    }
+  });
+
+  // Offset table with the absolute file position of each block.
+  uint64_t offset = header.data().size() + uint64_t(numBlocks) * sizeof(uint64_t);
+  for (unsigned int i = 0; i < numBlocks; ++i)
+  {
+    header.u64(offset);
+    offset += 8 + blocks[i].size(); // y and data size plus the data.
+  }
+
+  std::ofstream output(filename, std::ios::binary);
+  if (!output)
+  {
+    std::cerr << "ERROR: writeEXR() failed to open " << filename << '\n';
+    return false;
+  }
+  output.write(reinterpret_cast<const char*>(header.data().data()), header.data().size());
+
+  for (unsigned int i = 0; i < numBlocks; ++i)
+  {
+    ByteWriter prefix;
+    prefix.u32(i * linesPerBlock);
+    prefix.u32(uint32_t(blocks[i].size()));
+    output.write(reinterpret_cast<const char*>(prefix.data().data()), prefix.data().size());
+    output.write(reinterpret_cast<const char*>(blocks[i].data()), blocks[i].size());
+  }
+
+  if (!output)
+  {
+    std::cerr << "ERROR: writeEXR() failed to write " << filename << '\n';
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,176 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/GeometryRegistry.h"
+
+#include "inc/Hash.h"
+#include "inc/ThreadPool.h"
+
+#include <cstring>
+#include <unordered_set>
+
+
+GeometryRegistry::GeometryRegistry()
+: m_numShared(0)
+{
+}
+
+uint64_t GeometryRegistry::hashContent(sg::Triangles const& geometry)
+{
+  std::vector<VertexAttributes> const& attributes = geometry.getAttributes();
+  std::vector<unsigned int>     const& indices    = geometry.getIndices();
+
+  // VertexAttributes are four float3 without padding, the raw bytes are the content.
+  const uint64_t hashIndices = hash64(indices.data(), sizeof(unsigned int) * indices.size(), indices.size());
+
+  return hash64(attributes.data(), sizeof(VertexAttributes) * attributes.size(), hashIndices);
+}
+
+static bool isEqualContent(sg::Triangles const& a, sg::Triangles const& b)
+{
+  std::vector<VertexAttributes> const& attributesA = a.getAttributes();
+  std::vector<VertexAttributes> const& attributesB = b.getAttributes();
+  std::vector<unsigned int>     const& indicesA    = a.getIndices();
+  std::vector<unsigned int>     const& indicesB    = b.getIndices();
+
+  return attributesA.size() == attributesB.size() &&
+         indicesA.size()    == indicesB.size()    &&
+         memcmp(attributesA.data(), attributesB.data(), sizeof(VertexAttributes) * attributesA.size()) == 0 &&
+         memcmp(indicesA.data(),    indicesB.data(),    sizeof(unsigned int)     * indicesA.size())    == 0;
+}
+
+std::shared_ptr<sg::Triangles> GeometryRegistry::acquire(std::shared_ptr<sg::Triangles> const& geometry, const uint64_t hash)
+{
+  auto range = m_triangles.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if (it->second == geometry)
+    {
+      return geometry;
+    }
+    if (isEqualContent(*it->second, *geometry))
+    {
+      ++m_numShared;
+      return it->second;
+    }
+  }
+
+  m_triangles.emplace(hash, geometry);
+  return geometry;
+}
+
+void GeometryRegistry::share(std::vector< std::shared_ptr<sg::Node> >& geometries, std::vector< std::shared_ptr<sg::Group> > const& roots)
+{
+  std::vector<uint64_t> hashes(geometries.size(), 0);
+
+  ThreadPool::getInstance().parallelFor(0, geometries.size(), 1, [&geometries, &hashes](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      std::shared_ptr<sg::Node> const& geometry = geometries[i];
+      if (geometry->getType() == sg::NT_TRIANGLES && geometry->getId() == i)
+      {
+        hashes[i] = hashContent(*std::static_pointer_cast<sg::Triangles>(geometry));
+      }
+    }
+  });
+
+  std::unordered_map<const sg::Node*, std::shared_ptr<sg::Node> > remap;
+
+  for (size_t i = 0; i < geometries.size(); ++i)
+  {
+    std::shared_ptr<sg::Node>& geometry = geometries[i];
+    if (geometry->getType() != sg::NT_TRIANGLES || geometry->getId() != i) // Not registered or already shared.
+    {
+      continue;
+    }
+
+    std::shared_ptr<sg::Triangles> shared = acquire(std::static_pointer_cast<sg::Triangles>(geometry), hashes[i]);
+    if (shared != geometry)
+    {
+      remap[geometry.get()] = shared;
+      geometry = shared;
+    }
+  }
+
+  if (!remap.empty())
+  {
+    std::vector< std::shared_ptr<sg::Group> > stack(roots);
+    std::unordered_set<const sg::Group*>      visited;
+
+    while (!stack.empty())
+    {
+      std::shared_ptr<sg::Group> group = stack.back();
+      stack.pop_back();
+
+      if (!group || !visited.insert(group.get()).second)
+      {
+        continue;
+      }
+
+      for (size_t i = 0; i < group->getNumChildren(); ++i)
+      {
+        std::shared_ptr<sg::Instance> instance = group->getChild(i);
+        std::shared_ptr<sg::Node>     child    = instance->getChild();
+        if (!child)
+        {
+          continue;
+        }
+
+        if (child->getType() == sg::NT_GROUP)
+        {
+          stack.push_back(std::static_pointer_cast<sg::Group>(child));
+        }
+        else
+        {
+          std::unordered_map<const sg::Node*, std::shared_ptr<sg::Node> >::const_iterator it = remap.find(child.get());
+          if (it != remap.end())
+          {
+            instance->setChild(it->second);
+          }
+        }
+      }
+    }
+  }
+}
+
+void GeometryRegistry::clear()
+{
+  m_triangles.clear();
+  m_numShared = 0;
+}
+
+size_t GeometryRegistry::getNumRegistered() const
+{
+  return m_triangles.size();
+}
+
+size_t GeometryRegistry::getNumShared() const
+{
+  return m_numShared;
+}
@@ -36,11 +36,11 @@
 
 #include "inc/SceneGraph.h"
 #include "inc/Hair.h"
+#include "inc/SceneSnapshot.h"
 #include "vector_types.h"
 
 #include <optix.h>
 
-#include "inc/Application.h"
 #include "inc/CheckMacros.h"
 
 #include <inc/MyAssert.h>
@@ -53,14 +53,14 @@
 namespace sg {
 
     Curves::Curves(const unsigned int id)
-        : Node(id)
+        : Node(id, NT_CURVES)
     {
         m_density = 1.f;
         m_disparity = 1.f;
     }
     
     Curves::Curves(const unsigned int id, float density, float disparity)
-        : Node(id)
+        : Node(id, NT_CURVES)
     {
         if (density < 1.f)
             std::cout << "Density must be a >1.f value, setting m_density to 1.f default value !!!" << std::endl;
@@ -70,10 +70,6 @@ namespace sg {
         m_disparity = clamp(disparity, 0.f, 1.f);
     }
 
-    NodeType Curves::getType() const
-    {
-        return NT_CURVES;
-    }
     inline std::ostream& operator<<(std::ostream& o, float3 v)
     {
         o << "(" << v.x << ", " << v.y << ", " << v.z << ")";
@@ -84,6 +80,7 @@ namespace sg {
     {
         m_attributes.resize(attributes.size());
         memcpy(m_attributes.data(), attributes.data(), sizeof(VertexAttributes) * attributes.size());
+        setChanged(CHANGE_GEOMETRY);
     }
 
     std::vector<VertexAttributes> const& Curves::getAttributes() const
@@ -95,6 +92,7 @@ namespace sg {
     {
         m_indices.resize(indices.size());
         memcpy(m_indices.data(), indices.data(), sizeof(unsigned int) * indices.size());
+        setChanged(CHANGE_GEOMETRY);
     }
 
     std::vector<unsigned int> const& Curves::getIndices() const
@@ -106,10 +104,44 @@ namespace sg {
     {
         m_indices.resize(indices.size());
         memcpy(m_indices.data(), indices.data(), sizeof(float) * indices.size());
+        setChanged(CHANGE_GEOMETRY);
     }
 
     std::vector<float> const& Curves::getThickness() const { return m_thickness; };
 
+    void Curves::writeSnapshot(SnapshotWriter& writer) const
+    {
+        // The resolved strands after densification, reloading them skips the .hair parsing and the random duplication.
+        writer.write(m_header);
+        writer.write(m_hairthickness_tempo);
+        writer.write(m_density);
+        writer.write(m_disparity);
+        writer.write(m_splineMode);
+        writer.write(m_shadeMode);
+        writer.write(m_radiusMode);
+        writer.writeArray(m_strands);
+        writer.writeArray(m_points);
+        writer.writeArray(m_thickness);
+        writer.writeArray(m_attributes);
+        writer.writeArray(m_indices);
+    }
+
+    bool Curves::readSnapshot(SnapshotReader& reader)
+    {
+        return reader.read(m_header) &&
+               reader.read(m_hairthickness_tempo) &&
+               reader.read(m_density) &&
+               reader.read(m_disparity) &&
+               reader.read(m_splineMode) &&
+               reader.read(m_shadeMode) &&
+               reader.read(m_radiusMode) &&
+               reader.readArray(m_strands) &&
+               reader.readArray(m_points) &&
+               reader.readArray(m_thickness) &&
+               reader.readArray(m_attributes) &&
+               reader.readArray(m_indices);
+    }
+
 
     void Curves::createHairFromFile(const std::string& fileName)
     {
@@ -138,7 +170,7 @@ namespace sg {
             std::fill(strandSegments.begin(), strandSegments.end(), defaultNumberOfSegments());
         }
 
-        int density_int_part = unsigned int(m_density)-1;
+        int density_int_part = static_cast<unsigned int>(m_density)-1;
         float density_dec_part = m_density - (float)density_int_part - 1 ;
          
         std::vector<unsigned short> strandSegments_copy = strandSegments;
@@ -284,7 +316,7 @@ namespace sg {
             std::fill(strandSegments.begin(), strandSegments.end(), defaultNumberOfSegments());
         }
 
-        int density_int_part = unsigned int(m_density) - 1;
+        int density_int_part = static_cast<unsigned int>(m_density) - 1;
         float density_dec_part = m_density - (float)density_int_part - 1;
 
         std::vector<unsigned short> strandSegments_copy = strandSegments;
@@ -633,6 +665,7 @@ namespace sg {
         if (m_radiusMode != radiusMode)
         {
             m_radiusMode = radiusMode;
+            setChanged(CHANGE_GEOMETRY);
             if (CONSTANT_R == m_radiusMode)
             {
                 // assign all radii the root radius
@@ -0,0 +1,180 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/HairColorMatch.h"
+#include "inc/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Limits of the continuous melanin refinement. Same ranges as the material GUI sliders.
+static const float MATCH_MELANIN_CONCENTRATION_MAX = 8.0f;
+static const int   MATCH_MAX_REFINE_EVALUATIONS    = 64;
+
+
+static float3 linearToLab(float3 const& rgb)
+{
+  // Linear sRGB to XYZ, normalized by the D65 white point.
+  const float x = (0.4124f * rgb.x + 0.3576f * rgb.y + 0.1805f * rgb.z) / 0.95047f;
+  const float y = (0.2126f * rgb.x + 0.7152f * rgb.y + 0.0722f * rgb.z);
+  const float z = (0.0193f * rgb.x + 0.1192f * rgb.y + 0.9505f * rgb.z) / 1.08883f;
+
+  auto f = [](const float t)
+  {
+    return (0.008856f < t) ? cbrtf(t) : 7.787f * t + 16.0f / 116.0f;
+  };
+
+  const float fx = f(x);
+  const float fy = f(y);
+  const float fz = f(z);
+
+  return make_float3(116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz));
+}
+
+
+HairColorMatch::HairColorMatch(HairSwatch& hairSwatch)
+: m_hairSwatch(hairSwatch)
+{
+}
+
+HairColorMatch::~HairColorMatch()
+{
+}
+
+float HairColorMatch::deltaE(float3 const& a, float3 const& b)
+{
+  return length(linearToLab(a) - linearToLab(b));
+}
+
+std::vector<HairColorCandidate> HairColorMatch::match(float3 const& target,
+                                                      std::vector<MaterialGUI> const& candidates,
+                                                      const size_t numResults,
+                                                      const bool refineMelanin)
+{
+  std::vector<float3> colors;
+  m_hairSwatch.evaluate(candidates, colors);
+
+  std::vector<float> errors(candidates.size());
+  ThreadPool::getInstance().parallelFor(0, candidates.size(), 256, [&](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      errors[i] = deltaE(colors[i], target);
+    }
+  });
+
+  std::vector<size_t> order(candidates.size());
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    order[i] = i;
+  }
+  const size_t count = std::min(numResults, order.size());
+  std::partial_sort(order.begin(), order.begin() + count, order.end(), [&errors](size_t a, size_t b)
+  {
+    return errors[a] < errors[b];
+  });
+
+  std::vector<HairColorCandidate> results(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    results[i].material = candidates[order[i]];
+    results[i].color    = colors[order[i]];
+    results[i].error    = errors[order[i]];
+  }
+
+  if (refineMelanin)
+  {
+    ThreadPool::getInstance().parallelFor(0, results.size(), 1, [&](size_t first, size_t last)
+    {
+      for (size_t i = first; i < last; ++i)
+      {
+        refine(target, results[i]);
+      }
+    });
+
+    std::sort(results.begin(), results.end(), [](HairColorCandidate const& a, HairColorCandidate const& b)
+    {
+      return a.error < b.error;
+    });
+  }
+
+  return results;
+}
+
+// Compass search over melanin concentration and ratio, starting at the candidate's values.
+void HairColorMatch::refine(float3 const& target, HairColorCandidate& candidate)
+{
+  float stepConcentration = 0.5f;
+  float stepRatio         = 0.1f;
+
+  int evaluations = 0;
+  while (evaluations < MATCH_MAX_REFINE_EVALUATIONS && (0.01f <= stepConcentration || 0.005f <= stepRatio))
+  {
+    const float directions[4][2] =
+    {
+      {  stepConcentration, 0.0f },
+      { -stepConcentration, 0.0f },
+      { 0.0f,  stepRatio },
+      { 0.0f, -stepRatio }
+    };
+
+    bool improved = false;
+    for (int i = 0; i < 4 && evaluations < MATCH_MAX_REFINE_EVALUATIONS; ++i)
+    {
+      MaterialGUI material = candidate.material;
+
+      material.melanin_concentration = clamp(material.melanin_concentration + directions[i][0], 0.0f, MATCH_MELANIN_CONCENTRATION_MAX);
+      material.melanin_ratio         = clamp(material.melanin_ratio         + directions[i][1], 0.0f, 1.0f);
+
+      if (material.melanin_concentration == candidate.material.melanin_concentration &&
+          material.melanin_ratio         == candidate.material.melanin_ratio)
+      {
+        continue; // Clamped at the border.
+      }
+
+      const float3 color = m_hairSwatch.evaluate(material);
+      const float  error = deltaE(color, target);
+      ++evaluations;
+
+      if (error < candidate.error)
+      {
+        candidate.material = material;
+        candidate.color    = color;
+        candidate.error    = error;
+        improved = true;
+        break;
+      }
+    }
+
+    if (!improved)
+    {
+      stepConcentration *= 0.5f;
+      stepRatio         *= 0.5f;
+    }
+  }
+}
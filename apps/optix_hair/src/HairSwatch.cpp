@@ -0,0 +1,425 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/HairSwatch.h"
+#include "inc/ThreadPool.h"
+#include "inc/MyAssert.h"
+
+#include "shaders/bcsdf_hair_constants.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Fixed integration domain. Changing these changes the cost of a table build and of every swatch evaluation.
+static const int   SWATCH_THETA_O  = 8;   // Fiber inclinations against the view direction, stratified in [-45, 45] degrees.
+static const int   SWATCH_PHI_O    = 8;   // Fiber rotations around their axis.
+static const int   SWATCH_H        = 16;  // Offsets across the fiber width.
+static const int   SWATCH_THETA_I  = 16;  // Dome directions, stratified in sin(theta).
+static const int   SWATCH_PHI_I    = 32;
+static const int   SWATCH_TABLES   = 64;  // Number of cached roughness/tilt tables, about 20 KB each.
+
+// Preview environment: Uniform white dome plus a white key light 20 degrees above the viewer.
+static const float SWATCH_DOME_RADIANCE = 0.25f;
+static const float SWATCH_KEY_IRRADIANCE = 1.0f;
+static const float SWATCH_KEY_ELEVATION = 20.0f * M_PIf / 180.0f;
+
+// Index of refraction of the hair fiber. Same hardcoded value as in bcsdf_hair.cu.
+static const float SWATCH_IOR = 1.55f;
+
+// Per fiber melanin disparity is driven by a standard normal random value (Curves::strandRand()).
+// The quartile midpoints of the standard normal distribution integrate that variation.
+static const float SWATCH_DISPARITY_QUANTILES[4] = { -1.1503f, -0.3186f, 0.3186f, 1.1503f };
+
+
+// Host versions of the bcsdf_hair.cu functions.
+static float besselI0(const float x)
+{
+  float result = 1.0f;
+  const float x_sq = x * x;
+  float xi = x_sq;
+  float denom = 4.0f;
+  for (int i = 1; i <= 10; ++i)
+  {
+    result += xi / denom;
+    xi *= x_sq;
+    denom *= 4.0f * float((i + 1) * (i + 1));
+  }
+  return result;
+}
+
+static float logI0(const float x)
+{
+  return (12.0f < x) ? x + 0.5f * (-logf(2.0f * M_PIf * x) + 1.0f / (8.0f * x)) : logf(besselI0(x));
+}
+
+static float longitudinalM(const float v, const float sin_theta_i, const float sin_theta_o, const float cos_theta_i, const float cos_theta_o)
+{
+  const float a = cos_theta_i * cos_theta_o / v;
+  const float b = sin_theta_i * sin_theta_o / v;
+  return (v <= 0.1f) ? expf(logI0(a) - b - 1.0f / v + 0.6931f + logf(1.0f / (2.0f * v)))
+                     : (expf(-b) * besselI0(a)) / (sinhf(1.0f / v) * 2.0f * v);
+}
+
+static float fresnelDielectric(const float cos_theta, const float n1, const float n2)
+{
+  const float r = (n1 - n2) / (n1 + n2);
+  const float R0 = r * r;
+  const float c  = 1.0f - cos_theta;
+  return R0 + (1.0f - R0) * c * c * c * c * c;
+}
+
+static float phiSpecular(const int p, const float gammaT, const float gammaO)
+{
+  return 2.0f * p * gammaT - 2.0f * gammaO + p * M_PIf;
+}
+
+static float logistic(const float x, const float s)
+{
+  const float e = expf(-fabsf(x) / s);
+  return e / (s * (1.0f + e) * (1.0f + e));
+}
+
+static float logisticCDF(const float x, const float s)
+{
+  return 1.0f / (1.0f + expf(-x / s));
+}
+
+static float azimuthalN(const float phi, const int p, const float s, const float gammaO, const float gammaT)
+{
+  float dphi = phi - phiSpecular(p, gammaT, gammaO);
+  while (M_PIf < dphi)
+  {
+    dphi -= 2.0f * M_PIf;
+  }
+  while (dphi < -M_PIf)
+  {
+    dphi += 2.0f * M_PIf;
+  }
+  return logistic(dphi, s) / (logisticCDF(M_PIf, s) - logisticCDF(-M_PIf, s));
+}
+
+
+HairSwatch::HairSwatch()
+: m_tableUse(0)
+{
+}
+
+HairSwatch::~HairSwatch()
+{
+}
+
+float3 HairSwatch::getDyeAbsorption(MaterialGUI const& materialGUI)
+{
+  return (1.0f - materialGUI.dyeNeutralHT) * materialGUI.dyeNeutralHT_Concentration + (1.0f - materialGUI.dye) * materialGUI.dye_concentration;
+}
+
+bool HairSwatch::TableKey::operator<(TableKey const& rhs) const
+{
+  if (betaM != rhs.betaM)
+  {
+    return betaM < rhs.betaM;
+  }
+  if (betaN != rhs.betaN)
+  {
+    return betaN < rhs.betaN;
+  }
+  return scaleAngleDeg < rhs.scaleAngleDeg;
+}
+
+std::shared_ptr<HairSwatch::Table const> HairSwatch::getTable(MaterialGUI const& materialGUI)
+{
+  const TableKey key = { materialGUI.roughnessM, materialGUI.roughnessN, materialGUI.scale_angle_deg };
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutexTables);
+
+    std::map<TableKey, TableEntry>::iterator it = m_tables.find(key);
+    if (it != m_tables.end())
+    {
+      it->second.lastUse = ++m_tableUse;
+      return it->second.table;
+    }
+  }
+
+  // Build outside the lock. Other threads can still evaluate swatches with already cached tables.
+  std::shared_ptr<Table const> table = buildTable(materialGUI.roughnessM, materialGUI.roughnessN, materialGUI.scale_angle_deg);
+
+  std::lock_guard<std::mutex> lock(m_mutexTables);
+
+  if (SWATCH_TABLES <= m_tables.size() && m_tables.find(key) == m_tables.end())
+  {
+    std::map<TableKey, TableEntry>::iterator itOldest = m_tables.begin();
+    for (std::map<TableKey, TableEntry>::iterator it = m_tables.begin(); it != m_tables.end(); ++it)
+    {
+      if (it->second.lastUse < itOldest->second.lastUse)
+      {
+        itOldest = it;
+      }
+    }
+    m_tables.erase(itOldest);
+  }
+
+  // Another thread might have built the same table meanwhile. Either one is fine.
+  TableEntry& entry = m_tables[key];
+  entry.table = table;
+  entry.lastUse = ++m_tableUse;
+
+  return table;
+}
+
+std::shared_ptr<HairSwatch::Table> HairSwatch::buildTable(const float betaM, const float betaN, const float scaleAngleDeg) const
+{
+  std::shared_ptr<Table> table = std::make_shared<Table>();
+
+  table->normalization = 1.0f;
+  table->betaM = betaM;
+  table->betaN = betaN;
+  table->scaleAngleDeg = scaleAngleDeg;
+
+  const int numEntries = SWATCH_THETA_O * SWATCH_PHI_O * SWATCH_H;
+
+  table->weightR.resize(numEntries);
+  table->weightTT.resize(numEntries);
+  table->weightTRT.resize(numEntries);
+  table->fresnel.resize(numEntries);
+  table->pathLength.resize(numEntries);
+
+  // Same material constants as uploaded to the device.
+  const float v = hairLongitudinalVariance(std::max(betaM, 0.01f));
+  const float s = hairLogisticScale(std::max(betaN, 0.01f));
+  float3 sin2kAlpha;
+  float3 cos2kAlpha;
+  hairScaleTilt(scaleAngleDeg * (M_PIf / 180.0f), sin2kAlpha, cos2kAlpha);
+
+  // Solid angle of one stratum on the sphere, uniform in sin(theta) and phi.
+  const float domeWeight = SWATCH_DOME_RADIANCE * 4.0f * M_PIf / float(SWATCH_THETA_I * SWATCH_PHI_I);
+
+  // One task per fiber orientation.
+  ThreadPool::getInstance().parallelFor(0, SWATCH_THETA_O * SWATCH_PHI_O, 1, [&](size_t first, size_t last)
+  {
+    for (size_t orientation = first; orientation < last; ++orientation)
+    {
+      const int   indexThetaO = int(orientation) / SWATCH_PHI_O;
+      const int   indexPhiO   = int(orientation) % SWATCH_PHI_O;
+      const float theta_o     = (-0.25f + 0.5f * (float(indexThetaO) + 0.5f) / float(SWATCH_THETA_O)) * M_PIf;
+      const float phi_o       = (-1.0f + 2.0f * (float(indexPhiO) + 0.5f) / float(SWATCH_PHI_O)) * M_PIf;
+
+      const float sin_theta_o = sinf(theta_o);
+      const float cos_theta_o = cosf(theta_o);
+
+      const float sinThetaT = sin_theta_o / SWATCH_IOR;
+      const float cosThetaT = trigInverse(sinThetaT);
+      const float etap      = sqrtf(SWATCH_IOR * SWATCH_IOR - sin_theta_o * sin_theta_o) / cos_theta_o;
+
+      // Longitudinal lobe shifts by the cuticle tilt.
+      const float theta_0     = sin_theta_o - 2.0f * sin2kAlpha.x * (cosf(phi_o * 0.5f) * cos2kAlpha.x * cos_theta_o + sin_theta_o * sin2kAlpha.x);
+      const float sinThetaOp0 = sinf(theta_0);
+      const float cosThetaOp0 = fabsf(cosf(theta_0));
+      const float sinThetaOp1 = sin_theta_o * cos2kAlpha.x + cos_theta_o * sin2kAlpha.x;
+      const float cosThetaOp1 = fabsf(cos_theta_o * cos2kAlpha.x - sin_theta_o * sin2kAlpha.x);
+      const float sinThetaOp2 = sin_theta_o * cos2kAlpha.z + cos_theta_o * sin2kAlpha.z;
+      const float cosThetaOp2 = fabsf(cos_theta_o * cos2kAlpha.z - sin_theta_o * sin2kAlpha.z);
+
+      for (int indexH = 0; indexH < SWATCH_H; ++indexH)
+      {
+        const float h         = -1.0f + 2.0f * (float(indexH) + 0.5f) / float(SWATCH_H);
+        const float gammaO    = asinf(h);
+        const float sinGammaT = h / etap;
+        const float cosGammaT = trigInverse(sinGammaT);
+        const float gammaT    = asinf(sinGammaT);
+
+        float weightR   = 0.0f;
+        float weightTT  = 0.0f;
+        float weightTRT = 0.0f;
+
+        // Dome.
+        for (int indexThetaI = 0; indexThetaI < SWATCH_THETA_I; ++indexThetaI)
+        {
+          const float sin_theta_i = -1.0f + 2.0f * (float(indexThetaI) + 0.5f) / float(SWATCH_THETA_I);
+          const float cos_theta_i = trigInverse(sin_theta_i);
+
+          const float M_R   = longitudinalM(v,         sin_theta_i, sinThetaOp0, cos_theta_i, cosThetaOp0);
+          const float M_TT  = longitudinalM(0.25f * v, sin_theta_i, sinThetaOp1, cos_theta_i, cosThetaOp1);
+          const float M_TRT = longitudinalM(4.0f * v,  sin_theta_i, sinThetaOp2, cos_theta_i, cosThetaOp2);
+
+          float N_R   = 0.0f;
+          float N_TT  = 0.0f;
+          float N_TRT = 0.0f;
+          for (int indexPhiI = 0; indexPhiI < SWATCH_PHI_I; ++indexPhiI)
+          {
+            const float phi = (-1.0f + 2.0f * (float(indexPhiI) + 0.5f) / float(SWATCH_PHI_I)) * M_PIf;
+
+            N_R   += azimuthalN(phi, 0, s, gammaO, gammaT);
+            N_TT  += azimuthalN(phi, 1, s, gammaO, gammaT);
+            N_TRT += azimuthalN(phi, 2, s, gammaO, gammaT);
+          }
+
+          const float w = domeWeight * cos_theta_i;
+
+          weightR   += w * M_R   * N_R;
+          weightTT  += w * M_TT  * N_TT;
+          weightTRT += w * M_TRT * N_TRT;
+        }
+
+        // Key light next to the viewer, same azimuth.
+        {
+          const float theta_i     = std::min(theta_o + SWATCH_KEY_ELEVATION, M_PI_2f);
+          const float sin_theta_i = sinf(theta_i);
+          const float cos_theta_i = cosf(theta_i);
+          const float w           = SWATCH_KEY_IRRADIANCE * cos_theta_i;
+
+          weightR   += w * longitudinalM(v,         sin_theta_i, sinThetaOp0, cos_theta_i, cosThetaOp0) * azimuthalN(0.0f, 0, s, gammaO, gammaT);
+          weightTT  += w * longitudinalM(0.25f * v, sin_theta_i, sinThetaOp1, cos_theta_i, cosThetaOp1) * azimuthalN(0.0f, 1, s, gammaO, gammaT);
+          weightTRT += w * longitudinalM(4.0f * v,  sin_theta_i, sinThetaOp2, cos_theta_i, cosThetaOp2) * azimuthalN(0.0f, 2, s, gammaO, gammaT);
+        }
+
+        const size_t index = orientation * SWATCH_H + indexH;
+
+        table->weightR[index]    = weightR;
+        table->weightTT[index]   = weightTT;
+        table->weightTRT[index]  = weightTRT;
+        table->fresnel[index]    = fresnelDielectric(cos_theta_o * trigInverse(h), 1.0f, etap);
+        table->pathLength[index] = 2.0f * cosGammaT / cosThetaT;
+      }
+    }
+  });
+
+  const float3 white = integrate(*table, make_float3(0.0f));
+  table->normalization = (0.0f < white.x) ? 1.0f / white.x : 0.0f;
+
+  return table;
+}
+
+float3 HairSwatch::integrate(Table const& table, float3 const& absorption) const
+{
+  const float sigma[3] = { absorption.x, absorption.y, absorption.z };
+  float sum[3] = { 0.0f, 0.0f, 0.0f };
+
+  const size_t numEntries = table.weightR.size();
+  for (size_t i = 0; i < numEntries; ++i)
+  {
+    const float R   = table.fresnel[i];
+    const float l   = table.pathLength[i];
+    const float T2R = (1.0f - R) * (1.0f - R);
+
+    for (int c = 0; c < 3; ++c)
+    {
+      const float T = expf(-sigma[c] * l);
+      sum[c] += table.weightR[i] * R + T2R * T * (table.weightTT[i] + table.weightTRT[i] * R * T);
+    }
+  }
+
+  const float scale = 1.0f / float(numEntries);
+  return make_float3(sum[0] * scale, sum[1] * scale, sum[2] * scale);
+}
+
+float3 HairSwatch::evaluate(MaterialGUI const& materialGUI)
+{
+  std::shared_ptr<Table const> table = getTable(materialGUI);
+
+  return evaluate(materialGUI, *table);
+}
+
+float3 HairSwatch::evaluate(MaterialGUI const& materialGUI, Table const& table) const
+{
+  const float3 dye   = getDyeAbsorption(materialGUI);
+  const float  white = clamp(materialGUI.whitepercen, 0.0f, 1.0f); // Fraction of fibers without melanin.
+
+  float3 colorWhite = make_float3(0.0f);
+  if (0.0f < white)
+  {
+    colorWhite = integrate(table, dye);
+  }
+
+  float3 colorPigmented = make_float3(0.0f);
+  if (white < 1.0f)
+  {
+    if (materialGUI.melanin_concentration_disparity == 0.0f && materialGUI.melanin_ratio_disparity == 0.0f)
+    {
+      colorPigmented = integrate(table, dye + hairMelaninAbsorption(materialGUI.melanin_concentration, materialGUI.melanin_ratio));
+    }
+    else
+    {
+      for (int i = 0; i < 4; ++i)
+      {
+        const float q = SWATCH_DISPARITY_QUANTILES[i];
+        colorPigmented += integrate(table, dye + hairMelaninAbsorption(materialGUI.melanin_concentration * (1.0f + q * materialGUI.melanin_concentration_disparity),
+                                                                        materialGUI.melanin_ratio         * (1.0f + q * materialGUI.melanin_ratio_disparity)));
+      }
+      colorPigmented *= 0.25f;
+    }
+  }
+
+  return (white * colorWhite + (1.0f - white) * colorPigmented) * table.normalization;
+}
+
+void HairSwatch::evaluate(std::vector<MaterialGUI> const& materialsGUI, std::vector<float3>& colors)
+{
+  colors.resize(materialsGUI.size());
+
+  // Look up or build the tables first, in parallel inside buildTable(), to not have workers build the same table concurrently.
+  // Holding the references keeps the tables alive even when there are more distinct settings than the cache holds.
+  std::vector< std::shared_ptr<Table const> > tables(materialsGUI.size());
+  for (size_t i = 0; i < materialsGUI.size(); ++i)
+  {
+    if (0 < i && materialsGUI[i].roughnessM == materialsGUI[i - 1].roughnessM &&
+                 materialsGUI[i].roughnessN == materialsGUI[i - 1].roughnessN &&
+                 materialsGUI[i].scale_angle_deg == materialsGUI[i - 1].scale_angle_deg)
+    {
+      tables[i] = tables[i - 1];
+    }
+    else
+    {
+      tables[i] = getTable(materialsGUI[i]);
+    }
+  }
+
+  ThreadPool::getInstance().parallelFor(0, materialsGUI.size(), 1, [&](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      colors[i] = evaluate(materialsGUI[i], *tables[i]);
+    }
+  });
+}
+
+bool HairSwatch::isEquivalent(MaterialGUI const& a, MaterialGUI const& b)
+{
+  const float3 dyeA = getDyeAbsorption(a);
+  const float3 dyeB = getDyeAbsorption(b);
+
+  return a.roughnessM == b.roughnessM &&
+         a.roughnessN == b.roughnessN &&
+         a.scale_angle_deg == b.scale_angle_deg &&
+         a.whitepercen == b.whitepercen &&
+         dyeA.x == dyeB.x && dyeA.y == dyeB.y && dyeA.z == dyeB.z &&
+         a.melanin_concentration == b.melanin_concentration &&
+         a.melanin_ratio == b.melanin_ratio &&
+         a.melanin_concentration_disparity == b.melanin_concentration_disparity &&
+         a.melanin_ratio_disparity == b.melanin_ratio_disparity;
+}
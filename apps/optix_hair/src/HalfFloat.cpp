@@ -0,0 +1,272 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/HalfFloat.h"
+#include "inc/ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define HALF_USE_F16C 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HALF_TARGET_F16C
+#else
+#include <cpuid.h>
+// Compile only these functions for F16C. The rest of the program keeps the baseline instruction set.
+#define HALF_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+#endif
+
+// Number of elements per ThreadPool chunk. Small arrays are converted inline.
+#define HALF_GRAIN 262144
+
+
+uint16_t floatToHalf(const float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(float));
+
+  const uint32_t sign     = (bits >> 16) & 0x8000;
+  const uint32_t absolute = bits & 0x7FFFFFFF;
+
+  if (0x7F800000 <= absolute) // Infinity or NaN. Keep NaN quiet and non-zero.
+  {
+    return uint16_t(sign | 0x7C00 | ((0x7F800000 < absolute) ? (0x0200 | ((absolute >> 13) & 0x03FF)) : 0));
+  }
+  if (0x477FF000 <= absolute) // Rounds to a value beyond 65504.
+  {
+    return uint16_t(sign | 0x7C00);
+  }
+  if (absolute < 0x38800000) // Denormalized half or zero.
+  {
+    if (absolute < 0x33000000) // Below half of the smallest denormal.
+    {
+      return uint16_t(sign);
+    }
+    const uint32_t mantissa = (absolute & 0x007FFFFF) | 0x00800000;
+    const uint32_t shift    = 126 - (absolute >> 23); // 14 to 24
+    
+    uint32_t       half      = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway   = 1u << (shift - 1);
+    if (halfway < remainder || (remainder == halfway && (half & 1)))
+    {
+      ++half;
+    }
+    return uint16_t(sign | half);
+  }
+
+  // Normalized. Rebias the exponent and round the mantissa to nearest even. A carry into the exponent is correct.
+  uint32_t half = ((absolute - 0x38000000) >> 13);
+  const uint32_t remainder = absolute & 0x1FFF;
+  if (0x1000 < remainder || (remainder == 0x1000 && (half & 1)))
+  {
+    ++half;
+  }
+  return uint16_t(sign | half);
+}
+
+float halfToFloat(const uint16_t value)
+{
+  const uint32_t sign     = uint32_t(value & 0x8000) << 16;
+  const uint32_t exponent = (value >> 10) & 0x1F;
+  uint32_t       mantissa = value & 0x03FF;
+
+  uint32_t bits;
+  if (exponent == 0x1F) // Infinity or NaN.
+  {
+    bits = sign | 0x7F800000 | (mantissa << 13);
+  }
+  else if (exponent != 0)
+  {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  else if (mantissa == 0)
+  {
+    bits = sign;
+  }
+  else // Denormalized half, normalize it.
+  {
+    uint32_t e = 113;
+    while ((mantissa & 0x0400) == 0)
+    {
+      mantissa <<= 1;
+      --e;
+    }
+    bits = sign | (e << 23) | ((mantissa & 0x03FF) << 13);
+  }
+
+  float result;
+  memcpy(&result, &bits, sizeof(float));
+  return result;
+}
+
+
+static float saturateHalf(const float value)
+{
+  if (!(value == value)) // NaN
+  {
+    return 0.0f;
+  }
+  return std::min(std::max(value, -65504.0f), 65504.0f);
+}
+
+static void floatToHalfScalar(const float* src, uint16_t* dst, const size_t count, const bool saturate)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    dst[i] = floatToHalf((saturate) ? saturateHalf(src[i]) : src[i]);
+  }
+}
+
+static void halfToFloatScalar(const uint16_t* src, float* dst, const size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    dst[i] = halfToFloat(src[i]);
+  }
+}
+
+
+#if defined(HALF_USE_F16C)
+static bool detectF16C()
+{
+  // F16C needs the OS to save the AVX register state as well.
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  const unsigned int ecx = static_cast<unsigned int>(info[2]);
+#else
+  unsigned int eax;
+  unsigned int ebx;
+  unsigned int ecx;
+  unsigned int edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+  {
+    return false;
+  }
+#endif
+  const bool hasOSXSAVE = (ecx >> 27) & 1;
+  const bool hasAVX     = (ecx >> 28) & 1;
+  const bool hasF16C    = (ecx >> 29) & 1;
+  if (!(hasOSXSAVE && hasAVX && hasF16C))
+  {
+    return false;
+  }
+
+#if defined(_MSC_VER)
+  const unsigned long long xcr0 = _xgetbv(0);
+#else
+  unsigned int xcr0Low;
+  unsigned int xcr0High;
+  __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+  const unsigned long long xcr0 = xcr0Low;
+#endif
+  return (xcr0 & 6) == 6; // XMM and YMM state enabled.
+}
+
+HALF_TARGET_F16C
+static size_t floatToHalfF16C(const float* src, uint16_t* dst, const size_t count, const bool saturate)
+{
+  const __m256 maximum = _mm256_set1_ps( 65504.0f);
+  const __m256 minimum = _mm256_set1_ps(-65504.0f);
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 v = _mm256_loadu_ps(src + i);
+    if (saturate)
+    {
+      v = _mm256_and_ps(v, _mm256_cmp_ps(v, v, _CMP_ORD_Q)); // NaN to zero.
+      v = _mm256_max_ps(_mm256_min_ps(v, maximum), minimum);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }
+  return i; // The scalar code handles the remainder.
+}
+
+HALF_TARGET_F16C
+static size_t halfToFloatF16C(const uint16_t* src, float* dst, const size_t count)
+{
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+  }
+  return i;
+}
+#endif
+
+bool isHalfConversionAccelerated()
+{
+#if defined(HALF_USE_F16C)
+  static const bool hasF16C = detectF16C();
+  return hasF16C;
+#else
+  return false;
+#endif
+}
+
+void floatToHalf(const float* src, uint16_t* dst, const size_t count, const bool saturate)
+{
+  const bool accelerated = isHalfConversionAccelerated();
+
+  ThreadPool::getInstance().parallelFor(0, count, HALF_GRAIN, [&](size_t first, size_t last)
+  {
+    size_t done = 0;
+#if defined(HALF_USE_F16C)
+    if (accelerated)
+    {
+      done = floatToHalfF16C(src + first, dst + first, last - first, saturate);
+    }
+#endif
+    floatToHalfScalar(src + first + done, dst + first + done, last - first - done, saturate);
+  });
+  (void) accelerated;
+}
+
+void halfToFloat(const uint16_t* src, float* dst, const size_t count)
+{
+  const bool accelerated = isHalfConversionAccelerated();
+
+  ThreadPool::getInstance().parallelFor(0, count, HALF_GRAIN, [&](size_t first, size_t last)
+  {
+    size_t done = 0;
+#if defined(HALF_USE_F16C)
+    if (accelerated)
+    {
+      done = halfToFloatF16C(src + first, dst + first, last - first);
+    }
+#endif
+    halfToFloatScalar(src + first + done, dst + first + done, last - first - done);
+  });
+  (void) accelerated;
+}
@@ -0,0 +1,171 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/Hash.h"
+#include "inc/ThreadPool.h"
+
+#include <cstring>
+#include <vector>
+
+
+static const uint64_t c_prime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t c_prime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t c_prime3 = 0x165667B19E3779F9ull;
+static const uint64_t c_prime4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t c_prime5 = 0x27D4EB2F165667C5ull;
+
+// Chunk size for the parallel hash.
+static const size_t c_chunkSize = 1 << 20;
+
+static inline uint64_t rotl(const uint64_t x, const int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+// Unaligned little-endian reads.
+static inline uint64_t read64(const unsigned char* p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(uint64_t));
+  return v;
+}
+
+static inline uint32_t read32(const unsigned char* p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(uint32_t));
+  return v;
+}
+
+static inline uint64_t round64(uint64_t acc, const uint64_t input)
+{
+  acc += input * c_prime2;
+  acc  = rotl(acc, 31);
+  return acc * c_prime1;
+}
+
+static inline uint64_t mergeRound64(uint64_t acc, const uint64_t val)
+{
+  acc ^= round64(0, val);
+  return acc * c_prime1 + c_prime4;
+}
+
+uint64_t hash64(const void* data, const size_t size, const uint64_t seed)
+{
+  const unsigned char* p   = static_cast<const unsigned char*>(data);
+  const unsigned char* end = p + size;
+
+  uint64_t h;
+
+  if (32 <= size)
+  {
+    // Four independent lanes for instruction level parallelism.
+    uint64_t v1 = seed + c_prime1 + c_prime2;
+    uint64_t v2 = seed + c_prime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - c_prime1;
+
+    const unsigned char* limit = end - 32;
+    do
+    {
+      v1 = round64(v1, read64(p));
+      v2 = round64(v2, read64(p + 8));
+      v3 = round64(v3, read64(p + 16));
+      v4 = round64(v4, read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = mergeRound64(h, v1);
+    h = mergeRound64(h, v2);
+    h = mergeRound64(h, v3);
+    h = mergeRound64(h, v4);
+  }
+  else
+  {
+    h = seed + c_prime5;
+  }
+
+  h += static_cast<uint64_t>(size);
+
+  // Tail
+  for (; p + 8 <= end; p += 8)
+  {
+    h ^= round64(0, read64(p));
+    h  = rotl(h, 27) * c_prime1 + c_prime4;
+  }
+  if (p + 4 <= end)
+  {
+    h ^= static_cast<uint64_t>(read32(p)) * c_prime1;
+    h  = rotl(h, 23) * c_prime2 + c_prime3;
+    p += 4;
+  }
+  for (; p < end; ++p)
+  {
+    h ^= static_cast<uint64_t>(*p) * c_prime5;
+    h  = rotl(h, 11) * c_prime1;
+  }
+
+  // Avalanche
+  h ^= h >> 33;
+  h *= c_prime2;
+  h ^= h >> 29;
+  h *= c_prime3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+uint64_t hash64Parallel(const void* data, const size_t size, const uint64_t seed)
+{
+  if (size <= c_chunkSize)
+  {
+    return hash64(data, size, seed);
+  }
+
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+  const size_t numChunks = (size + c_chunkSize - 1) / c_chunkSize;
+
+  std::vector<uint64_t> hashes(numChunks + 1);
+
+  ThreadPool::getInstance().parallelFor(0, numChunks, 1, [&](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+    {
+      const size_t offset = i * c_chunkSize;
+      const size_t length = (offset + c_chunkSize <= size) ? c_chunkSize : size - offset;
+
+      hashes[i] = hash64(bytes + offset, length, seed);
+    }
+  });
+
+  hashes[numChunks] = static_cast<uint64_t>(size); // Distinguish buffers with different sizes but identical chunk hashes.
+
+  return hash64(hashes.data(), hashes.size() * sizeof(uint64_t), seed);
+}
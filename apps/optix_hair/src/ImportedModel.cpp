@@ -0,0 +1,212 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/ImportedModel.h"
+
+#include "inc/SceneSnapshot.h"
+
+#include <cstring>
+#include <iostream>
+
+
+ImportedMesh::ImportedMesh()
+: hasDiffuse(false)
+, diffuse(make_float3(0.0f, 0.0f, 0.0f))
+{
+}
+
+ImportedNode::ImportedNode()
+{
+  // Identity.
+  memset(matrix, 0, sizeof(float) * 12);
+  matrix[ 0] = 1.0f;
+  matrix[ 5] = 1.0f;
+  matrix[10] = 1.0f;
+}
+
+ImportedModel::ImportedModel()
+: isCached(false)
+{
+}
+
+
+struct CachedMesh
+{
+  uint32_t hasDiffuse;
+  float    diffuse[3];
+  uint32_t bytesPerIndex; // 2 or 4
+};
+
+struct CachedMatrix
+{
+  float matrix[12];
+};
+
+bool ImportedModel::save(std::string const& filename, const uint64_t key) const
+{
+  SnapshotWriter writer(key);
+
+  writer.write<uint64_t>(meshes.size());
+  for (ImportedMesh const& mesh : meshes)
+  {
+    CachedMesh data;
+
+    data.hasDiffuse    = (mesh.hasDiffuse) ? 1 : 0;
+    data.diffuse[0]    = mesh.diffuse.x;
+    data.diffuse[1]    = mesh.diffuse.y;
+    data.diffuse[2]    = mesh.diffuse.z;
+    data.bytesPerIndex = (mesh.attributes.size() <= 0x10000) ? 2 : 4;
+
+    writer.write(data);
+    writer.writeString(mesh.material);
+    writer.writeArray(mesh.attributes);
+
+    if (data.bytesPerIndex == 2)
+    {
+      std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+      writer.writeArray(indices);
+    }
+    else
+    {
+      writer.writeArray(mesh.indices);
+    }
+  }
+
+  writer.write<uint64_t>(nodes.size());
+  for (ImportedNode const& node : nodes)
+  {
+    CachedMatrix data;
+    memcpy(data.matrix, node.matrix, sizeof(data.matrix));
+
+    writer.write(data);
+    writer.writeArray(node.meshes);
+    writer.writeArray(node.children);
+  }
+
+  return writer.save(filename);
+}
+
+bool ImportedModel::load(std::string const& filename, const uint64_t key)
+{
+  SnapshotReader reader;
+  if (!reader.open(filename, key))
+  {
+    return false;
+  }
+
+  uint64_t numMeshes = 0;
+  if (!reader.read(numMeshes))
+  {
+    return false;
+  }
+
+  // Grow the vectors per record, a corrupted count fails at the first read past the end instead of in a huge allocation.
+  meshes.clear();
+  for (uint64_t i = 0; i < numMeshes; ++i)
+  {
+    meshes.emplace_back();
+    ImportedMesh& mesh = meshes.back();
+
+    CachedMesh data;
+    if (!reader.read(data) || !reader.readString(mesh.material) || !reader.readArray(mesh.attributes) ||
+        (data.bytesPerIndex != 2 && data.bytesPerIndex != 4))
+    {
+      return false;
+    }
+
+    mesh.hasDiffuse = (data.hasDiffuse != 0);
+    mesh.diffuse    = make_float3(data.diffuse[0], data.diffuse[1], data.diffuse[2]);
+
+    if (data.bytesPerIndex == 2)
+    {
+      std::vector<uint16_t> indices;
+      if (!reader.readArray(indices))
+      {
+        return false;
+      }
+      mesh.indices.assign(indices.begin(), indices.end());
+    }
+    else if (!reader.readArray(mesh.indices))
+    {
+      return false;
+    }
+
+    // The GAS build and the shaders index the attributes without checks. Reject the file, the model is imported again.
+    if (mesh.indices.size() % 3 != 0)
+    {
+      return false;
+    }
+    const size_t numVertices = mesh.attributes.size();
+    for (const unsigned int index : mesh.indices)
+    {
+      if (numVertices <= index)
+      {
+        return false;
+      }
+    }
+  }
+
+  uint64_t numNodes = 0;
+  if (!reader.read(numNodes) || numNodes == 0)
+  {
+    return false;
+  }
+
+  nodes.clear();
+  for (uint64_t i = 0; i < numNodes; ++i)
+  {
+    nodes.emplace_back();
+    ImportedNode& node = nodes.back();
+
+    CachedMatrix data;
+    if (!reader.read(data) || !reader.readArray(node.meshes) || !reader.readArray(node.children))
+    {
+      return false;
+    }
+    memcpy(node.matrix, data.matrix, sizeof(data.matrix));
+
+    // Reject references outside the model, a root which is a child would recurse endlessly.
+    for (const unsigned int indexMesh : node.meshes)
+    {
+      if (numMeshes <= indexMesh)
+      {
+        return false;
+      }
+    }
+    for (const unsigned int indexNode : node.children)
+    {
+      if (numNodes <= indexNode || indexNode <= i)
+      {
+        return false;
+      }
+    }
+  }
+
+  isCached = true;
+  return reader.isValid();
+}
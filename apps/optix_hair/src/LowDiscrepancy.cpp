@@ -0,0 +1,247 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/LowDiscrepancy.h"
+#include "inc/MyAssert.h"
+
+#include "shaders/vector_math.h"
+#include "shaders/low_discrepancy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <random>
+
+
+// Joe-Kuo "new-joe-kuo-6.21201" parameters of the Sobol dimensions 1 to 7. Dimension 0 needs none.
+struct SobolParameters
+{
+  unsigned int s;    // Degree of the primitive polynomial.
+  unsigned int a;    // Polynomial coefficients.
+  unsigned int m[5]; // Initial direction numbers.
+};
+
+static const SobolParameters c_sobolParameters[7] =
+{
+  { 1, 0, { 1 } },
+  { 2, 1, { 1, 3 } },
+  { 3, 1, { 1, 3, 1 } },
+  { 3, 2, { 1, 1, 1 } },
+  { 4, 1, { 1, 1, 3, 3 } },
+  { 4, 4, { 1, 3, 5, 13 } },
+  { 5, 2, { 1, 1, 5, 5, 17 } }
+};
+
+
+void generateSobolMatrices(const unsigned int numDimensions, std::vector<unsigned int>& matrices)
+{
+  MY_ASSERT(0 < numDimensions && numDimensions <= 8);
+
+  matrices.resize(numDimensions * LD_SOBOL_BITS);
+
+  for (unsigned int i = 0; i < LD_SOBOL_BITS; ++i)
+  {
+    matrices[i] = 1u << (31 - i);
+  }
+
+  for (unsigned int dim = 1; dim < numDimensions; ++dim)
+  {
+    SobolParameters const& p = c_sobolParameters[dim - 1];
+
+    unsigned int* v = matrices.data() + dim * LD_SOBOL_BITS;
+
+    for (unsigned int i = 0; i < LD_SOBOL_BITS; ++i)
+    {
+      if (i < p.s)
+      {
+        v[i] = p.m[i] << (31 - i);
+      }
+      else
+      {
+        v[i] = v[i - p.s] ^ (v[i - p.s] >> p.s);
+        for (unsigned int k = 1; k < p.s; ++k)
+        {
+          v[i] ^= ((p.a >> (p.s - 1 - k)) & 1u) * v[i - k];
+        }
+      }
+    }
+  }
+}
+
+
+// Void-and-cluster (Ulichney 1993) with a toroidal Gaussian energy filter.
+// The energy of every texel is updated incrementally when a texel is toggled, which makes the generation O(n^2) in the texel count.
+void generateBlueNoise(const int size, const unsigned int seed, std::vector<float>& values)
+{
+  MY_ASSERT(0 < size && (size & (size - 1)) == 0);
+
+  const int   n     = size * size;
+  const int   mask  = size - 1;
+  const float sigma = 1.9f;
+
+  // Gaussian weight for each toroidal offset.
+  std::vector<float> gauss(n);
+  for (int y = 0; y < size; ++y)
+  {
+    const int dy = std::min(y, size - y);
+    for (int x = 0; x < size; ++x)
+    {
+      const int dx = std::min(x, size - x);
+      gauss[y * size + x] = expf(-float(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+    }
+  }
+
+  std::vector<unsigned char> pattern(n, 0);
+  std::vector<float>         energy(n, 0.0f);
+
+  auto toggle = [&](const int p, const bool set)
+  {
+    pattern[p] = (set) ? 1 : 0;
+
+    const float sign = (set) ? 1.0f : -1.0f;
+    const int   px = p & mask;
+    const int   py = p / size;
+
+    for (int y = 0; y < size; ++y)
+    {
+      const float* g = gauss.data() + ((y - py) & mask) * size;
+      float*       e = energy.data() + y * size;
+      for (int x = 0; x < size; ++x)
+      {
+        e[x] += sign * g[(x - px) & mask];
+      }
+    }
+  };
+
+  auto tightestCluster = [&]() -> int
+  {
+    int   best = -1;
+    float bestEnergy = -1.0f;
+    for (int i = 0; i < n; ++i)
+    {
+      if (pattern[i] && bestEnergy < energy[i])
+      {
+        bestEnergy = energy[i];
+        best = i;
+      }
+    }
+    return best;
+  };
+
+  auto largestVoid = [&]() -> int
+  {
+    int   best = -1;
+    float bestEnergy = 3.0e38f;
+    for (int i = 0; i < n; ++i)
+    {
+      if (!pattern[i] && energy[i] < bestEnergy)
+      {
+        bestEnergy = energy[i];
+        best = i;
+      }
+    }
+    return best;
+  };
+
+  // Initial binary pattern: 10% random ones, then relax by moving the tightest cluster into the largest void until stable.
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> distribution(0, n - 1);
+
+  const int numInitial = std::max(1, n / 10);
+  for (int count = 0; count < numInitial; )
+  {
+    const int p = distribution(generator);
+    if (!pattern[p])
+    {
+      toggle(p, true);
+      ++count;
+    }
+  }
+
+  for (int iteration = 0; iteration < n; ++iteration) // Bounded, converges much earlier.
+  {
+    const int cluster = tightestCluster();
+    toggle(cluster, false);
+    const int hole = largestVoid();
+    if (hole == cluster)
+    {
+      toggle(cluster, true);
+      break;
+    }
+    toggle(hole, true);
+  }
+
+  const std::vector<unsigned char> initialPattern = pattern;
+  const std::vector<float>         initialEnergy  = energy;
+
+  std::vector<int> rank(n, 0);
+
+  // Phase 1: Rank the initial ones by removing the tightest clusters.
+  for (int r = numInitial - 1; 0 <= r; --r)
+  {
+    const int cluster = tightestCluster();
+    toggle(cluster, false);
+    rank[cluster] = r;
+  }
+
+  // Phase 2 and 3: Fill the largest voids until all texels are set.
+  pattern = initialPattern;
+  energy  = initialEnergy;
+
+  for (int r = numInitial; r < n; ++r)
+  {
+    const int hole = largestVoid();
+    toggle(hole, true);
+    rank[hole] = r;
+  }
+
+  values.resize(n);
+  for (int i = 0; i < n; ++i)
+  {
+    values[i] = (float(rank[i]) + 0.5f) / float(n);
+  }
+}
+
+
+std::vector<unsigned int> const& getSobolMatrices()
+{
+  static std::vector<unsigned int> matrices;
+  static std::once_flag            flag;
+
+  std::call_once(flag, []() { generateSobolMatrices(LD_SOBOL_DIMENSIONS, matrices); });
+  return matrices;
+}
+
+std::vector<float> const& getBlueNoise()
+{
+  static std::vector<float> values;
+  static std::once_flag     flag;
+
+  std::call_once(flag, []() { generateBlueNoise(LD_BLUE_NOISE_SIZE, 0x5EED, values); });
+  return values;
+}
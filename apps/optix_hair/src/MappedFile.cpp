@@ -0,0 +1,164 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/MappedFile.h"
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile()
+: m_data(nullptr)
+, m_size(0)
+#if defined(_WIN32)
+, m_file(INVALID_HANDLE_VALUE)
+, m_mapping(nullptr)
+#else
+, m_file(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(std::string const& filename)
+{
+  close();
+
+#if defined(_WIN32)
+  m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+  {
+    close();
+    return false;
+  }
+
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping == nullptr)
+  {
+    close();
+    return false;
+  }
+
+  m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (m_data == nullptr)
+  {
+    close();
+    return false;
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+#else
+  m_file = ::open(filename.c_str(), O_RDONLY);
+  if (m_file < 0)
+  {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(m_file, &info) != 0 || info.st_size == 0)
+  {
+    close();
+    return false;
+  }
+
+  void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+  if (data == MAP_FAILED)
+  {
+    close();
+    return false;
+  }
+  m_data = data;
+  m_size = static_cast<size_t>(info.st_size);
+#endif
+
+  return true;
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+  if (m_data != nullptr)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping != nullptr)
+  {
+    CloseHandle(m_mapping);
+  }
+  if (m_file != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(m_file);
+  }
+  m_mapping = nullptr;
+  m_file    = INVALID_HANDLE_VALUE;
+#else
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<void*>(m_data), m_size);
+  }
+  if (0 <= m_file)
+  {
+    ::close(m_file);
+  }
+  m_file = -1;
+#endif
+
+  m_data = nullptr;
+  m_size = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+  return m_data != nullptr;
+}
+
+const void* MappedFile::getData() const
+{
+  return m_data;
+}
+
+size_t MappedFile::getSize() const
+{
+  return m_size;
+}
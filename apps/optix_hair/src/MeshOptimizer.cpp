@@ -0,0 +1,312 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/MeshOptimizer.h"
+
+#include "inc/Hash.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "inc/MyAssert.h"
+
+
+size_t weldVertices(std::vector<VertexAttributes>& attributes, std::vector<unsigned int>& indices)
+{
+  const size_t numVertices = attributes.size();
+
+  // Open addressing table of vertex indices, at most half full.
+  size_t sizeTable = 16;
+  while (sizeTable < numVertices * 2)
+  {
+    sizeTable *= 2;
+  }
+  const size_t mask = sizeTable - 1;
+
+  std::vector<unsigned int> table(sizeTable, ~0u);
+  std::vector<unsigned int> remap(numVertices);
+
+  std::vector<VertexAttributes> welded;
+  welded.reserve(numVertices);
+
+  for (size_t i = 0; i < numVertices; ++i)
+  {
+    VertexAttributes const& attrib = attributes[i];
+
+    size_t slot = static_cast<size_t>(hash64(&attrib, sizeof(VertexAttributes))) & mask;
+    while (table[slot] != ~0u && memcmp(&welded[table[slot]], &attrib, sizeof(VertexAttributes)) != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+
+    if (table[slot] == ~0u)
+    {
+      table[slot] = static_cast<unsigned int>(welded.size());
+      welded.push_back(attrib);
+    }
+    remap[i] = table[slot];
+  }
+
+  for (unsigned int& index : indices)
+  {
+    MY_ASSERT(index < numVertices);
+    index = remap[index];
+  }
+
+  const size_t numRemoved = numVertices - welded.size();
+
+  attributes.swap(welded);
+
+  return numRemoved;
+}
+
+
+// Scoring constants from the paper.
+static const int   c_cacheSize          = 32;
+static const float c_cacheDecayPower    = 1.5f;
+static const float c_lastTriangleScore  = 0.75f;
+static const float c_valenceBoostScale  = 2.0f;
+static const float c_valenceBoostPower  = 0.5f;
+
+static float getVertexScore(const int cachePosition, const unsigned int numLiveTriangles)
+{
+  if (numLiveTriangles == 0)
+  {
+    return -1.0f; // No triangle left which uses this vertex.
+  }
+
+  float score = 0.0f;
+  if (0 <= cachePosition)
+  {
+    if (cachePosition < 3)
+    {
+      // The vertices of the last triangle get a fixed score, otherwise the next triangle would depend on their order.
+      score = c_lastTriangleScore;
+    }
+    else
+    {
+      const float scaler = 1.0f / float(c_cacheSize - 3);
+      score = powf(1.0f - float(cachePosition - 3) * scaler, c_cacheDecayPower);
+    }
+  }
+
+  // Prefer vertices with few remaining triangles to get rid of lone triangles early.
+  score += c_valenceBoostScale * powf(float(numLiveTriangles), -c_valenceBoostPower);
+
+  return score;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, const size_t numVertices)
+{
+  const size_t numTriangles = indices.size() / 3;
+  if (numTriangles < 2)
+  {
+    return;
+  }
+
+  // Triangles per vertex. The live triangles of vertex v are adjacency[offsets[v] .. offsets[v] + numLive[v]).
+  // Only complete triangles are counted, trailing indices are not part of the adjacency.
+  std::vector<unsigned int> offsets(numVertices + 1, 0);
+  for (size_t i = 0; i < numTriangles * 3; ++i)
+  {
+    MY_ASSERT(indices[i] < numVertices);
+    ++offsets[indices[i] + 1];
+  }
+  for (size_t v = 0; v < numVertices; ++v)
+  {
+    offsets[v + 1] += offsets[v];
+  }
+
+  std::vector<unsigned int> numLive(numVertices);
+  for (size_t v = 0; v < numVertices; ++v)
+  {
+    numLive[v] = offsets[v + 1] - offsets[v];
+  }
+
+  std::vector<unsigned int> adjacency(numTriangles * 3);
+  {
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < numTriangles; ++t)
+    {
+      for (size_t k = 0; k < 3; ++k)
+      {
+        adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+      }
+    }
+  }
+
+  std::vector<int>   cachePosition(numVertices, -1);
+  std::vector<float> scoreVertex(numVertices);
+  for (size_t v = 0; v < numVertices; ++v)
+  {
+    scoreVertex[v] = getVertexScore(-1, numLive[v]);
+  }
+
+  std::vector<float> scoreTriangle(numTriangles);
+  for (size_t t = 0; t < numTriangles; ++t)
+  {
+    scoreTriangle[t] = scoreVertex[indices[t * 3]] + scoreVertex[indices[t * 3 + 1]] + scoreVertex[indices[t * 3 + 2]];
+  }
+
+  std::vector<bool> isEmitted(numTriangles, false);
+
+  std::vector<unsigned int> result;
+  result.reserve(indices.size());
+
+  unsigned int cache[c_cacheSize + 3];
+  int          sizeCache = 0;
+
+  size_t next = 0;          // Linear search position for the next triangle when the cache has no candidate.
+  size_t best = ~size_t(0); // Best scoring triangle using a vertex in the cache.
+
+  for (size_t numEmitted = 0; numEmitted < numTriangles; ++numEmitted)
+  {
+    if (best == ~size_t(0))
+    {
+      while (isEmitted[next])
+      {
+        ++next;
+      }
+      best = next;
+    }
+
+    const unsigned int* triangle = &indices[best * 3];
+
+    isEmitted[best] = true;
+
+    // Remove the triangle from the live triangles of its vertices.
+    for (int k = 0; k < 3; ++k)
+    {
+      const unsigned int v = triangle[k];
+      result.push_back(v);
+
+      unsigned int* live = &adjacency[offsets[v]];
+      const unsigned int last = --numLive[v];
+      for (unsigned int i = 0; i <= last; ++i)
+      {
+        if (live[i] == best)
+        {
+          live[i] = live[last];
+          break;
+        }
+      }
+    }
+
+    // The triangle's vertices move to the front of the LRU cache.
+    unsigned int cacheNew[c_cacheSize + 3];
+    int          sizeCacheNew = 0;
+
+    for (int k = 0; k < 3; ++k)
+    {
+      const unsigned int v = triangle[k];
+      if ((k < 1 || v != triangle[0]) && (k < 2 || v != triangle[1])) // Degenerate triangles repeat vertices.
+      {
+        cacheNew[sizeCacheNew++] = v;
+      }
+    }
+    for (int i = 0; i < sizeCache; ++i)
+    {
+      const unsigned int v = cache[i];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+      {
+        cacheNew[sizeCacheNew++] = v;
+      }
+    }
+
+    // Update the scores of all vertices in the cache and the ones pushed out and propagate the differences to their live triangles.
+    for (int i = 0; i < sizeCacheNew; ++i)
+    {
+      const unsigned int v = cacheNew[i];
+
+      cachePosition[v] = (i < c_cacheSize) ? i : -1;
+
+      const float score = getVertexScore(cachePosition[v], numLive[v]);
+      const float delta = score - scoreVertex[v];
+
+      scoreVertex[v] = score;
+
+      for (unsigned int j = offsets[v]; j < offsets[v] + numLive[v]; ++j)
+      {
+        scoreTriangle[adjacency[j]] += delta;
+      }
+    }
+
+    sizeCache = (sizeCacheNew < c_cacheSize) ? sizeCacheNew : c_cacheSize;
+    memcpy(cache, cacheNew, sizeof(unsigned int) * sizeCache);
+
+    // The next triangle is the best one which has a vertex in the cache.
+    best = ~size_t(0);
+
+    float scoreBest = -1.0f;
+    for (int i = 0; i < sizeCache; ++i)
+    {
+      const unsigned int v = cache[i];
+      for (unsigned int j = offsets[v]; j < offsets[v] + numLive[v]; ++j)
+      {
+        const unsigned int t = adjacency[j];
+        if (scoreBest < scoreTriangle[t])
+        {
+          scoreBest = scoreTriangle[t];
+          best      = t;
+        }
+      }
+    }
+  }
+
+  // Trailing indices of an incomplete triangle stay at the end.
+  for (size_t i = numTriangles * 3; i < indices.size(); ++i)
+  {
+    result.push_back(indices[i]);
+  }
+
+  indices.swap(result);
+}
+
+
+void optimizeVertexFetch(std::vector<VertexAttributes>& attributes, std::vector<unsigned int>& indices)
+{
+  std::vector<unsigned int> remap(attributes.size(), ~0u);
+
+  std::vector<VertexAttributes> ordered;
+  ordered.reserve(attributes.size());
+
+  for (unsigned int& index : indices)
+  {
+    MY_ASSERT(index < attributes.size());
+
+    if (remap[index] == ~0u)
+    {
+      remap[index] = static_cast<unsigned int>(ordered.size());
+      ordered.push_back(attributes[index]);
+    }
+    index = remap[index];
+  }
+
+  attributes.swap(ordered);
+}
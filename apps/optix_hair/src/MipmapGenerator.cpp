@@ -0,0 +1,691 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/MipmapGenerator.h"
+#include "inc/Picture.h"
+#include "inc/Hash.h"
+#include "inc/MappedFile.h"
+#include "inc/ThreadPool.h"
+#include "inc/Timer.h"
+#include "inc/MyAssert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define MIPMAP_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define MIPMAP_USE_SSE 0
+#endif
+
+// Increment whenever the filters or the file layout change.
+#define MIPMAP_CACHE_VERSION 2
+
+// Kaiser windowed sinc parameters. Radius in destination pixels.
+static const float c_kaiserRadius = 2.0f;
+static const float c_kaiserAlpha  = 4.0f;
+
+
+// One RGBA float pixel. Each image component occupies one lane, unused lanes are zero.
+#if MIPMAP_USE_SSE
+typedef __m128 Pixel;
+
+static inline Pixel pixelZero()
+{
+  return _mm_setzero_ps();
+}
+
+static inline Pixel pixelLoad(const float* p)
+{
+  return _mm_loadu_ps(p);
+}
+
+static inline void pixelStore(float* p, const Pixel v)
+{
+  _mm_storeu_ps(p, _mm_max_ps(v, _mm_setzero_ps())); // The sinc lobes can ring below zero.
+}
+
+static inline Pixel pixelMadd(const Pixel acc, const Pixel v, const float w)
+{
+  return _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(w)));
+}
+#else
+struct Pixel
+{
+  float v[4];
+};
+
+static inline Pixel pixelZero()
+{
+  Pixel p = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+  return p;
+}
+
+static inline Pixel pixelLoad(const float* p)
+{
+  Pixel r = { { p[0], p[1], p[2], p[3] } };
+  return r;
+}
+
+static inline void pixelStore(float* p, const Pixel v)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    p[i] = std::max(0.0f, v.v[i]);
+  }
+}
+
+static inline Pixel pixelMadd(const Pixel acc, const Pixel v, const float w)
+{
+  Pixel r;
+  for (int i = 0; i < 4; ++i)
+  {
+    r.v[i] = acc.v[i] + v.v[i] * w;
+  }
+  return r;
+}
+#endif
+
+
+// Filter taps for one axis. Each destination pixel has numTaps source indices (clamped to edge) and weights summing to one.
+struct FilterTaps
+{
+  unsigned int        numTaps;
+  std::vector<int>    index;
+  std::vector<float>  weight;
+};
+
+// Zeroth order modified Bessel function of the first kind.
+static double besselI0(const double x)
+{
+  double sum  = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; ++k)
+  {
+    const double t = x / (2.0 * k);
+    term *= t * t;
+    sum  += term;
+    if (term < sum * 1e-12)
+    {
+      break;
+    }
+  }
+  return sum;
+}
+
+static double kaiserSinc(const double t) // t in destination pixels.
+{
+  const double r = t / c_kaiserRadius;
+  if (1.0 <= std::abs(r))
+  {
+    return 0.0;
+  }
+  const double sinc   = (std::abs(t) < 1e-6) ? 1.0 : sin(M_PI * t) / (M_PI * t);
+  const double window = besselI0(c_kaiserAlpha * sqrt(1.0 - r * r)) / besselI0(c_kaiserAlpha);
+  return sinc * window;
+}
+
+static void calculateTaps(const unsigned int sizeSrc, const unsigned int sizeDst, const MipmapFilter filter, FilterTaps& taps)
+{
+  const double scale = double(sizeSrc) / double(sizeDst); // Source pixels per destination pixel, 2.0 except for odd sizes.
+
+  const double support = (filter == MIPMAP_FILTER_BOX) ? 0.5 * scale : c_kaiserRadius * scale; // Half width in source pixels.
+
+  taps.numTaps = static_cast<unsigned int>(ceil(2.0 * support)) + 1;
+  taps.index.resize(sizeDst * taps.numTaps);
+  taps.weight.resize(sizeDst * taps.numTaps);
+
+  for (unsigned int x = 0; x < sizeDst; ++x)
+  {
+    const double center = (double(x) + 0.5) * scale; // In continuous source coordinates.
+    const int    first  = static_cast<int>(floor(center - support));
+
+    double sum = 0.0;
+    for (unsigned int t = 0; t < taps.numTaps; ++t)
+    {
+      const int i = first + int(t);
+
+      double w;
+      if (filter == MIPMAP_FILTER_BOX)
+      {
+        // Overlap of the source pixel [i, i + 1) with the footprint [center - support, center + support).
+        w = std::max(0.0, std::min(double(i + 1), center + support) - std::max(double(i), center - support));
+      }
+      else
+      {
+        w = kaiserSinc((double(i) + 0.5 - center) / scale);
+      }
+
+      taps.index[x * taps.numTaps + t]  = std::min(std::max(i, 0), int(sizeSrc) - 1); // Clamp to edge.
+      taps.weight[x * taps.numTaps + t] = float(w);
+      sum += w;
+    }
+
+    for (unsigned int t = 0; t < taps.numTaps; ++t)
+    {
+      taps.weight[x * taps.numTaps + t] = float(taps.weight[x * taps.numTaps + t] / sum);
+    }
+  }
+}
+
+// Downsample the RGBA float image src (wSrc x hSrc) into dst (wDst x hDst) with the separable filter.
+static void downsample(const float* src, const unsigned int wSrc, const unsigned int hSrc,
+                       float* dst, const unsigned int wDst, const unsigned int hDst,
+                       const MipmapFilter filter, std::vector<float>& scratch)
+{
+  FilterTaps tapsX;
+  FilterTaps tapsY;
+
+  calculateTaps(wSrc, wDst, filter, tapsX);
+  calculateTaps(hSrc, hDst, filter, tapsY);
+
+  scratch.resize(size_t(wDst) * hSrc * 4);
+  float* tmp = scratch.data();
+
+  ThreadPool& pool = ThreadPool::getInstance();
+
+  // Horizontal pass over all source rows.
+  pool.parallelFor(0, hSrc, 16, [&](size_t first, size_t last)
+  {
+    for (size_t y = first; y < last; ++y)
+    {
+      const float* row = src + y * wSrc * 4;
+      float*       out = tmp + y * wDst * 4;
+
+      for (unsigned int x = 0; x < wDst; ++x)
+      {
+        const int*   index  = &tapsX.index[x * tapsX.numTaps];
+        const float* weight = &tapsX.weight[x * tapsX.numTaps];
+
+        Pixel acc = pixelZero();
+        for (unsigned int t = 0; t < tapsX.numTaps; ++t)
+        {
+          acc = pixelMadd(acc, pixelLoad(row + index[t] * 4), weight[t]);
+        }
+        pixelStore(out + x * 4, acc);
+      }
+    }
+  });
+
+  // Vertical pass into the destination rows.
+  pool.parallelFor(0, hDst, 8, [&](size_t first, size_t last)
+  {
+    for (size_t y = first; y < last; ++y)
+    {
+      const int*   index  = &tapsY.index[y * tapsY.numTaps];
+      const float* weight = &tapsY.weight[y * tapsY.numTaps];
+
+      float* out = dst + y * wDst * 4;
+
+      for (unsigned int x = 0; x < wDst; ++x)
+      {
+        Pixel acc = pixelZero();
+        for (unsigned int t = 0; t < tapsY.numTaps; ++t)
+        {
+          acc = pixelMadd(acc, pixelLoad(tmp + (size_t(index[t]) * wDst + x) * 4), weight[t]);
+        }
+        pixelStore(out + x * 4, acc);
+      }
+    }
+  });
+}
+
+
+static unsigned int numberOfComponents(const int format)
+{
+  switch (format)
+  {
+    case IL_RGB:
+    case IL_BGR:
+      return 3;
+    case IL_RGBA:
+    case IL_BGRA:
+      return 4;
+    case IL_LUMINANCE_ALPHA:
+      return 2;
+    default: // IL_LUMINANCE, IL_ALPHA
+      return 1;
+  }
+}
+
+// Returns the component index holding alpha or -1.
+static int alphaComponent(const int format)
+{
+  switch (format)
+  {
+    case IL_RGBA:
+    case IL_BGRA:
+      return 3;
+    case IL_LUMINANCE_ALPHA:
+      return 1;
+    case IL_ALPHA:
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+static float srgbToLinear(const float c)
+{
+  return (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(const float c)
+{
+  return (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// Conversion of the image components to and from the RGBA float working format.
+class PixelCodec
+{
+public:
+  PixelCodec(const int format, const int type, const bool sRGB)
+  : m_type(type)
+  , m_numComponents(numberOfComponents(format))
+  , m_alpha(alphaComponent(format))
+  , m_sRGB(sRGB && type == IL_UNSIGNED_BYTE)
+  {
+    if (m_type == IL_UNSIGNED_BYTE)
+    {
+      for (int i = 0; i < 256; ++i)
+      {
+        m_decode[i] = (m_sRGB) ? srgbToLinear(float(i) / 255.0f) : float(i) / 255.0f;
+      }
+      if (m_sRGB)
+      {
+        // Linear to sRGB via table. 16K entries keep the error below a quarter 8-bit step in the darks.
+        m_encode.resize(c_encodeSize);
+        for (unsigned int i = 0; i < c_encodeSize; ++i)
+        {
+          m_encode[i] = static_cast<unsigned char>(linearToSrgb(float(i) / float(c_encodeSize - 1)) * 255.0f + 0.5f);
+        }
+      }
+    }
+  }
+
+  static bool isSupported(const int type)
+  {
+    return type == IL_UNSIGNED_BYTE || type == IL_UNSIGNED_SHORT || type == IL_FLOAT;
+  }
+
+  void decode(const void* pixels, float* rgba, const size_t count) const
+  {
+    ThreadPool::getInstance().parallelFor(0, count, 65536, [&](size_t first, size_t last)
+    {
+      for (size_t i = first; i < last; ++i)
+      {
+        float* out = rgba + i * 4;
+        out[0] = out[1] = out[2] = out[3] = 0.0f;
+
+        for (unsigned int c = 0; c < m_numComponents; ++c)
+        {
+          const size_t j = i * m_numComponents + c;
+          switch (m_type)
+          {
+            case IL_UNSIGNED_BYTE:
+            {
+              const unsigned char v = static_cast<const unsigned char*>(pixels)[j];
+              out[c] = (int(c) == m_alpha) ? float(v) / 255.0f : m_decode[v];
+              break;
+            }
+            case IL_UNSIGNED_SHORT:
+              out[c] = float(static_cast<const unsigned short*>(pixels)[j]) / 65535.0f;
+              break;
+            default: // IL_FLOAT
+              out[c] = static_cast<const float*>(pixels)[j];
+              break;
+          }
+        }
+      }
+    });
+  }
+
+  void encode(const float* rgba, void* pixels, const size_t count) const
+  {
+    ThreadPool::getInstance().parallelFor(0, count, 65536, [&](size_t first, size_t last)
+    {
+      for (size_t i = first; i < last; ++i)
+      {
+        const float* in = rgba + i * 4;
+
+        for (unsigned int c = 0; c < m_numComponents; ++c)
+        {
+          const size_t j = i * m_numComponents + c;
+          switch (m_type)
+          {
+            case IL_UNSIGNED_BYTE:
+            {
+              // Clamp on both sides, a value below zero would index outside the sRGB table. NaN maps to zero.
+              const float v = std::max(0.0f, std::min(in[c], 1.0f));
+              static_cast<unsigned char*>(pixels)[j] = (m_sRGB && int(c) != m_alpha)
+                                                      ? m_encode[static_cast<unsigned int>(v * float(c_encodeSize - 1) + 0.5f)]
+                                                      : static_cast<unsigned char>(v * 255.0f + 0.5f);
+              break;
+            }
+            case IL_UNSIGNED_SHORT:
+              static_cast<unsigned short*>(pixels)[j] = static_cast<unsigned short>(std::max(0.0f, std::min(in[c], 1.0f)) * 65535.0f + 0.5f);
+              break;
+            default: // IL_FLOAT
+              static_cast<float*>(pixels)[j] = in[c];
+              break;
+          }
+        }
+      }
+    });
+  }
+
+private:
+  static const unsigned int c_encodeSize = 16384;
+
+  int          m_type;
+  unsigned int m_numComponents;
+  int          m_alpha;
+  bool         m_sRGB;
+
+  float                      m_decode[256];
+  std::vector<unsigned char> m_encode;
+};
+
+
+// The mipmap cache file starts with this header, followed by the pixels of the levels 1 to numLevels - 1.
+struct MipmapCacheHeader
+{
+  char         magic[8]; // "MIPCACHE"
+  unsigned int version;
+  unsigned int width;
+  unsigned int height;
+  int          format;
+  int          type;
+  unsigned int filter;
+  unsigned int sRGB;
+  unsigned int numLevels;
+  uint64_t     hash;
+};
+
+static const char c_mipmapMagic[8] = { 'M', 'I', 'P', 'C', 'A', 'C', 'H', 'E' };
+
+static void nextExtents(unsigned int& w, unsigned int& h)
+{
+  w = std::max(1u, w >> 1);
+  h = std::max(1u, h >> 1);
+}
+
+static bool loadMipmapCache(std::string const& filename, MipmapCacheHeader const& key, Picture* picture, const unsigned int indexImage)
+{
+  MappedFile file;
+  if (!file.open(filename) || file.getSize() < sizeof(MipmapCacheHeader))
+  {
+    return false;
+  }
+
+  const MipmapCacheHeader* header = static_cast<const MipmapCacheHeader*>(file.getData());
+
+  if (memcmp(header->magic, key.magic, sizeof(c_mipmapMagic)) != 0 ||
+      header->version   != key.version ||
+      header->width     != key.width ||
+      header->height    != key.height ||
+      header->format    != key.format ||
+      header->type      != key.type ||
+      header->filter    != key.filter ||
+      header->sRGB      != key.sRGB ||
+      header->numLevels != key.numLevels ||
+      header->hash      != key.hash)
+  {
+    return false;
+  }
+
+  // Validate the size before adding any level.
+  size_t size = sizeof(MipmapCacheHeader);
+
+  unsigned int w = key.width;
+  unsigned int h = key.height;
+  for (unsigned int level = 1; level < key.numLevels; ++level)
+  {
+    nextExtents(w, h);
+    size += Image(w, h, 1, key.format, key.type).m_nob;
+  }
+  if (size != file.getSize())
+  {
+    return false;
+  }
+
+  const unsigned char* p = static_cast<const unsigned char*>(file.getData()) + sizeof(MipmapCacheHeader);
+
+  w = key.width;
+  h = key.height;
+  for (unsigned int level = 1; level < key.numLevels; ++level)
+  {
+    nextExtents(w, h);
+    picture->addLevel(indexImage, p, w, h, 1, key.format, key.type);
+    p += picture->getImageLevel(indexImage, level)->m_nob;
+  }
+  return true;
+}
+
+static void saveMipmapCache(std::string const& filename, MipmapCacheHeader const& header, const Picture* picture, const unsigned int indexImage)
+{
+  // Write to a temporary file first. Concurrent readers never see a partially written cache.
+  const std::string filenameTemp = filename + std::string(".tmp");
+  {
+    std::ofstream output(filenameTemp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+      std::cerr << "WARNING: generateMipmaps() cannot write " << filenameTemp << '\n';
+      return;
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(MipmapCacheHeader));
+    for (unsigned int level = 1; level < header.numLevels; ++level)
+    {
+      const Image* image = picture->getImageLevel(indexImage, level);
+      output.write(reinterpret_cast<const char*>(image->m_pixels), image->m_nob);
+    }
+
+    if (!output)
+    {
+      std::cerr << "WARNING: generateMipmaps() failed writing " << filenameTemp << '\n';
+      output.close();
+      std::remove(filenameTemp.c_str());
+      return;
+    }
+  }
+
+  std::remove(filename.c_str()); // rename() does not replace existing files on Windows.
+  if (std::rename(filenameTemp.c_str(), filename.c_str()) != 0)
+  {
+    std::cerr << "WARNING: generateMipmaps() cannot rename " << filenameTemp << " to " << filename << '\n';
+    std::remove(filenameTemp.c_str());
+  }
+}
+
+
+unsigned int generateMipmaps(Picture* picture, const unsigned int indexImage, const MipmapFilter filter, const bool sRGB, std::string const& cacheFilename)
+{
+  MY_ASSERT(indexImage < picture->getNumberOfImages());
+
+  if (picture->getNumberOfLevels(indexImage) != 1) // Keep mipmaps provided by the file.
+  {
+    return picture->getNumberOfLevels(indexImage);
+  }
+
+  const Image* image = picture->getImageLevel(indexImage, 0);
+
+  if (image->m_depth != 1 || !PixelCodec::isSupported(image->m_type))
+  {
+    return 0;
+  }
+
+  const int          format = image->m_format;
+  const int          type   = image->m_type;
+  const unsigned int width  = image->m_width;
+  const unsigned int height = image->m_height;
+
+  unsigned int numLevels = 1;
+  for (unsigned int w = width, h = height; 1 < w || 1 < h; nextExtents(w, h))
+  {
+    ++numLevels;
+  }
+
+  if (numLevels == 1)
+  {
+    return 1;
+  }
+
+  MipmapCacheHeader header;
+  memset(&header, 0, sizeof(MipmapCacheHeader));
+
+  if (!cacheFilename.empty())
+  {
+    memcpy(header.magic, c_mipmapMagic, sizeof(c_mipmapMagic));
+    header.version   = MIPMAP_CACHE_VERSION;
+    header.width     = width;
+    header.height    = height;
+    header.format    = format;
+    header.type      = type;
+    header.filter    = static_cast<unsigned int>(filter);
+    header.sRGB      = (sRGB) ? 1 : 0;
+    header.numLevels = numLevels;
+    header.hash      = hash64Parallel(image->m_pixels, image->m_nob);
+
+    if (loadMipmapCache(cacheFilename, header, picture, indexImage))
+    {
+      return numLevels;
+    }
+  }
+
+  const PixelCodec codec(format, type, sRGB);
+
+  std::vector<float> src(size_t(width) * height * 4);
+  std::vector<float> dst;
+  std::vector<float> scratch;
+  std::vector<unsigned char> pixels;
+
+  codec.decode(image->m_pixels, src.data(), size_t(width) * height);
+
+  // Each level is filtered from the previous level in full float precision.
+  unsigned int w = width;
+  unsigned int h = height;
+  for (unsigned int level = 1; level < numLevels; ++level)
+  {
+    unsigned int wNext = w;
+    unsigned int hNext = h;
+    nextExtents(wNext, hNext);
+
+    dst.resize(size_t(wNext) * hNext * 4);
+    downsample(src.data(), w, h, dst.data(), wNext, hNext, filter, scratch);
+
+    pixels.resize(Image(wNext, hNext, 1, format, type).m_nob);
+    codec.encode(dst.data(), pixels.data(), size_t(wNext) * hNext);
+
+    picture->addLevel(indexImage, pixels.data(), wNext, hNext, 1, format, type);
+
+    src.swap(dst);
+    w = wNext;
+    h = hNext;
+  }
+
+  if (!cacheFilename.empty())
+  {
+    saveMipmapCache(cacheFilename, header, picture, indexImage);
+  }
+
+  return numLevels;
+}
+
+void benchmarkMipmaps(const unsigned int size)
+{
+  struct Case
+  {
+    const char*  name;
+    int          type;
+    bool         sRGB;
+    MipmapFilter filter;
+  };
+
+  const Case cases[6] =
+  {
+    { "RGBA8 sRGB, box",      IL_UNSIGNED_BYTE, true,  MIPMAP_FILTER_BOX    },
+    { "RGBA8 sRGB, Kaiser",   IL_UNSIGNED_BYTE, true,  MIPMAP_FILTER_KAISER },
+    { "RGBA8 linear, box",    IL_UNSIGNED_BYTE, false, MIPMAP_FILTER_BOX    },
+    { "RGBA8 linear, Kaiser", IL_UNSIGNED_BYTE, false, MIPMAP_FILTER_KAISER },
+    { "RGBA32F, box",         IL_FLOAT,         false, MIPMAP_FILTER_BOX    },
+    { "RGBA32F, Kaiser",      IL_FLOAT,         false, MIPMAP_FILTER_KAISER }
+  };
+
+  const size_t numPixels = size_t(size) * size;
+
+  // Smooth gradients plus a high frequency checker, so the filters do real work on all channels.
+  std::vector<float> floats(numPixels * 4);
+  std::vector<unsigned char> bytes(numPixels * 4);
+  for (size_t i = 0; i < numPixels; ++i)
+  {
+    const unsigned int x = static_cast<unsigned int>(i % size);
+    const unsigned int y = static_cast<unsigned int>(i / size);
+
+    floats[i * 4    ] = float(x) / float(size);
+    floats[i * 4 + 1] = float(y) / float(size);
+    floats[i * 4 + 2] = float((x ^ y) & 1);
+    floats[i * 4 + 3] = 1.0f;
+  }
+  for (size_t i = 0; i < floats.size(); ++i)
+  {
+    bytes[i] = static_cast<unsigned char>(floats[i] * 255.0f + 0.5f);
+  }
+
+  const double megapixels = double(numPixels) * 1.0e-6;
+
+  std::cout << "benchmarkMipmaps(): " << size << " x " << size << ", " << ThreadPool::getInstance().getNumThreads() << " threads\n";
+
+  for (Case const& c : cases)
+  {
+    // Best of three, each run on a fresh Picture because the levels are appended.
+    double best = 0.0;
+    unsigned int numLevels = 0;
+
+    for (int run = 0; run < 3; ++run)
+    {
+      Picture picture;
+      const unsigned int index = picture.addImages((c.type == IL_FLOAT) ? static_cast<const void*>(floats.data()) : static_cast<const void*>(bytes.data()),
+                                                   size, size, 1, IL_RGBA, c.type, std::vector<const void*>(), IMAGE_FLAG_2D);
+      Timer timer;
+      timer.start();
+      numLevels = generateMipmaps(&picture, index, c.filter, c.sRGB);
+      timer.stop();
+
+      best = (run == 0) ? timer.getTime() : std::min(best, timer.getTime());
+    }
+
+    std::cout << "  " << c.name << ": " << numLevels << " levels in " << best * 1000.0 << " ms (" << best * 1000.0 / megapixels << " ms/MP)\n";
+  }
+}
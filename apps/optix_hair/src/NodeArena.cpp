@@ -0,0 +1,102 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/NodeArena.h"
+
+#include "inc/MyAssert.h"
+
+namespace sg
+{
+  // ========== NodeArena
+  NodeArena::NodeArena(const size_t sizeBlock)
+  : m_enabled(true)
+  , m_blocks(new Blocks(sizeBlock))
+  {
+  }
+
+  NodeArena::~NodeArena()
+  {
+    m_blocks->release(); // Nodes which are still alive keep the blocks.
+  }
+
+  void NodeArena::setEnabled(const bool enabled)
+  {
+    m_enabled = enabled;
+  }
+
+  bool NodeArena::isEnabled() const
+  {
+    return m_enabled;
+  }
+
+  size_t NodeArena::getNumBytes() const
+  {
+    return m_blocks->m_numBytes;
+  }
+
+  // ========== NodeArena::Blocks
+  NodeArena::Blocks::Blocks(const size_t sizeBlock)
+  : m_sizeBlock(sizeBlock)
+  , m_sizeCurrent(0)
+  , m_offset(0) // The first allocation creates the first block.
+  , m_numBytes(0)
+  , m_refCount(1) // The arena.
+  {
+  }
+
+  void* NodeArena::Blocks::allocate(const size_t size, const size_t alignment)
+  {
+    MY_ASSERT(alignment <= alignof(std::max_align_t));
+
+    size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+
+    if (m_sizeCurrent < offset + size)
+    {
+      // Oversized requests get a block of their own.
+      m_sizeCurrent = (m_sizeBlock < size) ? size : m_sizeBlock;
+      m_blocks.push_back(std::unique_ptr<char[]>(new char[m_sizeCurrent]));
+      offset = 0;
+    }
+
+    m_offset    = offset + size;
+    m_numBytes += size;
+
+    m_refCount.fetch_add(1, std::memory_order_relaxed);
+
+    return m_blocks.back().get() + offset;
+  }
+
+  void NodeArena::Blocks::release()
+  {
+    if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      delete this;
+    }
+  }
+
+} // namespace sg
@@ -31,11 +31,14 @@
 
 
 #include "inc/Picture.h"
+#include "inc/MipmapGenerator.h"
+#include "inc/ThreadPool.h"
 
 #include <algorithm>
 #include <cctype>
 #include <cstring>
 #include <iostream>
+#include <limits>
 
 #include "inc/MyAssert.h"
 
@@ -171,6 +174,17 @@ bool Picture::isCubemap() const
   return m_isCube;
 }
 
+std::mutex& getMutexDevIL()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::string const& Picture::getFilename() const
+{
+  return m_filename;
+}
+
 void Picture::setIsCubemap(const bool isCube)
 {
   m_isCube = isCube;
@@ -233,6 +247,7 @@ bool Picture::load(std::string const& filename, const unsigned int flags)
   bool success = false;
 
   clearImages(); // Each load() wipes previously loaded image data.
+  m_filename.clear();
 
   std::string foundFile = filename; // FIXME Search at least the current working directory.
   if (foundFile.empty())
@@ -503,6 +518,22 @@ bool Picture::load(std::string const& filename, const unsigned int flags)
         }
       }
     }
+
+    // Generate the missing mipmap chains of 2D and cubemap images. Layered images and 3D images are left alone.
+    if ((flags & IMAGE_FLAG_MIPMAP) && (flags & (IMAGE_FLAG_2D | IMAGE_FLAG_CUBE)) && !(flags & (IMAGE_FLAG_LAYER | IMAGE_FLAG_ENV)))
+    {
+      const MipmapFilter filter = (flags & IMAGE_FLAG_KAISER) ? MIPMAP_FILTER_KAISER : MIPMAP_FILTER_BOX;
+      const bool         sRGB   = (flags & IMAGE_FLAG_SRGB) != 0;
+
+      for (unsigned int index = 0; index < getNumberOfImages(); ++index)
+      {
+        const std::string cacheFilename = (index == 0) ? filename + std::string(".mipcache")
+                                                       : filename + std::string(".") + std::to_string(index) + std::string(".mipcache");
+        generateMipmaps(this, index, filter, sRGB, cacheFilename);
+      }
+    }
+
+    m_filename = filename;
     success = true;
   }
 
@@ -650,6 +681,125 @@ void Picture::mirrorY(unsigned int index)
 }
 
 
+// Reorder or expand the components of count pixels to RGBA. Missing color components are zero, missing alpha is the type's maximum.
+template<typename T>
+static void expandToRGBA(const T* src, T* dst, const size_t count, const int format)
+{
+  const T one = (std::numeric_limits<T>::is_integer) ? std::numeric_limits<T>::max() : T(1);
+
+  for (size_t i = 0; i < count; ++i, dst += 4)
+  {
+    switch (format)
+    {
+      case IL_RGB:
+        dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = one;
+        src += 3;
+        break;
+      case IL_BGR:
+        dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0]; dst[3] = one;
+        src += 3;
+        break;
+      case IL_BGRA:
+        dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0]; dst[3] = src[3];
+        src += 4;
+        break;
+      case IL_LUMINANCE:
+        dst[0] = src[0]; dst[1] = src[0]; dst[2] = src[0]; dst[3] = one;
+        src += 1;
+        break;
+      case IL_ALPHA:
+        dst[0] = T(0); dst[1] = T(0); dst[2] = T(0); dst[3] = src[0];
+        src += 1;
+        break;
+      case IL_LUMINANCE_ALPHA:
+        dst[0] = src[0]; dst[1] = src[0]; dst[2] = src[0]; dst[3] = src[1];
+        src += 2;
+        break;
+    }
+  }
+}
+
+template<typename T>
+static void expandImageToRGBA(const Image* image, unsigned char* pixels)
+{
+  const size_t numPixels = size_t(image->m_width) * image->m_height * image->m_depth;
+  const size_t numSrc    = image->m_bpp / sizeof(T);
+
+  ThreadPool::getInstance().parallelFor(0, numPixels, 65536, [&](size_t first, size_t last)
+  {
+    expandToRGBA<T>(reinterpret_cast<const T*>(image->m_pixels) + first * numSrc,
+                    reinterpret_cast<T*>(pixels) + first * 4,
+                    last - first, image->m_format);
+  });
+}
+
+void Picture::convertToRGBA()
+{
+  for (size_t index = 0; index < m_images.size(); ++index)
+  {
+    for (size_t level = 0; level < m_images[index].size(); ++level)
+    {
+      Image* image = m_images[index][level];
+
+      if (image->m_format == IL_RGBA)
+      {
+        continue;
+      }
+
+      Image rgba(image->m_width, image->m_height, image->m_depth, IL_RGBA, image->m_type);
+
+      unsigned char* pixels = new unsigned char[rgba.m_nob];
+
+      switch (image->m_type)
+      {
+        case IL_BYTE:
+          expandImageToRGBA<char>(image, pixels);
+          break;
+        case IL_UNSIGNED_BYTE:
+          expandImageToRGBA<unsigned char>(image, pixels);
+          break;
+        case IL_SHORT:
+          expandImageToRGBA<short>(image, pixels);
+          break;
+        case IL_UNSIGNED_SHORT:
+          expandImageToRGBA<unsigned short>(image, pixels);
+          break;
+        case IL_INT:
+          expandImageToRGBA<int>(image, pixels);
+          break;
+        case IL_UNSIGNED_INT:
+          expandImageToRGBA<unsigned int>(image, pixels);
+          break;
+        case IL_FLOAT:
+          expandImageToRGBA<float>(image, pixels);
+          break;
+      }
+
+      delete[] image->m_pixels;
+      image->m_pixels = pixels;
+      image->m_format = IL_RGBA;
+      image->m_bpp    = rgba.m_bpp;
+      image->m_bpl    = rgba.m_bpl;
+      image->m_bps    = rgba.m_bps;
+      image->m_nob    = rgba.m_nob;
+    }
+  }
+}
+
+size_t Picture::getMemorySize() const
+{
+  size_t size = 0;
+  for (size_t index = 0; index < m_images.size(); ++index)
+  {
+    for (size_t level = 0; level < m_images[index].size(); ++level)
+    {
+      size += m_images[index][level]->m_nob;
+    }
+  }
+  return size;
+}
+
+
 // DEBUG
 void Picture::generateRGBA8(unsigned int width, unsigned int height, unsigned int depth, const unsigned int flags)
 {
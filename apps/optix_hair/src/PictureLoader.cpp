@@ -0,0 +1,326 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/PictureLoader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "inc/MyAssert.h"
+
+
+PictureLoader::PictureLoader(const unsigned int numThreads, const size_t budget)
+: m_stop(false)
+, m_numActive(0)
+, m_budget(budget)
+, m_cacheSize(0)
+{
+  const unsigned int count = std::max(1u, numThreads);
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    m_threads.emplace_back(&PictureLoader::worker, this);
+  }
+}
+
+PictureLoader::~PictureLoader()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_queue.clear();
+  }
+  m_conditionWork.notify_all();
+
+  for (std::thread& thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+std::string PictureLoader::makeKey(std::string const& filename, const unsigned int flags)
+{
+  std::ostringstream key;
+  key << filename << '|' << flags; // Different flags produce different mipmaps or layers.
+  return key.str();
+}
+
+void PictureLoader::loadAsync(std::string const& filename, const unsigned int flags, Callback const& callback)
+{
+  const std::string key = makeKey(filename, flags);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::shared_ptr<Picture> picture = findCached(key);
+    if (picture)
+    {
+      Completed completed;
+      completed.picture = picture;
+      completed.callbacks.push_back(callback);
+      m_completed.push_back(completed);
+      return;
+    }
+
+    std::map<std::string, Request*>::iterator itInFlight = m_inFlight.find(key);
+    if (itInFlight != m_inFlight.end())
+    {
+      itInFlight->second->callbacks.push_back(callback);
+      return;
+    }
+
+    for (Request& request : m_queue)
+    {
+      if (request.key == key)
+      {
+        request.callbacks.push_back(callback);
+        return;
+      }
+    }
+
+    Request request;
+    request.key      = key;
+    request.filename = filename;
+    request.flags    = flags;
+    request.callbacks.push_back(callback);
+    m_queue.push_back(request);
+  }
+  m_conditionWork.notify_one();
+}
+
+std::shared_ptr<Picture> PictureLoader::load(std::string const& filename, const unsigned int flags)
+{
+  const std::string key = makeKey(filename, flags);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::shared_ptr<Picture> picture = findCached(key);
+    if (picture)
+    {
+      return picture;
+    }
+  }
+
+  std::shared_ptr<Picture> picture = decode(filename, flags);
+
+  if (picture)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    insertCached(key, picture);
+  }
+  return picture;
+}
+
+unsigned int PictureLoader::dispatchCompleted()
+{
+  std::vector<Completed> completed;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    completed.swap(m_completed);
+  }
+
+  // Run the callbacks without holding the lock. They may issue new requests.
+  unsigned int count = 0;
+  for (Completed const& c : completed)
+  {
+    for (Callback const& callback : c.callbacks)
+    {
+      callback(c.picture);
+      ++count;
+    }
+  }
+  return count;
+}
+
+void PictureLoader::wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_conditionIdle.wait(lock, [this] { return m_queue.empty() && m_numActive == 0; });
+}
+
+bool PictureLoader::isBusy() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return !m_queue.empty() || m_numActive != 0 || !m_completed.empty();
+}
+
+void PictureLoader::setBudget(const size_t budget)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_budget = budget;
+  evict();
+}
+
+size_t PictureLoader::getBudget() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_budget;
+}
+
+size_t PictureLoader::getCacheSize() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cacheSize;
+}
+
+void PictureLoader::clear()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_queue.clear();
+  
+  // Requests being decoded drop their callbacks. Their Pictures still end up in the cache.
+  for (std::map<std::string, Request*>::iterator it = m_inFlight.begin(); it != m_inFlight.end(); ++it)
+  {
+    it->second->callbacks.clear();
+  }
+  m_conditionIdle.wait(lock, [this] { return m_numActive == 0; });
+
+  m_completed.clear();
+  m_cache.clear();
+  m_lru.clear();
+  m_cacheSize = 0;
+}
+
+
+std::shared_ptr<Picture> PictureLoader::decode(std::string const& filename, const unsigned int flags)
+{
+  std::shared_ptr<Picture> picture = std::make_shared<Picture>();
+
+  bool success;
+  {
+    // DevIL keeps global state, only one thread may use it at a time.
+    // The orientation fixes and the mipmap generation inside load() are serialized as well, but use the ThreadPool internally.
+    std::lock_guard<std::mutex> lock(getMutexDevIL());
+    success = picture->load(filename, flags);
+  }
+
+  if (!success)
+  {
+    std::cerr << "ERROR: PictureLoader::decode() failed to load " << filename << '\n';
+    return std::shared_ptr<Picture>();
+  }
+
+  // Done here, concurrently with the next decode, the conversions in Texture::create() turn into plain copies.
+  picture->convertToRGBA();
+
+  return picture;
+}
+
+std::shared_ptr<Picture> PictureLoader::findCached(std::string const& key)
+{
+  std::map<std::string, CacheEntry>::iterator it = m_cache.find(key);
+  if (it == m_cache.end())
+  {
+    return std::shared_ptr<Picture>();
+  }
+
+  // Move to the front of the LRU list.
+  m_lru.splice(m_lru.begin(), m_lru, it->second.itLRU);
+
+  return it->second.picture;
+}
+
+void PictureLoader::insertCached(std::string const& key, std::shared_ptr<Picture> const& picture)
+{
+  std::map<std::string, CacheEntry>::iterator it = m_cache.find(key);
+  if (it != m_cache.end()) // Concurrent blocking load() of the same file.
+  {
+    m_cacheSize -= it->second.size;
+    m_lru.erase(it->second.itLRU);
+    m_cache.erase(it);
+  }
+
+  m_lru.push_front(key);
+
+  CacheEntry& entry = m_cache[key];
+  entry.picture = picture;
+  entry.size    = picture->getMemorySize();
+  entry.itLRU   = m_lru.begin();
+
+  m_cacheSize += entry.size;
+
+  evict();
+}
+
+void PictureLoader::evict()
+{
+  // Always keep the most recently used Picture, even when it alone exceeds the budget.
+  while (m_budget < m_cacheSize && 1 < m_lru.size())
+  {
+    std::map<std::string, CacheEntry>::iterator it = m_cache.find(m_lru.back());
+    MY_ASSERT(it != m_cache.end());
+
+    m_cacheSize -= it->second.size;
+    m_cache.erase(it);
+    m_lru.pop_back();
+  }
+}
+
+void PictureLoader::worker()
+{
+  while (true)
+  {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_conditionWork.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+      if (m_stop)
+      {
+        return;
+      }
+      request = m_queue.front();
+      m_queue.pop_front();
+      m_inFlight[request.key] = &request; // Further requests of this key attach their callbacks here.
+      ++m_numActive;
+    }
+
+    std::shared_ptr<Picture> picture = decode(request.filename, request.flags);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      m_inFlight.erase(request.key);
+      
+      if (picture)
+      {
+        insertCached(request.key, picture);
+      }
+      if (!request.callbacks.empty())
+      {
+        Completed completed;
+        completed.picture   = picture;
+        completed.callbacks = request.callbacks;
+        m_completed.push_back(completed);
+      }
+      --m_numActive;
+    }
+    m_conditionIdle.notify_all();
+  }
+}
@@ -444,6 +444,15 @@ unsigned int Rasterizer::getPixelBufferObject() const
   return m_pbo;
 }
 
+void Rasterizer::setDisplayImage(const float* rgba)
+{
+  // Only the texel data changes. The texture has been sized by the Device::updateDisplayTexture() call before
+  // and must not be reallocated while it's registered with CUDA in interop mode INTEROP_MODE_TEX.
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_hdrTexture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei) m_widthResolution, (GLsizei) m_heightResolution, GL_RGBA, GL_FLOAT, rgba);
+}
+
 void Rasterizer::setResolution(const int w, const int h)
 {
   if (m_widthResolution != w || m_heightResolution != h)
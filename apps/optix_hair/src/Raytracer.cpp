@@ -309,12 +309,14 @@ void Raytracer::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
   }
 }
 
-// Traverse the SceneGraph and store Groups, Instances and Triangles nodes in the raytracer representation.
+// Flatten the SceneGraph once and let all devices build their acceleration structures from the compiled result.
 void Raytracer::initScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries)
 {
+  m_compiledScene.compile(root, numGeometries);
+
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
-    m_activeDevices[i]->initScene(root, numGeometries);
+    m_activeDevices[i]->initScene(m_compiledScene);
   }
 }
 
@@ -355,6 +357,22 @@ void Raytracer::updateMaterial(const int idMaterial, MaterialGUI const& material
   m_iterationIndex = 0; // Restart accumulation.
 }
 
+void Raytracer::updateScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries)
+{
+  const SceneDiff diff = m_compiledScene.update(root, numGeometries);
+
+  if (diff.isEmpty())
+  {
+    return;
+  }
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    m_activeDevices[i]->updateScene(m_compiledScene, diff);
+  }
+  m_iterationIndex = 0; // Restart accumulation.
+}
+
 void Raytracer::updateState(DeviceState const& state)
 {
   m_samplesPerPixel = (unsigned int)(state.samplesSqrt * state.samplesSqrt);
@@ -29,6 +29,7 @@
 #include "shaders/config.h"
 
 #include "inc/SceneGraph.h"
+#include "inc/SceneSnapshot.h"
 
 #include <cstring>
 #include <iostream>
@@ -39,8 +40,11 @@
 namespace sg
 {
   // ========== Node
-  Node::Node(const unsigned int id)
+  Node::Node(const unsigned int id, const sg::NodeType type)
   : m_id(id)
+  , m_type(type)
+  , activated(true)
+  , m_changes(CHANGE_NONE)
   {
   }
 
@@ -50,7 +54,7 @@ namespace sg
 
   // ========== Group
   Group::Group(const unsigned int id)
-  : Node(id)
+  : Node(id, NT_GROUP)
   {
   }
 
@@ -58,14 +62,10 @@ namespace sg
   //{
   //}
 
-  sg::NodeType Group::getType() const
-  {
-    return NT_GROUP;
-  }
-
   void Group::addChild(std::shared_ptr<sg::Instance> instance)
   {
     m_children.push_back(instance);
+    setChanged(CHANGE_CHILD);
   }
 
   void Group::removeCurvesChild()
@@ -75,6 +75,7 @@ namespace sg
           if (m_children[i]->getType() == sg::NodeType::NT_INSTANCE && m_children[i]->getChild()->getType() == sg::NodeType::NT_CURVES)
           {
               m_children.erase(m_children.begin()+i);
+              setChanged(CHANGE_CHILD);
               removeCurvesChild();
               break;
           }
@@ -87,7 +88,7 @@ namespace sg
     return m_children.size();
   }
 
-  std::shared_ptr<sg::Instance> Group::getChild(const size_t index)
+  std::shared_ptr<sg::Instance> const& Group::getChild(const size_t index) const
   {
     MY_ASSERT(index < m_children.size());
     return m_children[index];
@@ -96,7 +97,7 @@ namespace sg
 
   // ========== Instance
   Instance::Instance(const unsigned int id)
-  : Node(id)
+  : Node(id, NT_INSTANCE)
   , m_material(-1) // No material index set by default. Last one >= 0 along a path wins.
   , m_light(-1)    // No light index set by default. Not a light.
   {
@@ -111,14 +112,10 @@ namespace sg
   //{
   //}
 
-  sg::NodeType Instance::getType() const
-  {
-    return NT_INSTANCE;
-  }
-
   void Instance::setTransform(const float m[12])
   {
     memcpy(m_matrix, m, sizeof(float) * 12);
+    setChanged(CHANGE_TRANSFORM);
   }
 
   const float* Instance::getTransform() const
@@ -129,9 +126,10 @@ namespace sg
   void Instance::setChild(std::shared_ptr<sg::Node> node) // Instances can hold all other groups.
   {
     m_child = node;
+    setChanged(CHANGE_CHILD);
   }
 
-  std::shared_ptr<sg::Node> Instance::getChild()
+  std::shared_ptr<sg::Node> const& Instance::getChild() const
   {
     return m_child;
   }
@@ -139,6 +137,7 @@ namespace sg
   void Instance::setMaterial(const int index)
   {
     m_material = index;
+    setChanged(CHANGE_MATERIAL);
   }
 
   int Instance::getMaterial() const
@@ -149,6 +148,7 @@ namespace sg
   void Instance::setLight(const int index)
   {
     m_light = index;
+    setChanged(CHANGE_LIGHT);
   }
 
   int Instance::getLight() const
@@ -158,7 +158,7 @@ namespace sg
 
   // ========== Triangles
   Triangles::Triangles(const unsigned int id)
-  : Node(id)
+  : Node(id, NT_TRIANGLES)
   {
   }
 
@@ -166,16 +166,12 @@ namespace sg
   //{
   //}
 
-  sg::NodeType Triangles::getType() const
-  {
-    return NT_TRIANGLES;
-  }
-
 
   void Triangles::setAttributes(std::vector<VertexAttributes> const& attributes)
   {
     m_attributes.resize(attributes.size());
     memcpy(m_attributes.data(), attributes.data(), sizeof(VertexAttributes) * attributes.size());
+    setChanged(CHANGE_GEOMETRY);
   }
 
   std::vector<VertexAttributes> const& Triangles::getAttributes() const
@@ -187,6 +183,7 @@ namespace sg
   {
     m_indices.resize(indices.size());
     memcpy(m_indices.data(), indices.data(), sizeof(unsigned int) * indices.size());
+    setChanged(CHANGE_GEOMETRY);
   }
   
   std::vector<unsigned int> const& Triangles::getIndices() const
@@ -194,5 +191,16 @@ namespace sg
     return m_indices;
   }
 
+  void Triangles::writeSnapshot(SnapshotWriter& writer) const
+  {
+    writer.writeArray(m_attributes);
+    writer.writeArray(m_indices);
+  }
+
+  bool Triangles::readSnapshot(SnapshotReader& reader)
+  {
+    return reader.readArray(m_attributes) && reader.readArray(m_indices);
+  }
+
 } // namespace sg
 
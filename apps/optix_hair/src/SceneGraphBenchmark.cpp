@@ -0,0 +1,249 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/SceneGraphBenchmark.h"
+
+#include "inc/NodeArena.h"
+#include "inc/SceneVisitor.h"
+#include "inc/Timer.h"
+
+#include "inc/MyAssert.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+  const unsigned int c_numModels         = 16; // Groups instanced by the top level instances.
+  const unsigned int c_numModelInstances = 8;  // Instances of the model's geometry inside each group.
+  const unsigned int c_numTraversals     = 8;
+
+  struct TraversalResult
+  {
+    unsigned int numGeometries;
+    float        checksum; // Keeps the compiler from dropping the matrix math.
+  };
+
+  void concatenate(float* m, const float* a, const float* b)
+  {
+    for (int row = 0; row < 3; ++row)
+    {
+      const float* r = a + row * 4;
+
+      m[row * 4 + 0] = r[0] * b[0] + r[1] * b[4] + r[2] * b[ 8];
+      m[row * 4 + 1] = r[0] * b[1] + r[1] * b[5] + r[2] * b[ 9];
+      m[row * 4 + 2] = r[0] * b[2] + r[1] * b[6] + r[2] * b[10];
+      m[row * 4 + 3] = r[0] * b[3] + r[1] * b[7] + r[2] * b[11] + r[3];
+    }
+  }
+
+  std::shared_ptr<sg::Group> buildScene(sg::NodeArena& arena, const unsigned int numInstances)
+  {
+    unsigned int idGroup    = 0;
+    unsigned int idInstance = 0;
+
+    std::shared_ptr<sg::Group> root = arena.create<sg::Group>(idGroup++);
+
+    std::vector< std::shared_ptr<sg::Group> > models;
+    for (unsigned int i = 0; i < c_numModels; ++i)
+    {
+      std::shared_ptr<sg::Triangles> geometry = arena.create<sg::Triangles>(i); // Empty, only the node matters here.
+      std::shared_ptr<sg::Group>     model    = arena.create<sg::Group>(idGroup++);
+
+      for (unsigned int j = 0; j < c_numModelInstances; ++j)
+      {
+        float matrix[12] = { 1.0f, 0.0f, 0.0f, float(j), 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+
+        std::shared_ptr<sg::Instance> instance = arena.create<sg::Instance>(idInstance++);
+        instance->setTransform(matrix);
+        instance->setChild(geometry);
+        model->addChild(instance);
+      }
+      models.push_back(model);
+    }
+
+    for (unsigned int i = 0; i < numInstances; ++i)
+    {
+      float matrix[12] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, float(i), 0.0f, 0.0f, 1.0f, 0.0f };
+
+      std::shared_ptr<sg::Instance> instance = arena.create<sg::Instance>(idInstance++);
+      instance->setTransform(matrix);
+      instance->setChild(models[i % c_numModels]);
+      root->addChild(instance);
+    }
+
+    return root;
+  }
+
+  // The traversal style before the type tags: the node and its children are passed around as shared_ptr copies.
+  void traverseShared(std::shared_ptr<sg::Node> node, const float* matrix, TraversalResult& result)
+  {
+    switch (node->getType())
+    {
+      case sg::NT_GROUP:
+        {
+          std::shared_ptr<sg::Group> group = std::static_pointer_cast<sg::Group>(node);
+          for (size_t i = 0; i < group->getNumChildren(); ++i)
+          {
+            std::shared_ptr<sg::Instance> child = group->getChild(i);
+            if (child->is_activated())
+            {
+              traverseShared(child, matrix, result);
+            }
+          }
+        }
+        break;
+
+      case sg::NT_INSTANCE:
+        {
+          std::shared_ptr<sg::Instance> instance = std::static_pointer_cast<sg::Instance>(node);
+
+          float trafo[12];
+          concatenate(trafo, matrix, instance->getTransform());
+
+          std::shared_ptr<sg::Node> child = instance->getChild();
+          traverseShared(child, trafo, result);
+        }
+        break;
+
+      case sg::NT_TRIANGLES:
+      case sg::NT_CURVES:
+        ++result.numGeometries;
+        result.checksum += matrix[3] + matrix[7];
+        break;
+    }
+  }
+
+  // The same traversal with the visitor API.
+  class BenchmarkVisitor
+  {
+  public:
+    BenchmarkVisitor(TraversalResult& result)
+    : m_result(result)
+    {
+      memset(m_matrix, 0, sizeof(m_matrix));
+      m_matrix[ 0] = 1.0f;
+      m_matrix[ 5] = 1.0f;
+      m_matrix[10] = 1.0f;
+    }
+
+    void visit(sg::Group& group)
+    {
+      sg::visitChildren(group, *this);
+    }
+
+    void visit(sg::Instance& instance)
+    {
+      float parent[12];
+      memcpy(parent, m_matrix, sizeof(m_matrix));
+
+      concatenate(m_matrix, parent, instance.getTransform());
+      sg::visitChild(instance, *this);
+
+      memcpy(m_matrix, parent, sizeof(m_matrix));
+    }
+
+    void visit(sg::Triangles&)
+    {
+      addGeometry();
+    }
+
+    void visit(sg::Curves&)
+    {
+      addGeometry();
+    }
+
+  private:
+    void addGeometry()
+    {
+      ++m_result.numGeometries;
+      m_result.checksum += m_matrix[3] + m_matrix[7];
+    }
+
+  private:
+    TraversalResult& m_result;
+    float            m_matrix[12];
+  };
+
+  void runBenchmark(const bool useArena, const unsigned int numInstances)
+  {
+    const char* name = (useArena) ? "arena" : "make_shared";
+
+    sg::NodeArena arena;
+    arena.setEnabled(useArena);
+
+    Timer timer;
+    timer.start();
+    std::shared_ptr<sg::Group> root = buildScene(arena, numInstances);
+    timer.stop();
+    const double timeBuild = timer.getTime();
+
+    const float identity[12] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+
+    TraversalResult resultShared = { 0, 0.0f };
+    timer.restart();
+    for (unsigned int i = 0; i < c_numTraversals; ++i)
+    {
+      traverseShared(root, identity, resultShared);
+    }
+    timer.stop();
+    const double timeShared = timer.getTime();
+
+    TraversalResult resultVisitor = { 0, 0.0f };
+    timer.restart();
+    for (unsigned int i = 0; i < c_numTraversals; ++i)
+    {
+      BenchmarkVisitor visitor(resultVisitor);
+      sg::dispatch(*root, visitor);
+    }
+    timer.stop();
+    const double timeVisitor = timer.getTime();
+
+    MY_ASSERT(resultShared.numGeometries == resultVisitor.numGeometries);
+
+    std::cout << "benchmarkSceneGraph(): " << name << ": build " << timeBuild << " s"
+              << ", shared_ptr traversal " << timeShared / c_numTraversals << " s"
+              << ", visitor traversal " << timeVisitor / c_numTraversals << " s"
+              << " (" << resultVisitor.numGeometries / c_numTraversals << " geometry instances, checksum " << resultVisitor.checksum << ")\n";
+
+    timer.restart();
+    root.reset();
+    timer.stop();
+    std::cout << "benchmarkSceneGraph(): " << name << ": destruction " << timer.getTime() << " s\n";
+  }
+
+} // namespace
+
+
+void benchmarkSceneGraph(const unsigned int numInstances)
+{
+  std::cout << "benchmarkSceneGraph(): " << numInstances << " instances of " << c_numModels << " groups with " << c_numModelInstances << " geometry instances each\n";
+
+  runBenchmark(false, numInstances);
+  runBenchmark(true,  numInstances);
+}
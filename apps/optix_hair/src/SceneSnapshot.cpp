@@ -0,0 +1,516 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "inc/SceneSnapshot.h"
+
+#include "inc/Hair.h"
+#include "inc/MyAssert.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+
+struct SnapshotHeader
+{
+  char     magic[8]; // "SGSNAPSH"
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t key;
+  uint64_t size;     // Of the whole file, detects truncated snapshots.
+};
+
+static const char     c_snapshotMagic[8] = { 'S', 'G', 'S', 'N', 'A', 'P', 'S', 'H' };
+static const uint32_t c_snapshotVersion  = 2;
+static const size_t   c_snapshotAlign    = 16;
+
+
+// ========== SnapshotWriter
+
+SnapshotWriter::SnapshotWriter(const uint64_t key)
+{
+  SnapshotHeader header;
+
+  memcpy(header.magic, c_snapshotMagic, sizeof(c_snapshotMagic));
+  header.version  = c_snapshotVersion;
+  header.reserved = 0;
+  header.key      = key;
+  header.size     = 0; // Set in save().
+
+  m_data.reserve(1 << 20);
+  writeBytes(&header, sizeof(SnapshotHeader));
+}
+
+void SnapshotWriter::writeString(std::string const& value)
+{
+  write<uint64_t>(value.size());
+  writeBytes(value.data(), value.size());
+}
+
+void SnapshotWriter::writeBytes(const void* data, const size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  m_data.insert(m_data.end(), bytes, bytes + size);
+}
+
+void SnapshotWriter::align()
+{
+  m_data.resize((m_data.size() + c_snapshotAlign - 1) & ~(c_snapshotAlign - 1), 0);
+}
+
+bool SnapshotWriter::save(std::string const& filename) const
+{
+  SnapshotHeader header;
+
+  memcpy(&header, m_data.data(), sizeof(SnapshotHeader));
+  header.size = m_data.size();
+
+  const std::string filenameTemp = filename + std::string(".tmp");
+  {
+    std::ofstream output(filenameTemp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+      std::cerr << "WARNING: SnapshotWriter::save() cannot write " << filenameTemp << '\n';
+      return false;
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(SnapshotHeader));
+    output.write(reinterpret_cast<const char*>(m_data.data()) + sizeof(SnapshotHeader), m_data.size() - sizeof(SnapshotHeader));
+
+    if (!output)
+    {
+      std::cerr << "WARNING: SnapshotWriter::save() failed writing " << filenameTemp << '\n';
+      output.close();
+      std::remove(filenameTemp.c_str());
+      return false;
+    }
+  }
+
+  std::remove(filename.c_str()); // rename() does not replace existing files on Windows.
+  if (std::rename(filenameTemp.c_str(), filename.c_str()) != 0)
+  {
+    std::cerr << "WARNING: SnapshotWriter::save() cannot rename " << filenameTemp << " to " << filename << '\n';
+    std::remove(filenameTemp.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+// ========== SnapshotReader
+
+SnapshotReader::SnapshotReader()
+: m_offset(0)
+, m_isValid(false)
+{
+}
+
+bool SnapshotReader::open(std::string const& filename, const uint64_t key)
+{
+  m_offset  = 0;
+  m_isValid = false;
+
+  if (!m_file.open(filename) || m_file.getSize() < sizeof(SnapshotHeader))
+  {
+    return false;
+  }
+
+  SnapshotHeader header;
+  memcpy(&header, m_file.getData(), sizeof(SnapshotHeader));
+
+  if (memcmp(header.magic, c_snapshotMagic, sizeof(c_snapshotMagic)) != 0 ||
+      header.version != c_snapshotVersion ||
+      header.key     != key ||
+      header.size    != m_file.getSize())
+  {
+    m_file.close();
+    return false;
+  }
+
+  m_offset  = sizeof(SnapshotHeader);
+  m_isValid = true;
+  return true;
+}
+
+bool SnapshotReader::readString(std::string& value)
+{
+  uint64_t size = 0;
+  if (!read(size))
+  {
+    return false;
+  }
+  const unsigned char* data = consume(size);
+  if (data == nullptr)
+  {
+    return false;
+  }
+  value.assign(reinterpret_cast<const char*>(data), size);
+  return true;
+}
+
+bool SnapshotReader::readBytes(void* data, const size_t size)
+{
+  const unsigned char* source = consume(size);
+  if (source == nullptr)
+  {
+    return false;
+  }
+  memcpy(data, source, size);
+  return true;
+}
+
+bool SnapshotReader::isValid() const
+{
+  return m_isValid;
+}
+
+void SnapshotReader::align()
+{
+  m_offset = (m_offset + c_snapshotAlign - 1) & ~(c_snapshotAlign - 1);
+}
+
+size_t SnapshotReader::getRemaining() const
+{
+  return (m_offset < m_file.getSize()) ? m_file.getSize() - m_offset : 0;
+}
+
+const unsigned char* SnapshotReader::consume(const size_t size)
+{
+  if (!m_isValid || m_file.getSize() < m_offset || m_file.getSize() - m_offset < size)
+  {
+    m_isValid = false;
+    return nullptr;
+  }
+  const unsigned char* data = static_cast<const unsigned char*>(m_file.getData()) + m_offset;
+  m_offset += size;
+  return data;
+}
+
+
+// ========== Scene graph
+
+enum SnapshotChild : uint32_t
+{
+  SNAPSHOT_CHILD_NONE,
+  SNAPSHOT_CHILD_GEOMETRY,
+  SNAPSHOT_CHILD_GROUP
+};
+
+struct SnapshotInstance
+{
+  uint32_t id;
+  uint32_t activated;
+  float    matrix[12];
+  int32_t  material;
+  int32_t  light;
+  uint32_t childType;  // SnapshotChild
+  uint32_t childIndex; // Into the geometries or the group table.
+};
+
+// Appends the group and all groups below it to the table, parents before children.
+static void gatherGroups(std::shared_ptr<sg::Group> const& group,
+                         std::vector< std::shared_ptr<sg::Group> >& groups,
+                         std::unordered_map<const sg::Group*, uint32_t>& indices)
+{
+  if (!group || indices.find(group.get()) != indices.end())
+  {
+    return;
+  }
+
+  indices[group.get()] = static_cast<uint32_t>(groups.size());
+  groups.push_back(group);
+
+  for (size_t i = 0; i < group->getNumChildren(); ++i)
+  {
+    std::shared_ptr<sg::Node> child = group->getChild(i)->getChild();
+    if (child && child->getType() == sg::NT_GROUP)
+    {
+      gatherGroups(std::static_pointer_cast<sg::Group>(child), groups, indices);
+    }
+  }
+}
+
+void writeSceneGraph(SnapshotWriter& writer,
+                     std::shared_ptr<sg::Group> const& root,
+                     std::vector< std::shared_ptr<sg::Node> > const& geometries,
+                     std::map< std::string, std::shared_ptr<sg::Group> > const& mapGroups)
+{
+  // Geometries. Their ids are their indices, see Application::m_idGeometry.
+  // Entries shared with an earlier geometry (see Application::shareGeometries()) store only the id of that one.
+  writer.write<uint64_t>(geometries.size());
+  for (size_t i = 0; i < geometries.size(); ++i)
+  {
+    std::shared_ptr<sg::Node> const& geometry = geometries[i];
+
+    const uint32_t type = geometry->getType();
+
+    writer.write(type);
+    writer.write<uint32_t>(geometry->getId());
+    writer.write<uint32_t>(geometry->is_activated() ? 1 : 0);
+
+    if (geometry->getId() != i)
+    {
+      continue;
+    }
+
+    switch (type)
+    {
+      case sg::NT_TRIANGLES:
+        std::static_pointer_cast<sg::Triangles>(geometry)->writeSnapshot(writer);
+        break;
+
+      case sg::NT_CURVES:
+        std::static_pointer_cast<sg::Curves>(geometry)->writeSnapshot(writer);
+        break;
+
+      default:
+        MY_ASSERT(!"writeSceneGraph() unexpected geometry type");
+        break;
+    }
+  }
+
+  // Groups, the root first.
+  std::vector< std::shared_ptr<sg::Group> > groups;
+  std::unordered_map<const sg::Group*, uint32_t> indices;
+
+  gatherGroups(root, groups, indices);
+  for (auto const& it : mapGroups)
+  {
+    gatherGroups(it.second, groups, indices);
+  }
+
+  std::unordered_map<const sg::Node*, uint32_t> indicesGeometry;
+  for (size_t i = 0; i < geometries.size(); ++i)
+  {
+    indicesGeometry.emplace(geometries[i].get(), static_cast<uint32_t>(i)); // Shared geometries keep their first index.
+  }
+
+  writer.write<uint64_t>(groups.size());
+  for (std::shared_ptr<sg::Group> const& group : groups)
+  {
+    writer.write<uint32_t>(group->getId());
+  }
+
+  for (std::shared_ptr<sg::Group> const& group : groups)
+  {
+    std::vector<SnapshotInstance> instances(group->getNumChildren());
+
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+      std::shared_ptr<sg::Instance> instance = group->getChild(i);
+      std::shared_ptr<sg::Node>     child    = instance->getChild();
+
+      SnapshotInstance& data = instances[i];
+
+      data.id        = instance->getId();
+      data.activated = instance->is_activated() ? 1 : 0;
+      memcpy(data.matrix, instance->getTransform(), sizeof(data.matrix));
+      data.material  = instance->getMaterial();
+      data.light     = instance->getLight();
+
+      data.childType  = SNAPSHOT_CHILD_NONE;
+      data.childIndex = 0;
+      if (child)
+      {
+        if (child->getType() == sg::NT_GROUP)
+        {
+          data.childType  = SNAPSHOT_CHILD_GROUP;
+          data.childIndex = indices[static_cast<const sg::Group*>(child.get())];
+        }
+        else
+        {
+          std::unordered_map<const sg::Node*, uint32_t>::const_iterator it = indicesGeometry.find(child.get());
+          MY_ASSERT(it != indicesGeometry.end());
+          if (it != indicesGeometry.end())
+          {
+            data.childType  = SNAPSHOT_CHILD_GEOMETRY;
+            data.childIndex = it->second;
+          }
+        }
+      }
+    }
+
+    writer.writeArray(instances);
+  }
+
+  writer.write<uint64_t>(mapGroups.size());
+  for (auto const& it : mapGroups)
+  {
+    writer.writeString(it.first);
+    writer.write<uint32_t>(indices[it.second.get()]);
+  }
+}
+
+bool readSceneGraph(SnapshotReader& reader,
+                    sg::NodeArena& arena,
+                    std::shared_ptr<sg::Group>& root,
+                    std::vector< std::shared_ptr<sg::Node> >& geometries,
+                    std::map< std::string, std::shared_ptr<sg::Group> >& mapGroups)
+{
+  uint64_t numGeometries = 0;
+  if (!reader.read(numGeometries))
+  {
+    return false;
+  }
+
+  geometries.clear();
+  geometries.reserve(numGeometries);
+  for (uint64_t i = 0; i < numGeometries; ++i)
+  {
+    uint32_t type      = 0;
+    uint32_t id        = 0;
+    uint32_t activated = 0;
+
+    if (!reader.read(type) || !reader.read(id) || !reader.read(activated))
+    {
+      return false;
+    }
+
+    if (id != i)
+    {
+      if (i < id || geometries[id]->getType() != type)
+      {
+        std::cerr << "ERROR: readSceneGraph() invalid shared geometry " << id << '\n';
+        return false;
+      }
+      geometries.push_back(geometries[id]);
+      continue;
+    }
+
+    std::shared_ptr<sg::Node> geometry;
+
+    switch (type)
+    {
+      case sg::NT_TRIANGLES:
+        {
+          std::shared_ptr<sg::Triangles> triangles = arena.create<sg::Triangles>(id);
+          if (!triangles->readSnapshot(reader))
+          {
+            return false;
+          }
+          geometry = triangles;
+        }
+        break;
+
+      case sg::NT_CURVES:
+        {
+          std::shared_ptr<sg::Curves> curves = arena.create<sg::Curves>(id);
+          if (!curves->readSnapshot(reader))
+          {
+            return false;
+          }
+          geometry = curves;
+        }
+        break;
+
+      default:
+        std::cerr << "ERROR: readSceneGraph() unexpected geometry type " << type << '\n';
+        return false;
+    }
+
+    geometry->set_activation(activated != 0);
+    geometries.push_back(geometry);
+  }
+
+  uint64_t numGroups = 0;
+  if (!reader.read(numGroups) || numGroups == 0)
+  {
+    return false;
+  }
+
+  std::vector< std::shared_ptr<sg::Group> > groups(numGroups);
+  for (uint64_t i = 0; i < numGroups; ++i)
+  {
+    uint32_t id = 0;
+    if (!reader.read(id))
+    {
+      return false;
+    }
+    groups[i] = arena.create<sg::Group>(id);
+  }
+
+  // Fix up the instance children now that all nodes exist.
+  std::vector<SnapshotInstance> instances;
+  for (uint64_t i = 0; i < numGroups; ++i)
+  {
+    if (!reader.readArray(instances))
+    {
+      return false;
+    }
+
+    for (SnapshotInstance const& data : instances)
+    {
+      std::shared_ptr<sg::Instance> instance = arena.create<sg::Instance>(data.id);
+
+      instance->set_activation(data.activated != 0);
+      instance->setTransform(data.matrix);
+      instance->setMaterial(data.material);
+      instance->setLight(data.light);
+
+      if (data.childType == SNAPSHOT_CHILD_GEOMETRY && data.childIndex < geometries.size())
+      {
+        instance->setChild(geometries[data.childIndex]);
+      }
+      else if (data.childType == SNAPSHOT_CHILD_GROUP && data.childIndex < groups.size())
+      {
+        instance->setChild(groups[data.childIndex]);
+      }
+      else if (data.childType != SNAPSHOT_CHILD_NONE)
+      {
+        std::cerr << "ERROR: readSceneGraph() invalid child index " << data.childIndex << '\n';
+        return false;
+      }
+
+      groups[i]->addChild(instance);
+    }
+  }
+
+  uint64_t numMapGroups = 0;
+  if (!reader.read(numMapGroups))
+  {
+    return false;
+  }
+
+  mapGroups.clear();
+  for (uint64_t i = 0; i < numMapGroups; ++i)
+  {
+    std::string name;
+    uint32_t    index = 0;
+
+    if (!reader.readString(name) || !reader.read(index) || groups.size() <= index)
+    {
+      return false;
+    }
+    mapGroups[name] = groups[index];
+  }
+
+  root = groups[0];
+  return reader.isValid();
+}
@@ -0,0 +1,335 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "shaders/config.h"
+
+#include "shaders/vector_math.h"
+
+#include "inc/ScreenshotWriter.h"
+#include "inc/Picture.h"
+#include "inc/ThreadPool.h"
+#include "inc/Timer.h"
+
+#include <IL/il.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#include "inc/MyAssert.h"
+
+
+// The same tonemapper as the display shader. Rows are distributed over the ThreadPool.
+static void tonemapImage(const float4* src, uchar3* dst, const int2 resolution, TonemapperGUI const& tonemapper)
+{
+  const float  invGamma       = 1.0f / tonemapper.gamma;
+  const float3 colorBalance   = make_float3(tonemapper.colorBalance[0], tonemapper.colorBalance[1], tonemapper.colorBalance[2]);
+  const float  invWhitePoint  = tonemapper.brightness / tonemapper.whitePoint;
+  const float  burnHighlights = tonemapper.burnHighlights;
+  const float  crushBlacks    = tonemapper.crushBlacks + tonemapper.crushBlacks + 1.0f;
+  const float  saturation     = tonemapper.saturation;
+
+  ThreadPool::getInstance().parallelFor(0, size_t(resolution.y), 16, [&](size_t first, size_t last)
+  {
+    for (int y = int(first); y < int(last); ++y)
+    {
+      for (int x = 0; x < resolution.x; ++x)
+      {
+        const int idx = y * resolution.x + x;
+
+        float3 hdrColor = make_float3(src[idx]);
+        float3 ldrColor = invWhitePoint * colorBalance * hdrColor;
+        ldrColor       *= ((ldrColor * burnHighlights) + 1.0f) / (ldrColor + 1.0f);
+        
+        float luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
+        ldrColor = lerp(make_float3(luminance), ldrColor, saturation); // This can generate negative values for saturation > 1.0f!
+        ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
+
+        luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
+        if (luminance < 1.0f)
+        {
+          const float3 crushed = powf(ldrColor, crushBlacks);
+          ldrColor = lerp(crushed, ldrColor, sqrtf(luminance));
+          ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
+        }
+        ldrColor = clamp(powf(ldrColor, invGamma), 0.0f, 1.0f); // Saturate, clamp to range [0.0f, 1.0f].
+
+        dst[idx] = make_uchar3((unsigned char) (ldrColor.x * 255.0f),
+                               (unsigned char) (ldrColor.y * 255.0f),
+                               (unsigned char) (ldrColor.z * 255.0f));
+      }
+    }
+  });
+}
+
+
+ScreenshotWriter::ScreenshotWriter(const unsigned int numThreads, const unsigned int capacity)
+: m_capacity(std::max(1u, capacity))
+, m_stop(false)
+, m_numActive(0)
+, m_numWritten(0)
+, m_numFailed(0)
+, m_timeCapture(0.0)
+, m_timeStall(0.0)
+, m_timeTonemap(0.0)
+, m_timeWrite(0.0)
+{
+  const unsigned int count = std::max(1u, numThreads);
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    m_threads.emplace_back(&ScreenshotWriter::worker, this);
+  }
+}
+
+ScreenshotWriter::~ScreenshotWriter()
+{
+  wait(); // Screenshots are results, don't drop them.
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_conditionWork.notify_all();
+
+  for (std::thread& thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+bool ScreenshotWriter::capture(std::string const& filename, const float4* rgba, const float* variance, const int2 resolution,
+                               const bool tonemap, TonemapperGUI const& tonemapper, const bool exrHalf, const ExrCompression exrCompression,
+                               const bool announce)
+{
+  if (rgba == nullptr || resolution.x <= 0 || resolution.y <= 0)
+  {
+    std::cerr << "ERROR: ScreenshotWriter::capture() no image for " << filename << '\n';
+    return false;
+  }
+
+  Timer timer;
+  timer.start();
+
+  // Wait for a free slot before copying, the copy is the memory the queue bounds.
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_conditionSpace.wait(lock, [this] { return m_queue.size() + m_numActive < m_capacity; });
+  }
+  timer.stop();
+  const double secondsStall = timer.getTime();
+
+  timer.start();
+  const size_t numPixels = size_t(resolution.x) * size_t(resolution.y);
+
+  Snapshot snapshot;
+  snapshot.filename       = filename + ((tonemap) ? std::string(".png") : std::string(".exr"));
+  try
+  {
+    snapshot.rgba.assign(rgba, rgba + numPixels);
+    if (variance != nullptr && !tonemap) // Only the EXR files store the variance.
+    {
+      snapshot.variance.assign(variance, variance + numPixels);
+    }
+  }
+  catch (std::bad_alloc const&)
+  {
+    std::cerr << "ERROR: ScreenshotWriter::capture() out of memory for " << snapshot.filename << '\n';
+    return false;
+  }
+  snapshot.resolution     = resolution;
+  snapshot.tonemap        = tonemap;
+  snapshot.tonemapper     = tonemapper;
+  snapshot.exrHalf        = exrHalf;
+  snapshot.exrCompression = exrCompression;
+  snapshot.announce       = announce;
+  timer.stop();
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.push_back(std::move(snapshot));
+    m_timeStall   += secondsStall;
+    m_timeCapture += timer.getTime();
+  }
+  m_conditionWork.notify_one();
+  return true;
+}
+
+void ScreenshotWriter::wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_conditionIdle.wait(lock, [this] { return m_queue.empty() && m_numActive == 0; });
+}
+
+bool ScreenshotWriter::isBusy() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return !m_queue.empty() || m_numActive != 0;
+}
+
+std::string ScreenshotWriter::getLastFailure()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  std::string filename;
+  filename.swap(m_lastFailure);
+  return filename;
+}
+
+std::string ScreenshotWriter::getTimings()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  std::ostringstream stream;
+  stream.precision(4);
+
+  const double scale = (m_numWritten != 0) ? 1000.0 / double(m_numWritten) : 0.0;
+  stream << "screenshots : " << m_numWritten << " written, " << m_numFailed << " failed; ms per image: capture " << m_timeCapture * scale
+         << ", queue stall " << m_timeStall * scale << ", tonemap " << m_timeTonemap * scale << ", encode and write " << m_timeWrite * scale;
+
+  m_numWritten  = 0;
+  m_numFailed   = 0;
+  m_timeCapture = 0.0;
+  m_timeStall   = 0.0;
+  m_timeTonemap = 0.0;
+  m_timeWrite   = 0.0;
+
+  return stream.str();
+}
+
+bool ScreenshotWriter::write(Snapshot const& snapshot, double& secondsTonemap, double& secondsWrite)
+{
+  Timer timer;
+
+  secondsTonemap = 0.0;
+  secondsWrite   = 0.0;
+
+  if (!snapshot.tonemap)
+  {
+    timer.start();
+    const float* variance = (snapshot.variance.empty()) ? nullptr : snapshot.variance.data();
+    const bool success = writeEXR(snapshot.filename, snapshot.resolution.x, snapshot.resolution.y, reinterpret_cast<const float*>(snapshot.rgba.data()),
+                                  variance, std::string("variance"), snapshot.exrHalf, snapshot.exrCompression);
+    timer.stop();
+    secondsWrite = timer.getTime();
+    return success;
+  }
+
+  timer.start();
+  std::vector<uchar3> pixels(snapshot.rgba.size());
+  tonemapImage(snapshot.rgba.data(), pixels.data(), snapshot.resolution, snapshot.tonemapper);
+  timer.stop();
+  secondsTonemap = timer.getTime();
+
+  timer.start();
+  bool success = false;
+  {
+    std::lock_guard<std::mutex> lock(getMutexDevIL());
+
+    unsigned int imageID;
+
+    ilGenImages(1, (ILuint *) &imageID);
+
+    ilBindImage(imageID);
+    ilActiveImage(0);
+    ilActiveFace(0);
+
+    ilDisable(IL_ORIGIN_SET);
+
+    if (ilTexImage(snapshot.resolution.x, snapshot.resolution.y, 1, 3, IL_RGB, IL_UNSIGNED_BYTE, pixels.data()))
+    {
+      ilEnable(IL_FILE_OVERWRITE); // By default, always overwrite
+
+      success = (ilSaveImage((const ILstring) snapshot.filename.c_str()) != IL_FALSE);
+    }
+
+    if (!success)
+    {
+      std::cerr << "ERROR: ScreenshotWriter::write() failed with IL error " << ilGetError() << '\n';
+
+      while (ilGetError() != IL_NO_ERROR) // Clean up errors.
+      {
+      }
+    }
+
+    // Free all resources associated with the DevIL image
+    ilDeleteImages(1, &imageID);
+  }
+  timer.stop();
+  secondsWrite = timer.getTime();
+
+  return success;
+}
+
+void ScreenshotWriter::worker()
+{
+  while (true)
+  {
+    Snapshot snapshot;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_conditionWork.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+      if (m_stop && m_queue.empty())
+      {
+        return;
+      }
+      snapshot = std::move(m_queue.front());
+      m_queue.pop_front();
+      ++m_numActive;
+    }
+
+    double secondsTonemap;
+    double secondsWrite;
+    const bool success = write(snapshot, secondsTonemap, secondsWrite);
+
+    if (success && snapshot.announce)
+    {
+      std::cout << snapshot.filename << '\n'; // Print out filename to indicate that a screenshot has been taken.
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (success)
+      {
+        ++m_numWritten;
+      }
+      else
+      {
+        ++m_numFailed;
+        m_lastFailure = snapshot.filename;
+      }
+      m_timeTonemap += secondsTonemap;
+      m_timeWrite   += secondsWrite;
+      --m_numActive;
+    }
+    m_conditionSpace.notify_one();
+    m_conditionIdle.notify_all();
+  }
+}
@@ -32,10 +32,16 @@
 
 #include "inc/Texture.h"
 #include "inc/CheckMacros.h"
+#include "inc/AliasTable.h"
+#include "inc/EnvironmentCache.h"
+#include "inc/HalfFloat.h"
+#include "inc/Hash.h"
+#include "inc/ThreadPool.h"
 
 #include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 #include "inc/MyAssert.h"
 
@@ -209,9 +215,9 @@ static void determineFormatChannels(const unsigned int deviceEncoding, CUarray_f
     case ENC_TYPE_UNSIGNED_INT:
       format = CU_AD_FORMAT_UNSIGNED_INT32;
       break;
-    //case ENC_TYPE_HALF: // FIXME Implement.
-    //  format = CU_AD_FORMAT_HALF;
-    //  break;
+    case ENC_TYPE_HALF:
+      format = CU_AD_FORMAT_HALF;
+      break;
     case ENC_TYPE_FLOAT:
       format = CU_AD_FORMAT_FLOAT;
       break;
@@ -237,8 +243,8 @@ static unsigned int getElementSize(const unsigned int deviceEncoding)
       break;
     case ENC_TYPE_SHORT:
     case ENC_TYPE_UNSIGNED_SHORT:
-    //case ENC_TYPE_HALF: // FIXME Implement.
-    bytes = 2;
+    case ENC_TYPE_HALF:
+      bytes = 2;
       break;
     case ENC_TYPE_INT:
     case ENC_TYPE_UNSIGNED_INT:
@@ -255,6 +261,12 @@ static unsigned int getElementSize(const unsigned int deviceEncoding)
   return bytes * numChannels;
 }
 
+// The same encoding with float components. Half float data is always converted via float.
+static unsigned int getFloatEncoding(const unsigned int deviceEncoding)
+{
+  return (deviceEncoding & ~(ENC_MASK << ENC_TYPE_SHIFT)) | ENC_TYPE_FLOAT;
+}
+
 
 // Texture format conversion routines.
 
@@ -617,7 +629,317 @@ PFNREMAP remappers[7][7] =
 };
 
 
+// Fast paths for the common conversions into the four channel device formats.
+// The channel mapping is resolved once per image into a swizzle instead of decoding the encoding bits per element.
+// SSSE3 and SSE2 kernels handle the byte shuffles and the float expansions, the scalar kernels the remaining swizzles.
+// The remappers above are the reference implementation and handle everything else.
+
+#if defined(__SSSE3__) || (defined(_MSC_VER) && defined(_M_X64))
+#define TEXTURE_USE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+// Swizzle indices beyond the source channels pick these constants.
+#define SWIZZLE_ZERO 4
+#define SWIZZLE_ONE  5
+
+// Number of elements per job when converting on the ThreadPool.
+#define CONVERT_GRAIN 65536
+
+// Fills swizzle[4] with the source channel for each of the destination RGBA channels.
+// Returns false if the destination is not the standard four channel RGBA layout.
+static bool determineSwizzle(const unsigned int deviceEncoding, const unsigned int hostEncoding, unsigned int swizzle[4])
+{
+  if (((deviceEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK) != 4)
+  {
+    return false;
+  }
+
+  const bool alphaOne = !!(deviceEncoding & ENC_ALPHA_ONE);
+
+  unsigned int shift = ENC_RED_SHIFT;
+  for (unsigned int i = 0; i < 4; ++i, shift += 4) // R, G, B, A
+  {
+    if (((deviceEncoding >> shift) & ENC_MASK) != i)
+    {
+      return false;
+    }
+
+    const unsigned int s = (hostEncoding >> shift) & ENC_MASK;
+    if (shift == ENC_ALPHA_SHIFT && (alphaOne || 4 <= s))
+    {
+      swizzle[i] = SWIZZLE_ONE;
+    }
+    else
+    {
+      swizzle[i] = (s < 4) ? s : SWIZZLE_ZERO;
+    }
+  }
+  return true;
+}
+
+static bool isSwizzleIdentity(const unsigned int swizzle[4], const unsigned int alpha)
+{
+  return swizzle[0] == 0 && swizzle[1] == 1 && swizzle[2] == 2 && swizzle[3] == alpha;
+}
+
+// Element conversions matching the reference remappers.
+template<typename D, typename S>
+struct ConvertCopy
+{
+  D operator()(const S value) const
+  {
+    return D(value);
+  }
+};
+
+// Same as remapFromFloat<D> with fixed point destination.
+template<typename D>
+struct ConvertFromFloatFixed
+{
+  D operator()(const float value) const
+  {
+    const float minimum = (std::numeric_limits<D>::is_signed) ? -1.0f : 0.0f;
+    return D(std::numeric_limits<D>::max() * std::min(std::max(minimum, value), 1.0f));
+  }
+};
+
+// Branch free scalar swizzle of count elements with srcChannels into RGBA.
+template<typename D, typename S, typename F>
+static void remapSwizzle(D* dst, const S* src, const unsigned int srcChannels, const unsigned int swizzle[4], size_t count, F const& convertValue)
+{
+  D value[6];
+  value[SWIZZLE_ZERO] = D(0);
+  value[SWIZZLE_ONE]  = getAlphaOne<D>();
+
+  while (count--)
+  {
+    for (unsigned int c = 0; c < srcChannels; ++c)
+    {
+      value[c] = convertValue(src[c]);
+    }
+
+    dst[0] = value[swizzle[0]];
+    dst[1] = value[swizzle[1]];
+    dst[2] = value[swizzle[2]];
+    dst[3] = value[swizzle[3]];
+
+    dst += 4;
+    src += srcChannels;
+  }
+}
+
+#if defined(TEXTURE_USE_SSSE3)
+// Byte swizzle of 3 or 4 channel unsigned char data into RGBA8 with a single shuffle per four pixels.
+// Returns the number of processed elements, the caller handles the remainder.
+static size_t remapSwizzleBytes(unsigned char* dst, const unsigned char* src, const unsigned int srcChannels, const unsigned int swizzle[4], const size_t count)
+{
+  unsigned char mask[16];
+  unsigned char ones[16];
+
+  for (unsigned int p = 0; p < 4; ++p)
+  {
+    for (unsigned int c = 0; c < 4; ++c)
+    {
+      const unsigned int s = swizzle[c];
+
+      mask[p * 4 + c] = (s < 4) ? static_cast<unsigned char>(p * srcChannels + s) : 0x80; // 0x80 writes zero.
+      ones[p * 4 + c] = (s == SWIZZLE_ONE) ? 0xFF : 0x00;
+    }
+  }
+
+  const __m128i shuffle  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+  const __m128i constant = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ones));
+
+  // Each iteration reads 16 bytes, but only consumes 4 * srcChannels. Stop before reading past the source.
+  size_t i = 0;
+  for (; i + 4 <= count && (i * srcChannels + 16) <= count * srcChannels; i += 4)
+  {
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * srcChannels));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), constant));
+  }
+  return i;
+}
+#endif
+
+#if defined(TEXTURE_USE_SSSE3) || defined(_M_X64) || defined(__SSE2__)
+#define TEXTURE_USE_SSE2
+#include <emmintrin.h>
+
+// RGB or RGBA float to RGBA float with alpha 1.0f. Returns the number of processed elements.
+static size_t remapFloatAlphaOne(float* dst, const float* src, const unsigned int srcChannels, const size_t count)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  size_t i = 0;
+  if (srcChannels == 3)
+  {
+    // Four RGB pixels in three registers: [r0 g0 b0 r1] [g1 b1 r2 g2] [b2 r3 g3 b3]
+    for (; i + 4 <= count; i += 4)
+    {
+      const float* p = src + i * 3;
+
+      const __m128 a = _mm_loadu_ps(p);
+      const __m128 b = _mm_loadu_ps(p + 4);
+      const __m128 c = _mm_loadu_ps(p + 8);
+
+      const __m128 p0 = _mm_shuffle_ps(a, _mm_unpackhi_ps(a, one), _MM_SHUFFLE(1, 0, 1, 0)); // [r0 g0 b0 1]
+
+      const __m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 3, 3));                       // [r1 r1 g1 g1]
+      const __m128 p1 = _mm_shuffle_ps(t1, _mm_shuffle_ps(b, one, _MM_SHUFFLE(0, 0, 1, 1)), _MM_SHUFFLE(2, 0, 2, 0)); // [r1 g1 b1 1]
+
+      const __m128 t2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 0, 3, 2));                       // [r2 g2 b2 b2]
+      const __m128 p2 = _mm_shuffle_ps(t2, _mm_unpackhi_ps(t2, one), _MM_SHUFFLE(1, 0, 1, 0)); // [r2 g2 b2 1]
+
+      const __m128 t3 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 2, 1));                       // [r3 g3 b3 b3]
+      const __m128 p3 = _mm_shuffle_ps(t3, _mm_unpackhi_ps(t3, one), _MM_SHUFFLE(1, 0, 1, 0)); // [r3 g3 b3 1]
+
+      float* q = dst + i * 4;
+      _mm_storeu_ps(q,      p0);
+      _mm_storeu_ps(q + 4,  p1);
+      _mm_storeu_ps(q + 8,  p2);
+      _mm_storeu_ps(q + 12, p3);
+    }
+  }
+  else if (srcChannels == 4)
+  {
+    const __m128 maskRGB = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 alpha   = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    for (; i < count; ++i)
+    {
+      _mm_storeu_ps(dst + i * 4, _mm_or_ps(_mm_and_ps(_mm_loadu_ps(src + i * 4), maskRGB), alpha));
+    }
+  }
+  return i;
+}
+
+// RGBA unsigned char to RGBA float without normalization, like remapToFloat<unsigned char>. Returns the number of processed elements.
+static size_t remapBytesToFloat(float* dst, const unsigned char* src, const bool alphaOne, const size_t count)
+{
+  const __m128i zero    = _mm_setzero_si128();
+  const __m128  maskRGB = _mm_castsi128_ps(_mm_set_epi32((alphaOne) ? 0 : -1, -1, -1, -1));
+  const __m128  alpha   = _mm_set_ps((alphaOne) ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    const __m128i lo    = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi    = _mm_unpackhi_epi8(bytes, zero);
+
+    float* q = dst + i * 4;
+    _mm_storeu_ps(q,      _mm_or_ps(_mm_and_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), maskRGB), alpha));
+    _mm_storeu_ps(q + 4,  _mm_or_ps(_mm_and_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), maskRGB), alpha));
+    _mm_storeu_ps(q + 8,  _mm_or_ps(_mm_and_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), maskRGB), alpha));
+    _mm_storeu_ps(q + 12, _mm_or_ps(_mm_and_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), maskRGB), alpha));
+  }
+  return i;
+}
+
+// RGBA float to fixed point RGBA unsigned char, like remapFromFloat<unsigned char>. Returns the number of processed elements.
+static size_t remapFloatToBytes(unsigned char* dst, const float* src, const size_t count)
+{
+  const __m128 zero  = _mm_setzero_ps();
+  const __m128 one   = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const float* p = src + i * 4;
+
+    // Truncation matches the scalar float to integer conversion.
+    // _mm_max_ps() returns its second operand when one is NaN, so NaN turns into zero like std::max(0.0f, NaN) in ConvertFromFloatFixed.
+    const __m128i v0 = _mm_cvttps_epi32(_mm_mul_ps(scale, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p),      zero), one)));
+    const __m128i v1 = _mm_cvttps_epi32(_mm_mul_ps(scale, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p + 4),  zero), one)));
+    const __m128i v2 = _mm_cvttps_epi32(_mm_mul_ps(scale, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p + 8),  zero), one)));
+    const __m128i v3 = _mm_cvttps_epi32(_mm_mul_ps(scale, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p + 12), zero), one)));
+
+    const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), bytes);
+  }
+  return i;
+}
+#endif
+
+// Convert one range of elements on the fast paths. Returns false if there is none for this combination of encodings.
+static bool convertFast(void* dst, const unsigned int deviceEncoding, const void* src, const unsigned int hostEncoding, const size_t count)
+{
+  unsigned int swizzle[4];
+  if (!determineSwizzle(deviceEncoding, hostEncoding, swizzle))
+  {
+    return false;
+  }
+
+  const unsigned int dstType     = deviceEncoding & (ENC_MASK << ENC_TYPE_SHIFT);
+  const unsigned int srcType     = hostEncoding   & (ENC_MASK << ENC_TYPE_SHIFT);
+  const unsigned int srcChannels = (hostEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
+  const bool         fixedPoint  = !!(deviceEncoding & ENC_FIXED_POINT);
+
+  size_t done = 0; // Elements handled by the SIMD kernels.
+
+  if (dstType == ENC_TYPE_UNSIGNED_CHAR && srcType == ENC_TYPE_UNSIGNED_CHAR) // RGB8, BGR8, BGRA8, L8 to RGBA8
+  {
+    unsigned char*       d = static_cast<unsigned char*>(dst);
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+#if defined(TEXTURE_USE_SSSE3)
+    if (srcChannels == 3 || srcChannels == 4)
+    {
+      done = remapSwizzleBytes(d, s, srcChannels, swizzle, count);
+    }
+#endif
+    remapSwizzle(d + done * 4, s + done * srcChannels, srcChannels, swizzle, count - done, ConvertCopy<unsigned char, unsigned char>());
+    return true;
+  }
+
+  if (dstType == ENC_TYPE_FLOAT && srcType == ENC_TYPE_FLOAT) // RGB32F, RGBA32F with alpha one to RGBA32F
+  {
+    float*       d = static_cast<float*>(dst);
+    const float* s = static_cast<const float*>(src);
+#if defined(TEXTURE_USE_SSE2)
+    if (isSwizzleIdentity(swizzle, SWIZZLE_ONE))
+    {
+      done = remapFloatAlphaOne(d, s, srcChannels, count);
+    }
+#endif
+    remapSwizzle(d + done * 4, s + done * srcChannels, srcChannels, swizzle, count - done, ConvertCopy<float, float>());
+    return true;
+  }
+
+  if (dstType == ENC_TYPE_FLOAT && srcType == ENC_TYPE_UNSIGNED_CHAR) // LDR environment maps.
+  {
+    float*               d = static_cast<float*>(dst);
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+#if defined(TEXTURE_USE_SSE2)
+    if (srcChannels == 4 && (isSwizzleIdentity(swizzle, 3) || isSwizzleIdentity(swizzle, SWIZZLE_ONE)))
+    {
+      done = remapBytesToFloat(d, s, swizzle[3] == SWIZZLE_ONE, count);
+    }
+#endif
+    remapSwizzle(d + done * 4, s + done * srcChannels, srcChannels, swizzle, count - done, ConvertCopy<float, unsigned char>());
+    return true;
+  }
+
+  if (dstType == ENC_TYPE_UNSIGNED_CHAR && srcType == ENC_TYPE_FLOAT && fixedPoint)
+  {
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    const float*   s = static_cast<const float*>(src);
+#if defined(TEXTURE_USE_SSE2)
+    if (srcChannels == 4 && isSwizzleIdentity(swizzle, 3))
+    {
+      done = remapFloatToBytes(d, s, count);
+    }
+#endif
+    remapSwizzle(d + done * 4, s + done * srcChannels, srcChannels, swizzle, count - done, ConvertFromFloatFixed<unsigned char>());
+    return true;
+  }
+
+  return false;
+}
+
 // Finally the function which converts any loaded image into a texture format supported by CUDA (1, 2, 4 channels only).
+// Large images are converted in parallel ranges on the ThreadPool.
 static void convert(void *dst, unsigned int deviceEncoding, const void *src, unsigned int hostEncoding, size_t elements)
 {
   // Only destination encoding knows about the fixed-point encoding. For straight data memcpy() cases that is irrelevant.
@@ -625,17 +947,39 @@ static void convert(void *dst, unsigned int deviceEncoding, const void *src, uns
   if ((deviceEncoding & ~ENC_FIXED_POINT) == hostEncoding)
   {
     memcpy(dst, src, elements * getElementSize(deviceEncoding)); // The fastest path.
+    return;
   }
-  else
+
+  const unsigned int dstType = (deviceEncoding >> ENC_TYPE_SHIFT) & ENC_MASK;
+  const unsigned int srcType = (hostEncoding   >> ENC_TYPE_SHIFT) & ENC_MASK;
+
+  if (dstType == (ENC_TYPE_HALF >> ENC_TYPE_SHIFT)) // There are no half remappers. Convert to float, then to half with F16C.
   {
-    unsigned int dstType = (deviceEncoding >> ENC_TYPE_SHIFT) & ENC_MASK;
-    unsigned int srcType = (hostEncoding   >> ENC_TYPE_SHIFT) & ENC_MASK;
-    MY_ASSERT(dstType < 7 && srcType < 7); 
-          
-    PFNREMAP pfn = remappers[dstType][srcType];
+    const size_t numComponents = elements * ((deviceEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK);
 
-    (*pfn)(dst, deviceEncoding, src, hostEncoding, elements);
+    std::vector<float> scratch(numComponents);
+    convert(scratch.data(), getFloatEncoding(deviceEncoding), src, hostEncoding, elements);
+    floatToHalf(scratch.data(), static_cast<uint16_t*>(dst), numComponents, true);
+    return;
   }
+
+  MY_ASSERT(dstType < 7 && srcType < 7); 
+
+  const size_t dstSize = getElementSize(deviceEncoding);
+  const size_t srcSize = getElementSize(hostEncoding);
+
+  PFNREMAP pfn = remappers[dstType][srcType];
+
+  ThreadPool::getInstance().parallelFor(0, elements, CONVERT_GRAIN, [&](size_t first, size_t last)
+  {
+    void*       d = static_cast<unsigned char*>(dst) + first * dstSize;
+    const void* s = static_cast<const unsigned char*>(src) + first * srcSize;
+
+    if (!convertFast(d, deviceEncoding, s, hostEncoding, last - first))
+    {
+      (*pfn)(d, deviceEncoding, s, hostEncoding, last - first);
+    }
+  });
 }
 
 Texture::Texture()
@@ -649,8 +993,13 @@ Texture::Texture()
 , m_textureObject(0)
 , m_d_array(0)
 , m_d_mipmappedArray(0)
+, m_blockFormat(BLOCK_FORMAT_NONE)
+, m_isCompressed(false)
+, m_halfFloat(false)
 , m_d_envCDF_U(0)
 , m_d_envCDF_V(0)
+, m_d_envAlias_U(0)
+, m_d_envAlias_V(0)
 , m_integral(1.0f)
 {
   m_descArray3D.Width       = 0;
@@ -713,6 +1062,14 @@ Texture::~Texture()
   {
     CU_CHECK_NO_THROW( cuMemFree(m_d_envCDF_V) );
   }
+  if (m_d_envAlias_U)
+  {
+    CU_CHECK_NO_THROW( cuMemFree(m_d_envAlias_U) );
+  }
+  if (m_d_envAlias_V)
+  {
+    CU_CHECK_NO_THROW( cuMemFree(m_d_envAlias_V) );
+  }
   if (m_textureObject)
   {
     CU_CHECK_NO_THROW( cuTexObjectDestroy(m_textureObject) );
@@ -772,6 +1129,20 @@ void Texture::setMipmapLevelBiasMinMax(float bias, float minimum, float maximum)
   m_textureDescription.maxMipmapLevelClamp = maximum;
 }
 
+void Texture::setBlockFormat(BlockFormat format)
+{
+  MY_ASSERT(m_textureObject == 0);
+
+  m_blockFormat = format;
+}
+
+void Texture::setHalfFloat(bool half)
+{
+  MY_ASSERT(m_textureObject == 0);
+
+  m_halfFloat = half;
+}
+
 void Texture::setReadMode(bool asInteger)
 {
   MY_ASSERT(m_textureObject == 0);
@@ -928,10 +1299,172 @@ bool Texture::create1D(const Picture* picture)
 }
 
 
+// Compress the LOD 0 and the following mipmap levels with extents which are multiples of the 4x4 block size,
+// and upload them into a block compressed (mipmapped) array. dataLevel0 optionally provides the already converted LOD 0.
+// Returns false without allocating anything when the format, the image, or the CUDA version doesn't allow compression.
+bool Texture::createCompressedArray(const Picture* picture, const void* dataLevel0)
+{
+#if CUDA_VERSION >= 11050
+  const unsigned int type        = m_deviceEncoding & (ENC_MASK << ENC_TYPE_SHIFT);
+  const unsigned int numChannels = (m_deviceEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
+
+  // BC6H compresses RGBA32F, all others RGBA8.
+  const bool isHDR = (m_blockFormat == BLOCK_FORMAT_BC6H);
+  const bool isFloat = (type == ENC_TYPE_FLOAT || type == ENC_TYPE_HALF);
+  if (numChannels != 4 || ((isHDR) ? !isFloat : type != ENC_TYPE_UNSIGNED_CHAR))
+  {
+    return false;
+  }
+  if ((m_width & 3) != 0 || (m_height & 3) != 0)
+  {
+    std::cerr << "WARNING: Texture::createCompressedArray() " << m_width << " x " << m_height << " is not a multiple of the block size. Not compressed.\n";
+    return false;
+  }
+
+  CUarray_format format;
+  switch (m_blockFormat)
+  {
+    case BLOCK_FORMAT_BC1:
+      format = CU_AD_FORMAT_BC1_UNORM;
+      break;
+    case BLOCK_FORMAT_BC3:
+      format = CU_AD_FORMAT_BC3_UNORM;
+      break;
+    case BLOCK_FORMAT_BC5:
+      format = CU_AD_FORMAT_BC5_UNORM;
+      break;
+    case BLOCK_FORMAT_BC6H:
+      format = CU_AD_FORMAT_BC6H_UF16;
+      break;
+    case BLOCK_FORMAT_BC7:
+      format = CU_AD_FORMAT_BC7_UNORM;
+      break;
+    default:
+      return false;
+  }
+
+  unsigned int numLevels = ((m_flags & IMAGE_FLAG_MIPMAP) && !(m_flags & IMAGE_FLAG_ENV)) ? picture->getNumberOfLevels(0) : 1;
+  for (unsigned int level = 1; level < numLevels; ++level)
+  {
+    const Image* image = picture->getImageLevel(0, level);
+    if ((image->m_width & 3) != 0 || (image->m_height & 3) != 0) // The remaining levels are smaller than a block.
+    {
+      numLevels = level;
+      break;
+    }
+  }
+
+  // Convert all levels to the device encoding first. The disk cache is keyed on the converted data.
+  // BC6H always compresses float data, also when half float storage was requested.
+  const unsigned int encoding = (isHDR) ? getFloatEncoding(m_deviceEncoding) : m_deviceEncoding;
+
+  std::vector< std::vector<unsigned char> > converted(numLevels);
+  std::vector<BlockLevel> levels(numLevels);
+
+  for (unsigned int level = 0; level < numLevels; ++level)
+  {
+    const Image* image = picture->getImageLevel(0, level);
+
+    levels[level].width  = image->m_width;
+    levels[level].height = image->m_height;
+
+    if (level == 0 && dataLevel0 != nullptr)
+    {
+      levels[level].pixels = dataLevel0;
+    }
+    else
+    {
+      const size_t sizeElements = size_t(image->m_width) * image->m_height;
+
+      converted[level].resize(sizeElements * getElementSize(encoding));
+      convert(converted[level].data(), encoding, image->m_pixels, m_hostEncoding, sizeElements);
+      levels[level].pixels = converted[level].data();
+    }
+  }
+
+  std::string cacheFilename;
+  if (!picture->getFilename().empty())
+  {
+    cacheFilename = picture->getFilename() + std::string(".") + std::string(getBlockFormatName(m_blockFormat)) + std::string("cache");
+  }
+
+  std::vector< std::vector<unsigned char> > blocks;
+  compressLevels(m_blockFormat, levels, blocks, cacheFilename);
+
+  m_descArray3D.Width       = m_width;
+  m_descArray3D.Height      = m_height;
+  m_descArray3D.Depth       = 0;
+  m_descArray3D.Format      = format;
+  m_descArray3D.NumChannels = (m_blockFormat == BLOCK_FORMAT_BC5) ? 2 : ((isHDR) ? 3 : 4);
+  m_descArray3D.Flags       = 0;
+
+  if (1 < numLevels)
+  {
+    CU_CHECK( cuMipmappedArrayCreate(&m_d_mipmappedArray, &m_descArray3D, numLevels) );
+
+    m_resourceDescription.resType = CU_RESOURCE_TYPE_MIPMAPPED_ARRAY;
+    m_resourceDescription.res.mipmap.hMipmappedArray = m_d_mipmappedArray;
+
+    // The levels smaller than a block are missing.
+    m_textureDescription.maxMipmapLevelClamp = std::min(m_textureDescription.maxMipmapLevelClamp, float(numLevels - 1));
+  }
+  else
+  {
+    CU_CHECK( cuArray3DCreate(&m_d_array, &m_descArray3D) );
+
+    m_resourceDescription.resType = CU_RESOURCE_TYPE_ARRAY;
+    m_resourceDescription.res.array.hArray = m_d_array;
+  }
+
+  for (unsigned int level = 0; level < numLevels; ++level)
+  {
+    CUarray d_levelArray = m_d_array;
+    if (1 < numLevels)
+    {
+      CU_CHECK( cuMipmappedArrayGetLevel(&d_levelArray, m_d_mipmappedArray, level) );
+    }
+
+    // Block compressed copies are expressed in rows of blocks.
+    CUDA_MEMCPY3D params = {};
+
+    params.srcMemoryType = CU_MEMORYTYPE_HOST;
+    params.srcHost       = blocks[level].data();
+    params.srcPitch      = (levels[level].width / 4) * getBlockSize(m_blockFormat);
+    params.srcHeight     = levels[level].height / 4;
+
+    params.dstMemoryType = CU_MEMORYTYPE_ARRAY;
+    params.dstArray      = d_levelArray;
+
+    params.WidthInBytes  = params.srcPitch;
+    params.Height        = levels[level].height / 4;
+    params.Depth         = 1;
+
+    CU_CHECK( cuMemcpy3D(&params) );
+  }
+
+  m_isCompressed = true;
+  return true;
+#else
+  (void) picture;
+  (void) dataLevel0;
+  std::cerr << "WARNING: Texture::createCompressedArray() block compressed arrays require CUDA 11.5. Not compressed.\n";
+  return false;
+#endif
+}
+
 bool Texture::create2D(const Picture* picture)
 {
   memset(&m_resourceDescription, 0, sizeof(CUDA_RESOURCE_DESC));
 
+  if (m_blockFormat != BLOCK_FORMAT_NONE && !(m_flags & IMAGE_FLAG_LAYER) && createCompressedArray(picture, nullptr))
+  {
+    m_textureObject = 0;
+
+    CU_CHECK( cuTexObjectCreate(&m_textureObject, &m_resourceDescription, &m_textureDescription, nullptr) ); 
+
+    return (m_textureObject != 0);
+  }
+
   // Default initialization for a 2D texture without layers.
   m_descArray3D.Width  = m_width;
   m_descArray3D.Height = m_height;
@@ -954,7 +1487,7 @@ bool Texture::create2D(const Picture* picture)
   
   const unsigned int numLevels = picture->getNumberOfLevels(0); // This is the number of mipmap levels including LOD 0.
 
-  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture // FIXME Add a mechanism to generate mipmaps if there are none.
+  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture. Picture::load() generates missing mipmaps with IMAGE_FLAG_MIPMAP.
   {
     // A 2D mipmapped array is allocated if only Depth extent is zero.
     // A 2D layered CUDA mipmapped array is allocated if all three extents are non-zero and the ::CUDA_ARRAY3D_LAYERED flag is set.
@@ -1305,34 +1838,48 @@ bool Texture::createEnv(const Picture* picture)
 
   float* data = new float[sizeElements * 4]; // RGBA32F
   
-  // A 2D array is allocated if only Depth extent is zero.
-  CU_CHECK( cuArray3DCreate(&m_d_array, &m_descArray3D) );
-
   const Image* image = picture->getImageLevel(0, 0); // LOD 0 only.
 
-  convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+  // The importance sampling needs float data. With half float storage only the uploaded texels are halved.
+  convert(data, getFloatEncoding(m_deviceEncoding), image->m_pixels, m_hostEncoding, sizeElements);
 
-  CUDA_MEMCPY3D params = {};
+  std::vector<uint16_t> halves;
+  const void* texels = data;
+  if ((m_deviceEncoding & (ENC_MASK << ENC_TYPE_SHIFT)) == ENC_TYPE_HALF)
+  {
+    halves.resize(sizeElements * 4);
+    floatToHalf(data, halves.data(), halves.size(), true);
+    texels = halves.data();
+  }
 
-  params.srcMemoryType = CU_MEMORYTYPE_HOST;
-  params.srcHost       = data;
-  params.srcPitch      = m_width * m_sizeBytesPerElement;
-  params.srcHeight     = m_height;
+  // The importance sampling below always uses the uncompressed data.
+  if (m_blockFormat != BLOCK_FORMAT_BC6H || !createCompressedArray(picture, data))
+  {
+    // A 2D array is allocated if only Depth extent is zero.
+    CU_CHECK( cuArray3DCreate(&m_d_array, &m_descArray3D) );
 
-  params.dstMemoryType = CU_MEMORYTYPE_ARRAY;
-  params.dstArray      = m_d_array;
+    CUDA_MEMCPY3D params = {};
+
+    params.srcMemoryType = CU_MEMORYTYPE_HOST;
+    params.srcHost       = texels;
+    params.srcPitch      = m_width * m_sizeBytesPerElement;
+    params.srcHeight     = m_height;
+
+    params.dstMemoryType = CU_MEMORYTYPE_ARRAY;
+    params.dstArray      = m_d_array;
       
-  params.WidthInBytes  = params.srcPitch;
-  params.Height        = m_height;
-  params.Depth         = m_depth;
+    params.WidthInBytes  = params.srcPitch;
+    params.Height        = m_height;
+    params.Depth         = m_depth;
 
-  CU_CHECK( cuMemcpy3D(&params) );
+    CU_CHECK( cuMemcpy3D(&params) );
 
-  m_resourceDescription.resType = CU_RESOURCE_TYPE_ARRAY;
-  m_resourceDescription.res.array.hArray = m_d_array;
+    m_resourceDescription.resType = CU_RESOURCE_TYPE_ARRAY;
+    m_resourceDescription.res.array.hArray = m_d_array;
+  }
 
   // Generate the CDFs for direct environment lighting and the environment texture sampler itself.
-  calculateSphericalCDF(data);
+  calculateSphericalCDF(data, picture->getFilename());
   
   delete[] data;
 
@@ -1411,6 +1958,12 @@ bool Texture::create(const Picture* picture, const unsigned int flags)
   {
     m_deviceEncoding = determineDeviceEncoding(image->m_format, image->m_type);
   }
+
+  // Half float storage halves the memory and bandwidth of HDR textures. The texture units return floats either way.
+  if (m_halfFloat && (m_deviceEncoding & (ENC_MASK << ENC_TYPE_SHIFT)) == ENC_TYPE_FLOAT)
+  {
+    m_deviceEncoding = (m_deviceEncoding & ~(ENC_MASK << ENC_TYPE_SHIFT)) | ENC_TYPE_HALF;
+  }
   
   if ((m_hostEncoding | m_deviceEncoding) & ENC_INVALID) // If either of the encodings is invalid, bail out.
   {
@@ -1486,153 +2039,222 @@ cudaTextureObject_t Texture::getTextureObject() const
 
 // The following functions are used to build the data needed for an importance sampled spherical HDR environment map. 
 
-// Implement a simple Gaussian 3x3 filter with sigma = 0.5
+// Separable Gaussian 3-tap filter with sigma = 0.5.
+// The products of these weights are the former 3x3 kernel weights 0.619347 (center), 0.0838195 (edges) and 0.0113437 (corners).
 // Needed for the CDF generation of the importance sampled HDR environment texture light.
-static float gaussianFilter(const float* rgba, unsigned int width, unsigned int height, unsigned int x, unsigned int y)
+static const float c_gaussianCenter = 0.786986f;
+static const float c_gaussianSide   = 0.106507f;
+
+// Horizontal filter pass of one row. Lookup is repeated in x.
+static void gaussianFilterRow(const float* src, float* dst, const unsigned int width)
 {
-  // Lookup is repeated in x and clamped to edge in y.
-  unsigned int left   = (0 < x)          ? x - 1 : width - 1; // repeat
-  unsigned int right  = (x < width - 1)  ? x + 1 : 0;         // repeat
-  unsigned int bottom = (0 < y)          ? y - 1 : y;         // clamp
-  unsigned int top    = (y < height - 1) ? y + 1 : y;         // clamp
-  
-  // Center
-  const float *p = rgba + (width * y + x) * 4;
-  float intensity = (p[0] + p[1] + p[2]) * 0.619347f;
-
-  // 4-neighbours
-  p = rgba + (width * bottom + x) * 4;
-  float f = p[0] + p[1] + p[2];
-  p = rgba + (width * y + left) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * y + right) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * top + x) * 4;
-  f += p[0] + p[1] + p[2];
-  intensity += f * 0.0838195f;
-
-  // 8-neighbours corners
-  p = rgba + (width * bottom + left) * 4;
-  f  = p[0] + p[1] + p[2];
-  p = rgba + (width * bottom + right) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * top + left) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * top + right) * 4;
-  f += p[0] + p[1] + p[2];
-  intensity += f * 0.0113437f;
-
-  return intensity / 3.0f;
+  if (width == 1)
+  {
+    dst[0] = src[0];
+    return;
+  }
+
+  dst[0] = c_gaussianCenter * src[0] + c_gaussianSide * (src[width - 1] + src[1]);
+
+  // Branch free inner loop, vectorized by the compiler.
+  for (unsigned int x = 1; x < width - 1; ++x)
+  {
+    dst[x] = c_gaussianCenter * src[x] + c_gaussianSide * (src[x - 1] + src[x + 1]);
+  }
+
+  dst[width - 1] = c_gaussianCenter * src[width - 1] + c_gaussianSide * (src[width - 2] + src[0]);
+}
+
+// Vertical filter pass of one row, scaled by the row's sine. The bottom and top rows are clamped to edge by the caller.
+static void gaussianFilterColumn(const float* bottom, const float* center, const float* top, float* dst, const unsigned int width, const float scale)
+{
+  const float weightCenter = c_gaussianCenter * scale;
+  const float weightSide   = c_gaussianSide   * scale;
+
+  for (unsigned int x = 0; x < width; ++x)
+  {
+    dst[x] = weightCenter * center[x] + weightSide * (bottom[x] + top[x]);
+  }
 }
 
 // Create cumulative distribution function for importance sampling of spherical environment lights.
 // This is a textbook implementation for the CDF generation of a spherical HDR environment.
 // See "Physically Based Rendering" v2, chapter 14.6.5 on Infinite Area Lights.
-void Texture::calculateSphericalCDF(const float* rgba)
+// The rows are processed in parallel. The same distribution is also stored as alias tables for constant time sampling.
+void Texture::calculateSphericalCDF(const float* rgba, std::string const& filename)
 {
-  // The original data needs to be retained to calculate the PDF.
-  float *funcU = new float[m_width * m_height];
-  float *funcV = new float[m_height + 1];
+  const unsigned int width  = m_width;
+  const unsigned int height = m_height;
 
-  float sum = 0.0f;
-  // First generate the function data.
-  for (unsigned int y = 0; y < m_height; ++y)
+  // The disk cache is keyed by the content of the RGBA32F data and the extents. 
+  uint64_t          hash = 0;
+  const std::string filenameCache = (filename.empty()) ? std::string() : EnvironmentCache::getCacheFilename(filename);
+
+  if (!filenameCache.empty())
   {
-    // Scale distibution by the sine to get the sampling uniform. (Avoid sampling more values near the poles.)
-    // See Physically Based Rendering v2, chapter 14.6.5 on Infinite Area Lights, page 728.
-    float sinTheta = float(sin(M_PI * (double(y) + 0.5) / double(m_height))); // Make this as accurate as possible.
+    hash = hash64Parallel(rgba, size_t(width) * height * 4 * sizeof(float));
 
-    for (unsigned int x = 0; x < m_width; ++x)
+    EnvironmentCache cache;
+    if (cache.load(filenameCache, width, height, hash))
     {
-      // Filter to keep the piecewise linear function intact for samples with zero value next to non-zero values.
-      const float value = gaussianFilter(rgba, m_width, m_height, x, y);
-      funcU[y * m_width + x] = value * sinTheta;
+      m_integral = cache.getIntegral();
+
+      // Upload directly from the memory mapped file.
+      uploadBuffer(m_d_envCDF_U,   cache.getCDF_U(),   size_t(width + 1) * height * sizeof(float));
+      uploadBuffer(m_d_envCDF_V,   cache.getCDF_V(),   size_t(height + 1) * sizeof(float));
+      uploadBuffer(m_d_envAlias_U, cache.getAlias_U(), size_t(width) * height * sizeof(AliasEntry));
+      uploadBuffer(m_d_envAlias_V, cache.getAlias_V(), size_t(height) * sizeof(AliasEntry));
+      return;
+    }
+  }
+
+  ThreadPool& pool = ThreadPool::getInstance();
+
+  std::vector<float>  intensities(width * height);
+  std::vector<float>  filtered(width * height);   // Horizontally filtered intensities.
+  std::vector<float>  funcU(width * height);      // The original data needs to be retained to calculate the PDF.
+  std::vector<float>  funcV(height + 1);
+  std::vector<double> sums(height);               // Per row integral over the actual function.
+
+  std::vector<float> sinTheta(height);
+
+  // Scale distibution by the sine to get the sampling uniform. (Avoid sampling more values near the poles.)
+  // See Physically Based Rendering v2, chapter 14.6.5 on Infinite Area Lights, page 728.
+  for (unsigned int y = 0; y < height; ++y)
+  {
+    sinTheta[y] = float(sin(M_PI * (double(y) + 0.5) / double(height))); // Make this as accurate as possible.
+  }
+
+  // First pass: Intensities, their integral, and the horizontal filter.
+  pool.parallelFor(0, height, 8, [&](size_t first, size_t last)
+  {
+    for (size_t y = first; y < last; ++y)
+    {
+      const float* p   = rgba + y * width * 4;
+      float*       row = &intensities[y * width];
+
+      double sum = 0.0;
+      for (unsigned int x = 0; x < width; ++x, p += 4)
+      {
+        row[x] = (p[0] + p[1] + p[2]) / 3.0f;
+        sum += row[x];
+      }
+      sums[y] = sum * sinTheta[y];
 
-      // Compute integral over the actual function.
-      const float *p = rgba + (y * m_width + x) * 4;
-      const float intensity = (p[0] + p[1] + p[2]) / 3.0f;
-      sum += intensity * sinTheta;
+      gaussianFilterRow(row, &filtered[y * width], width);
     }
+  });
+
+  double sum = 0.0;
+  for (unsigned int y = 0; y < height; ++y) // Serial to be deterministic.
+  {
+    sum += sums[y];
   }
 
   // This integral is used inside the light sampling function (see sysData.envIntegral).
-  m_integral = sum * 2.0f * M_PIf * M_PIf / float(m_width * m_height);
+  m_integral = float(sum * 2.0 * M_PI * M_PI / double(width * height));
 
   // Now generate the CDF data.
   // Normalized 1D distributions in the rows of the 2D buffer, and the marginal CDF in the 1D buffer.
   // Include the starting 0.0f and the ending 1.0f to avoid special cases during the continuous sampling.
-  float *cdfU = new float[(m_width + 1) * m_height];
-  float *cdfV = new float[m_height + 1];
+  std::vector<float> cdfU((width + 1) * height);
+  std::vector<float> cdfV(height + 1);
 
-  for (unsigned int y = 0; y < m_height; ++y)
-  {
-    unsigned int row = y * (m_width + 1); // Watch the stride!
-    cdfU[row + 0] = 0.0f; // CDF starts at 0.0f.
+  std::vector<AliasEntry> aliasU(width * height);
+  std::vector<AliasEntry> aliasV(height);
 
-    for (unsigned int x = 1; x <= m_width; ++x)
+  // Second pass: Vertical filter, the conditional distributions of the rows.
+  pool.parallelFor(0, height, 4, [&](size_t first, size_t last)
+  {
+    for (size_t y = first; y < last; ++y)
     {
-      unsigned int i = row + x;
-      cdfU[i] = cdfU[i - 1] + funcU[y * m_width + x - 1]; // Attention, funcU is only m_width wide! 
-    }
+      // Lookup is clamped to edge in y.
+      const size_t bottom = (0 < y)          ? y - 1 : y;
+      const size_t top    = (y < height - 1) ? y + 1 : y;
 
-    const float integral = cdfU[row + m_width]; // The integral over this row is in the last element.
-    funcV[y] = integral;                        // Store this as function values of the marginal CDF.
+      float* func = &funcU[y * width];
 
-    if (integral != 0.0f)
-    {
-      for (unsigned int x = 1; x <= m_width; ++x)
+      // Filter to keep the piecewise linear function intact for samples with zero value next to non-zero values.
+      gaussianFilterColumn(&filtered[bottom * width], &filtered[y * width], &filtered[top * width], func, width, sinTheta[y]);
+
+      float* cdf = &cdfU[y * (width + 1)]; // Watch the stride!
+      cdf[0] = 0.0f; // CDF starts at 0.0f.
+
+      for (unsigned int x = 1; x <= width; ++x)
       {
-        cdfU[row + x] /= integral;
+        cdf[x] = cdf[x - 1] + func[x - 1]; // Attention, funcU is only m_width wide! 
       }
-    }
-    else // All texels were black in this row. Generate an equal distribution.
-    {
-      for (unsigned int x = 1; x <= m_width; ++x)
+
+      const float integral = cdf[width]; // The integral over this row is in the last element.
+      funcV[y] = integral;               // Store this as function values of the marginal CDF.
+
+      if (integral != 0.0f)
       {
-        cdfU[row + x] = float(x) / float(m_width);
+        const float invIntegral = 1.0f / integral;
+        for (unsigned int x = 1; x <= width; ++x)
+        {
+          cdf[x] *= invIntegral;
+        }
       }
+      else // All texels were black in this row. Generate an equal distribution.
+      {
+        for (unsigned int x = 1; x <= width; ++x)
+        {
+          cdf[x] = float(x) / float(width);
+        }
+      }
+
+      buildAliasTable(func, width, &aliasU[y * width]); // Falls back to an equal distribution for black rows as well.
     }
-  }
+  });
 
   // Now do the same thing with the marginal CDF.
   cdfV[0] = 0.0f; // CDF starts at 0.0f.
-  for (unsigned int y = 1; y <= m_height; ++y)
+  for (unsigned int y = 1; y <= height; ++y)
   {
     cdfV[y] = cdfV[y - 1] + funcV[y - 1];
   }
         
-  const float integral = cdfV[m_height]; // The integral over this marginal CDF is in the last element.
-  funcV[m_height] = integral;            // For completeness, actually unused.
+  const float integral = cdfV[height]; // The integral over this marginal CDF is in the last element.
+  funcV[height] = integral;            // For completeness, actually unused.
 
   if (integral != 0.0f)
   {
-    for (unsigned int y = 1; y <= m_height; ++y)
+    for (unsigned int y = 1; y <= height; ++y)
     {
       cdfV[y] /= integral;
     }
   }
   else // All texels were black in the whole image. Seriously? :-) Generate an equal distribution.
   {
-    for (unsigned int y = 1; y <= m_height; ++y)
+    for (unsigned int y = 1; y <= height; ++y)
     {
-      cdfV[y] = float(y) / float(m_height);
+      cdfV[y] = float(y) / float(height);
     }
   }
 
-  // Upload the CDFs into CUDA buffers.
-  size_t sizeBytes = (m_width + 1) * m_height * sizeof(float);
-  CU_CHECK( cuMemAlloc(&m_d_envCDF_U, sizeBytes) );
-  CU_CHECK( cuMemcpyHtoD(m_d_envCDF_U, cdfU, sizeBytes) );
+  buildAliasTable(funcV.data(), height, aliasV.data());
 
-  sizeBytes = (m_height + 1) * sizeof(float);
-  CU_CHECK( cuMemAlloc(&m_d_envCDF_V, sizeBytes) );
-  CU_CHECK( cuMemcpyHtoD(m_d_envCDF_V, cdfV, sizeBytes) );
+  // Upload the CDFs and alias tables into CUDA buffers. Free the previous ones when updating the environment.
+  uploadBuffer(m_d_envCDF_U,   cdfU.data(),   cdfU.size()   * sizeof(float));
+  uploadBuffer(m_d_envCDF_V,   cdfV.data(),   cdfV.size()   * sizeof(float));
+  uploadBuffer(m_d_envAlias_U, aliasU.data(), aliasU.size() * sizeof(AliasEntry));
+  uploadBuffer(m_d_envAlias_V, aliasV.data(), aliasV.size() * sizeof(AliasEntry));
 
-  delete[] cdfV;
-  delete[] cdfU;
-        
-  delete[] funcV;
-  delete[] funcU;
+  if (!filenameCache.empty())
+  {
+    EnvironmentCache::save(filenameCache, width, height, hash, m_integral, cdfU.data(), cdfV.data(), aliasU.data(), aliasV.data());
+  }
+}
+
+void Texture::uploadBuffer(CUdeviceptr& d_buffer, const void* data, const size_t sizeBytes)
+{
+  if (d_buffer)
+  {
+    CU_CHECK( cuMemFree(d_buffer) );
+  }
+  CU_CHECK( cuMemAlloc(&d_buffer, sizeBytes) );
+  CU_CHECK( cuMemcpyHtoD(d_buffer, data, sizeBytes) );
 }
 
 CUdeviceptr Texture::getCDF_U() const
@@ -1645,6 +2267,16 @@ CUdeviceptr Texture::getCDF_V() const
   return m_d_envCDF_V;
 }
 
+CUdeviceptr Texture::getAlias_U() const
+{
+  return m_d_envAlias_U;
+}
+
+CUdeviceptr Texture::getAlias_V() const
+{
+  return m_d_envAlias_V;
+}
+
 float Texture::getIntegral() const
 {
   // This is the sum of the piecewise linear function values (roughly the texels' intensity) divided by the number of texels m_width * m_height.
@@ -1747,7 +2379,7 @@ bool Texture::update2D(const Picture* picture)
   
   const unsigned int numLevels = picture->getNumberOfLevels(0); // This is the number of mipmap levels including LOD 0.
 
-  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture // FIXME Add a mechanism to generate mipmaps if there are none.
+  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture. Picture::load() generates missing mipmaps with IMAGE_FLAG_MIPMAP.
   {
     CU_CHECK( cuMipmappedArrayCreate(&m_d_mipmappedArray, &m_descArray3D, numLevels) );
 
@@ -2010,12 +2642,22 @@ bool Texture::updateEnv(const Picture* picture)
   
   const Image* image = picture->getImageLevel(0, 0); // LOD 0 only.
 
-  convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+  // The importance sampling needs float data. With half float storage only the uploaded texels are halved.
+  convert(data, getFloatEncoding(m_deviceEncoding), image->m_pixels, m_hostEncoding, sizeElements);
+
+  std::vector<uint16_t> halves;
+  const void* texels = data;
+  if ((m_deviceEncoding & (ENC_MASK << ENC_TYPE_SHIFT)) == ENC_TYPE_HALF)
+  {
+    halves.resize(sizeElements * 4);
+    floatToHalf(data, halves.data(), halves.size(), true);
+    texels = halves.data();
+  }
 
   CUDA_MEMCPY3D params = {};
 
   params.srcMemoryType = CU_MEMORYTYPE_HOST;
-  params.srcHost       = data;
+  params.srcHost       = texels;
   params.srcPitch      = m_width * m_sizeBytesPerElement;
   params.srcHeight     = m_height;
 
@@ -2032,7 +2674,7 @@ bool Texture::updateEnv(const Picture* picture)
   m_resourceDescription.res.array.hArray = m_d_array;
 
   // Generate the CDFs for direct environment lighting and the environment texture sampler itself.
-  calculateSphericalCDF(data);
+  calculateSphericalCDF(data, picture->getFilename());
   
   delete[] data;
 
@@ -2050,6 +2692,12 @@ bool Texture::update(const Picture* picture)
     return success;
   }
 
+  if (m_isCompressed)
+  {
+    std::cerr << "ERROR: Texture::update() not supported for block compressed textures.\n";
+    return success;
+  }
+
   if (picture == nullptr)
   {
     std::cerr << "ERROR: Texture::update() called with nullptr picture.\n";
@@ -0,0 +1,171 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+: m_stop(false)
+{
+  if (numThreads == 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  m_threads.reserve(numThreads);
+  for (unsigned int i = 0; i < numThreads; ++i)
+  {
+    m_threads.emplace_back(&ThreadPool::worker, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+
+  for (auto& thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+ThreadPool& ThreadPool::getInstance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+unsigned int ThreadPool::getNumThreads() const
+{
+  return static_cast<unsigned int>(m_threads.size());
+}
+
+void ThreadPool::enqueue(std::function<void()>&& job)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push(std::move(job));
+  }
+  m_condition.notify_one();
+}
+
+void ThreadPool::worker()
+{
+  for (;;)
+  {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+      if (m_stop && m_jobs.empty())
+      {
+        return;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop();
+    }
+    job();
+  }
+}
+
+void ThreadPool::parallelFor(const size_t begin, const size_t end, const size_t grain, std::function<void(size_t, size_t)> const& body)
+{
+  if (end <= begin)
+  {
+    return;
+  }
+
+  const size_t step      = std::max(size_t(1), grain);
+  const size_t numChunks = (end - begin + step - 1) / step;
+
+  if (numChunks == 1 || m_threads.empty())
+  {
+    body(begin, end);
+    return;
+  }
+
+  // The shared state outlives this call when helpers get scheduled late, e.g. when all workers are busy.
+  struct State
+  {
+    std::atomic<size_t>     next{ 0 };
+    std::atomic<size_t>     done{ 0 };
+    std::mutex              mutex;
+    std::condition_variable condition;
+    std::exception_ptr      exception;
+  };
+  auto state = std::make_shared<State>();
+
+  // Copy of the body for the helpers. The caller's reference is only guaranteed to be valid until all chunks are done.
+  auto work = [state, begin, end, step, numChunks, body]()
+  {
+    size_t chunk;
+    while ((chunk = state->next.fetch_add(1)) < numChunks)
+    {
+      const size_t first = begin + chunk * step;
+      try
+      {
+        body(first, std::min(first + step, end));
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->exception)
+        {
+          state->exception = std::current_exception();
+        }
+      }
+      if (state->done.fetch_add(1) + 1 == numChunks)
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->condition.notify_all();
+      }
+    }
+  };
+
+  const size_t numHelpers = std::min(numChunks - 1, m_threads.size());
+  for (size_t i = 0; i < numHelpers; ++i)
+  {
+    enqueue(work);
+  }
+
+  work(); // The calling thread works as well.
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->condition.wait(lock, [&state, numChunks]() { return state->done.load() == numChunks; });
+
+  if (state->exception)
+  {
+    std::rethrow_exception(state->exception);
+  }
+}
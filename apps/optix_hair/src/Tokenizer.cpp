@@ -0,0 +1,343 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "inc/Tokenizer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+
+namespace
+{
+  // Character classes of the tokenizer, looked up per byte instead of searching the delimiter strings for every character.
+  enum CharClass : unsigned char
+  {
+    CC_DELIMITER   = 1, // space, tab, carriage return, linefeed
+    CC_VALUE       = 2, // "+-0123456789.eE"
+    CC_VALUE_START = 4  // Legal start characters for a floating point number.
+  };
+
+  struct CharTable
+  {
+    unsigned char flags[256];
+
+    CharTable()
+    {
+      memset(flags, 0, sizeof(flags));
+
+      for (const char c : std::string_view(" \t\r\n"))
+      {
+        flags[static_cast<unsigned char>(c)] |= CC_DELIMITER;
+      }
+      for (const char c : std::string_view("+-0123456789.eE"))
+      {
+        flags[static_cast<unsigned char>(c)] |= CC_VALUE;
+      }
+      for (const char c : std::string_view("+-0123456789."))
+      {
+        flags[static_cast<unsigned char>(c)] |= CC_VALUE_START;
+      }
+    }
+  };
+
+  const CharTable charTable;
+}
+
+
+Tokenizer::Tokenizer()
+: m_index(0)
+, m_lineStart(0)
+, m_line(1)
+, m_tokenLine(1)
+, m_tokenColumn(1)
+{
+}
+
+//Tokenizer::~Tokenizer()
+//{
+//}
+
+bool Tokenizer::load(std::string const& filename)
+{
+  m_file.close();
+  m_buffer.clear();
+  m_source = std::string_view();
+  m_filename = filename;
+
+  m_index       = 0;
+  m_lineStart   = 0;
+  m_line        = 1;
+  m_tokenLine   = 1;
+  m_tokenColumn = 1;
+
+  if (m_file.open(filename))
+  {
+    m_source = std::string_view(static_cast<const char*>(m_file.getData()), m_file.getSize());
+    return true;
+  }
+
+  // Empty files can't be mapped. Read through a stream to distinguish these from missing files.
+  std::ifstream inputStream(filename, std::ios::binary);
+  if (!inputStream)
+  {
+    std::cerr << "ERROR: Tokenizer::load() failed to open file " << filename << '\n';
+    return false;
+  }
+
+  std::stringstream data;
+
+  data << inputStream.rdbuf();
+
+  m_buffer = data.str();
+  m_source = m_buffer;
+  return true;
+}
+
+void Tokenizer::setSource(std::string const& source)
+{
+  m_file.close();
+  m_buffer   = source;
+  m_source   = m_buffer;
+  m_filename = "<string>";
+
+  m_index       = 0;
+  m_lineStart   = 0;
+  m_line        = 1;
+  m_tokenLine   = 1;
+  m_tokenColumn = 1;
+}
+
+ParserTokenType Tokenizer::getNextToken(std::string_view& token)
+{
+  const char*  data = m_source.data();
+  const size_t size = m_source.size();
+
+  while (true)
+  {
+    // Find first character which is not a whitespace.
+    size_t first = m_index;
+    while (first < size && (data[first] == ' ' || data[first] == '\t'))
+    {
+      ++first;
+    }
+    if (size <= first)
+    {
+      m_index = size;
+      token = std::string_view();
+      return PTT_EOF;
+    }
+
+    // The found character indicates how parsing continues.
+    const char c = data[first];
+
+    if (c == '#') // comment until the next newline
+    {
+      const char* newline = static_cast<const char*>(memchr(data + first, '\n', size - first));
+      if (newline == nullptr)
+      {
+        m_index = size;
+        token = std::string_view();
+        return PTT_EOF;
+      }
+      m_index = (newline - data) + 1; // skip newline
+      m_lineStart = m_index;
+      m_line++;
+    }
+    else if (c == '\r') // carriage return 13
+    {
+      m_index = first + 1;
+    }
+    else if (c == '\n') // newline (linefeed 10)
+    {
+      m_index = first + 1;
+      m_lineStart = m_index;
+      m_line++;
+    }
+    else if (c == '\"') // Quotation mark delimits strings (filenames or material names with spaces.)
+    {
+      const char* quotation = static_cast<const char*>(memchr(data + first + 1, '\"', size - first - 1)); // Find the ending quotation mark. Should be in the same line!
+      if (quotation == nullptr) // Error, no matching end quotation mark found.
+      {
+        m_index = first + 1; // Keep scanning behind the quotation mark.
+      }
+      else
+      {
+        m_tokenLine   = m_line;
+        m_tokenColumn = static_cast<unsigned int>(first - m_lineStart) + 1;
+
+        const size_t last = quotation - data;
+
+        token = std::string_view(data + first + 1, last - first - 1);
+
+        // Keep the line count right if the string did span lines.
+        for (size_t i = first + 1; i < last; ++i)
+        {
+          if (data[i] == '\n')
+          {
+            m_lineStart = i + 1;
+            m_line++;
+          }
+        }
+
+        m_index = last + 1; // Skip the ending quotation mark.
+        return PTT_STRING;
+      }
+    }
+    else // anything else
+    {
+      // Check if the token is only built of characters used for numbers while scanning for its end.
+      // (Not perfectly parsing a floating point number but good enough for most filenames.)
+      bool isValue = (charTable.flags[static_cast<unsigned char>(c)] & CC_VALUE_START) != 0;
+
+      size_t last = first + 1;
+      while (last < size)
+      {
+        const unsigned char flags = charTable.flags[static_cast<unsigned char>(data[last])];
+        if (flags & CC_DELIMITER)
+        {
+          break;
+        }
+        if (!(flags & CC_VALUE))
+        {
+          isValue = false;
+        }
+        ++last;
+      }
+
+      m_tokenLine   = m_line;
+      m_tokenColumn = static_cast<unsigned int>(first - m_lineStart) + 1;
+
+      m_index = last;
+      token = std::string_view(data + first, last - first);
+      return (isValue) ? PTT_VAL : PTT_ID; // Default to general identifier.
+    }
+  }
+}
+
+ParserTokenType Tokenizer::getNextToken(std::string& token)
+{
+  std::string_view view;
+
+  const ParserTokenType type = getNextToken(view);
+
+  token.assign(view.data(), view.size());
+  return type;
+}
+
+std::string::size_type Tokenizer::getSize() const
+{
+  return m_source.size();
+}
+
+std::string::size_type Tokenizer::getIndex() const
+{
+  return m_index;
+}
+
+unsigned int Tokenizer::getLine() const
+{
+  return m_tokenLine;
+}
+
+unsigned int Tokenizer::getColumn() const
+{
+  return m_tokenColumn;
+}
+
+std::string Tokenizer::getLocation() const
+{
+  return m_filename + "(" + std::to_string(m_tokenLine) + "," + std::to_string(m_tokenColumn) + ")";
+}
+
+
+static std::string_view skipSign(std::string_view token)
+{
+  size_t i = 0;
+  while (i < token.size() && (token[i] == ' ' || token[i] == '\t'))
+  {
+    ++i;
+  }
+  // std::from_chars() doesn't accept a plus sign. A second sign is no number, but would be accepted behind it.
+  if (i < token.size() && token[i] == '+')
+  {
+    ++i;
+    if (i < token.size() && (token[i] == '-' || token[i] == '+'))
+    {
+      return std::string_view();
+    }
+  }
+  return token.substr(i);
+}
+
+// strtof() needs a terminated string.
+static float parseFloatTerminated(std::string_view token)
+{
+  char buffer[128];
+  const size_t length = std::min(token.size(), sizeof(buffer) - 1);
+  memcpy(buffer, token.data(), length);
+  buffer[length] = '\0';
+  return strtof(buffer, nullptr);
+}
+
+float parseFloat(std::string_view token)
+{
+  token = skipSign(token);
+
+#if defined(__cpp_lib_to_chars) || (defined(_MSC_VER) && 1924 <= _MSC_VER)
+  float value = 0.0f;
+  const std::from_chars_result result = std::from_chars(token.data(), token.data() + token.size(), value);
+  if (result.ec == std::errc::result_out_of_range)
+  {
+    return parseFloatTerminated(token); // Rare, but keep the atof() infinity and denormal results.
+  }
+  return value;
+#else
+  // Standard libraries without floating point from_chars().
+  return parseFloatTerminated(token);
+#endif
+}
+
+int parseInt(std::string_view token)
+{
+  token = skipSign(token);
+
+  int value = 0;
+  const std::from_chars_result result = std::from_chars(token.data(), token.data() + token.size(), value);
+  if (result.ec == std::errc::result_out_of_range)
+  {
+    return (token[0] == '-') ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+  }
+  return value;
+}
@@ -0,0 +1,190 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include <cuda_runtime.h>
+
+#include "inc/AliasTable.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+  // Selection probability of every bin implied by the thresholds and aliases.
+  std::vector<double> impliedDistribution(std::vector<AliasEntry> const& table)
+  {
+    const double count = double(table.size());
+
+    std::vector<double> probabilities(table.size(), 0.0);
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+      probabilities[i] += double(table[i].threshold) / count;
+      probabilities[table[i].alias] += (1.0 - double(table[i].threshold)) / count;
+    }
+    return probabilities;
+  }
+
+  // Stratified histogram of the selected bins.
+  std::vector<double> sampledDistribution(std::vector<AliasEntry> const& table, const unsigned int numSamples)
+  {
+    std::vector<double> histogram(table.size(), 0.0);
+    for (unsigned int i = 0; i < numSamples; ++i)
+    {
+      const float u = (float(i) + 0.5f) / float(numSamples);
+
+      float pmf;
+      const int index = sampleAliasTable(table.data(), int(table.size()), u, pmf);
+      histogram[index] += 1.0 / double(numSamples);
+
+      CHECK(pmf == table[index].pmf);
+    }
+    return histogram;
+  }
+
+  std::vector<float> randomWeights(const unsigned int count, const unsigned int seed)
+  {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+    std::vector<float> weights(count);
+    for (float& weight : weights)
+    {
+      // Wide dynamic range and some empty bins, like a key light with weak fills and switched off lights.
+      const float u = distribution(generator);
+      weight = (u < 0.1f) ? 0.0f : powf(u, 8.0f) * 1000.0f;
+    }
+    return weights;
+  }
+}
+
+UNIT_TEST(alias_table, distribution)
+{
+  const unsigned int counts[4] = { 1, 2, 7, 1000 };
+
+  for (const unsigned int count : counts)
+  {
+    std::vector<float> weights = randomWeights(count, count);
+    weights[0] = 1.0f; // At least one non-zero weight.
+
+    double sum = 0.0;
+    for (const float weight : weights)
+    {
+      sum += weight;
+    }
+
+    std::vector<AliasEntry> table;
+    const float result = buildAliasTable(weights, table);
+    CHECK(table.size() == count);
+    CHECK_NEAR(result, sum, sum * 1.0e-6);
+
+    const std::vector<double> implied = impliedDistribution(table);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      const double p = double(weights[i]) / sum;
+
+      CHECK_NEAR(table[i].pmf, p, 1.0e-6);
+      CHECK_NEAR(implied[i], p, 1.0e-6);
+      CHECK(0.0f <= table[i].threshold && table[i].threshold <= 1.0f);
+      CHECK(0 <= table[i].alias && table[i].alias < int(count));
+    }
+  }
+}
+
+UNIT_TEST(alias_table, sampling)
+{
+  const unsigned int count = 100;
+  const unsigned int numSamples = 1u << 20;
+
+  const std::vector<float> weights = randomWeights(count, 42);
+
+  std::vector<AliasEntry> table;
+  buildAliasTable(weights, table);
+
+  const std::vector<double> histogram = sampledDistribution(table, numSamples);
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    // Stratified samples, each bin is off by at most two samples per slot boundary.
+    CHECK_NEAR(histogram[i], table[i].pmf, 4.0 * count / double(numSamples));
+    if (weights[i] == 0.0f)
+    {
+      CHECK(histogram[i] == 0.0); // Lights without power are never selected.
+    }
+  }
+}
+
+UNIT_TEST(alias_table, zero_weights)
+{
+  const std::vector<float> weights(5, 0.0f);
+
+  std::vector<AliasEntry> table;
+  CHECK(buildAliasTable(weights, table) == 0.0f);
+
+  // Falls back to the uniform distribution.
+  const std::vector<double> histogram = sampledDistribution(table, 1000);
+  for (unsigned int i = 0; i < 5; ++i)
+  {
+    CHECK_NEAR(table[i].pmf, 0.2f, 1.0e-7);
+    CHECK_NEAR(histogram[i], 0.2, 1.0e-9);
+  }
+}
+
+UNIT_TEST(alias_table, continuous)
+{
+  const unsigned int count = 16;
+  const unsigned int numSamples = 1u << 16;
+
+  const std::vector<float> weights = randomWeights(count, 7);
+
+  std::vector<AliasEntry> table;
+  buildAliasTable(weights, table);
+
+  // The rescaled remainder must be uniform inside the selected bin.
+  std::vector<double> sum(count, 0.0);
+  std::vector<double> hits(count, 0.0);
+  for (unsigned int i = 0; i < numSamples; ++i)
+  {
+    float u = (float(i) + 0.5f) / float(numSamples);
+
+    const int index = sampleAliasTableContinuous(table.data(), int(count), u);
+    CHECK(0.0f <= u && u < 1.0f);
+
+    sum[index]  += u;
+    hits[index] += 1.0;
+  }
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    CHECK_NEAR(hits[i] / double(numSamples), table[i].pmf, 4.0 * count / double(numSamples));
+    if (1000.0 < hits[i])
+    {
+      CHECK_NEAR(sum[i] / hits[i], 0.5, 0.01);
+    }
+  }
+}
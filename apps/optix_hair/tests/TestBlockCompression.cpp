@@ -0,0 +1,234 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/BlockCompression.h"
+#include "inc/HalfFloat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const unsigned int c_width  = 64;
+  const unsigned int c_height = 64;
+
+  // Smooth gradients with some noise and a few hard edges, roughly like the color textures of the scenes.
+  std::vector<unsigned char> createImage(const unsigned int seed)
+  {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> noise(-6, 6);
+
+    std::vector<unsigned char> pixels(c_width * c_height * 4);
+    for (unsigned int y = 0; y < c_height; ++y)
+    {
+      for (unsigned int x = 0; x < c_width; ++x)
+      {
+        const bool edge = ((x / 16) + (y / 16)) & 1;
+
+        const int rgba[4] =
+        {
+          int(x * 4) + noise(generator),
+          int(y * 4) + noise(generator),
+          (edge ? 200 : 40) + noise(generator),
+          (edge ? 255 : int((x + y) * 2)) // Opaque and gradient alpha regions.
+        };
+
+        for (int c = 0; c < 4; ++c)
+        {
+          pixels[(y * c_width + x) * 4 + c] = (unsigned char) std::min(255, std::max(0, rgba[c]));
+        }
+      }
+    }
+    return pixels;
+  }
+
+  // HDR image spanning several orders of magnitude.
+  std::vector<float> createImageHDR()
+  {
+    std::vector<float> pixels(c_width * c_height * 4);
+    for (unsigned int y = 0; y < c_height; ++y)
+    {
+      for (unsigned int x = 0; x < c_width; ++x)
+      {
+        float* rgba = &pixels[(y * c_width + x) * 4];
+
+        const float scale = powf(2.0f, float(y) / 4.0f - 6.0f); // 1/64 to 2^10
+        rgba[0] = scale * (1.0f + float(x) / float(c_width));
+        rgba[1] = scale * 0.5f;
+        rgba[2] = scale * (2.0f - float(x) / float(c_width));
+        rgba[3] = 1.0f;
+      }
+    }
+    return pixels;
+  }
+
+  std::vector<unsigned char> roundTrip(const BlockFormat format, std::vector<unsigned char> const& pixels)
+  {
+    std::vector<unsigned char> blocks(getCompressedSize(format, c_width, c_height));
+    compressBlocks(format, pixels.data(), c_width, c_height, blocks.data());
+
+    std::vector<unsigned char> decoded(pixels.size());
+    decompressBlocks(format, blocks.data(), c_width, c_height, decoded.data());
+    return decoded;
+  }
+
+  // Root mean square error over the channels [first, last).
+  double rmse(std::vector<unsigned char> const& a, std::vector<unsigned char> const& b, const int first, const int last)
+  {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i += 4)
+    {
+      for (int c = first; c < last; ++c)
+      {
+        const double d = double(a[i + c]) - double(b[i + c]);
+        sum += d * d;
+      }
+    }
+    return sqrt(sum / double(a.size() / 4 * (last - first)));
+  }
+}
+
+
+UNIT_TEST(block_compression, sizes)
+{
+  CHECK(getBlockSize(BLOCK_FORMAT_BC1) == 8);
+  CHECK(getBlockSize(BLOCK_FORMAT_BC7) == 16);
+  CHECK(getCompressedSize(BLOCK_FORMAT_BC1, 64, 32) == 16 * 8 * 8);
+  CHECK(getCompressedSize(BLOCK_FORMAT_BC3, 4, 4) == 16);
+}
+
+UNIT_TEST(block_compression, bc1)
+{
+  const std::vector<unsigned char> pixels  = createImage(1);
+  const std::vector<unsigned char> decoded = roundTrip(BLOCK_FORMAT_BC1, pixels);
+
+  CHECK(rmse(pixels, decoded, 0, 3) < 5.0);
+  for (size_t i = 3; i < decoded.size(); i += 4)
+  {
+    CHECK(decoded[i] == 255); // The four color mode is always opaque.
+  }
+}
+
+UNIT_TEST(block_compression, bc3)
+{
+  const std::vector<unsigned char> pixels  = createImage(2);
+  const std::vector<unsigned char> decoded = roundTrip(BLOCK_FORMAT_BC3, pixels);
+
+  CHECK(rmse(pixels, decoded, 0, 3) < 5.0);
+  CHECK(rmse(pixels, decoded, 3, 4) < 1.5);
+}
+
+UNIT_TEST(block_compression, bc5)
+{
+  const std::vector<unsigned char> pixels  = createImage(3);
+  const std::vector<unsigned char> decoded = roundTrip(BLOCK_FORMAT_BC5, pixels);
+
+  CHECK(rmse(pixels, decoded, 0, 2) < 1.5);
+}
+
+UNIT_TEST(block_compression, bc7)
+{
+  const std::vector<unsigned char> pixels  = createImage(4);
+  const std::vector<unsigned char> decoded = roundTrip(BLOCK_FORMAT_BC7, pixels);
+
+  CHECK(rmse(pixels, decoded, 0, 4) < 4.0);
+}
+
+UNIT_TEST(block_compression, bc7_constant)
+{
+  // A uniform color must survive up to the rounding of the 7-bit endpoints with p-bit.
+  std::vector<unsigned char> pixels(c_width * c_height * 4);
+  for (size_t i = 0; i < pixels.size(); i += 4)
+  {
+    pixels[i + 0] = 37;
+    pixels[i + 1] = 140;
+    pixels[i + 2] = 222;
+    pixels[i + 3] = 255;
+  }
+  const std::vector<unsigned char> decoded = roundTrip(BLOCK_FORMAT_BC7, pixels);
+
+  CHECK(rmse(pixels, decoded, 0, 4) <= 1.0);
+}
+
+UNIT_TEST(block_compression, bc6h)
+{
+  const std::vector<float> pixels = createImageHDR();
+
+  std::vector<unsigned char> blocks(getCompressedSize(BLOCK_FORMAT_BC6H, c_width, c_height));
+  compressBlocks(BLOCK_FORMAT_BC6H, pixels.data(), c_width, c_height, blocks.data());
+
+  std::vector<float> decoded(pixels.size());
+  decompressBlocks(BLOCK_FORMAT_BC6H, blocks.data(), c_width, c_height, decoded.data());
+
+  // The error is relative since the blocks span very different magnitudes.
+  double sum = 0.0;
+  double worst = 0.0;
+  for (size_t i = 0; i < pixels.size(); i += 4)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      const double relative = fabs(double(decoded[i + c]) - double(pixels[i + c])) / double(pixels[i + c]);
+      sum += relative * relative;
+      worst = std::max(worst, relative);
+    }
+  }
+  const double relativeRMS = sqrt(sum / double(pixels.size() / 4 * 3));
+
+  CHECK(relativeRMS < 0.025);
+  CHECK(worst < 0.1);
+}
+
+UNIT_TEST(block_compression, cache)
+{
+  const std::vector<unsigned char> pixels = createImage(5);
+
+  std::vector<BlockLevel> levels(1);
+  levels[0].pixels = pixels.data();
+  levels[0].width  = c_width;
+  levels[0].height = c_height;
+
+  const std::string filename("optix_hair_test_blocks.bin");
+  std::remove(filename.c_str());
+
+  std::vector< std::vector<unsigned char> > written;
+  compressLevels(BLOCK_FORMAT_BC7, levels, written, filename); // Encodes and writes the cache.
+
+  std::vector< std::vector<unsigned char> > read;
+  compressLevels(BLOCK_FORMAT_BC7, levels, read, filename);    // Loads the cache.
+
+  CHECK(written.size() == 1 && read.size() == 1);
+  CHECK(written == read);
+
+  std::remove(filename.c_str());
+}
@@ -0,0 +1,501 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/CompiledScene.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+  // Records the device work of applyScene() and applySceneDiff(), which Device::initScene() and Device::updateScene() run, without a GPU.
+  // A GAS is the copy of the attributes it was built from plus a serial number standing in for the traversable handle.
+  class StubDevice : public SceneTarget
+  {
+  public:
+    StubDevice()
+    : m_serial(0)
+    , m_tlasBuilt(false)
+    , m_sbtRebuilt(false)
+    {
+    }
+
+    void initScene(CompiledScene const& scene)
+    {
+      applyScene(scene, *this);
+    }
+
+    void updateScene(CompiledScene const& scene, SceneDiff const& diff)
+    {
+      m_freed.clear();
+      m_built.clear();
+      m_tlasBuilt  = false;
+      m_sbtRebuilt = false;
+      m_recordsWritten.clear();
+
+      applySceneDiff(scene, diff, *this);
+    }
+
+    // The device data is what a full initScene() of the current compilation would produce, up to the serial numbers.
+    bool isConsistent(CompiledScene const& scene) const
+    {
+      std::vector<CompiledInstance> const& instances = scene.getInstances();
+
+      if (m_tlas.size() != instances.size() || m_records.size() != instances.size() || m_instanceData.size() != instances.size())
+      {
+        return false;
+      }
+
+      for (size_t i = 0; i < instances.size(); ++i)
+      {
+        InstanceData const& data = instances[i].data;
+
+        if (m_gas.size() <= data.idGeometry)
+        {
+          return false;
+        }
+        Gas const& gas = m_gas[data.idGeometry];
+
+        std::vector<VertexAttributes> const& attributes = *scene.getGeometries()[data.idGeometry].attributes;
+
+        if (gas.serial == 0 ||
+            gas.attributes.size() != attributes.size() ||
+            memcmp(gas.attributes.data(), attributes.data(), sizeof(VertexAttributes) * attributes.size()) != 0)
+        {
+          return false; // Missing or stale GAS.
+        }
+        if (m_tlas[i].serial != gas.serial || memcmp(m_tlas[i].matrix, instances[i].matrix, sizeof(float) * 12) != 0)
+        {
+          return false;
+        }
+        if (!isEqual(m_instanceData[i], data) || !isEqual(m_records[i].data, data) || m_records[i].serial != gas.serial)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool isGeometryBuilt(const unsigned int idGeometry) const
+    {
+      return idGeometry < m_gas.size() && m_gas[idGeometry].serial != 0;
+    }
+
+    std::vector<unsigned int> const& getFreed() const          { return m_freed; }
+    std::vector<unsigned int> const& getBuilt() const          { return m_built; }
+    bool                             isTlasBuilt() const       { return m_tlasBuilt; }
+    bool                             isSbtRebuilt() const      { return m_sbtRebuilt; }
+    std::vector<unsigned int> const& getRecordsWritten() const { return m_recordsWritten; }
+
+    // No device work at all in the last updateScene().
+    bool isIdle() const
+    {
+      return m_freed.empty() && m_built.empty() && !m_tlasBuilt && !m_sbtRebuilt && m_recordsWritten.empty();
+    }
+
+  private:
+    struct Gas
+    {
+      Gas()
+      : serial(0)
+      {
+      }
+
+      unsigned int                  serial; // 0 when there is no GAS.
+      std::vector<VertexAttributes> attributes;
+    };
+
+    struct TlasEntry
+    {
+      float        matrix[12];
+      unsigned int serial;
+    };
+
+    struct Record
+    {
+      InstanceData data;
+      unsigned int serial; // The geometry buffers the record points to.
+    };
+
+    static bool isEqual(InstanceData const& a, InstanceData const& b)
+    {
+      return a.idGeometry == b.idGeometry && a.idMaterial == b.idMaterial && a.idLight == b.idLight;
+    }
+
+  public:
+    // SceneTarget
+    size_t getNumGeometries() const
+    {
+      return m_gas.size();
+    }
+
+    void setNumGeometries(const size_t numGeometries)
+    {
+      m_gas.resize(numGeometries);
+    }
+
+    void freeGeometry(const unsigned int idGeometry)
+    {
+      if (m_gas[idGeometry].serial != 0)
+      {
+        m_gas[idGeometry] = Gas();
+        m_freed.push_back(idGeometry);
+      }
+    }
+
+    void buildGeometry(const unsigned int idGeometry, CompiledGeometry const& geometry)
+    {
+      m_gas[idGeometry].serial     = ++m_serial;
+      m_gas[idGeometry].attributes = *geometry.attributes;
+      m_built.push_back(idGeometry);
+    }
+
+    void buildInstances(CompiledScene const& scene)
+    {
+      m_tlas.clear();
+      m_instanceData.clear();
+
+      for (CompiledInstance const& instance : scene.getInstances())
+      {
+        TlasEntry entry;
+        memcpy(entry.matrix, instance.matrix, sizeof(float) * 12);
+        entry.serial = m_gas[instance.data.idGeometry].serial;
+
+        m_tlas.push_back(entry);
+        m_instanceData.push_back(instance.data);
+      }
+      m_tlasBuilt = true;
+    }
+
+    void setInstanceData(const unsigned int idInstance, InstanceData const& data)
+    {
+      m_instanceData[idInstance] = data;
+    }
+
+    void buildRecords()
+    {
+      m_records.clear();
+      for (size_t i = 0; i < m_instanceData.size(); ++i)
+      {
+        m_records.push_back(createRecord(i));
+      }
+      m_sbtRebuilt = true;
+    }
+
+    void updateRecord(const unsigned int idInstance)
+    {
+      m_records[idInstance] = createRecord(idInstance);
+      m_recordsWritten.push_back(idInstance);
+    }
+
+  private:
+    Record createRecord(const size_t idInstance) const
+    {
+      return Record{ m_instanceData[idInstance], m_gas[m_instanceData[idInstance].idGeometry].serial };
+    }
+
+  private:
+    unsigned int              m_serial;
+    std::vector<Gas>          m_gas; // Indexed by the geometry ID.
+    std::vector<TlasEntry>    m_tlas;
+    std::vector<InstanceData> m_instanceData;
+    std::vector<Record>       m_records;
+
+    // What the last updateScene() did.
+    std::vector<unsigned int> m_freed;
+    std::vector<unsigned int> m_built;
+    bool                      m_tlasBuilt;
+    bool                      m_sbtRebuilt;
+    std::vector<unsigned int> m_recordsWritten;
+  };
+
+  std::shared_ptr<sg::Instance> createInstance(const unsigned int id, std::shared_ptr<sg::Node> const& child, const int material)
+  {
+    std::shared_ptr<sg::Instance> instance = std::make_shared<sg::Instance>(id);
+    instance->setChild(child);
+    instance->setMaterial(material);
+    return instance;
+  }
+
+  std::shared_ptr<sg::Triangles> createBox(const unsigned int id, const float scale)
+  {
+    std::shared_ptr<sg::Triangles> box = std::make_shared<sg::Triangles>(id);
+    box->createBox();
+
+    std::vector<VertexAttributes> attributes = box->getAttributes();
+    for (VertexAttributes& attribute : attributes)
+    {
+      attribute.vertex = attribute.vertex * scale;
+    }
+    box->setAttributes(attributes);
+    return box;
+  }
+
+  // root
+  //   instance 0, material 0 -> box 0
+  //   instance 1, material 1 -> box 0, translated
+  //   instance 2, material 2 -> group -> instance 3 -> box 1
+  // Box 2 is not referenced.
+  struct TestScene
+  {
+    TestScene()
+    {
+      root  = std::make_shared<sg::Group>(0);
+      group = std::make_shared<sg::Group>(1);
+
+      for (unsigned int id = 0; id < 3; ++id)
+      {
+        boxes.push_back(createBox(id, float(id + 1)));
+      }
+
+      instances.push_back(createInstance(0, boxes[0], 0));
+      instances.push_back(createInstance(1, boxes[0], 1));
+      instances.push_back(createInstance(2, group, 2));
+      instances.push_back(createInstance(3, boxes[1], -1));
+
+      const float translation[12] = { 1.0f, 0.0f, 0.0f, 5.0f,
+                                      0.0f, 1.0f, 0.0f, 0.0f,
+                                      0.0f, 0.0f, 1.0f, 0.0f };
+      instances[1]->setTransform(translation);
+
+      root->addChild(instances[0]);
+      root->addChild(instances[1]);
+      root->addChild(instances[2]);
+      group->addChild(instances[3]);
+
+      scene.compile(root, 3);
+      device.initScene(scene);
+    }
+
+    SceneDiff update(const unsigned int numGeometries = 3)
+    {
+      const SceneDiff diff = scene.update(root, numGeometries);
+      device.updateScene(scene, diff);
+      return diff;
+    }
+
+    std::shared_ptr<sg::Group>                   root;
+    std::shared_ptr<sg::Group>                   group;
+    std::vector< std::shared_ptr<sg::Triangles> > boxes;
+    std::vector< std::shared_ptr<sg::Instance> >  instances;
+
+    CompiledScene scene;
+    StubDevice    device;
+  };
+}
+
+
+UNIT_TEST(scene_diff, compile)
+{
+  TestScene test;
+
+  CHECK(test.scene.getInstances().size() == 3);
+  CHECK(test.scene.getInstances()[2].data.idGeometry == 1);
+  CHECK(test.scene.getInstances()[2].data.idMaterial == 2); // Inherited from instance 2.
+  CHECK(test.scene.getInstances()[1].matrix[3] == 5.0f);
+  CHECK(!test.scene.getGeometries()[2].node);
+  CHECK(test.device.isConsistent(test.scene));
+  CHECK(test.device.isGeometryBuilt(0) && test.device.isGeometryBuilt(1) && !test.device.isGeometryBuilt(2));
+}
+
+UNIT_TEST(scene_diff, no_op)
+{
+  TestScene test;
+
+  const SceneDiff diff = test.update();
+
+  CHECK(diff.isEmpty());
+  CHECK(test.device.isIdle());
+  CHECK(test.device.isConsistent(test.scene));
+
+  // Setting a value which is already set raises the change flag, but the instance table compares equal.
+  test.instances[1]->setMaterial(1);
+  CHECK(test.update().isEmpty());
+  CHECK(test.device.isIdle());
+}
+
+UNIT_TEST(scene_diff, toggle)
+{
+  TestScene test;
+
+  // Switching off the group instance removes its instance but keeps the GAS of box 1 for switching it on again.
+  test.instances[2]->set_activation(false);
+  SceneDiff diff = test.update();
+
+  CHECK(diff.instancesChanged && diff.recordsResized);
+  CHECK(diff.geometriesBuilt.empty() && diff.geometriesRemoved.empty());
+  CHECK(test.device.isTlasBuilt() && test.device.isSbtRebuilt());
+  CHECK(test.device.getFreed().empty() && test.device.getBuilt().empty());
+  CHECK(test.scene.getInstances().size() == 2);
+  CHECK(test.device.isGeometryBuilt(1));
+  CHECK(test.device.isConsistent(test.scene));
+
+  test.instances[2]->set_activation(true);
+  diff = test.update();
+
+  CHECK(diff.instancesChanged && diff.recordsResized);
+  CHECK(test.device.getBuilt().empty());
+  CHECK(test.scene.getInstances().size() == 3);
+  CHECK(test.device.isConsistent(test.scene));
+}
+
+UNIT_TEST(scene_diff, transform)
+{
+  TestScene test;
+
+  const float matrix[12] = { 2.0f, 0.0f, 0.0f, 0.0f,
+                             0.0f, 2.0f, 0.0f, 1.0f,
+                             0.0f, 0.0f, 2.0f, 0.0f };
+  test.instances[3]->setTransform(matrix); // Nested below the group.
+  const SceneDiff diff = test.update();
+
+  CHECK(diff.instancesChanged && !diff.recordsResized);
+  CHECK(diff.recordsChanged.empty()); // The hit group records don't depend on the transform.
+  CHECK(diff.geometriesBuilt.empty());
+  CHECK(test.device.isTlasBuilt() && !test.device.isSbtRebuilt() && test.device.getRecordsWritten().empty());
+  CHECK(test.scene.getInstances()[2].matrix[7] == 1.0f);
+  CHECK(test.device.isConsistent(test.scene));
+}
+
+UNIT_TEST(scene_diff, material)
+{
+  TestScene test;
+
+  test.instances[1]->setMaterial(7);
+  const SceneDiff diff = test.update();
+
+  CHECK(!diff.instancesChanged && !diff.recordsResized);
+  CHECK(diff.recordsChanged.size() == 1 && diff.recordsChanged[0] == 1);
+  CHECK(!test.device.isTlasBuilt() && !test.device.isSbtRebuilt());
+  CHECK(test.device.getRecordsWritten() == std::vector<unsigned int>(1, 1));
+  CHECK(test.device.isConsistent(test.scene));
+
+  // A material on the group instance changes the record of the nested geometry instance.
+  test.instances[2]->setMaterial(3);
+  test.update();
+  CHECK(test.device.getRecordsWritten() == std::vector<unsigned int>(1, 2));
+  CHECK(test.scene.getInstances()[2].data.idMaterial == 3);
+  CHECK(test.device.isConsistent(test.scene));
+}
+
+UNIT_TEST(scene_diff, geometry_replaced)
+{
+  TestScene test;
+
+  // Instance 0 switches to the unreferenced box 2, box 0 stays referenced by instance 1.
+  test.instances[0]->setChild(test.boxes[2]);
+  SceneDiff diff = test.update();
+
+  CHECK(diff.geometriesBuilt == std::vector<unsigned int>(1, 2));
+  CHECK(diff.geometriesRemoved.empty());
+  CHECK(diff.instancesChanged && !diff.recordsResized);
+  CHECK(diff.recordsChanged == std::vector<unsigned int>(1, 0));
+  CHECK(test.device.getBuilt() == std::vector<unsigned int>(1, 2));
+  CHECK(test.device.isTlasBuilt());
+  CHECK(test.device.isConsistent(test.scene));
+
+  // A new node under an existing geometry ID, like the hair model switch does, needs a new GAS for that ID.
+  std::shared_ptr<sg::Triangles> replacement = createBox(1, 10.0f);
+  test.instances[3]->setChild(replacement);
+  diff = test.update();
+
+  CHECK(diff.geometriesBuilt == std::vector<unsigned int>(1, 1));
+  CHECK(test.device.getFreed() == std::vector<unsigned int>(1, 1));
+  CHECK(diff.recordsChanged == std::vector<unsigned int>(1, 2));
+  CHECK(test.device.isConsistent(test.scene));
+
+  // Dropping the geometry IDs beyond the new count frees their GAS.
+  test.instances[0]->setChild(test.boxes[0]);
+  diff = test.update(2);
+
+  CHECK(diff.geometriesRemoved == std::vector<unsigned int>(1, 2));
+  CHECK(!test.device.isGeometryBuilt(2));
+  CHECK(test.device.isConsistent(test.scene));
+}
+
+UNIT_TEST(scene_diff, geometry_edited)
+{
+  TestScene test;
+
+  // Box 0 is instanced twice, both instances need new records and the TLAS the new traversable.
+  std::vector<VertexAttributes> attributes = test.boxes[0]->getAttributes();
+  attributes[0].vertex.x += 1.0f;
+  test.boxes[0]->setAttributes(attributes);
+
+  SceneDiff diff = test.update();
+
+  CHECK(diff.geometriesBuilt == std::vector<unsigned int>(1, 0));
+  CHECK(diff.instancesChanged && !diff.recordsResized);
+  CHECK(diff.recordsChanged.size() == 2 && diff.recordsChanged[0] == 0 && diff.recordsChanged[1] == 1);
+  CHECK(test.device.getBuilt() == std::vector<unsigned int>(1, 0));
+  CHECK(test.device.isConsistent(test.scene));
+
+  // Editing a geometry which is switched off drops its GAS, switching it on again builds it.
+  test.instances[2]->set_activation(false);
+  test.update();
+
+  test.boxes[1]->setAttributes(attributes);
+  diff = test.update();
+
+  CHECK(diff.geometriesRemoved == std::vector<unsigned int>(1, 1));
+  CHECK(!diff.instancesChanged);
+  CHECK(!test.device.isGeometryBuilt(1));
+
+  test.instances[2]->set_activation(true);
+  diff = test.update();
+
+  CHECK(diff.geometriesBuilt == std::vector<unsigned int>(1, 1));
+  CHECK(test.device.isConsistent(test.scene));
+}
+
+UNIT_TEST(scene_diff, instance_added)
+{
+  TestScene test;
+
+  test.root->addChild(createInstance(4, test.boxes[2], 4));
+  SceneDiff diff = test.update();
+
+  CHECK(diff.instancesChanged && diff.recordsResized);
+  CHECK(diff.recordsChanged.empty());
+  CHECK(diff.geometriesBuilt == std::vector<unsigned int>(1, 2));
+  CHECK(test.device.isTlasBuilt() && test.device.isSbtRebuilt());
+  CHECK(test.scene.getInstances().size() == 4);
+  CHECK(test.device.isConsistent(test.scene));
+
+  // Another instance of an already built geometry doesn't build a GAS.
+  test.group->addChild(createInstance(5, test.boxes[0], -1));
+  diff = test.update();
+
+  CHECK(diff.geometriesBuilt.empty());
+  CHECK(test.device.getBuilt().empty());
+  CHECK(test.scene.getInstances().size() == 5);
+  CHECK(test.device.isConsistent(test.scene));
+}
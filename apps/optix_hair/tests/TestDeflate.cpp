@@ -0,0 +1,803 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/Deflate.h"
+#include "inc/ExrWriter.h"
+#include "inc/HalfFloat.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const char* c_filename = "optix_hair_test_image.exr";
+
+  // Reference inflate (RFC 1951) written straight from the specification, independent of the encoder tables.
+  class Inflater
+  {
+  public:
+    Inflater(const unsigned char* data, const size_t size)
+    : m_data(data)
+    , m_size(size)
+    , m_pos(0)
+    , m_bits(0)
+    , m_count(0)
+    , m_error(false)
+    {
+    }
+
+    bool inflate(std::vector<unsigned char>& out)
+    {
+      int last = 0;
+      do
+      {
+        last = bits(1);
+        const int type = bits(2);
+        if (type == 0)
+        {
+          stored(out);
+        }
+        else if (type == 1)
+        {
+          fixed(out);
+        }
+        else if (type == 2)
+        {
+          dynamic(out);
+        }
+        else
+        {
+          m_error = true;
+        }
+      } while (!last && !m_error);
+      return !m_error;
+    }
+
+    // Number of bytes consumed, the unused bits of the last byte are padding.
+    size_t getPosition() const
+    {
+      return m_pos;
+    }
+
+  private:
+    struct Huffman
+    {
+      int count[16];
+      int symbol[288];
+    };
+
+    int bits(const int count)
+    {
+      uint32_t value = m_bits;
+      while (m_count < count)
+      {
+        if (m_size <= m_pos)
+        {
+          m_error = true;
+          return 0;
+        }
+        value |= uint32_t(m_data[m_pos++]) << m_count;
+        m_count += 8;
+      }
+      m_bits   = value >> count;
+      m_count -= count;
+      return int(value & ((1u << count) - 1));
+    }
+
+    // Returns 0 for a complete code, a positive value for an incomplete code and a negative value for an over-subscribed code.
+    static int construct(Huffman& h, const int* lengths, const int n)
+    {
+      memset(h.count, 0, sizeof(h.count));
+      for (int i = 0; i < n; ++i)
+      {
+        ++h.count[lengths[i]];
+      }
+      if (h.count[0] == n)
+      {
+        return 0;
+      }
+
+      int left = 1;
+      for (int length = 1; length < 16; ++length)
+      {
+        left <<= 1;
+        left -= h.count[length];
+        if (left < 0)
+        {
+          return left;
+        }
+      }
+
+      int offsets[16];
+      offsets[1] = 0;
+      for (int length = 1; length < 15; ++length)
+      {
+        offsets[length + 1] = offsets[length] + h.count[length];
+      }
+      for (int i = 0; i < n; ++i)
+      {
+        if (lengths[i] != 0)
+        {
+          h.symbol[offsets[lengths[i]]++] = i;
+        }
+      }
+      return left;
+    }
+
+    int decode(Huffman const& h)
+    {
+      int code  = 0;
+      int first = 0;
+      int index = 0;
+      for (int length = 1; length < 16; ++length)
+      {
+        code |= bits(1);
+        const int count = h.count[length];
+        if (code - count < first)
+        {
+          return h.symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code  <<= 1;
+      }
+      m_error = true;
+      return -1;
+    }
+
+    void stored(std::vector<unsigned char>& out)
+    {
+      m_bits  = 0; // Skip to the byte boundary.
+      m_count = 0;
+      if (m_size < m_pos + 4)
+      {
+        m_error = true;
+        return;
+      }
+      const unsigned int length = m_data[m_pos] | (m_data[m_pos + 1] << 8);
+      const unsigned int check  = m_data[m_pos + 2] | (m_data[m_pos + 3] << 8);
+      m_pos += 4;
+      if (length != (~check & 0xFFFF) || m_size < m_pos + length)
+      {
+        m_error = true;
+        return;
+      }
+      out.insert(out.end(), m_data + m_pos, m_data + m_pos + length);
+      m_pos += length;
+    }
+
+    void codes(std::vector<unsigned char>& out, Huffman const& lengthCode, Huffman const& distanceCode)
+    {
+      static const int lengthBase[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+      static const int lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+      static const int distBase[30]    = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                           1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+      static const int distExtra[30]   = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+      while (!m_error)
+      {
+        int symbol = decode(lengthCode);
+        if (symbol < 256)
+        {
+          if (0 <= symbol)
+          {
+            out.push_back((unsigned char) symbol);
+          }
+          continue;
+        }
+        if (symbol == 256)
+        {
+          return;
+        }
+        symbol -= 257;
+        if (29 <= symbol)
+        {
+          m_error = true;
+          return;
+        }
+        const int length = lengthBase[symbol] + bits(lengthExtra[symbol]);
+
+        const int symbolDist = decode(distanceCode);
+        if (symbolDist < 0 || 30 <= symbolDist)
+        {
+          m_error = true;
+          return;
+        }
+        const size_t distance = size_t(distBase[symbolDist] + bits(distExtra[symbolDist]));
+        if (out.size() < distance)
+        {
+          m_error = true;
+          return;
+        }
+        for (int i = 0; i < length; ++i)
+        {
+          out.push_back(out[out.size() - distance]);
+        }
+      }
+    }
+
+    void fixed(std::vector<unsigned char>& out)
+    {
+      int lengths[288];
+      for (int i = 0; i < 288; ++i)
+      {
+        lengths[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+      }
+      Huffman lengthCode;
+      construct(lengthCode, lengths, 288);
+
+      for (int i = 0; i < 30; ++i)
+      {
+        lengths[i] = 5;
+      }
+      Huffman distanceCode;
+      construct(distanceCode, lengths, 30);
+
+      codes(out, lengthCode, distanceCode);
+    }
+
+    void dynamic(std::vector<unsigned char>& out)
+    {
+      static const int order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+      const int numLength   = bits(5) + 257;
+      const int numDistance = bits(5) + 1;
+      const int numCode     = bits(4) + 4;
+      if (286 < numLength || 30 < numDistance)
+      {
+        m_error = true;
+        return;
+      }
+
+      int lengths[320] = {};
+      for (int i = 0; i < numCode; ++i)
+      {
+        lengths[order[i]] = bits(3);
+      }
+      Huffman codeLengthCode;
+      if (construct(codeLengthCode, lengths, 19) != 0) // The code length code must be complete.
+      {
+        m_error = true;
+        return;
+      }
+
+      int index = 0;
+      while (index < numLength + numDistance && !m_error)
+      {
+        int symbol = decode(codeLengthCode);
+        if (symbol < 16)
+        {
+          lengths[index++] = symbol;
+          continue;
+        }
+        int value = 0;
+        int count = 0;
+        if (symbol == 16)
+        {
+          if (index == 0)
+          {
+            m_error = true;
+            return;
+          }
+          value = lengths[index - 1];
+          count = 3 + bits(2);
+        }
+        else if (symbol == 17)
+        {
+          count = 3 + bits(3);
+        }
+        else
+        {
+          count = 11 + bits(7);
+        }
+        if (numLength + numDistance < index + count)
+        {
+          m_error = true;
+          return;
+        }
+        while (count--)
+        {
+          lengths[index++] = value;
+        }
+      }
+      if (m_error || lengths[256] == 0)
+      {
+        m_error = true;
+        return;
+      }
+
+      // Incomplete codes are only allowed for a single symbol.
+      Huffman lengthCode;
+      int left = construct(lengthCode, lengths, numLength);
+      if (left < 0 || (0 < left && numLength - lengthCode.count[0] != 1))
+      {
+        m_error = true;
+        return;
+      }
+      Huffman distanceCode;
+      left = construct(distanceCode, lengths + numLength, numDistance);
+      if (left < 0 || (0 < left && numDistance - distanceCode.count[0] != 1))
+      {
+        m_error = true;
+        return;
+      }
+
+      codes(out, lengthCode, distanceCode);
+    }
+
+    const unsigned char* m_data;
+    size_t   m_size;
+    size_t   m_pos;
+    uint32_t m_bits;
+    int      m_count;
+    bool     m_error;
+  };
+
+  uint32_t adler32(std::vector<unsigned char> const& data)
+  {
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (const unsigned char c : data)
+    {
+      a = (a + c) % 65521;
+      b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+  }
+
+  // Checks the zlib header, the deflate stream and the Adler-32 trailer.
+  bool inflateZlib(const unsigned char* data, const size_t size, std::vector<unsigned char>& out)
+  {
+    out.clear();
+    if (size < 6 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0)
+    {
+      return false;
+    }
+
+    Inflater inflater(data + 2, size - 6);
+    if (!inflater.inflate(out) || inflater.getPosition() != size - 6)
+    {
+      return false;
+    }
+
+    const unsigned char* trailer = data + size - 4;
+    const uint32_t adler = (uint32_t(trailer[0]) << 24) | (uint32_t(trailer[1]) << 16) | (uint32_t(trailer[2]) << 8) | uint32_t(trailer[3]);
+    return adler == adler32(out);
+  }
+
+  // The source is copied into a buffer of exactly its size, so reads behind the end show up in checked builds.
+  bool roundTrip(std::vector<unsigned char> const& data, const int effort)
+  {
+    std::vector<unsigned char> src(data);
+    std::vector<unsigned char> compressed;
+    compressZlib(src.data(), src.size(), compressed, effort);
+
+    std::vector<unsigned char> result;
+    return inflateZlib(compressed.data(), compressed.size(), result) && result == data;
+  }
+
+  bool roundTripAllEfforts(std::vector<unsigned char> const& data)
+  {
+    bool result = true;
+    for (int effort = 1; effort <= 9; ++effort)
+    {
+      result = roundTrip(data, effort) && result;
+    }
+    return result;
+  }
+
+  std::vector<unsigned char> randomBytes(const size_t size, const unsigned int seed)
+  {
+    std::mt19937 generator(seed);
+    std::vector<unsigned char> data(size);
+    for (unsigned char& c : data)
+    {
+      c = (unsigned char) (generator() & 0xFF);
+    }
+    return data;
+  }
+
+
+  // Little endian reader over the EXR file.
+  class ExrReader
+  {
+  public:
+    explicit ExrReader(std::vector<unsigned char> const& data)
+    : m_data(data)
+    , m_pos(0)
+    , m_error(false)
+    {
+    }
+
+    uint32_t u32()
+    {
+      uint32_t value = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        value |= uint32_t(u8()) << (8 * i);
+      }
+      return value;
+    }
+
+    uint64_t u64()
+    {
+      const uint64_t low = u32();
+      return low | (uint64_t(u32()) << 32);
+    }
+
+    unsigned char u8()
+    {
+      if (m_data.size() <= m_pos)
+      {
+        m_error = true;
+        return 0;
+      }
+      return m_data[m_pos++];
+    }
+
+    std::string str()
+    {
+      std::string value;
+      for (unsigned char c = u8(); c != 0 && !m_error; c = u8())
+      {
+        value.push_back(char(c));
+      }
+      return value;
+    }
+
+    std::vector<unsigned char> bytes(const size_t size)
+    {
+      if (m_data.size() - m_pos < size)
+      {
+        m_error = true;
+        return std::vector<unsigned char>();
+      }
+      std::vector<unsigned char> value(m_data.begin() + m_pos, m_data.begin() + m_pos + size);
+      m_pos += size;
+      return value;
+    }
+
+    size_t getPosition() const
+    {
+      return m_pos;
+    }
+
+    void setPosition(const size_t pos)
+    {
+      m_error = m_error || m_data.size() < pos;
+      m_pos   = pos;
+    }
+
+    bool isValid() const
+    {
+      return !m_error;
+    }
+
+  private:
+    std::vector<unsigned char> const& m_data;
+    size_t m_pos;
+    bool   m_error;
+  };
+
+  void decompressRLE(std::vector<unsigned char> const& src, std::vector<unsigned char>& dst)
+  {
+    dst.clear();
+    size_t i = 0;
+    while (i < src.size())
+    {
+      const int count = (signed char) src[i++];
+      if (count < 0)
+      {
+        for (int j = 0; j < -count && i < src.size(); ++j)
+        {
+          dst.push_back(src[i++]);
+        }
+      }
+      else if (i < src.size())
+      {
+        dst.insert(dst.end(), size_t(count) + 1, src[i++]);
+      }
+    }
+  }
+
+  // Inverse of the byte delta predictor and the split into even and odd bytes.
+  void unpredict(std::vector<unsigned char> const& src, std::vector<unsigned char>& dst)
+  {
+    std::vector<unsigned char> t(src);
+    for (size_t i = 1; i < t.size(); ++i)
+    {
+      t[i] = (unsigned char) (t[i - 1] + t[i] - 128);
+    }
+
+    dst.resize(t.size());
+    const size_t half = (t.size() + 1) / 2;
+    for (size_t i = 0; i < t.size(); ++i)
+    {
+      dst[i] = (i & 1) ? t[half + i / 2] : t[i / 2];
+    }
+  }
+
+  // Smooth gradients with a noisy region, which doesn't compress, and constant rows, which compress with every method.
+  std::vector<float> createImage(const unsigned int width, const unsigned int height, const unsigned int numComponents)
+  {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> noise(0.0f, 100.0f);
+
+    std::vector<float> image(size_t(width) * height * numComponents);
+    for (unsigned int y = 0; y < height; ++y)
+    {
+      for (unsigned int x = 0; x < width; ++x)
+      {
+        for (unsigned int c = 0; c < numComponents; ++c)
+        {
+          float& value = image[(size_t(y) * width + x) * numComponents + c];
+          if (x < 8 && y < 8)
+          {
+            value = noise(generator);
+          }
+          else
+          {
+            value = (y < height - 4) ? float(x + c) / float(width) + float(y) * 0.25f : 0.5f;
+          }
+        }
+      }
+    }
+    return image;
+  }
+
+  // Writes the image, parses the file, and compares the decoded blocks with the expected scanline bytes.
+  void checkEXR(const bool half, const ExrCompression compression)
+  {
+    const unsigned int width  = 37;
+    const unsigned int height = 21; // Not a multiple of the 16 scanline ZIP blocks.
+
+    const std::vector<float> rgba     = createImage(width, height, 4);
+    const std::vector<float> variance = createImage(width, height, 1);
+
+    CHECK(writeEXR(c_filename, width, height, rgba.data(), variance.data(), "variance", half, compression));
+
+    std::ifstream input(c_filename, std::ios::binary);
+    const std::vector<unsigned char> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+    std::remove(c_filename);
+
+    ExrReader reader(file);
+    CHECK(reader.u32() == 20000630);
+    CHECK(reader.u32() == 2);
+
+    std::map< std::string, std::pair< std::string, std::vector<unsigned char> > > attributes;
+    for (std::string name = reader.str(); !name.empty() && reader.isValid(); name = reader.str())
+    {
+      const std::string type = reader.str();
+      const uint32_t    size = reader.u32();
+      attributes[name] = std::make_pair(type, reader.bytes(size));
+    }
+    CHECK(reader.isValid());
+    CHECK(attributes.size() == 8);
+
+    CHECK(attributes["compression"].first == "compression");
+    CHECK(attributes["compression"].second == std::vector<unsigned char>(1, (unsigned char) compression));
+    CHECK(attributes["lineOrder"].second == std::vector<unsigned char>(1, 0));
+
+    // Channels in alphabetical order, all with the same pixel type and no subsampling.
+    std::vector<std::string> names;
+    {
+      std::vector<unsigned char> const& list = attributes["channels"].second;
+      ExrReader channels(list);
+      for (std::string name = channels.str(); !name.empty() && channels.isValid(); name = channels.str())
+      {
+        names.push_back(name);
+        CHECK(channels.u32() == ((half) ? 1u : 2u));
+        CHECK(channels.u32() == 0);
+        CHECK(channels.u32() == 1);
+        CHECK(channels.u32() == 1);
+      }
+      CHECK(channels.isValid() && channels.getPosition() == list.size());
+      CHECK(attributes["channels"].first == "chlist");
+    }
+    CHECK(names == std::vector<std::string>({ "A", "B", "G", "R", "variance" }));
+
+    for (const char* window : { "dataWindow", "displayWindow" })
+    {
+      std::vector<unsigned char> const& box = attributes[window].second;
+      ExrReader values(box);
+      CHECK(attributes[window].first == "box2i");
+      CHECK(values.u32() == 0 && values.u32() == 0 && values.u32() == width - 1 && values.u32() == height - 1);
+    }
+
+    const unsigned int linesPerBlock = (compression == EXR_COMPRESSION_ZIP) ? 16 : 1;
+    const unsigned int numBlocks     = (height + linesPerBlock - 1) / linesPerBlock;
+    const size_t       bytesPerValue = (half) ? 2 : 4;
+
+    std::vector<uint64_t> offsets(numBlocks);
+    for (uint64_t& offset : offsets)
+    {
+      offset = reader.u64();
+    }
+    CHECK(reader.isValid());
+    CHECK(offsets[0] == reader.getPosition());
+
+    unsigned int numCompressed = 0;
+    for (unsigned int i = 0; i < numBlocks && reader.isValid(); ++i)
+    {
+      CHECK(reader.getPosition() == offsets[i]);
+      reader.setPosition(offsets[i]);
+
+      const unsigned int y0 = i * linesPerBlock;
+      const unsigned int y1 = std::min(y0 + linesPerBlock, height);
+      CHECK(reader.u32() == y0);
+      const uint32_t size = reader.u32();
+      const std::vector<unsigned char> data = reader.bytes(size);
+
+      // The expected scanlines, top to bottom, channel by channel.
+      std::vector<unsigned char> expected;
+      for (unsigned int y = y0; y < y1; ++y)
+      {
+        const size_t row = size_t(height - 1 - y) * width;
+        for (int channel = 0; channel < 5; ++channel)
+        {
+          for (unsigned int x = 0; x < width; ++x)
+          {
+            const float value = (channel == 4) ? variance[row + x] : rgba[(row + x) * 4 + (3 - channel)]; // A, B, G, R
+            unsigned char bytes[4];
+            if (half)
+            {
+              uint16_t h;
+              floatToHalf(&value, &h, 1, true);
+              memcpy(bytes, &h, 2);
+            }
+            else
+            {
+              memcpy(bytes, &value, 4);
+            }
+            expected.insert(expected.end(), bytes, bytes + bytesPerValue);
+          }
+        }
+      }
+
+      std::vector<unsigned char> raw;
+      if (data.size() == expected.size()) // Stored without compression.
+      {
+        raw = data;
+      }
+      else
+      {
+        ++numCompressed;
+        std::vector<unsigned char> predicted;
+        if (compression == EXR_COMPRESSION_RLE)
+        {
+          decompressRLE(data, predicted);
+        }
+        else
+        {
+          CHECK(inflateZlib(data.data(), data.size(), predicted));
+        }
+        unpredict(predicted, raw);
+      }
+      CHECK(raw == expected);
+    }
+    CHECK(reader.isValid() && reader.getPosition() == file.size());
+    CHECK((compression == EXR_COMPRESSION_NONE) == (numCompressed == 0));
+  }
+}
+
+
+UNIT_TEST(deflate, empty)
+{
+  CHECK(roundTripAllEfforts(std::vector<unsigned char>()));
+}
+
+UNIT_TEST(deflate, short_inputs)
+{
+  for (size_t size = 1; size <= 16; ++size)
+  {
+    CHECK(roundTripAllEfforts(randomBytes(size, unsigned(size))));
+  }
+  CHECK(roundTripAllEfforts(std::vector<unsigned char>(1, 'a')));
+  CHECK(roundTripAllEfforts(std::vector<unsigned char>(3, 'a')));
+}
+
+UNIT_TEST(deflate, repetitive)
+{
+  std::vector<unsigned char> data;
+  for (int i = 0; i < 100000; ++i)
+  {
+    data.push_back((unsigned char) "optix_hair"[i % 10]);
+  }
+  std::vector<unsigned char> compressed;
+  compressZlib(data.data(), data.size(), compressed);
+  CHECK(compressed.size() < data.size() / 50);
+
+  CHECK(roundTripAllEfforts(data));
+  CHECK(roundTripAllEfforts(std::vector<unsigned char>(70000, 0)));
+}
+
+UNIT_TEST(deflate, incompressible)
+{
+  // More tokens than one Huffman block holds.
+  const std::vector<unsigned char> data = randomBytes(200000, 1);
+
+  std::vector<unsigned char> compressed;
+  compressZlib(data.data(), data.size(), compressed);
+  CHECK(compressed.size() < data.size() + data.size() / 50);
+
+  CHECK(roundTripAllEfforts(data));
+}
+
+UNIT_TEST(deflate, ends_inside_match)
+{
+  // The last matches reach the end of the input below the nice length, with more candidates in the hash chain.
+  for (size_t size = 3; size <= 300; ++size)
+  {
+    std::vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      data[i] = (unsigned char) ("xyz"[i % 3]);
+    }
+    CHECK(roundTripAllEfforts(data));
+  }
+
+  std::vector<unsigned char> data = randomBytes(1000, 2);
+  data.insert(data.end(), data.begin(), data.begin() + 200);
+  data.insert(data.end(), data.begin(), data.begin() + 100);
+  CHECK(roundTripAllEfforts(data));
+}
+
+UNIT_TEST(exr, none)
+{
+  checkEXR(true,  EXR_COMPRESSION_NONE);
+  checkEXR(false, EXR_COMPRESSION_NONE);
+}
+
+UNIT_TEST(exr, rle)
+{
+  checkEXR(true,  EXR_COMPRESSION_RLE);
+  checkEXR(false, EXR_COMPRESSION_RLE);
+}
+
+UNIT_TEST(exr, zips)
+{
+  checkEXR(true,  EXR_COMPRESSION_ZIPS);
+  checkEXR(false, EXR_COMPRESSION_ZIPS);
+}
+
+UNIT_TEST(exr, zip)
+{
+  checkEXR(true,  EXR_COMPRESSION_ZIP);
+  checkEXR(false, EXR_COMPRESSION_ZIP);
+}
@@ -0,0 +1,223 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/GeometryRegistry.h"
+#include "inc/SceneSnapshot.h"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const char* c_filename = "optix_hair_test_registry.bin";
+
+  std::shared_ptr<sg::Triangles> createBox(const unsigned int id, const float scale)
+  {
+    std::shared_ptr<sg::Triangles> box = std::make_shared<sg::Triangles>(id);
+    box->createBox();
+
+    std::vector<VertexAttributes> attributes = box->getAttributes();
+    for (VertexAttributes& attribute : attributes)
+    {
+      attribute.vertex = attribute.vertex * scale;
+    }
+    box->setAttributes(attributes);
+    return box;
+  }
+
+  std::shared_ptr<sg::Instance> createInstance(const unsigned int id, std::shared_ptr<sg::Node> const& child)
+  {
+    std::shared_ptr<sg::Instance> instance = std::make_shared<sg::Instance>(id);
+    instance->setChild(child);
+    return instance;
+  }
+
+  // Three models loaded under different keys, the first two with identical meshes.
+  // The scene instances all three, the model group of the second one is not instanced.
+  struct TestScene
+  {
+    TestScene()
+    {
+      geometries.push_back(createBox(0, 1.0f));
+      geometries.push_back(createBox(1, 1.0f));
+      geometries.push_back(createBox(2, 2.0f));
+
+      mapGeometries["a.obj"] = 0;
+      mapGeometries["b.obj"] = 1;
+      mapGeometries["c.obj"] = 2;
+
+      root = std::make_shared<sg::Group>(0);
+      for (unsigned int id = 0; id < 3; ++id)
+      {
+        root->addChild(createInstance(id, geometries[id]));
+      }
+
+      std::shared_ptr<sg::Group> model = std::make_shared<sg::Group>(1);
+      model->addChild(createInstance(3, geometries[1]));
+      mapGroups["b.obj"] = model;
+    }
+
+    void share()
+    {
+      std::vector< std::shared_ptr<sg::Group> > roots;
+      roots.push_back(root);
+      for (auto const& it : mapGroups)
+      {
+        roots.push_back(it.second);
+      }
+      registry.share(geometries, roots);
+    }
+
+    GeometryRegistry                                    registry;
+    std::vector< std::shared_ptr<sg::Node> >            geometries;
+    std::map<std::string, unsigned int>                 mapGeometries;
+    std::shared_ptr<sg::Group>                          root;
+    std::map< std::string, std::shared_ptr<sg::Group> > mapGroups;
+  };
+}
+
+
+UNIT_TEST(geometry_registry, share_identical)
+{
+  TestScene test;
+  test.share();
+
+  CHECK(test.registry.getNumShared() == 1);
+  CHECK(test.registry.getNumRegistered() == 2);
+
+  // Both keys resolve to one node, the different mesh keeps its own.
+  std::shared_ptr<sg::Node> a = test.geometries[test.mapGeometries["a.obj"]];
+  std::shared_ptr<sg::Node> b = test.geometries[test.mapGeometries["b.obj"]];
+  std::shared_ptr<sg::Node> c = test.geometries[test.mapGeometries["c.obj"]];
+  CHECK(a == b && a->getId() == 0);
+  CHECK(c != a && c->getId() == 2);
+
+  // The instances in the scene and in the model group not instanced yet use the shared node.
+  CHECK(test.root->getChild(0)->getChild() == a);
+  CHECK(test.root->getChild(1)->getChild() == a);
+  CHECK(test.root->getChild(2)->getChild() == c);
+  CHECK(test.mapGroups["b.obj"]->getChild(0)->getChild() == a);
+
+  // Sharing again changes nothing.
+  test.share();
+  CHECK(test.registry.getNumShared() == 1);
+  CHECK(test.registry.getNumRegistered() == 2);
+}
+
+UNIT_TEST(geometry_registry, hash_collision)
+{
+  GeometryRegistry registry;
+
+  std::shared_ptr<sg::Triangles> small = createBox(0, 1.0f);
+  std::shared_ptr<sg::Triangles> large = createBox(1, 2.0f);
+  std::shared_ptr<sg::Triangles> copy  = createBox(2, 2.0f);
+
+  CHECK(GeometryRegistry::hashContent(*large) == GeometryRegistry::hashContent(*copy));
+  CHECK(GeometryRegistry::hashContent(*small) != GeometryRegistry::hashContent(*large));
+
+  // Forced equal hashes, the content decides.
+  const uint64_t hash = 42;
+  CHECK(registry.acquire(small, hash) == small);
+  CHECK(registry.acquire(large, hash) == large);
+  CHECK(registry.getNumShared() == 0);
+  CHECK(registry.getNumRegistered() == 2);
+
+  CHECK(registry.acquire(copy, hash) == large);
+  CHECK(registry.getNumShared() == 1);
+  CHECK(registry.getNumRegistered() == 2);
+
+  // Different indices with the same attributes are different content.
+  std::shared_ptr<sg::Triangles> reversed = createBox(3, 1.0f);
+  std::vector<unsigned int> indices(reversed->getIndices().rbegin(), reversed->getIndices().rend());
+  reversed->setIndices(indices);
+  CHECK(registry.acquire(reversed, hash) == reversed);
+  CHECK(registry.getNumShared() == 1);
+
+  registry.clear();
+  CHECK(registry.getNumRegistered() == 0 && registry.getNumShared() == 0);
+}
+
+UNIT_TEST(geometry_registry, reacquire)
+{
+  GeometryRegistry registry;
+
+  std::shared_ptr<sg::Triangles> box = createBox(0, 1.0f);
+  const uint64_t hash = GeometryRegistry::hashContent(*box);
+
+  CHECK(registry.acquire(box, hash) == box);
+  CHECK(registry.acquire(box, hash) == box);
+  CHECK(registry.getNumShared() == 0);
+  CHECK(registry.getNumRegistered() == 1);
+}
+
+UNIT_TEST(geometry_registry, snapshot)
+{
+  TestScene test;
+  test.share();
+
+  SnapshotWriter writer(3);
+  writeSceneGraph(writer, test.root, test.geometries, test.mapGroups);
+  CHECK(writer.save(c_filename));
+
+  SnapshotReader reader;
+  CHECK(reader.open(c_filename, 3));
+
+  sg::NodeArena arena;
+
+  std::shared_ptr<sg::Group>                          root;
+  std::vector< std::shared_ptr<sg::Node> >            geometries;
+  std::map< std::string, std::shared_ptr<sg::Group> > mapGroups;
+
+  CHECK(readSceneGraph(reader, arena, root, geometries, mapGroups));
+  CHECK(geometries.size() == 3);
+  CHECK(root && root->getNumChildren() == 3);
+  CHECK(mapGroups.size() == 1 && mapGroups.count("b.obj") == 1);
+
+  if (geometries.size() == 3 && root && root->getNumChildren() == 3 && mapGroups.count("b.obj") == 1)
+  {
+    // The shared slot refers to the node of the first slot again.
+    CHECK(geometries[1] == geometries[0] && geometries[1]->getId() == 0);
+    CHECK(geometries[2] != geometries[0] && geometries[2]->getId() == 2);
+
+    CHECK(root->getChild(0)->getChild() == geometries[0]);
+    CHECK(root->getChild(1)->getChild() == geometries[0]);
+    CHECK(root->getChild(2)->getChild() == geometries[2]);
+    CHECK(mapGroups["b.obj"]->getChild(0)->getChild() == geometries[0]);
+
+    std::shared_ptr<sg::Triangles> box = std::static_pointer_cast<sg::Triangles>(geometries[0]);
+    CHECK(box->getAttributes().size() == 24);
+    CHECK(GeometryRegistry::hashContent(*box) == GeometryRegistry::hashContent(*std::static_pointer_cast<sg::Triangles>(test.geometries[0])));
+  }
+
+  std::remove(c_filename);
+}
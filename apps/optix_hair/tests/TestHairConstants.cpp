@@ -0,0 +1,179 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Checks the host precalculated hair BCSDF material constants against the formulas
+// bcsdf_hair.cu evaluated per sample before they moved into the MaterialDefinition.
+
+#include "UnitTest.h"
+
+#include <cuda_runtime.h>
+
+#include "shaders/bcsdf_hair_constants.h"
+
+#include <algorithm>
+
+namespace
+{
+  // The per launch formulas as they were in bcsdf_hair.cu.
+  float referenceSqrtV(const float betaM)
+  {
+    return 0.726f * betaM + 0.812f * (betaM * betaM) + 3.7f * (betaM * betaM) * (betaM * betaM) * (betaM * betaM) *
+      (betaM * betaM) * (betaM * betaM) * (betaM * betaM) * (betaM * betaM) * (betaM * betaM) *
+      (betaM * betaM) * (betaM * betaM);
+  }
+
+  float referenceS(const float betaN)
+  {
+    return 0.626657069f * (0.265f * betaN + 1.194f * (betaN * betaN) + 5.372f * (betaN * betaN) * (betaN * betaN) * (betaN * betaN) *
+      (betaN * betaN) * (betaN * betaN) * (betaN * betaN) * (betaN * betaN) * (betaN * betaN) *
+      (betaN * betaN) * (betaN * betaN) * (betaN * betaN));
+  }
+
+  float3 referenceMelanin(MaterialDefinition const& material, const float rnd)
+  {
+    const float3 absorption_eumelanin = make_float3(0.419f, 0.697f, 1.37f);
+    const float3 absorption_pheomelanin = make_float3(0.187f, 0.4f, 1.05f);
+
+    float melanin_ratio = clamp(material.melanin_ratio * (1.f + material.melanin_ratio_disparity * rnd), 0.f, 1.f);
+    float melanin_concentration = fmaxf(material.melanin_concentration * (1.f + rnd * material.melanin_concentration_disparity), .0f);
+    return melanin_concentration * lerp(absorption_eumelanin, absorption_pheomelanin, melanin_ratio);
+  }
+
+  // The polynomials are evaluated in a different order, allow a few ulps.
+  float tolerance(const float reference)
+  {
+    return std::max(1.0e-6f, std::fabs(reference) * 1.0e-5f);
+  }
+}
+
+UNIT_TEST(hair_constants, variance)
+{
+  for (int i = 0; i <= 100; ++i)
+  {
+    const float betaM = float(i) * 0.01f;
+    const float sqrtv = referenceSqrtV(betaM);
+    const float v = sqrtv * sqrtv;
+
+    CHECK_NEAR(hairLongitudinalVariance(betaM), v, tolerance(v));
+  }
+}
+
+UNIT_TEST(hair_constants, logistic_scale)
+{
+  for (int i = 0; i <= 100; ++i)
+  {
+    const float betaN = float(i) * 0.01f;
+    const float s = referenceS(betaN);
+
+    CHECK_NEAR(hairLogisticScale(betaN), s, tolerance(s));
+  }
+}
+
+UNIT_TEST(hair_constants, scale_tilt)
+{
+  for (int i = -20; i <= 20; ++i)
+  {
+    const float scale_angle_rad = float(i) * 0.01f; // About +-11 degrees.
+
+    // Exactly the same operations as before, so the results must be identical.
+    float sin2kAlpha0 = sinf(scale_angle_rad);
+    float cos2kAlpha0 = trigInverse(sin2kAlpha0);
+    float sin2kAlpha1 = 2.f * cos2kAlpha0 * sin2kAlpha0;
+    float cos2kAlpha1 = cos2kAlpha0 * cos2kAlpha0 - sin2kAlpha0 * sin2kAlpha0;
+    float sin2kAlpha2 = 2.f * cos2kAlpha1 * sin2kAlpha1;
+    float cos2kAlpha2 = cos2kAlpha1 * cos2kAlpha1 - sin2kAlpha1 * sin2kAlpha1;
+
+    float3 sin2kAlpha;
+    float3 cos2kAlpha;
+    hairScaleTilt(scale_angle_rad, sin2kAlpha, cos2kAlpha);
+
+    CHECK(sin2kAlpha.x == sin2kAlpha0);
+    CHECK(cos2kAlpha.x == cos2kAlpha0);
+    CHECK(sin2kAlpha.y == sin2kAlpha1);
+    CHECK(cos2kAlpha.y == cos2kAlpha1);
+    CHECK(sin2kAlpha.z == sin2kAlpha2);
+    CHECK(cos2kAlpha.z == cos2kAlpha2);
+  }
+}
+
+UNIT_TEST(hair_constants, melanin)
+{
+  MaterialDefinition material = {};
+
+  const float disparities[3] = { 0.0f, 0.25f, -0.5f };
+
+  for (int c = 0; c <= 8; ++c)
+  {
+    for (int r = 0; r <= 8; ++r)
+    {
+      for (const float disparity : disparities)
+      {
+        material.melanin_concentration = float(c) * 1.25f;
+        material.melanin_ratio = float(r) * 0.125f;
+        material.melanin_concentration_disparity = disparity;
+        material.melanin_ratio_disparity = disparity;
+
+        precalculateHairMaterial(material);
+
+        for (int i = 0; i < 8; ++i)
+        {
+          const float rnd = float(i) / 8.0f;
+
+          const float3 reference = referenceMelanin(material, rnd);
+          const float3 absorption = hairFiberMelaninAbsorption(material, rnd);
+
+          CHECK_NEAR(absorption.x, reference.x, tolerance(reference.x));
+          CHECK_NEAR(absorption.y, reference.y, tolerance(reference.y));
+          CHECK_NEAR(absorption.z, reference.z, tolerance(reference.z));
+        }
+      }
+    }
+  }
+}
+
+UNIT_TEST(hair_constants, material)
+{
+  MaterialDefinition material = {};
+
+  material.betaM = 0.3f;
+  material.betaN = 0.4f;
+  material.scale_angle_rad = 0.035f;
+  material.melanin_concentration = 1.3f;
+  material.melanin_ratio = 0.2f;
+
+  precalculateHairMaterial(material);
+
+  CHECK(material.variance == hairLongitudinalVariance(material.betaM));
+  CHECK(material.logisticScale == hairLogisticScale(material.betaN));
+  CHECK(material.sin2kAlpha.x == sinf(material.scale_angle_rad));
+
+  const float3 reference = referenceMelanin(material, 0.0f);
+  CHECK_NEAR(material.absorptionMelanin.x, reference.x, tolerance(reference.x));
+  CHECK_NEAR(material.absorptionMelanin.y, reference.y, tolerance(reference.y));
+  CHECK_NEAR(material.absorptionMelanin.z, reference.z, tolerance(reference.z));
+}
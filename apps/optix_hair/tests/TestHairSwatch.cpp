@@ -0,0 +1,97 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/HairSwatch.h"
+
+#include <vector>
+
+namespace
+{
+  MaterialGUI makeHairMaterial(const float roughnessM, const float roughnessN)
+  {
+    MaterialGUI materialGUI = {};
+
+    materialGUI.whitepercen = 0.1f;
+    materialGUI.dye = make_float3(0.8f, 0.6f, 0.4f);
+    materialGUI.dye_concentration = 0.5f;
+    materialGUI.scale_angle_deg = 2.0f;
+    materialGUI.roughnessM = roughnessM;
+    materialGUI.roughnessN = roughnessN;
+    materialGUI.melanin_concentration = 1.0f;
+    materialGUI.melanin_ratio = 0.3f;
+    materialGUI.dyeNeutralHT = make_float3(1.0f);
+
+    return materialGUI;
+  }
+}
+
+// More distinct roughness settings than the table cache holds must neither change the results nor rebuild tables per swatch.
+UNIT_TEST(hair_swatch, many_tables)
+{
+  HairSwatch swatch;
+
+  std::vector<MaterialGUI> materialsGUI;
+  for (int i = 0; i < 72; ++i)
+  {
+    materialsGUI.push_back(makeHairMaterial(0.1f + float(i) * 0.005f, 0.3f));
+  }
+
+  std::vector<float3> colors;
+  swatch.evaluate(materialsGUI, colors);
+  CHECK(colors.size() == materialsGUI.size());
+
+  HairSwatch reference;
+  for (size_t i = 0; i < materialsGUI.size(); i += 8)
+  {
+    const float3 color = reference.evaluate(materialsGUI[i]);
+
+    CHECK(color.x == colors[i].x);
+    CHECK(color.y == colors[i].y);
+    CHECK(color.z == colors[i].z);
+    CHECK(0.0f < color.x && color.x < 1.0f);
+  }
+}
+
+UNIT_TEST(hair_swatch, equivalent)
+{
+  const MaterialGUI a = makeHairMaterial(0.3f, 0.3f);
+  MaterialGUI b = a;
+
+  b.name = "other";
+  b.HT = 7; // Not read by the swatch evaluation.
+  CHECK(HairSwatch::isEquivalent(a, b));
+
+  b.dye_concentration = 0.6f;
+  CHECK(!HairSwatch::isEquivalent(a, b));
+
+  b = a;
+  b.roughnessN = 0.31f;
+  CHECK(!HairSwatch::isEquivalent(a, b));
+}
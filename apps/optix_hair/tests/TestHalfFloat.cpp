@@ -0,0 +1,251 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/HalfFloat.h"
+#include "inc/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+  uint32_t floatBits(const float value)
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    return bits;
+  }
+
+  bool isHalfNaN(const uint16_t half)
+  {
+    return (half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0;
+  }
+
+  // Random float bit patterns, biased to the half range, with some NaN, infinities and denormals.
+  std::vector<float> randomFloats(const size_t count, const unsigned int seed)
+  {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<uint32_t> exponent(100, 150); // 2^-27 to 2^23
+    std::uniform_int_distribution<uint32_t> bits;
+
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      uint32_t value = bits(generator);
+      if ((i & 15) != 0)
+      {
+        value = (value & 0x807FFFFF) | (exponent(generator) << 23);
+      }
+      memcpy(&values[i], &value, sizeof(float));
+    }
+    return values;
+  }
+
+  // Best of three runs in seconds.
+  template <typename F>
+  double bestTime(F const& function)
+  {
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < 3; ++run)
+    {
+      Timer timer;
+      timer.start();
+      function();
+      timer.stop();
+      best = std::min(best, timer.getTime());
+    }
+    return best;
+  }
+}
+
+
+UNIT_TEST(half_float, round_trip)
+{
+  // Every half must survive the conversion to float and back. NaN only needs to stay NaN.
+  for (uint32_t h = 0; h <= 0xFFFF; ++h)
+  {
+    const uint16_t half   = uint16_t(h);
+    const uint16_t result = floatToHalf(halfToFloat(half));
+    if (isHalfNaN(half))
+    {
+      CHECK(isHalfNaN(result) && (result & 0x8000) == (half & 0x8000));
+    }
+    else
+    {
+      CHECK(result == half);
+    }
+  }
+}
+
+UNIT_TEST(half_float, rounding)
+{
+  // The midpoints of all neighboring finite halves are exact floats. They must round to the even half,
+  // the floats right next to them to the closer half.
+  for (uint32_t sign = 0; sign <= 0x8000; sign += 0x8000)
+  {
+    for (uint32_t h = 0; h < 0x7BFF; ++h)
+    {
+      const uint16_t lower = uint16_t(sign | h);
+      const uint16_t upper = uint16_t(sign | (h + 1));
+
+      const float midpoint = 0.5f * (halfToFloat(lower) + halfToFloat(upper));
+      const float outward  = std::nextafter(midpoint, (sign) ? -HUGE_VALF : HUGE_VALF);
+      const float inward   = std::nextafter(midpoint, 0.0f);
+
+      CHECK(floatToHalf(midpoint) == ((h & 1) ? upper : lower));
+      CHECK(floatToHalf(outward)  == upper);
+      CHECK(floatToHalf(inward)   == lower);
+    }
+  }
+
+  // 65520 is halfway between 65504 and the next, not representable, step, which is odd and rounds to infinity.
+  CHECK(floatToHalf(65520.0f) == 0x7C00);
+  CHECK(floatToHalf(std::nextafter(65520.0f, 0.0f)) == 0x7BFF);
+  CHECK(floatToHalf(-65520.0f) == 0xFC00);
+
+  // Half of the smallest denormal rounds to even zero, anything above it to the denormal.
+  CHECK(floatToHalf(ldexpf(1.0f, -25)) == 0x0000);
+  CHECK(floatToHalf(std::nextafter(ldexpf(1.0f, -25), HUGE_VALF)) == 0x0001);
+  CHECK(floatToHalf(-0.0f) == 0x8000);
+}
+
+UNIT_TEST(half_float, arrays)
+{
+  // Not a multiple of the vector width and several ThreadPool chunks.
+  const size_t count = 3 * 262144 + 13;
+
+  const std::vector<float> values = randomFloats(count, 7);
+
+  for (int saturate = 0; saturate < 2; ++saturate)
+  {
+    std::vector<uint16_t> halves(count);
+    floatToHalf(values.data(), halves.data(), count, saturate != 0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      const float value = values[i];
+
+      uint16_t expected;
+      if (saturate)
+      {
+        expected = (value != value) ? uint16_t(0) : floatToHalf(std::min(std::max(value, -65504.0f), 65504.0f));
+      }
+      else
+      {
+        expected = floatToHalf(value);
+      }
+
+      if (isHalfNaN(expected)) // F16C doesn't keep the NaN payload bits the same way.
+      {
+        CHECK(isHalfNaN(halves[i]));
+      }
+      else
+      {
+        CHECK(halves[i] == expected);
+      }
+    }
+  }
+
+  std::vector<uint16_t> halves(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    halves[i] = uint16_t(i * 40503u); // Every half pattern a few times.
+  }
+
+  std::vector<float> floats(count);
+  halfToFloat(halves.data(), floats.data(), count);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    const float expected = halfToFloat(halves[i]);
+    if (isHalfNaN(halves[i]))
+    {
+      CHECK(floats[i] != floats[i]);
+    }
+    else
+    {
+      CHECK(floatBits(floats[i]) == floatBits(expected));
+    }
+  }
+}
+
+UNIT_TEST(half_float, saturate)
+{
+  const float values[6] = { std::numeric_limits<float>::quiet_NaN(), 1.0e6f, -1.0e6f,
+                            std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), 1.0f };
+  uint16_t halves[6];
+
+  floatToHalf(values, halves, 6, true);
+
+  CHECK(halves[0] == 0x0000);
+  CHECK(halves[1] == 0x7BFF);
+  CHECK(halves[2] == 0xFBFF);
+  CHECK(halves[3] == 0x7BFF);
+  CHECK(halves[4] == 0xFBFF);
+  CHECK(halves[5] == 0x3C00);
+
+  floatToHalf(values, halves, 6, false);
+
+  CHECK(isHalfNaN(halves[0]));
+  CHECK(halves[1] == 0x7C00);
+  CHECK(halves[4] == 0xFC00);
+}
+
+UNIT_TEST(half_float, throughput)
+{
+  const size_t count = 1 << 22;
+
+  const std::vector<float> values = randomFloats(count, 11);
+  std::vector<uint16_t> halves(count);
+  std::vector<float>    floats(count);
+
+  const double timeScalar = bestTime([&]()
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      halves[i] = floatToHalf(values[i]);
+    }
+  });
+  const double timeToHalf  = bestTime([&]() { floatToHalf(values.data(), halves.data(), count, true); });
+  const double timeToFloat = bestTime([&]() { halfToFloat(halves.data(), floats.data(), count); });
+
+  const double mega = double(count) * 1.0e-6;
+  std::cout << "  scalar floatToHalf " << mega / timeScalar  << " M/s, array floatToHalf " << mega / timeToHalf
+            << " M/s, array halfToFloat " << mega / timeToFloat << " M/s, F16C " << (isHalfConversionAccelerated() ? "on" : "off") << '\n';
+
+  if (isHalfConversionAccelerated())
+  {
+    CHECK(timeToHalf < timeScalar);
+  }
+}
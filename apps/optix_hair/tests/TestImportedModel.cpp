@@ -0,0 +1,117 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/ImportedModel.h"
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+  const char* c_filename = "optix_hair_test_model.bin";
+
+  // One triangle referenced by the root node.
+  void createTriangle(ImportedModel& model, const size_t numVertices)
+  {
+    ImportedMesh mesh;
+
+    mesh.attributes.resize(numVertices);
+    mesh.indices  = { 0, 1, 2 };
+    mesh.material = "default";
+
+    model.meshes.push_back(mesh);
+    model.nodes.resize(1);
+    model.nodes[0].meshes.push_back(0);
+  }
+}
+
+
+UNIT_TEST(imported_model, round_trip)
+{
+  ImportedModel model;
+  createTriangle(model, 3);
+  model.meshes[0].hasDiffuse = true;
+  model.meshes[0].diffuse    = make_float3(0.25f, 0.5f, 1.0f);
+  CHECK(model.save(c_filename, 5));
+
+  ImportedModel result;
+  CHECK(!result.load(c_filename, 6)); // Other source file or import settings.
+  CHECK(result.load(c_filename, 5));
+  CHECK(result.isCached);
+  CHECK(result.meshes.size() == 1 && result.nodes.size() == 1);
+
+  if (result.meshes.size() == 1 && result.nodes.size() == 1)
+  {
+    CHECK(result.meshes[0].attributes.size() == 3);
+    CHECK(result.meshes[0].indices == model.meshes[0].indices);
+    CHECK(result.meshes[0].material == "default");
+    CHECK(result.meshes[0].hasDiffuse && result.meshes[0].diffuse.y == 0.5f);
+    CHECK(result.nodes[0].meshes == model.nodes[0].meshes);
+  }
+
+  std::remove(c_filename);
+}
+
+UNIT_TEST(imported_model, index_out_of_range)
+{
+  // 16-bit indices.
+  ImportedModel model;
+  createTriangle(model, 3);
+  model.meshes[0].indices[2] = 3;
+  CHECK(model.save(c_filename, 5));
+
+  ImportedModel result;
+  CHECK(!result.load(c_filename, 5));
+  CHECK(!result.isCached);
+
+  // 32-bit indices.
+  ImportedModel modelLarge;
+  createTriangle(modelLarge, 0x10001);
+  modelLarge.meshes[0].indices[1] = 0x10001;
+  CHECK(modelLarge.save(c_filename, 5));
+
+  ImportedModel resultLarge;
+  CHECK(!resultLarge.load(c_filename, 5));
+
+  std::remove(c_filename);
+}
+
+UNIT_TEST(imported_model, partial_triangle)
+{
+  ImportedModel model;
+  createTriangle(model, 3);
+  model.meshes[0].indices.push_back(0);
+  CHECK(model.save(c_filename, 5));
+
+  ImportedModel result;
+  CHECK(!result.load(c_filename, 5));
+
+  std::remove(c_filename);
+}
@@ -0,0 +1,232 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include <cuda_runtime.h>
+
+#include "inc/LowDiscrepancy.h"
+
+#include "shaders/vector_math.h"
+#include "shaders/low_discrepancy.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+  // True when each of the 2^m elementary intervals of every shape 2^-a x 2^-(m-a) contains exactly one of the 2^m points, a (0, m, 2)-net in base 2.
+  bool isNet(std::vector<float2> const& points)
+  {
+    const unsigned int n = static_cast<unsigned int>(points.size());
+
+    unsigned int m = 0;
+    while ((1u << m) < n)
+    {
+      ++m;
+    }
+
+    std::vector<unsigned int> counts(n);
+
+    for (unsigned int a = 0; a <= m; ++a)
+    {
+      const unsigned int cellsX = 1u << a;
+      const unsigned int cellsY = 1u << (m - a);
+
+      std::fill(counts.begin(), counts.end(), 0u);
+      for (float2 const& p : points)
+      {
+        const unsigned int x = static_cast<unsigned int>(p.x * float(cellsX));
+        const unsigned int y = static_cast<unsigned int>(p.y * float(cellsY));
+        ++counts[y * cellsX + x];
+      }
+      for (const unsigned int count : counts)
+      {
+        if (count != 1)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // L2 star discrepancy with Warnock's formula.
+  double discrepancyL2(std::vector<float2> const& points)
+  {
+    const double n = double(points.size());
+
+    double sum1 = 0.0;
+    double sum2 = 0.0;
+    for (float2 const& p : points)
+    {
+      sum1 += (1.0 - double(p.x) * double(p.x)) * (1.0 - double(p.y) * double(p.y));
+      for (float2 const& q : points)
+      {
+        sum2 += (1.0 - double(std::max(p.x, q.x))) * (1.0 - double(std::max(p.y, q.y)));
+      }
+    }
+    return sqrt(1.0 / 9.0 - sum1 / (2.0 * n) + sum2 / (n * n));
+  }
+
+  std::vector<float2> owenSobol2D(const unsigned int count, const unsigned int seed)
+  {
+    std::vector<unsigned int> const& matrices = getSobolMatrices();
+
+    std::vector<float2> points(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      points[i] = ldOwenSobol2D(i, seed, matrices.data());
+    }
+    return points;
+  }
+}
+
+UNIT_TEST(sobol, matrices)
+{
+  std::vector<unsigned int> matrices;
+  generateSobolMatrices(LD_SOBOL_DIMENSIONS, matrices);
+  CHECK(matrices.size() == LD_SOBOL_DIMENSIONS * LD_SOBOL_BITS);
+
+  // Dimension 0 is the identity. The generator matrices are upper triangular with ones on the diagonal,
+  // so the lowest set bit of direction number k is bit 31 - k.
+  for (unsigned int dimension = 0; dimension < LD_SOBOL_DIMENSIONS; ++dimension)
+  {
+    for (unsigned int bit = 0; bit < LD_SOBOL_BITS; ++bit)
+    {
+      const unsigned int v = matrices[dimension * LD_SOBOL_BITS + bit];
+      CHECK((v & (0u - v)) == (1u << (31 - bit)));
+      if (dimension == 0)
+      {
+        CHECK(v == (1u << (31 - bit)));
+      }
+    }
+  }
+
+  // Without scrambling the first two dimensions form nets for all power-of-two prefixes.
+  for (unsigned int m = 1; m <= 10; ++m)
+  {
+    std::vector<float2> points(1u << m);
+    for (unsigned int i = 0; i < points.size(); ++i)
+    {
+      points[i] = make_float2(ldToFloat(ldSobol(i, 0, matrices.data())), ldToFloat(ldSobol(i, 1, matrices.data())));
+    }
+    CHECK(isNet(points));
+  }
+}
+
+UNIT_TEST(sobol, stratification_2d)
+{
+  // Scrambling and shuffling keeps every power-of-two prefix a net, for any seed.
+  const unsigned int seeds[4] = { 0u, 1u, 0x12345678u, 0xDEADBEEFu };
+
+  for (const unsigned int seed : seeds)
+  {
+    for (unsigned int m = 1; m <= 10; ++m)
+    {
+      CHECK(isNet(owenSobol2D(1u << m, seed)));
+    }
+  }
+}
+
+UNIT_TEST(sobol, stratification_1d)
+{
+  for (unsigned int seed = 0; seed < 16; ++seed)
+  {
+    for (unsigned int m = 1; m <= 12; ++m)
+    {
+      const unsigned int n = 1u << m;
+
+      std::vector<unsigned int> counts(n, 0u);
+      for (unsigned int i = 0; i < n; ++i)
+      {
+        const float u = ldOwenSobol1D(i, ldHash(seed));
+        CHECK(0.0f <= u && u < 1.0f);
+        ++counts[std::min(n - 1, static_cast<unsigned int>(u * float(n)))];
+      }
+      CHECK(std::count(counts.begin(), counts.end(), 1u) == n);
+    }
+  }
+}
+
+UNIT_TEST(sobol, discrepancy)
+{
+  const unsigned int n = 256;
+
+  // Expected L2 star discrepancy of n uniform random points in 2D is sqrt((1/4 - 1/9) / n), about 0.023 here.
+  const double random = sqrt((1.0 / 4.0 - 1.0 / 9.0) / double(n));
+
+  std::mt19937 generator(12345);
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+  std::vector<float2> points(n);
+  for (float2& p : points)
+  {
+    p = make_float2(distribution(generator), distribution(generator));
+  }
+  const double measured = discrepancyL2(points);
+  CHECK(0.5 * random < measured && measured < 2.0 * random); // Sanity check of the metric.
+
+  for (unsigned int seed = 0; seed < 4; ++seed)
+  {
+    const double sobol = discrepancyL2(owenSobol2D(n, ldHash(seed)));
+    CHECK(sobol < 0.25 * random);
+  }
+}
+
+UNIT_TEST(sobol, blue_noise)
+{
+  const int size = 16;
+
+  std::vector<float> values;
+  generateBlueNoise(size, 1, values);
+  CHECK(values.size() == size_t(size * size));
+
+  // The values are the ranks of the void-and-cluster ordering, every rank exactly once.
+  std::vector<float> sorted(values);
+  std::sort(sorted.begin(), sorted.end());
+  for (int i = 0; i < size * size; ++i)
+  {
+    CHECK(sorted[i] == (float(i) + 0.5f) / float(size * size));
+  }
+
+  // Blue noise has little low frequency energy, so the 4x4 block means stay much closer to 0.5 than white noise would.
+  for (int y = 0; y < size; y += 4)
+  {
+    for (int x = 0; x < size; x += 4)
+    {
+      float sum = 0.0f;
+      for (int i = 0; i < 16; ++i)
+      {
+        sum += values[(y + i / 4) * size + x + i % 4];
+      }
+      CHECK_NEAR(sum / 16.0f, 0.5f, 0.2f);
+    }
+  }
+}
@@ -0,0 +1,350 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+  typedef std::array<float, sizeof(VertexAttributes) / sizeof(float)> VertexKey;
+  typedef std::array<VertexKey, 3>                                    TriangleKey;
+
+  VertexAttributes makeVertex(const float x, const float y)
+  {
+    VertexAttributes attrib;
+
+    attrib.vertex   = make_float3(x, y, 0.0f);
+    attrib.tangent  = make_float3(1.0f, 0.0f, 0.0f);
+    attrib.normal   = make_float3(0.0f, 0.0f, 1.0f);
+    attrib.texcoord = make_float3(x * 0.125f, y * 0.125f, 0.0f);
+
+    return attrib;
+  }
+
+  // Indexed grid of size x size quads with two triangles each.
+  void makeGrid(const unsigned int size, std::vector<VertexAttributes>& attributes, std::vector<unsigned int>& indices)
+  {
+    attributes.clear();
+    indices.clear();
+
+    for (unsigned int y = 0; y <= size; ++y)
+    {
+      for (unsigned int x = 0; x <= size; ++x)
+      {
+        attributes.push_back(makeVertex(float(x), float(y)));
+      }
+    }
+
+    const unsigned int stride = size + 1;
+    for (unsigned int y = 0; y < size; ++y)
+    {
+      for (unsigned int x = 0; x < size; ++x)
+      {
+        const unsigned int i = y * stride + x;
+
+        indices.push_back(i);
+        indices.push_back(i + 1);
+        indices.push_back(i + stride + 1);
+
+        indices.push_back(i + stride + 1);
+        indices.push_back(i + stride);
+        indices.push_back(i);
+      }
+    }
+  }
+
+  // The same grid with three separate vertices per triangle, like an unindexed import.
+  void makeTriangleSoup(const unsigned int size, std::vector<VertexAttributes>& attributes, std::vector<unsigned int>& indices)
+  {
+    std::vector<VertexAttributes> shared;
+    std::vector<unsigned int>     sharedIndices;
+
+    makeGrid(size, shared, sharedIndices);
+
+    attributes.clear();
+    indices.clear();
+
+    for (const unsigned int index : sharedIndices)
+    {
+      indices.push_back(static_cast<unsigned int>(attributes.size()));
+      attributes.push_back(shared[index]);
+    }
+  }
+
+  void shuffleTriangles(std::vector<unsigned int>& indices, const unsigned int seed)
+  {
+    const size_t numTriangles = indices.size() / 3;
+
+    std::vector<size_t> order(numTriangles);
+    for (size_t t = 0; t < numTriangles; ++t)
+    {
+      order[t] = t;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+
+    std::vector<unsigned int> shuffled;
+    shuffled.reserve(indices.size());
+    for (const size_t t : order)
+    {
+      shuffled.insert(shuffled.end(), &indices[t * 3], &indices[t * 3] + 3);
+    }
+    indices.swap(shuffled);
+  }
+
+  // Average cache miss ratio, the transformed vertices per triangle of a FIFO post-transform cache.
+  float getACMR(std::vector<unsigned int> const& indices, const size_t numVertices, const size_t sizeCache)
+  {
+    std::vector<size_t> timestamp(numVertices, 0); // Zero means not in the cache.
+    size_t time   = sizeCache + 1;
+    size_t misses = 0;
+
+    for (const unsigned int index : indices)
+    {
+      if (timestamp[index] == 0 || timestamp[index] + sizeCache <= time)
+      {
+        timestamp[index] = time++;
+        ++misses;
+      }
+    }
+
+    return float(misses) / float(indices.size() / 3);
+  }
+
+  // The sorted triangles as vertex attribute triples, each rotated to start at its smallest vertex, which keeps the winding.
+  std::vector<TriangleKey> getTriangles(std::vector<VertexAttributes> const& attributes, std::vector<unsigned int> const& indices)
+  {
+    std::vector<TriangleKey> triangles(indices.size() / 3);
+
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+      TriangleKey& triangle = triangles[t];
+      for (size_t k = 0; k < 3; ++k)
+      {
+        memcpy(triangle[k].data(), &attributes[indices[t * 3 + k]], sizeof(VertexAttributes));
+      }
+      std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+
+    return triangles;
+  }
+
+  bool areIndicesInRange(std::vector<unsigned int> const& indices, const size_t numVertices)
+  {
+    for (const unsigned int index : indices)
+    {
+      if (numVertices <= index)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+
+UNIT_TEST(mesh_optimizer, weld_merges_identical_vertices)
+{
+  std::vector<VertexAttributes> attributes;
+  std::vector<unsigned int>     indices;
+
+  makeTriangleSoup(8, attributes, indices);
+
+  const std::vector<TriangleKey> reference = getTriangles(attributes, indices);
+
+  CHECK(attributes.size() == 8 * 8 * 6);
+
+  const size_t numRemoved = weldVertices(attributes, indices);
+
+  CHECK(attributes.size() == 9 * 9);
+  CHECK(numRemoved == 8 * 8 * 6 - 9 * 9);
+  CHECK(indices.size() == 8 * 8 * 6);
+  CHECK(areIndicesInRange(indices, attributes.size()));
+  CHECK(getTriangles(attributes, indices) == reference);
+
+  // Welding twice finds nothing.
+  CHECK(weldVertices(attributes, indices) == 0);
+  CHECK(attributes.size() == 9 * 9);
+}
+
+UNIT_TEST(mesh_optimizer, weld_keeps_vertices_with_different_attributes)
+{
+  // Two triangles sharing positions but not normals, like a hard edge.
+  std::vector<VertexAttributes> attributes;
+  for (int i = 0; i < 2; ++i)
+  {
+    attributes.push_back(makeVertex(0.0f, 0.0f));
+    attributes.push_back(makeVertex(1.0f, 0.0f));
+    attributes.push_back(makeVertex(0.0f, 1.0f));
+  }
+  for (size_t i = 3; i < 6; ++i)
+  {
+    attributes[i].normal = make_float3(0.0f, 0.0f, -1.0f);
+  }
+
+  std::vector<unsigned int> indices = { 0, 1, 2, 5, 4, 3 };
+
+  const std::vector<TriangleKey> reference = getTriangles(attributes, indices);
+
+  CHECK(weldVertices(attributes, indices) == 0);
+  CHECK(attributes.size() == 6);
+  CHECK(getTriangles(attributes, indices) == reference);
+}
+
+UNIT_TEST(mesh_optimizer, vertex_cache_improves_acmr)
+{
+  std::vector<VertexAttributes> attributes;
+  std::vector<unsigned int>     indices;
+
+  makeGrid(32, attributes, indices);
+  shuffleTriangles(indices, 1234);
+
+  const std::vector<TriangleKey> reference = getTriangles(attributes, indices);
+
+  const float before = getACMR(indices, attributes.size(), 16);
+
+  optimizeVertexCache(indices, attributes.size());
+
+  const float after = getACMR(indices, attributes.size(), 16);
+
+  CHECK(indices.size() == 32 * 32 * 6);
+  CHECK(getTriangles(attributes, indices) == reference);
+
+  // A shuffled grid misses nearly every vertex, the ideal for a regular grid is about 0.5 per triangle.
+  CHECK(2.0f < before);
+  CHECK(after < 1.0f);
+  CHECK(after < before * 0.5f);
+}
+
+UNIT_TEST(mesh_optimizer, vertex_cache_handles_degenerate_triangles)
+{
+  std::vector<VertexAttributes> attributes;
+  std::vector<unsigned int>     indices;
+
+  makeGrid(4, attributes, indices);
+
+  // Triangles with repeated vertices, including one with a single vertex.
+  const unsigned int degenerate[] = { 0, 0, 6, 7, 12, 7, 3, 3, 3, 24, 18, 18 };
+  indices.insert(indices.end(), std::begin(degenerate), std::end(degenerate));
+
+  shuffleTriangles(indices, 42);
+
+  const std::vector<TriangleKey> reference = getTriangles(attributes, indices);
+
+  // Trailing indices of an incomplete triangle are kept at the end.
+  indices.push_back(5);
+  indices.push_back(9);
+
+  optimizeVertexCache(indices, attributes.size());
+
+  CHECK(indices.size() == 4 * 4 * 6 + 12 + 2);
+  CHECK(indices[indices.size() - 2] == 5);
+  CHECK(indices[indices.size() - 1] == 9);
+
+  indices.resize(indices.size() - 2);
+  CHECK(getTriangles(attributes, indices) == reference);
+}
+
+UNIT_TEST(mesh_optimizer, vertex_fetch_drops_unreferenced_vertices)
+{
+  std::vector<VertexAttributes> attributes;
+  std::vector<unsigned int>     indices;
+
+  makeGrid(8, attributes, indices);
+
+  // Only the lower half of the quads is referenced, in shuffled order.
+  indices.resize(indices.size() / 2);
+  shuffleTriangles(indices, 7);
+
+  const std::vector<TriangleKey> reference = getTriangles(attributes, indices);
+
+  optimizeVertexFetch(attributes, indices);
+
+  CHECK(attributes.size() == 9 * 5);
+  CHECK(getTriangles(attributes, indices) == reference);
+
+  // Vertices are ordered by their first use.
+  unsigned int next = 0;
+  for (const unsigned int index : indices)
+  {
+    CHECK(index <= next);
+    if (index == next)
+    {
+      ++next;
+    }
+  }
+  CHECK(next == attributes.size());
+}
+
+UNIT_TEST(mesh_optimizer, full_pipeline)
+{
+  std::vector<VertexAttributes> attributes;
+  std::vector<unsigned int>     indices;
+
+  makeTriangleSoup(16, attributes, indices);
+  shuffleTriangles(indices, 99);
+
+  // An unreferenced vertex at the end.
+  attributes.push_back(makeVertex(-1.0f, -1.0f));
+
+  const std::vector<TriangleKey> reference = getTriangles(attributes, indices);
+
+  weldVertices(attributes, indices);
+
+  const float before = getACMR(indices, attributes.size(), 16);
+
+  optimizeVertexCache(indices, attributes.size());
+  optimizeVertexFetch(attributes, indices);
+
+  CHECK(attributes.size() == 17 * 17);
+  CHECK(areIndicesInRange(indices, attributes.size()));
+  CHECK(getTriangles(attributes, indices) == reference);
+  CHECK(getACMR(indices, attributes.size(), 16) < before);
+}
+
+UNIT_TEST(mesh_optimizer, empty_mesh)
+{
+  std::vector<VertexAttributes> attributes;
+  std::vector<unsigned int>     indices;
+
+  CHECK(weldVertices(attributes, indices) == 0);
+
+  optimizeVertexCache(indices, 0);
+  optimizeVertexFetch(attributes, indices);
+
+  CHECK(attributes.empty());
+  CHECK(indices.empty());
+}
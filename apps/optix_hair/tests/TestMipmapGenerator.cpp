@@ -0,0 +1,114 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/MipmapGenerator.h"
+#include "inc/Picture.h"
+
+#include <vector>
+
+namespace
+{
+  const unsigned int c_size = 32;
+
+  // Black left half, white right half. Returns the LOD 0 in the component type of the image.
+  template <typename T>
+  std::vector<T> createStepEdge(const T white)
+  {
+    std::vector<T> pixels(c_size * c_size * 4);
+    for (unsigned int y = 0; y < c_size; ++y)
+    {
+      for (unsigned int x = 0; x < c_size; ++x)
+      {
+        T* p = &pixels[(y * c_size + x) * 4];
+        p[0] = p[1] = p[2] = (x < c_size / 2) ? T(0) : white;
+        p[3] = white;
+      }
+    }
+    return pixels;
+  }
+
+  // The filtered step must stay dark on the left and bright on the right half, and start at black.
+  // A negative filter result wrapping around to the maximum or reading outside the sRGB table breaks this.
+  template <typename T>
+  void checkStepEdge(const int type, const bool sRGB, const T white)
+  {
+    const std::vector<T> pixels = createStepEdge<T>(white);
+
+    Picture picture;
+    const unsigned int index = picture.addImages(pixels.data(), c_size, c_size, 1, IL_RGBA, type, std::vector<const void*>(), IMAGE_FLAG_2D);
+
+    const unsigned int numLevels = generateMipmaps(&picture, index, MIPMAP_FILTER_KAISER, sRGB);
+    CHECK(numLevels == 6 && picture.getNumberOfLevels(index) == numLevels);
+
+    // The 2x2 and 1x1 levels average both sides.
+    for (unsigned int level = 1; level < picture.getNumberOfLevels(index) && 4 <= picture.getImageLevel(index, level)->m_width; ++level)
+    {
+      const Image* image = picture.getImageLevel(index, level);
+      const T*     p     = reinterpret_cast<const T*>(image->m_pixels);
+
+      bool isSplit = true;
+      bool isBlack = true;
+      for (unsigned int y = 0; y < image->m_height; ++y)
+      {
+        const T* row = p + y * image->m_width * 4;
+
+        isBlack = isBlack && (row[0] == T(0) || image->m_width <= 4);
+        for (unsigned int x = 0; x < image->m_width; ++x)
+        {
+          const bool isBright = (white / 2 < row[x * 4]);
+          isSplit = isSplit && (isBright == (image->m_width / 2 <= x));
+        }
+      }
+      CHECK(isSplit);
+      CHECK(isBlack);
+    }
+  }
+}
+
+
+UNIT_TEST(mipmaps, step_edge_srgb8)
+{
+  checkStepEdge<unsigned char>(IL_UNSIGNED_BYTE, true, 255);
+}
+
+UNIT_TEST(mipmaps, step_edge_linear8)
+{
+  checkStepEdge<unsigned char>(IL_UNSIGNED_BYTE, false, 255);
+}
+
+UNIT_TEST(mipmaps, step_edge_linear16)
+{
+  checkStepEdge<unsigned short>(IL_UNSIGNED_SHORT, false, 65535);
+}
+
+UNIT_TEST(mipmaps, step_edge_float)
+{
+  checkStepEdge<float>(IL_FLOAT, false, 1.0f);
+}
@@ -0,0 +1,230 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/NodeArena.h"
+#include "inc/SceneGraph.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // Counts the live objects, so the tests can check that every node is destroyed exactly once.
+  int g_numAlive = 0;
+
+  template <size_t Size, size_t Alignment>
+  struct alignas(Alignment) Payload
+  {
+    Payload(const unsigned char value)
+    {
+      memset(data, value, Size);
+      ++g_numAlive;
+    }
+
+    ~Payload()
+    {
+      --g_numAlive;
+    }
+
+    bool isFilled(const unsigned char value) const
+    {
+      for (size_t i = 0; i < Size; ++i)
+      {
+        if (data[i] != value)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    unsigned char data[Size];
+  };
+
+  template <typename T>
+  bool isAligned(std::shared_ptr<T> const& p)
+  {
+    return (reinterpret_cast<uintptr_t>(p.get()) & (alignof(T) - 1)) == 0;
+  }
+}
+
+
+UNIT_TEST(node_arena, nodes_outlive_arena)
+{
+  std::shared_ptr< Payload<24, 8> > survivor;
+  std::shared_ptr<sg::Group>        group;
+  {
+    sg::NodeArena arena;
+
+    survivor = arena.create< Payload<24, 8> >(0x5A);
+    group    = arena.create<sg::Group>(7);
+
+    // Dropped while the arena lives.
+    arena.create< Payload<24, 8> >(0x11);
+    CHECK(g_numAlive == 1);
+    CHECK(0 < arena.getNumBytes());
+  }
+
+  // The blocks stay alive as long as a node references them.
+  CHECK(g_numAlive == 1);
+  CHECK(survivor->isFilled(0x5A));
+  CHECK(group->getId() == 7);
+
+  std::weak_ptr< Payload<24, 8> > weak = survivor;
+  survivor.reset();
+  CHECK(g_numAlive == 0);
+  CHECK(weak.expired());
+  group.reset();
+}
+
+UNIT_TEST(node_arena, release_on_other_threads)
+{
+  std::vector< std::shared_ptr< Payload<32, 8> > > nodes;
+  {
+    sg::NodeArena arena(1024);
+    for (int i = 0; i < 1000; ++i)
+    {
+      nodes.push_back(arena.create< Payload<32, 8> >((unsigned char) i));
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&nodes, t]()
+    {
+      for (size_t i = t; i < nodes.size(); i += 4)
+      {
+        nodes[i].reset();
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  CHECK(g_numAlive == 0);
+}
+
+UNIT_TEST(node_arena, oversized)
+{
+  std::shared_ptr< Payload<4096, 8> > large;
+  std::shared_ptr< Payload<16, 8> >   before;
+  std::shared_ptr< Payload<16, 8> >   after;
+  {
+    sg::NodeArena arena(256);
+
+    before = arena.create< Payload<16, 8> >(1);
+    large  = arena.create< Payload<4096, 8> >(2); // Larger than a block, gets its own.
+    after  = arena.create< Payload<16, 8> >(3);
+
+    CHECK(4096 < arena.getNumBytes());
+  }
+
+  CHECK(before->isFilled(1));
+  CHECK(large->isFilled(2));
+  CHECK(after->isFilled(3));
+
+  // No overlap with the neighbours.
+  const char* p = reinterpret_cast<const char*>(large.get());
+  const char* b = reinterpret_cast<const char*>(before.get());
+  const char* a = reinterpret_cast<const char*>(after.get());
+  CHECK(b + sizeof(*before) <= p || p + sizeof(*large) <= b);
+  CHECK(a + sizeof(*after) <= p || p + sizeof(*large) <= a);
+
+  before.reset();
+  large.reset();
+  after.reset();
+  CHECK(g_numAlive == 0);
+}
+
+UNIT_TEST(node_arena, alignment)
+{
+  sg::NodeArena arena(512);
+
+  std::vector< std::shared_ptr<void> > nodes;
+
+  // Mixed sizes and alignments, the odd sizes misalign the offset for the next allocation.
+  bool isAlignedAll = true;
+  for (unsigned char i = 0; i < 100; ++i)
+  {
+    std::shared_ptr< Payload<1, 1> >   p1  = arena.create< Payload<1, 1> >(i);
+    std::shared_ptr< Payload<3, 2> >   p2  = arena.create< Payload<3, 2> >(i);
+    std::shared_ptr< Payload<5, 4> >   p4  = arena.create< Payload<5, 4> >(i);
+    std::shared_ptr< Payload<9, 8> >   p8  = arena.create< Payload<9, 8> >(i);
+    std::shared_ptr< Payload<17, 16> > p16 = arena.create< Payload<17, 16> >(i);
+
+    isAlignedAll = isAlignedAll && isAligned(p1) && isAligned(p2) && isAligned(p4) && isAligned(p8) && isAligned(p16);
+
+    nodes.push_back(p1);
+    nodes.push_back(p2);
+    nodes.push_back(p4);
+    nodes.push_back(p8);
+    nodes.push_back(p16);
+  }
+  CHECK(isAlignedAll);
+
+  // The scene graph nodes themselves.
+  std::shared_ptr<sg::Triangles> triangles = arena.create<sg::Triangles>(0);
+  std::shared_ptr<sg::Instance>  instance  = arena.create<sg::Instance>(1);
+  CHECK(isAligned(triangles) && isAligned(instance));
+
+  nodes.clear();
+  CHECK(g_numAlive == 0);
+}
+
+UNIT_TEST(node_arena, disabled)
+{
+  sg::NodeArena arena(256);
+  CHECK(arena.isEnabled());
+
+  std::shared_ptr< Payload<16, 8> > inArena = arena.create< Payload<16, 8> >(1);
+  const size_t numBytes = arena.getNumBytes();
+  CHECK(0 < numBytes);
+
+  arena.setEnabled(false);
+  CHECK(!arena.isEnabled());
+
+  std::shared_ptr< Payload<16, 8> > onHeap = arena.create< Payload<16, 8> >(2);
+  std::shared_ptr<sg::Group>        group  = arena.create<sg::Group>(3);
+  CHECK(arena.getNumBytes() == numBytes); // std::make_shared() doesn't use the blocks.
+  CHECK(onHeap->isFilled(2) && group->getId() == 3);
+
+  arena.setEnabled(true);
+  arena.create< Payload<16, 8> >(4);
+  CHECK(numBytes < arena.getNumBytes());
+
+  inArena.reset();
+  onHeap.reset();
+  CHECK(g_numAlive == 0);
+}
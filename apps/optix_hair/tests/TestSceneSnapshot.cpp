@@ -0,0 +1,161 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/SceneSnapshot.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const char* c_filename = "optix_hair_test_snapshot.bin";
+
+  struct Record
+  {
+    int   index;
+    float value;
+  };
+}
+
+
+UNIT_TEST(scene_snapshot, round_trip)
+{
+  const std::vector<Record> records = { { 1, 0.5f }, { 2, -3.0f }, { 7, 1.0e6f } };
+
+  SnapshotWriter writer(42);
+  writer.write(17u);
+  writer.writeString("name");
+  writer.writeArray(records);
+  writer.writeString(std::string());
+  CHECK(writer.save(c_filename));
+
+  SnapshotReader reader;
+  CHECK(!reader.open(c_filename, 43)); // Other inputs.
+  CHECK(reader.open(c_filename, 42));
+
+  unsigned int        value = 0;
+  std::string         name;
+  std::vector<Record> result;
+  std::string         empty("x");
+
+  CHECK(reader.read(value) && value == 17u);
+  CHECK(reader.readString(name) && name == "name");
+  CHECK(reader.readArray(result) && result.size() == records.size());
+  for (size_t i = 0; i < result.size() && i < records.size(); ++i)
+  {
+    CHECK(result[i].index == records[i].index && result[i].value == records[i].value);
+  }
+  CHECK(reader.readString(empty) && empty.empty());
+  CHECK(reader.isValid());
+
+  // Reading past the end invalidates the reader.
+  CHECK(!reader.read(value));
+  CHECK(!reader.isValid());
+
+  std::remove(c_filename);
+}
+
+UNIT_TEST(scene_snapshot, corrupted_count)
+{
+  // sizeof(float) * count wraps around to 4 bytes, which are available. The count alone must be rejected.
+  const std::vector<float> values = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+  SnapshotWriter writer(1);
+  writer.write<uint64_t>((1ull << 62) + 1);
+  writer.writeArray(values);
+  CHECK(writer.save(c_filename));
+
+  SnapshotReader reader;
+  CHECK(reader.open(c_filename, 1));
+
+  std::vector<float> result;
+  CHECK(!reader.readArray(result));
+  CHECK(result.empty());
+  CHECK(!reader.isValid());
+
+  std::remove(c_filename);
+}
+
+UNIT_TEST(scene_snapshot, scene_graph)
+{
+  sg::NodeArena arena;
+
+  std::shared_ptr<sg::Group> root = arena.create<sg::Group>(0);
+  std::shared_ptr<sg::Group> group = arena.create<sg::Group>(1);
+
+  std::shared_ptr<sg::Triangles> box = arena.create<sg::Triangles>(0);
+  box->createBox();
+
+  std::vector< std::shared_ptr<sg::Node> > geometries = { box };
+
+  // Two instances share the geometry, a third one references the named group.
+  for (unsigned int id = 0; id < 2; ++id)
+  {
+    std::shared_ptr<sg::Instance> instance = arena.create<sg::Instance>(id);
+    instance->setChild(box);
+    root->addChild(instance);
+  }
+  std::shared_ptr<sg::Instance> instanceGroup = arena.create<sg::Instance>(2);
+  instanceGroup->setChild(group);
+  root->addChild(instanceGroup);
+
+  std::map< std::string, std::shared_ptr<sg::Group> > mapGroups;
+  mapGroups["group"] = group;
+
+  SnapshotWriter writer(2);
+  writeSceneGraph(writer, root, geometries, mapGroups);
+  CHECK(writer.save(c_filename));
+
+  SnapshotReader reader;
+  CHECK(reader.open(c_filename, 2));
+
+  std::shared_ptr<sg::Group>                          rootRead;
+  std::vector< std::shared_ptr<sg::Node> >            geometriesRead;
+  std::map< std::string, std::shared_ptr<sg::Group> > mapGroupsRead;
+
+  CHECK(readSceneGraph(reader, arena, rootRead, geometriesRead, mapGroupsRead));
+  CHECK(rootRead && rootRead->getNumChildren() == 3);
+  CHECK(geometriesRead.size() == 1);
+  CHECK(mapGroupsRead.size() == 1 && mapGroupsRead.count("group") == 1);
+
+  if (rootRead && rootRead->getNumChildren() == 3 && geometriesRead.size() == 1)
+  {
+    CHECK(rootRead->getChild(0)->getChild() == geometriesRead[0]);
+    CHECK(rootRead->getChild(1)->getChild() == geometriesRead[0]);
+    CHECK(rootRead->getChild(2)->getChild() == mapGroupsRead["group"]);
+
+    std::shared_ptr<sg::Triangles> boxRead = std::static_pointer_cast<sg::Triangles>(geometriesRead[0]);
+    CHECK(boxRead->getAttributes().size() == box->getAttributes().size());
+    CHECK(boxRead->getIndices() == box->getIndices());
+  }
+
+  std::remove(c_filename);
+}
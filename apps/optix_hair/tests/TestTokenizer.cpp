@@ -0,0 +1,230 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include "inc/Tokenizer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+
+namespace
+{
+  const char* c_filename = "optix_hair_test_tokens.txt";
+
+  struct Expected
+  {
+    ParserTokenType type;
+    const char*     token;
+    unsigned int    line;
+    unsigned int    column;
+  };
+
+  template <size_t N>
+  void checkTokens(Tokenizer& tokenizer, const Expected (&expected)[N])
+  {
+    std::string_view token;
+    for (Expected const& e : expected)
+    {
+      const ParserTokenType type = tokenizer.getNextToken(token);
+      CHECK(type == e.type);
+      CHECK(token == e.token);
+      CHECK(tokenizer.getLine() == e.line);
+      CHECK(tokenizer.getColumn() == e.column);
+    }
+    CHECK(tokenizer.getNextToken(token) == PTT_EOF);
+    CHECK(token.empty());
+    CHECK(tokenizer.getNextToken(token) == PTT_EOF); // Stays at the end.
+  }
+}
+
+
+UNIT_TEST(tokenizer, token_types)
+{
+  Tokenizer tokenizer;
+  tokenizer.setSource("albedo 0.5 -2 +1e-3 .25 \"file name.png\" name_1 1.0.0 e5 3x\n");
+
+  // Tokens built only of number characters are values, even if they are no valid numbers.
+  const Expected expected[] =
+  {
+    { PTT_ID,     "albedo",        1,  1 },
+    { PTT_VAL,    "0.5",           1,  8 },
+    { PTT_VAL,    "-2",            1, 12 },
+    { PTT_VAL,    "+1e-3",         1, 15 },
+    { PTT_VAL,    ".25",           1, 21 },
+    { PTT_STRING, "file name.png", 1, 25 },
+    { PTT_ID,     "name_1",        1, 41 },
+    { PTT_VAL,    "1.0.0",         1, 48 },
+    { PTT_ID,     "e5",            1, 54 },
+    { PTT_ID,     "3x",            1, 57 }
+  };
+  checkTokens(tokenizer, expected);
+}
+
+UNIT_TEST(tokenizer, comments_and_lines)
+{
+  Tokenizer tokenizer;
+  tokenizer.setSource("# comment \"not a string\"\n\tmaterial # trailing 1.0\r\n\r\n  \"a\nb\" next\n#last line without newline");
+
+  const Expected expected[] =
+  {
+    { PTT_ID,     "material", 2, 2 },
+    { PTT_STRING, "a\nb",     4, 3 },
+    { PTT_ID,     "next",     5, 4 } // Behind the string spanning lines.
+  };
+  checkTokens(tokenizer, expected);
+}
+
+UNIT_TEST(tokenizer, unterminated_string)
+{
+  Tokenizer tokenizer;
+  tokenizer.setSource("name \"file.png\nnext");
+
+  // The quotation mark is skipped, scanning continues behind it.
+  const Expected expected[] =
+  {
+    { PTT_ID, "name",      1, 1 },
+    { PTT_ID, "file.png",  1, 7 },
+    { PTT_ID, "next",      2, 1 }
+  };
+  checkTokens(tokenizer, expected);
+}
+
+UNIT_TEST(tokenizer, location)
+{
+  Tokenizer tokenizer;
+  tokenizer.setSource("first\n  second");
+
+  std::string token;
+  CHECK(tokenizer.getNextToken(token) == PTT_ID && token == "first");
+  CHECK(tokenizer.getLocation() == "<string>(1,1)");
+  CHECK(tokenizer.getNextToken(token) == PTT_ID && token == "second");
+  CHECK(tokenizer.getLocation() == "<string>(2,3)");
+  CHECK(tokenizer.getIndex() == tokenizer.getSize());
+
+  // A new source restarts the counting.
+  tokenizer.setSource("third");
+  CHECK(tokenizer.getNextToken(token) == PTT_ID && token == "third");
+  CHECK(tokenizer.getLocation() == "<string>(1,1)");
+}
+
+UNIT_TEST(tokenizer, load)
+{
+  {
+    std::ofstream output(c_filename, std::ios::binary);
+    output << "camera\n  fov 45\n";
+  }
+
+  Tokenizer tokenizer;
+  CHECK(tokenizer.load(c_filename));
+
+  std::string token;
+  CHECK(tokenizer.getNextToken(token) == PTT_ID && token == "camera");
+  CHECK(tokenizer.getNextToken(token) == PTT_ID && token == "fov");
+  CHECK(tokenizer.getNextToken(token) == PTT_VAL && token == "45");
+  CHECK(tokenizer.getLocation() == std::string(c_filename) + "(2,7)");
+  CHECK(tokenizer.getNextToken(token) == PTT_EOF);
+
+  // Empty files can't be mapped but are valid.
+  {
+    std::ofstream output(c_filename, std::ios::binary | std::ios::trunc);
+  }
+  CHECK(tokenizer.load(c_filename));
+  CHECK(tokenizer.getSize() == 0);
+  CHECK(tokenizer.getNextToken(token) == PTT_EOF);
+
+  std::remove(c_filename);
+  CHECK(!tokenizer.load(c_filename));
+}
+
+UNIT_TEST(tokenizer, parse_float)
+{
+  CHECK(parseFloat("0.5") == 0.5f);
+  CHECK(parseFloat("-0.5") == -0.5f);
+  CHECK(parseFloat("+2.25") == 2.25f);
+  CHECK(parseFloat("  \t7") == 7.0f);
+  CHECK(parseFloat(".25") == 0.25f);
+  CHECK(parseFloat("1e3") == 1000.0f);
+  CHECK(parseFloat("1.5E-2") == 0.015f);
+  CHECK(parseFloat("-2e+1") == -20.0f);
+  CHECK(parseFloat("0.1") == 0.1f); // Correctly rounded like strtof().
+
+  // The longest valid prefix.
+  CHECK(parseFloat("1.5abc") == 1.5f);
+  CHECK(parseFloat("1.0.0") == 1.0f);
+  CHECK(parseFloat("2e") == 2.0f);
+  CHECK(parseFloat("3x") == 3.0f);
+
+  // No number.
+  CHECK(parseFloat("") == 0.0f);
+  CHECK(parseFloat("abc") == 0.0f);
+  CHECK(parseFloat("-") == 0.0f);
+  CHECK(parseFloat("+") == 0.0f);
+  CHECK(parseFloat("+-1") == 0.0f);
+
+  // Out of range like atof().
+  CHECK(parseFloat("1e40") == std::numeric_limits<float>::infinity());
+  CHECK(parseFloat("-1e40") == -std::numeric_limits<float>::infinity());
+  CHECK(parseFloat("1e-50") == 0.0f);
+  CHECK(0.0f < parseFloat("1e-40") && parseFloat("1e-40") < std::numeric_limits<float>::min()); // Denormal.
+
+  // Views into a larger buffer must not read past their end.
+  const std::string_view view = std::string_view("12345").substr(0, 2);
+  CHECK(parseFloat(view) == 12.0f);
+}
+
+UNIT_TEST(tokenizer, parse_int)
+{
+  CHECK(parseInt("42") == 42);
+  CHECK(parseInt("-42") == -42);
+  CHECK(parseInt("+7") == 7);
+  CHECK(parseInt("  3") == 3);
+  CHECK(parseInt("2147483647") == 2147483647);
+  CHECK(parseInt("-2147483648") == std::numeric_limits<int>::min());
+
+  // The longest valid prefix.
+  CHECK(parseInt("12abc") == 12);
+  CHECK(parseInt("1.9") == 1);
+  CHECK(parseInt("1e3") == 1);
+
+  // No number.
+  CHECK(parseInt("") == 0);
+  CHECK(parseInt("abc") == 0);
+  CHECK(parseInt("-") == 0);
+  CHECK(parseInt("+-1") == 0);
+
+  // Out of range values saturate like strtol().
+  CHECK(parseInt("2147483648") == std::numeric_limits<int>::max());
+  CHECK(parseInt("-99999999999") == std::numeric_limits<int>::min());
+
+  const std::string_view view = std::string_view("12345").substr(0, 3);
+  CHECK(parseInt(view) == 123);
+}
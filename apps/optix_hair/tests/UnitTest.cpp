@@ -0,0 +1,110 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UnitTest.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+  struct UnitTest
+  {
+    const char*      group;
+    const char*      name;
+    UnitTestFunction function;
+  };
+
+  // Function local to be independent of the static initialization order of the test translation units.
+  std::vector<UnitTest>& getUnitTests()
+  {
+    static std::vector<UnitTest> tests;
+    return tests;
+  }
+
+  int g_failures = 0;
+}
+
+UnitTestRegistrar::UnitTestRegistrar(const char* group, const char* name, UnitTestFunction function)
+{
+  getUnitTests().push_back({ group, name, function });
+}
+
+void reportUnitTestFailure(const char* file, const int line, const char* expression)
+{
+  std::cerr << "  FAILED: " << file << "(" << line << "): " << expression << '\n';
+  ++g_failures;
+}
+
+// Usage: optix_hair_tests [group ...]
+// Without arguments all tests run. Returns non-zero when a check failed or a group name is unknown.
+int main(int argc, char *argv[])
+{
+  std::vector<std::string> groups(argv + 1, argv + argc);
+
+  for (std::string const& group : groups)
+  {
+    bool found = false;
+    for (UnitTest const& test : getUnitTests())
+    {
+      found |= (group == test.group);
+    }
+    if (!found)
+    {
+      std::cerr << "ERROR: Unknown test group " << group << '\n';
+      return 1;
+    }
+  }
+
+  int numTests = 0;
+
+  for (UnitTest const& test : getUnitTests())
+  {
+    bool run = groups.empty();
+    for (std::string const& group : groups)
+    {
+      run |= (group == test.group);
+    }
+    if (!run)
+    {
+      continue;
+    }
+
+    const int failures = g_failures;
+
+    std::cout << test.group << "." << test.name << std::endl;
+    test.function();
+
+    std::cout << ((failures == g_failures) ? "  passed" : "  FAILED") << std::endl;
+    ++numTests;
+  }
+
+  std::cout << numTests << " tests, " << g_failures << " failed checks" << std::endl;
+
+  return (g_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef UNIT_TEST_H
+#define UNIT_TEST_H
+
+#include <cmath>
+#include <iostream>
+
+// Minimal self registering unit tests for the host side modules. They don't need a GPU.
+// Each test belongs to a group. Running optix_hair_tests with group names only runs those groups, CTest adds one test per group.
+
+typedef void (*UnitTestFunction)();
+
+struct UnitTestRegistrar
+{
+  UnitTestRegistrar(const char* group, const char* name, UnitTestFunction function);
+};
+
+// Called by the CHECK macros. Counts the failure and prints its location.
+void reportUnitTestFailure(const char* file, const int line, const char* expression);
+
+#define UNIT_TEST(group, name) \
+  static void unitTest_##group##_##name(); \
+  static UnitTestRegistrar unitTestRegistrar_##group##_##name(#group, #name, unitTest_##group##_##name); \
+  static void unitTest_##group##_##name()
+
+#define CHECK(expression) \
+  do { if (!(expression)) { reportUnitTestFailure(__FILE__, __LINE__, #expression); } } while (0)
+
+// Fails when the absolute difference of a and b is bigger than epsilon. NaN always fails.
+#define CHECK_NEAR(a, b, epsilon) \
+  do { if (!(std::fabs(double(a) - double(b)) <= double(epsilon))) { \
+    std::cerr << "  " << (a) << " != " << (b) << '\n'; \
+    reportUnitTestFailure(__FILE__, __LINE__, #a " ~ " #b); } } while (0)
+
+#endif // UNIT_TEST_H